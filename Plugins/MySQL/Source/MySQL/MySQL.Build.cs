@@ -57,7 +57,7 @@ public class MySQL : ModuleRules
         
         PublicDependencyModuleNames.AddRange(new[] { "Core", "CoreUObject", "Engine", "RHI",
             "ImageWrapper", "RenderCore", "ImageWriteQueue", "InputCore" , "Projects" });
-        PrivateDependencyModuleNames.AddRange(new[] { "XmlParser", "Core", "ImageWrapper", "Engine" });
+        PrivateDependencyModuleNames.AddRange(new[] { "XmlParser", "Core", "ImageWrapper", "ImageCore", "Engine" });
 
         if (Target.Platform == UnrealTargetPlatform.Win64 || Target.Platform == UnrealTargetPlatform.LinuxArm64 ||
             Target.Platform == UnrealTargetPlatform.Linux)
@@ -0,0 +1,734 @@
+// Copyright 2021-2023, Athian Games. All Rights Reserved.
+
+#include "MySQLAsyncEngine.h"
+#include "MySQLResultSet.h"
+
+#include <algorithm>
+#include <mysql/errmsg.h>
+
+#if PLATFORM_WINDOWS
+#include "Windows/AllowWindowsPlatformTypes.h"
+#include <winsock2.h>
+#include "Windows/HideWindowsPlatformTypes.h"
+
+typedef SOCKET FEngineSocket;
+typedef WSAPOLLFD FEnginePollFD;
+typedef int FEngineSocketLength;
+
+static int PollSockets(FEnginePollFD* FDs, size_t NumFDs, int TimeoutMs)
+{
+	return WSAPoll(FDs, static_cast<ULONG>(NumFDs), TimeoutMs);
+}
+
+static void CloseEngineSocket(FEngineSocket Socket)
+{
+	closesocket(Socket);
+}
+
+static bool SetNonBlocking(FEngineSocket Socket)
+{
+	u_long NonBlocking = 1;
+	return ioctlsocket(Socket, FIONBIO, &NonBlocking) == 0;
+}
+
+static const FEngineSocket InvalidEngineSocket = INVALID_SOCKET;
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+typedef int FEngineSocket;
+typedef pollfd FEnginePollFD;
+typedef socklen_t FEngineSocketLength;
+
+static int PollSockets(FEnginePollFD* FDs, size_t NumFDs, int TimeoutMs)
+{
+	return poll(FDs, static_cast<nfds_t>(NumFDs), TimeoutMs);
+}
+
+static void CloseEngineSocket(FEngineSocket Socket)
+{
+	close(Socket);
+}
+
+static bool SetNonBlocking(FEngineSocket Socket)
+{
+	const int Flags = fcntl(Socket, F_GETFL, 0);
+	return Flags != -1 && fcntl(Socket, F_SETFL, Flags | O_NONBLOCK) == 0;
+}
+
+static const FEngineSocket InvalidEngineSocket = -1;
+#endif
+
+// Poll interval when there is no wake socket for Submit and the pools to signal
+static constexpr int AcquireRetryMs = 10;
+
+static bool IsConnectionLostError(unsigned int ErrorCode)
+{
+	return ErrorCode == CR_SERVER_GONE_ERROR || ErrorCode == CR_SERVER_LOST;
+}
+
+
+struct MySQLAsyncEngine::FRequest
+{
+	shared_ptr<MySQLHandlePool> Pool;
+	vector<string> Queries;
+	bool bRetryOnLostConnection = false;
+	double PingIdleSeconds = 0.0;
+	FCompletion OnComplete;
+
+	MySQLPooledHandle Handle;
+	int Attempt = 0;
+
+	// New handle of the pool while its connection is being made, and the result of mysql_real_connect_cont
+	MYSQL* ConnectingHandle = nullptr;
+	MYSQL* Connected = nullptr;
+
+	EStep Step = EStep::AcquireHandle;
+	size_t QueryIndex = 0;
+
+	// Return values of the _start/_cont calls
+	int QueryStatus = 0;
+	MYSQL_ROW Row = nullptr;
+	MYSQL_RES* Result = nullptr;
+
+	// MYSQL_WAIT_* events the current step waits for, 0 when it can go on right away
+	int WaitStatus = 0;
+	FClock::time_point Deadline;
+
+	FMySQLResultSet Rows;
+	uint64_t AffectedRows = 0;
+	unsigned int ErrorCode = 0;
+	string ErrorMessage;
+
+	MYSQL* GetMySQL() const
+	{
+		return Step == EStep::Connect ? ConnectingHandle : Handle.Get();
+	}
+
+	void SetWaitStatus(int Status)
+	{
+		WaitStatus = Status;
+		if (Status & MYSQL_WAIT_TIMEOUT)
+		{
+			Deadline = FClock::now() + chrono::milliseconds(mysql_get_timeout_value_ms(GetMySQL()));
+		}
+	}
+};
+
+
+shared_ptr<MySQLAsyncEngine> MySQLAsyncEngine::GetShared()
+{
+	static mutex SharedEngineMutex;
+	static weak_ptr<MySQLAsyncEngine> SharedEngine;
+
+	lock_guard<mutex> Lock(SharedEngineMutex);
+	shared_ptr<MySQLAsyncEngine> Engine = SharedEngine.lock();
+	if (!Engine)
+	{
+		Engine = make_shared<MySQLAsyncEngine>();
+		SharedEngine = Engine;
+	}
+	return Engine;
+}
+
+MySQLAsyncEngine::MySQLAsyncEngine()
+{
+#if PLATFORM_WINDOWS
+	WSADATA SocketData;
+	WSAStartup(MAKEWORD(2, 2), &SocketData);
+#endif
+
+	FEngineSocket Socket = socket(AF_INET, SOCK_DGRAM, 0);
+	if (Socket != InvalidEngineSocket)
+	{
+		// Bound to an ephemeral loopback port and connected to itself, so that send() wakes our own poll
+		sockaddr_in Address = {};
+		Address.sin_family = AF_INET;
+		Address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		FEngineSocketLength AddressLength = sizeof(Address);
+
+		bHasWakeSocket = bind(Socket, reinterpret_cast<sockaddr*>(&Address), sizeof(Address)) == 0
+			&& getsockname(Socket, reinterpret_cast<sockaddr*>(&Address), &AddressLength) == 0
+			&& connect(Socket, reinterpret_cast<sockaddr*>(&Address), sizeof(Address)) == 0
+			&& SetNonBlocking(Socket);
+		if (bHasWakeSocket)
+		{
+			WakeSocket = static_cast<my_socket>(Socket);
+		}
+		else
+		{
+			CloseEngineSocket(Socket);
+		}
+	}
+
+	IOThread = thread(&MySQLAsyncEngine::Loop, this);
+}
+
+MySQLAsyncEngine::~MySQLAsyncEngine()
+{
+	{
+		lock_guard<mutex> Lock(IncomingMutex);
+		bStop = true;
+	}
+	Wake();
+	IOThread.join();
+
+	for (const pair<MySQLHandlePool* const, weak_ptr<MySQLHandlePool>>& Listened : ListenedPools)
+	{
+		if (shared_ptr<MySQLHandlePool> Pool = Listened.second.lock())
+		{
+			Pool->RemoveReleaseListener(this);
+		}
+	}
+
+	if (bHasWakeSocket)
+	{
+		CloseEngineSocket(static_cast<FEngineSocket>(WakeSocket));
+	}
+
+#if PLATFORM_WINDOWS
+	WSACleanup();
+#endif
+}
+
+void MySQLAsyncEngine::Submit(shared_ptr<MySQLHandlePool> Pool, vector<string> Queries, bool bRetryOnLostConnection, double PingIdleSeconds,
+	FCompletion OnComplete)
+{
+	unique_ptr<FRequest> Request = make_unique<FRequest>();
+	Request->Pool = std::move(Pool);
+	Request->Queries = std::move(Queries);
+	Request->bRetryOnLostConnection = bRetryOnLostConnection;
+	Request->PingIdleSeconds = PingIdleSeconds;
+	Request->OnComplete = std::move(OnComplete);
+
+	NumRequests++;
+	{
+		lock_guard<mutex> Lock(IncomingMutex);
+		Incoming.push_back(std::move(Request));
+	}
+	Wake();
+}
+
+void MySQLAsyncEngine::Wake()
+{
+	if (bHasWakeSocket)
+	{
+		const char Signal = 0;
+		send(static_cast<FEngineSocket>(WakeSocket), &Signal, 1, 0);
+	}
+}
+
+void MySQLAsyncEngine::Loop()
+{
+	vector<FEnginePollFD> PollFDs;
+	vector<FRequest*> PolledRequests;
+
+	for (;;)
+	{
+		{
+			lock_guard<mutex> Lock(IncomingMutex);
+			if (bStop)
+			{
+				break;
+			}
+			for (unique_ptr<FRequest>& Request : Incoming)
+			{
+				WaitingForHandle.push_back(std::move(Request));
+			}
+			Incoming.clear();
+		}
+
+		// Raised before asking the pools, so that a handle released right after a refusal still wakes the poll below
+		bWaitingForHandle = !WaitingForHandle.empty();
+		AcquireHandles();
+		bWaitingForHandle = !WaitingForHandle.empty();
+
+		// Requests that are not waiting for their socket run now: new ones, and the ones that yielded
+		for (size_t Index = 0; Index < Running.size(); Index++)
+		{
+			if (Running[Index]->WaitStatus == 0)
+			{
+				Run(*Running[Index], 0);
+			}
+		}
+
+		// Finished requests give their handles back before the waiting ones ask again
+		bool bHandleReleased = false;
+		for (size_t Index = 0; Index < Running.size();)
+		{
+			FRequest& Request = *Running[Index];
+			if (Request.Step == EStep::Done || Request.Step == EStep::AcquireHandle)
+			{
+				unique_ptr<FRequest> Finished = std::move(Running[Index]);
+				Running.erase(Running.begin() + Index);
+				if (Finished->Step == EStep::Done)
+				{
+					Complete(std::move(Finished));
+				}
+				else
+				{
+					WaitingForHandle.push_front(std::move(Finished));
+				}
+				bHandleReleased = true;
+				continue;
+			}
+			Index++;
+		}
+
+		const bool bRunnable = bHandleReleased || any_of(Running.begin(), Running.end(), [](const unique_ptr<FRequest>& Request)
+		{
+			return Request->WaitStatus == 0;
+		});
+
+		PollFDs.clear();
+		PolledRequests.clear();
+		if (bHasWakeSocket)
+		{
+			FEnginePollFD WakeFD = {};
+			WakeFD.fd = static_cast<FEngineSocket>(WakeSocket);
+			WakeFD.events = POLLIN;
+			PollFDs.push_back(WakeFD);
+		}
+
+		const FClock::time_point Now = FClock::now();
+		int TimeoutMs = bRunnable ? 0 : -1;
+		// Without a wake socket neither Submit nor the pools can interrupt the wait
+		if (TimeoutMs != 0 && !bHasWakeSocket)
+		{
+			TimeoutMs = AcquireRetryMs;
+		}
+
+		for (const unique_ptr<FRequest>& Request : Running)
+		{
+			if (Request->WaitStatus == 0)
+			{
+				continue;
+			}
+
+			FEnginePollFD RequestFD = {};
+			RequestFD.fd = static_cast<FEngineSocket>(mysql_get_socket(Request->GetMySQL()));
+			if (Request->WaitStatus & MYSQL_WAIT_READ)
+			{
+				RequestFD.events |= POLLIN;
+			}
+			if (Request->WaitStatus & MYSQL_WAIT_WRITE)
+			{
+				RequestFD.events |= POLLOUT;
+			}
+#if !PLATFORM_WINDOWS
+			if (Request->WaitStatus & MYSQL_WAIT_EXCEPT)
+			{
+				RequestFD.events |= POLLPRI;
+			}
+#endif
+			PollFDs.push_back(RequestFD);
+			PolledRequests.push_back(Request.get());
+
+			if (Request->WaitStatus & MYSQL_WAIT_TIMEOUT)
+			{
+				const int RequestTimeoutMs = static_cast<int>(max<long long>(0,
+					chrono::duration_cast<chrono::milliseconds>(Request->Deadline - Now).count()));
+				TimeoutMs = TimeoutMs < 0 ? RequestTimeoutMs : min(TimeoutMs, RequestTimeoutMs);
+			}
+		}
+
+		if (PollFDs.empty())
+		{
+			this_thread::sleep_for(chrono::milliseconds(TimeoutMs));
+		}
+		else if (PollSockets(PollFDs.data(), PollFDs.size(), TimeoutMs) < 0)
+		{
+			// Interrupted; the timeouts below still get their turn
+			for (FEnginePollFD& PollFD : PollFDs)
+			{
+				PollFD.revents = 0;
+			}
+		}
+
+		const size_t FirstRequestFD = bHasWakeSocket ? 1 : 0;
+		if (bHasWakeSocket && PollFDs[0].revents != 0)
+		{
+			char Signals[64];
+			while (recv(static_cast<FEngineSocket>(WakeSocket), Signals, sizeof(Signals), 0) > 0)
+			{
+			}
+		}
+
+		const FClock::time_point PollEnd = FClock::now();
+		for (size_t Index = 0; Index < PolledRequests.size(); Index++)
+		{
+			FRequest& Request = *PolledRequests[Index];
+			const short Events = PollFDs[FirstRequestFD + Index].revents;
+
+			int ReadyStatus = 0;
+			if (Events & (POLLERR | POLLHUP | POLLNVAL))
+			{
+				// Let the client library find the error on its next read or write
+				ReadyStatus = Request.WaitStatus & (MYSQL_WAIT_READ | MYSQL_WAIT_WRITE | MYSQL_WAIT_EXCEPT);
+			}
+			if (Events & POLLIN)
+			{
+				ReadyStatus |= MYSQL_WAIT_READ;
+			}
+			if (Events & POLLOUT)
+			{
+				ReadyStatus |= MYSQL_WAIT_WRITE;
+			}
+#if !PLATFORM_WINDOWS
+			if (Events & POLLPRI)
+			{
+				ReadyStatus |= MYSQL_WAIT_EXCEPT;
+			}
+#endif
+			if (ReadyStatus == 0 && (Request.WaitStatus & MYSQL_WAIT_TIMEOUT) && PollEnd >= Request.Deadline)
+			{
+				ReadyStatus = MYSQL_WAIT_TIMEOUT;
+			}
+
+			if (ReadyStatus != 0)
+			{
+				Run(Request, ReadyStatus);
+			}
+		}
+	}
+
+	FailAll("MySQL engine stopped");
+}
+
+void MySQLAsyncEngine::AcquireHandles()
+{
+	for (size_t Index = 0; Index < WaitingForHandle.size();)
+	{
+		FRequest& Request = *WaitingForHandle[Index];
+
+		// Registered before the first attempt, so that no release can slip in between a busy answer and the listener
+		weak_ptr<MySQLHandlePool>& Listened = ListenedPools[Request.Pool.get()];
+		if (Listened.expired())
+		{
+			Listened = Request.Pool;
+			Request.Pool->AddReleaseListener(this, [this]()
+			{
+				if (bWaitingForHandle)
+				{
+					Wake();
+				}
+			});
+		}
+
+		string ErrorMessage;
+		double IdleSeconds = 0.0;
+		bool bOpenSlot = false;
+		MYSQL* Handle = Request.Pool->TryAcquire(ErrorMessage, IdleSeconds, bOpenSlot);
+		if (!Handle && bOpenSlot)
+		{
+			// The new handle connects on this thread like any other step, instead of blocking it in mysql_real_connect
+			int WaitStatus = 0;
+			Request.Connected = nullptr;
+			Request.ConnectingHandle = Request.Pool->StartOpenHandle(WaitStatus, Request.Connected, ErrorMessage);
+			if (Request.ConnectingHandle)
+			{
+				Request.Step = EStep::Connect;
+				Request.SetWaitStatus(WaitStatus);
+				if (WaitStatus == 0)
+				{
+					OnConnectDone(Request);
+				}
+				Running.push_back(std::move(WaitingForHandle[Index]));
+				WaitingForHandle.erase(WaitingForHandle.begin() + Index);
+				continue;
+			}
+			Request.Pool->FinishOpenHandle(nullptr, false, ErrorMessage);
+		}
+
+		if (!Handle)
+		{
+			if (ErrorMessage.empty())
+			{
+				// Every handle of the pool is busy
+				Index++;
+				continue;
+			}
+
+			unique_ptr<FRequest> Failed = std::move(WaitingForHandle[Index]);
+			WaitingForHandle.erase(WaitingForHandle.begin() + Index);
+			Failed->ErrorCode = CR_CONN_HOST_ERROR;
+			Failed->ErrorMessage = ErrorMessage;
+			Complete(std::move(Failed));
+			continue;
+		}
+
+		Request.Handle = MySQLPooledHandle(Request.Pool, Handle);
+		Request.Step = IdleSeconds > Request.PingIdleSeconds ? EStep::Ping : EStep::Query;
+		Request.WaitStatus = 0;
+		Running.push_back(std::move(WaitingForHandle[Index]));
+		WaitingForHandle.erase(WaitingForHandle.begin() + Index);
+	}
+}
+
+void MySQLAsyncEngine::OnConnectDone(FRequest& Request)
+{
+	MYSQL* Handle = Request.ConnectingHandle;
+	Request.ConnectingHandle = nullptr;
+
+	string ErrorMessage = Request.Connected ? "" : mysql_error(Handle);
+	if (Request.Pool->FinishOpenHandle(Handle, Request.Connected != nullptr, ErrorMessage))
+	{
+		Request.Handle = MySQLPooledHandle(Request.Pool, Handle);
+		Request.Step = EStep::Query;
+		return;
+	}
+
+	// Reported like a failed lease, without the retry of a lost connection
+	Request.ErrorCode = CR_CONN_HOST_ERROR;
+	Request.ErrorMessage = ErrorMessage;
+	Request.Step = EStep::Done;
+}
+
+void MySQLAsyncEngine::Run(FRequest& Request, int ReadyStatus)
+{
+	MYSQL* Handle = Request.GetMySQL();
+	bool bResume = Request.WaitStatus != 0;
+	Request.WaitStatus = 0;
+
+	for (int RowBudget = MaxRowsPerTurn; ; )
+	{
+		int Status = 0;
+		switch (Request.Step)
+		{
+		case EStep::Connect:
+			// Started by AcquireHandles, so there is only something to do here once the socket is ready
+			if (!bResume)
+			{
+				return;
+			}
+			Status = mysql_real_connect_cont(&Request.Connected, Handle, ReadyStatus);
+			break;
+		case EStep::Ping:
+			Status = bResume ? mysql_ping_cont(&Request.QueryStatus, Handle, ReadyStatus) : mysql_ping_start(&Request.QueryStatus, Handle);
+			break;
+		case EStep::Query:
+			{
+				const string& Query = Request.Queries[Request.QueryIndex];
+				Status = bResume ? mysql_real_query_cont(&Request.QueryStatus, Handle, ReadyStatus)
+					: mysql_real_query_start(&Request.QueryStatus, Handle, Query.data(), static_cast<unsigned long>(Query.size()));
+			}
+			break;
+		case EStep::FetchRow:
+			Status = bResume ? mysql_fetch_row_cont(&Request.Row, Request.Result, ReadyStatus) : mysql_fetch_row_start(&Request.Row, Request.Result);
+			break;
+		case EStep::FreeResult:
+			Status = bResume ? mysql_free_result_cont(Request.Result, ReadyStatus) : mysql_free_result_start(Request.Result);
+			break;
+		case EStep::NextResult:
+			Status = bResume ? mysql_next_result_cont(&Request.QueryStatus, Handle, ReadyStatus) : mysql_next_result_start(&Request.QueryStatus, Handle);
+			break;
+		default:
+			return;
+		}
+		bResume = false;
+
+		if (Status != 0)
+		{
+			Request.SetWaitStatus(Status);
+			return;
+		}
+
+		switch (Request.Step)
+		{
+		case EStep::Connect:
+			OnConnectDone(Request);
+			break;
+
+		case EStep::Ping:
+			if (Request.QueryStatus != 0)
+			{
+				// Dead handle: take another one, this does not count as an attempt
+				Request.Handle.Discard();
+				Request.Step = EStep::AcquireHandle;
+				return;
+			}
+			Request.Step = EStep::Query;
+			break;
+
+		case EStep::Query:
+		case EStep::NextResult:
+			OnResultReady(Request, Request.QueryStatus);
+			break;
+
+		case EStep::FetchRow:
+			if (Request.Row)
+			{
+				Request.Rows.AddRow(Request.Row, mysql_fetch_lengths(Request.Result));
+				if (--RowBudget == 0)
+				{
+					return;
+				}
+			}
+			else
+			{
+				Request.ErrorCode = mysql_errno(Handle);
+				Request.ErrorMessage = Request.ErrorCode == 0 ? "" : mysql_error(Handle);
+				Request.Step = EStep::FreeResult;
+			}
+			break;
+
+		case EStep::FreeResult:
+			Request.Result = nullptr;
+			OnStatementDone(Request);
+			break;
+
+		default:
+			return;
+		}
+
+		if (Request.Step == EStep::Done)
+		{
+			return;
+		}
+	}
+}
+
+void MySQLAsyncEngine::OnResultReady(FRequest& Request, int QueryStatus)
+{
+	MYSQL* Handle = Request.Handle.Get();
+
+	// mysql_next_result reports -1 once a statement has no more results
+	if (Request.Step == EStep::NextResult && QueryStatus < 0)
+	{
+		Request.Step = ++Request.QueryIndex < Request.Queries.size() ? EStep::Query : EStep::Done;
+		return;
+	}
+
+	if (QueryStatus != 0)
+	{
+		Request.ErrorCode = mysql_errno(Handle);
+		Request.ErrorMessage = mysql_error(Handle);
+		Request.Step = ++Request.QueryIndex < Request.Queries.size() && !IsConnectionLostError(Request.ErrorCode) ? EStep::Query : EStep::Done;
+		return;
+	}
+
+	Request.ErrorCode = 0;
+	Request.ErrorMessage.clear();
+
+	if (mysql_field_count(Handle) == 0)
+	{
+		Request.AffectedRows = mysql_affected_rows(Handle);
+		OnStatementDone(Request);
+		return;
+	}
+
+	// Rows are parsed into their columns as they come off the socket
+	Request.Result = mysql_use_result(Handle);
+	if (!Request.Result)
+	{
+		Request.ErrorCode = mysql_errno(Handle);
+		Request.ErrorMessage = mysql_error(Handle);
+		Request.Step = EStep::Done;
+		return;
+	}
+
+	Request.Rows.Reset(mysql_fetch_fields(Request.Result), mysql_num_fields(Request.Result));
+	Request.Step = EStep::FetchRow;
+}
+
+void MySQLAsyncEngine::OnStatementDone(FRequest& Request)
+{
+	if (IsConnectionLostError(Request.ErrorCode))
+	{
+		Request.Step = EStep::Done;
+	}
+	else if (mysql_more_results(Request.Handle.Get()))
+	{
+		// Procedures answer with several results, which have to be read before the next query
+		Request.Step = EStep::NextResult;
+	}
+	else
+	{
+		Request.Step = ++Request.QueryIndex < Request.Queries.size() ? EStep::Query : EStep::Done;
+	}
+}
+
+void MySQLAsyncEngine::Complete(unique_ptr<FRequest> Request)
+{
+	if (IsConnectionLostError(Request->ErrorCode))
+	{
+		if (Request->Result)
+		{
+			mysql_free_result(Request->Result);
+			Request->Result = nullptr;
+		}
+		Request->Handle.Discard();
+
+		if (Request->bRetryOnLostConnection && Request->Attempt == 0)
+		{
+			Request->Attempt++;
+			Request->Step = EStep::AcquireHandle;
+			Request->QueryIndex = 0;
+			Request->AffectedRows = 0;
+			Request->ErrorCode = 0;
+			Request->ErrorMessage.clear();
+			WaitingForHandle.push_back(std::move(Request));
+			return;
+		}
+	}
+
+	// Back to the pool before the callback, which may submit more work for it
+	Request->Handle = MySQLPooledHandle();
+
+	try
+	{
+		Request->OnComplete(Request->ErrorCode == 0, Request->ErrorMessage, Request->Rows, Request->AffectedRows);
+	}
+	catch (const std::exception&)
+	{
+	}
+	NumRequests--;
+}
+
+void MySQLAsyncEngine::FailAll(const string& ErrorMessage)
+{
+	vector<unique_ptr<FRequest>> Requests;
+	{
+		lock_guard<mutex> Lock(IncomingMutex);
+		Requests.swap(Incoming);
+	}
+	for (unique_ptr<FRequest>& Request : WaitingForHandle)
+	{
+		Requests.push_back(std::move(Request));
+	}
+	WaitingForHandle.clear();
+	for (unique_ptr<FRequest>& Request : Running)
+	{
+		Requests.push_back(std::move(Request));
+	}
+	Running.clear();
+
+	for (unique_ptr<FRequest>& Request : Requests)
+	{
+		// A handle stopped in the middle of a query can not be used again
+		if (Request->Result)
+		{
+			mysql_free_result(Request->Result);
+			Request->Result = nullptr;
+		}
+		if (Request->Handle && Request->Step != EStep::Done)
+		{
+			Request->Handle.Discard();
+		}
+		if (Request->ConnectingHandle)
+		{
+			string Unused;
+			Request->Pool->FinishOpenHandle(Request->ConnectingHandle, false, Unused);
+			Request->ConnectingHandle = nullptr;
+		}
+
+		Request->Step = EStep::Done;
+		Request->ErrorCode = CR_UNKNOWN_ERROR;
+		Request->ErrorMessage = ErrorMessage;
+		Complete(std::move(Request));
+	}
+}
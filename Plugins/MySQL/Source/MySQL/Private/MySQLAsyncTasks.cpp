@@ -7,7 +7,8 @@
 #include "Async/Async.h"
 
 OpenMySQLConnectionTask::OpenMySQLConnectionTask(TWeakObjectPtr<AMySQLDBConnectionActor> dbConnectionActor, int32 connectionID,
-	TWeakObjectPtr<UMySQLDBConnector> dbConnector, FString server, FString dBName, FString userID, FString password, int32 port, TArray<FMySQLOptionPair> options)
+	TWeakObjectPtr<UMySQLDBConnector> dbConnector, FString server, FString dBName, FString userID, FString password, int32 port, TArray<FMySQLOptionPair> options,
+	int32 poolSize)
 {
 	Server = server;
 	DBName = dBName;
@@ -18,6 +19,7 @@ OpenMySQLConnectionTask::OpenMySQLConnectionTask(TWeakObjectPtr<AMySQLDBConnecti
 	MySQLDBConnector = dbConnector;
 	ConnectionID = connectionID;
 	MySQLOptions = options;
+	PoolSize = poolSize;
 }
 
 OpenMySQLConnectionTask::~OpenMySQLConnectionTask()
@@ -34,18 +36,18 @@ void OpenMySQLConnectionTask::DoWork()
 		MySQLDBConnector->CloseConnection(ConnectionID);
 
 		FString ErrorMessage;
-		bool ConnectionStatus = MySQLDBConnector->CreateNewConnection(ConnectionID, Server, DBName, UserID, Password, Port, MySQLOptions, ErrorMessage);
-		AsyncTask(ENamedThreads::GameThread, [this, ConnectionStatus, ErrorMessage]()
+		bool ConnectionStatus = MySQLDBConnector->CreateNewConnection(ConnectionID, Server, DBName, UserID, Password, Port, MySQLOptions, PoolSize, ErrorMessage);
+		// The task is released once DoWork returns, so the game thread call only takes copies of what it needs
+		AsyncTask(ENamedThreads::GameThread, [DBConnectionActor = CurrentDBConnectionActor, CurrentConnectionID = ConnectionID, ConnectionStatus, ErrorMessage]()
 		{
 			
-			if (CurrentDBConnectionActor.IsValid())
+			if (DBConnectionActor.IsValid())
 			{
-				CurrentDBConnectionActor->bIsConnectionBusy = false;
 				if(!ConnectionStatus)
 				{
-					CurrentDBConnectionActor->ResetLastConnection();
+					DBConnectionActor->ResetLastConnection();
 				}
-				CurrentDBConnectionActor->OnConnectionStateChanged(ConnectionStatus, ConnectionID, ErrorMessage);
+				DBConnectionActor->OnConnectionStateChanged(ConnectionStatus, CurrentConnectionID, ErrorMessage);
 			}
 			
 		});
@@ -56,9 +58,11 @@ void OpenMySQLConnectionTask::DoWork()
 
 
 
-UpdateMySQLQueryAsyncTask::UpdateMySQLQueryAsyncTask(TWeakObjectPtr<AMySQLDBConnectionActor> dbConnectionActor, TWeakObjectPtr<UMySQLDBConnector> dbConnector, int32 connectionID, int32 queryID, TArray<FString> queries)
+UpdateMySQLQueryAsyncTask::UpdateMySQLQueryAsyncTask(TWeakObjectPtr<AMySQLDBConnectionActor> dbConnectionActor, TWeakObjectPtr<UMySQLDBConnector> dbConnector, int32 connectionID, int32 queryID, TArray<FString> queries,
+	bool asTransaction)
 {
-	Queries = queries;
+	Queries = MoveTemp(queries);
+	bAsTransaction = asTransaction;
 	CurrentDBConnectionActor = dbConnectionActor;
 	MySQLDBConnector = dbConnector;
 	ConnectionID = connectionID;
@@ -74,33 +78,59 @@ void UpdateMySQLQueryAsyncTask::DoWork()
 {
 	FString ErrorMessage;
 	bool currentUpdateQueryStatus = false;
-	
-	if (MySQLDBConnector.IsValid() && MySQLDBConnector->IsValidLowLevel())
+
+	if (bAsTransaction)
 	{
-		for (int iIndex = 0; iIndex < Queries.Num(); iIndex++)
+		TArray<EMySQLStatementStatus> StatementStatus;
+		if (MySQLDBConnector.IsValid())
 		{
-			MySQLDBConnector->UpdateDataFromQuery(ConnectionID, QueryID, Queries[iIndex], currentUpdateQueryStatus, ErrorMessage);
+			MySQLDBConnector->UpdateDataInTransaction(ConnectionID, Queries, currentUpdateQueryStatus, ErrorMessage, StatementStatus);
 		}
+		else
+		{
+			ErrorMessage = "InValid Connection";
+			StatementStatus.Init(EMySQLStatementStatus::NotExecuted, Queries.Num());
+		}
+
+		AsyncTask(ENamedThreads::GameThread, [DBConnectionActor = CurrentDBConnectionActor, CurrentConnectionID = ConnectionID, CurrentQueryID = QueryID,
+			currentUpdateQueryStatus, ErrorMessage, StatementStatus = MoveTemp(StatementStatus)]()
+		{
+			if (DBConnectionActor.IsValid() && DBConnectionActor->IsValidLowLevel())
+			{
+				DBConnectionActor->OnTransactionStatusChanged(CurrentConnectionID, CurrentQueryID, currentUpdateQueryStatus, ErrorMessage, StatementStatus);
+				DBConnectionActor->OnQueryTaskFinished(CurrentConnectionID, CurrentQueryID);
+			}
+		});
+		return;
+	}
+	
+	if (MySQLDBConnector.IsValid() && MySQLDBConnector->IsValidLowLevel())
+	{
+		// All queries of the task share one pooled handle so that session state carries over between them
+		MySQLDBConnector->UpdateDataFromQueries(ConnectionID, QueryID, Queries, currentUpdateQueryStatus, ErrorMessage);
 	}
 
-	AsyncTask(ENamedThreads::GameThread, [this, currentUpdateQueryStatus, ErrorMessage]()
+	AsyncTask(ENamedThreads::GameThread, [DBConnectionActor = CurrentDBConnectionActor, CurrentConnectionID = ConnectionID, CurrentQueryID = QueryID,
+		currentUpdateQueryStatus, ErrorMessage]()
 	{
-		if (CurrentDBConnectionActor.IsValid() && CurrentDBConnectionActor->IsValidLowLevel())
+		if (DBConnectionActor.IsValid() && DBConnectionActor->IsValidLowLevel())
 		{
-			CurrentDBConnectionActor->bIsConnectionBusy = false;
-			CurrentDBConnectionActor->OnQueryUpdateStatusChanged(ConnectionID, QueryID, currentUpdateQueryStatus, ErrorMessage);
-			CurrentDBConnectionActor->ExecuteNextQueryTask();
+			DBConnectionActor->OnQueryUpdateStatusChanged(CurrentConnectionID, CurrentQueryID, currentUpdateQueryStatus, ErrorMessage);
+			DBConnectionActor->OnQueryTaskFinished(CurrentConnectionID, CurrentQueryID);
 		}
 	});
 }
 
-SelectMySQLQueryAsyncTask::SelectMySQLQueryAsyncTask(TWeakObjectPtr<AMySQLDBConnectionActor> dbConnectionActor, TWeakObjectPtr<UMySQLDBConnector> dbConnector, int32 connectionID, int32 queryID, FString query)
+SelectMySQLQueryAsyncTask::SelectMySQLQueryAsyncTask(TWeakObjectPtr<AMySQLDBConnectionActor> dbConnectionActor, TWeakObjectPtr<UMySQLDBConnector> dbConnector, int32 connectionID, int32 queryID, FString query,
+	bool buildLegacyArrays, bool keepResultSet)
 {
 	Query = query;
 	CurrentDBConnectionActor = dbConnectionActor;
 	MySQLDBConnector = dbConnector;
 	ConnectionID = connectionID;
 	QueryID = queryID;
+	bBuildLegacyArrays = buildLegacyArrays;
+	bKeepResultSet = keepResultSet;
 }
 
 SelectMySQLQueryAsyncTask::~SelectMySQLQueryAsyncTask()
@@ -113,29 +143,298 @@ void SelectMySQLQueryAsyncTask::DoWork()
 	
 	FString ErrorMessage;
 	bool SelectQueryStatus;
+	FMySQLResultSet Result;
+
+	if (MySQLDBConnector.IsValid())
+	{
+		MySQLDBConnector->SelectResultSet(ConnectionID, Query, SelectQueryStatus, ErrorMessage, Result);
+	}
+	else
+	{
+		ErrorMessage = "InValid Connection";
+		SelectQueryStatus = false;
+	}
+
+	CompleteSelect(CurrentDBConnectionActor, ConnectionID, QueryID, SelectQueryStatus, ErrorMessage, MakeShared<FMySQLResultSet, ESPMode::ThreadSafe>(MoveTemp(Result)),
+		bBuildLegacyArrays, bKeepResultSet);
+}
+
+void SelectMySQLQueryAsyncTask::CompleteSelect(TWeakObjectPtr<AMySQLDBConnectionActor> DBConnectionActor, int32 CurrentConnectionID, int32 CurrentQueryID,
+	bool SelectQueryStatus, const FString& ErrorMessage, FMySQLResultSetPtr ResultSet, bool bBuildLegacyArrays, bool bKeepResultSet)
+{
 	TArray<FMySQLDataTable> ResultByColumn;
 	TArray<FMySQLDataRow> ResultByRow;
+	if (SelectQueryStatus && bBuildLegacyArrays)
+	{
+		ResultSet->ToColumns(ResultByColumn);
+		ResultSet->ToRows(ResultByRow);
+	}
+
+	if (!bKeepResultSet)
+	{
+		ResultSet.Reset();
+	}
+
+	AsyncTask(ENamedThreads::GameThread, [DBConnectionActor, CurrentConnectionID, CurrentQueryID, SelectQueryStatus, ErrorMessage, ResultSet = MoveTemp(ResultSet),
+		ResultByColumn = MoveTemp(ResultByColumn), ResultByRow = MoveTemp(ResultByRow)]()
+	{
+		if (DBConnectionActor.IsValid() && DBConnectionActor->IsValidLowLevel())
+		{
+			UMySQLResult* Result = SelectQueryStatus && ResultSet.IsValid() ? UMySQLResult::Create(DBConnectionActor.Get(), ResultSet) : nullptr;
+			DBConnectionActor->OnQuerySelectResult(CurrentConnectionID, CurrentQueryID, SelectQueryStatus, ErrorMessage, Result);
+			DBConnectionActor->OnQuerySelectStatusChanged(CurrentConnectionID, CurrentQueryID, SelectQueryStatus, ErrorMessage, ResultByColumn, ResultByRow);
+			DBConnectionActor->OnQueryTaskFinished(CurrentConnectionID, CurrentQueryID);
+		}
+	});
+}
+
+
+bool FMySQLChunkFlow::WaitForRoom()
+{
+	unique_lock<mutex> Lock(FlowMutex);
+	ChunkConsumed.wait(Lock, [this] { return bCancelled || PendingChunks < MaxPendingChunks; });
+	return !bCancelled;
+}
+
+void FMySQLChunkFlow::ChunkQueued()
+{
+	lock_guard<mutex> Lock(FlowMutex);
+	PendingChunks++;
+}
+
+void FMySQLChunkFlow::ChunkDelivered()
+{
+	{
+		lock_guard<mutex> Lock(FlowMutex);
+		PendingChunks--;
+	}
+	ChunkConsumed.notify_all();
+}
+
+void FMySQLChunkFlow::Cancel()
+{
+	{
+		lock_guard<mutex> Lock(FlowMutex);
+		bCancelled = true;
+	}
+	ChunkConsumed.notify_all();
+}
+
+
+SelectMySQLQueryChunkedAsyncTask::SelectMySQLQueryChunkedAsyncTask(TWeakObjectPtr<AMySQLDBConnectionActor> dbConnectionActor, TWeakObjectPtr<UMySQLDBConnector> dbConnector,
+	int32 connectionID, int32 queryID, FString query, int32 chunkSize, TSharedRef<FMySQLChunkFlow, ESPMode::ThreadSafe> chunkFlow)
+	: ChunkFlow(chunkFlow)
+{
+	Query = query;
+	CurrentDBConnectionActor = dbConnectionActor;
+	MySQLDBConnector = dbConnector;
+	ConnectionID = connectionID;
+	QueryID = queryID;
+	ChunkSize = chunkSize;
+}
+
+SelectMySQLQueryChunkedAsyncTask::~SelectMySQLQueryChunkedAsyncTask()
+{
+
+}
+
+void SelectMySQLQueryChunkedAsyncTask::DoWork()
+{
+	FString ErrorMessage;
+	bool SelectQueryStatus = false;
+	TArray<FString> ColumnNames;
+	TArray<FMySQLDataRow> LastRows;
+	int32 ChunkIndex = 0;
+
+	// Chunks are moved into the game thread callbacks, which only hold weak references and
+	// shared state, so nothing here has to outlive the task
+	const TWeakObjectPtr<AMySQLDBConnectionActor> DBConnectionActor = CurrentDBConnectionActor;
+	const int32 CurrentConnectionID = ConnectionID;
+	const int32 CurrentQueryID = QueryID;
+	const TSharedRef<FMySQLChunkFlow, ESPMode::ThreadSafe> Flow = ChunkFlow;
+
+	auto DeliverChunk = [&](const TArray<FString>& ChunkColumnNames, TArray<FMySQLDataRow>& Rows)
+	{
+		if (!Flow->WaitForRoom())
+		{
+			return false;
+		}
+
+		Flow->ChunkQueued();
+		AsyncTask(ENamedThreads::GameThread, [DBConnectionActor, Flow, CurrentConnectionID, CurrentQueryID, Index = ChunkIndex++, ChunkColumnNames,
+			ChunkRows = MoveTemp(Rows)]()
+		{
+			if (DBConnectionActor.IsValid() && DBConnectionActor->IsValidLowLevel())
+			{
+				DBConnectionActor->OnQuerySelectChunk(CurrentConnectionID, CurrentQueryID, Index, ChunkColumnNames, ChunkRows, false, true, FString());
+			}
+			else
+			{
+				Flow->Cancel();
+			}
+			Flow->ChunkDelivered();
+		});
+		return true;
+	};
 
 	if (MySQLDBConnector.IsValid())
 	{
-		MySQLDBConnector->SelectDataFromQuery(ConnectionID, Query, SelectQueryStatus, ErrorMessage, ResultByColumn, ResultByRow);
+		MySQLDBConnector->SelectDataInChunks(ConnectionID, Query, ChunkSize, DeliverChunk, SelectQueryStatus, ErrorMessage, ColumnNames, LastRows);
 	}
 	else
 	{
 		ErrorMessage = "InValid Connection";
-		SelectQueryStatus = false;
 	}
 
-	AsyncTask(ENamedThreads::GameThread, [this, SelectQueryStatus, ErrorMessage, ResultByColumn, ResultByRow]()
+	AsyncTask(ENamedThreads::GameThread, [DBConnectionActor, CurrentConnectionID, CurrentQueryID, Index = ChunkIndex, SelectQueryStatus, ErrorMessage,
+		ColumnNames = MoveTemp(ColumnNames), LastRows = MoveTemp(LastRows)]()
 	{
-		if (CurrentDBConnectionActor.IsValid() && CurrentDBConnectionActor->IsValidLowLevel())
+		if (DBConnectionActor.IsValid() && DBConnectionActor->IsValidLowLevel())
 		{
-			CurrentDBConnectionActor->bIsConnectionBusy = false;
-			CurrentDBConnectionActor->OnQuerySelectStatusChanged(ConnectionID, QueryID, SelectQueryStatus, ErrorMessage, ResultByColumn, ResultByRow);
-			CurrentDBConnectionActor->ExecuteNextQueryTask();
+			DBConnectionActor->OnQuerySelectChunk(CurrentConnectionID, CurrentQueryID, Index, ColumnNames, LastRows, true, SelectQueryStatus, ErrorMessage);
+			DBConnectionActor->OnQueryTaskFinished(CurrentConnectionID, CurrentQueryID);
+		}
+	});
+}
+
+
+PrepareMySQLStatementAsyncTask::PrepareMySQLStatementAsyncTask(TWeakObjectPtr<AMySQLDBConnectionActor> dbConnectionActor, TWeakObjectPtr<UMySQLDBConnector> dbConnector,
+	int32 connectionID, int32 queryID, int32 statementID, FString query)
+{
+	Query = query;
+	CurrentDBConnectionActor = dbConnectionActor;
+	MySQLDBConnector = dbConnector;
+	ConnectionID = connectionID;
+	QueryID = queryID;
+	StatementID = statementID;
+}
+
+PrepareMySQLStatementAsyncTask::~PrepareMySQLStatementAsyncTask()
+{
+
+}
+
+void PrepareMySQLStatementAsyncTask::DoWork()
+{
+	FString ErrorMessage;
+	bool PrepareStatus = false;
+	int32 ParameterCount = 0;
+
+	if (MySQLDBConnector.IsValid())
+	{
+		MySQLDBConnector->PrepareStatement(ConnectionID, Query, ParameterCount, PrepareStatus, ErrorMessage);
+	}
+	else
+	{
+		ErrorMessage = "InValid Connection";
+	}
+
+	AsyncTask(ENamedThreads::GameThread, [DBConnectionActor = CurrentDBConnectionActor, CurrentConnectionID = ConnectionID, CurrentQueryID = QueryID,
+		CurrentStatementID = StatementID, PrepareStatus, ErrorMessage, ParameterCount]()
+	{
+		if (DBConnectionActor.IsValid() && DBConnectionActor->IsValidLowLevel())
+		{
+			DBConnectionActor->OnStatementPrepared(CurrentConnectionID, CurrentQueryID, CurrentStatementID, PrepareStatus, ErrorMessage, ParameterCount);
+			DBConnectionActor->OnQueryTaskFinished(CurrentConnectionID, CurrentQueryID);
+		}
+	});
+}
+
+
+ExecuteMySQLStatementAsyncTask::ExecuteMySQLStatementAsyncTask(TWeakObjectPtr<AMySQLDBConnectionActor> dbConnectionActor, TWeakObjectPtr<UMySQLDBConnector> dbConnector,
+	int32 connectionID, int32 queryID, int32 statementID, FString query, TArray<FMySQLParameter> parameters)
+{
+	Query = query;
+	Parameters = MoveTemp(parameters);
+	CurrentDBConnectionActor = dbConnectionActor;
+	MySQLDBConnector = dbConnector;
+	ConnectionID = connectionID;
+	QueryID = queryID;
+	StatementID = statementID;
+}
+
+ExecuteMySQLStatementAsyncTask::~ExecuteMySQLStatementAsyncTask()
+{
+
+}
+
+void ExecuteMySQLStatementAsyncTask::DoWork()
+{
+	FString ErrorMessage;
+	bool ExecuteStatus = false;
+	int64 AffectedRows = 0;
+	FMySQLResultSet Result;
+
+	if (MySQLDBConnector.IsValid())
+	{
+		MySQLDBConnector->ExecuteStatement(ConnectionID, Query, Parameters, ExecuteStatus, ErrorMessage, Result, AffectedRows);
+	}
+	else
+	{
+		ErrorMessage = "InValid Connection";
+	}
+
+	FMySQLResultSetPtr ResultSet = MakeShared<FMySQLResultSet, ESPMode::ThreadSafe>(MoveTemp(Result));
+
+	AsyncTask(ENamedThreads::GameThread, [DBConnectionActor = CurrentDBConnectionActor, CurrentConnectionID = ConnectionID, CurrentQueryID = QueryID,
+		CurrentStatementID = StatementID, ExecuteStatus, ErrorMessage, AffectedRows, ResultSet = MoveTemp(ResultSet)]()
+	{
+		if (DBConnectionActor.IsValid() && DBConnectionActor->IsValidLowLevel())
+		{
+			// Statements without rows have no columns and get no result object
+			UMySQLResult* StatementResult = ExecuteStatus && ResultSet->GetNumColumns() > 0 ? UMySQLResult::Create(DBConnectionActor.Get(), ResultSet) : nullptr;
+			DBConnectionActor->OnStatementExecuted(CurrentConnectionID, CurrentQueryID, CurrentStatementID, ExecuteStatus, ErrorMessage, AffectedRows, StatementResult);
+			DBConnectionActor->OnQueryTaskFinished(CurrentConnectionID, CurrentQueryID);
+		}
+	});
+}
+
+
+ExecuteMySQLBatchAsyncTask::ExecuteMySQLBatchAsyncTask(TWeakObjectPtr<AMySQLDBConnectionActor> dbConnectionActor, TWeakObjectPtr<UMySQLDBConnector> dbConnector,
+	int32 connectionID, int32 queryID, FString query, TArray<FMySQLParameterColumn> columns, bool allOrNothing)
+{
+	Query = query;
+	Columns = MoveTemp(columns);
+	bAllOrNothing = allOrNothing;
+	CurrentDBConnectionActor = dbConnectionActor;
+	MySQLDBConnector = dbConnector;
+	ConnectionID = connectionID;
+	QueryID = queryID;
+}
+
+ExecuteMySQLBatchAsyncTask::~ExecuteMySQLBatchAsyncTask()
+{
+
+}
+
+void ExecuteMySQLBatchAsyncTask::DoWork()
+{
+	FString ErrorMessage;
+	bool BatchStatus = false;
+	int64 AffectedRows = 0;
+	TArray<FMySQLBatchRowError> FailedRows;
+
+	if (MySQLDBConnector.IsValid())
+	{
+		MySQLDBConnector->ExecuteBatch(ConnectionID, Query, Columns, bAllOrNothing, BatchStatus, ErrorMessage, AffectedRows, FailedRows);
+	}
+	else
+	{
+		ErrorMessage = "InValid Connection";
+	}
+
+	// The parameters are not needed any more, and may be large
+	Columns.Empty();
+
+	AsyncTask(ENamedThreads::GameThread, [DBConnectionActor = CurrentDBConnectionActor, CurrentConnectionID = ConnectionID, CurrentQueryID = QueryID,
+		BatchStatus, ErrorMessage, AffectedRows, FailedRows = MoveTemp(FailedRows)]()
+	{
+		if (DBConnectionActor.IsValid() && DBConnectionActor->IsValidLowLevel())
+		{
+			DBConnectionActor->OnBatchExecuted(CurrentConnectionID, CurrentQueryID, BatchStatus, ErrorMessage, AffectedRows, FailedRows);
+			DBConnectionActor->OnQueryTaskFinished(CurrentConnectionID, CurrentQueryID);
 		}
 	});
-	
 }
 
 
@@ -172,12 +471,77 @@ void UpdateMySQLImageAsyncTask::DoWork()
 		UpdateQueryStatus = false;
 	}
 	
-	AsyncTask(ENamedThreads::GameThread, [this, UpdateQueryStatus, ErrorMessage]()
+	AsyncTask(ENamedThreads::GameThread, [DBConnectionActor = CurrentDBConnectionActor, CurrentConnectionID = ConnectionID, CurrentQueryID = QueryID,
+		UpdateQueryStatus, ErrorMessage]()
+		{
+			if (DBConnectionActor.IsValid() && DBConnectionActor->IsValidLowLevel())
+			{
+				DBConnectionActor->OnImageUpdateStatusChanged(CurrentConnectionID, CurrentQueryID, UpdateQueryStatus, ErrorMessage);
+				DBConnectionActor->OnQueryTaskFinished(CurrentConnectionID, CurrentQueryID);
+			}
+
+		});
+}
+
+
+UpdateMySQLTextureAsyncTask::UpdateMySQLTextureAsyncTask(TWeakObjectPtr<AMySQLDBConnectionActor> dbConnectionActor, TWeakObjectPtr<UMySQLDBConnector> dbConnector, int32 connectionID, int32 queryID, FString query, FString updateParameter, int parameterID, FMySQLTextureReader readImage)
+{
+	Query = query;
+	UpdateParameter = updateParameter;
+	ParameterID = parameterID;
+	ReadImage = MoveTemp(readImage);
+	CurrentDBConnectionActor = dbConnectionActor;
+	MySQLDBConnector = dbConnector;
+	ConnectionID = connectionID;
+	QueryID = queryID;
+
+}
+
+UpdateMySQLTextureAsyncTask::~UpdateMySQLTextureAsyncTask()
+{
+
+}
+
+void UpdateMySQLTextureAsyncTask::DoWork()
+{
+	bool UpdateQueryStatus = false;
+	FString ErrorMessage;
+
+	// The pixels are converted here, next to the encode, rather than on the game thread
+	TUniquePtr<FMySQLDecodedImage> Image = ReadImage();
+
+	// PNG keeps the pixels exactly as they were read
+	TArray64<uint8> ImageData;
+	FMySQLImageInfo ImageInfo;
+	ImageInfo.Format = EImageFormat::PNG;
+	ImageInfo.Width = Image.IsValid() ? Image->Width : 0;
+	ImageInfo.Height = Image.IsValid() ? Image->Height : 0;
+
+	if (!MySQLDBConnector.IsValid())
+	{
+		ErrorMessage = "InValid Connection";
+	}
+	else if (!Image.IsValid())
+	{
+		ErrorMessage = "The texture pixels could not be read";
+	}
+	else if (!UMySQLBPLibrary::EncodeImage(*Image, ImageInfo.Format, ImageData))
+	{
+		ErrorMessage = "The texture could not be encoded as PNG";
+	}
+	else
+	{
+		Image.Reset();
+		MySQLDBConnector->UpdateImageFromData(ConnectionID, QueryID, Query, UpdateParameter, ParameterID, ImageData, ImageInfo, UpdateQueryStatus, ErrorMessage);
+	}
+	
+	AsyncTask(ENamedThreads::GameThread, [DBConnectionActor = CurrentDBConnectionActor, CurrentConnectionID = ConnectionID, CurrentQueryID = QueryID,
+		UpdateQueryStatus, ErrorMessage]()
 		{
-			if (CurrentDBConnectionActor.IsValid() && CurrentDBConnectionActor->IsValidLowLevel())
+			if (DBConnectionActor.IsValid() && DBConnectionActor->IsValidLowLevel())
 			{
-				CurrentDBConnectionActor->bIsConnectionBusy = false;
-				CurrentDBConnectionActor->OnImageUpdateStatusChanged(ConnectionID, QueryID, UpdateQueryStatus, ErrorMessage);
+				DBConnectionActor->OnImageUpdateStatusChanged(CurrentConnectionID, CurrentQueryID, UpdateQueryStatus, ErrorMessage);
+				DBConnectionActor->OnQueryTaskFinished(CurrentConnectionID, CurrentQueryID);
 			}
 
 		});
@@ -204,11 +568,12 @@ void SelectMySQLImageAsyncTask::DoWork()
 {
 	bool SelectQueryStatus;
 	FString ErrorMessage;
-	UTexture2D* SelectedTexture = nullptr;
+	TUniquePtr<FMySQLDecodedImage> Image = MakeUnique<FMySQLDecodedImage>();
 
+	// Fetching and decoding happen here; UObjects can only be created on the game thread
 	if (MySQLDBConnector.IsValid())
 	{
-		SelectedTexture = MySQLDBConnector->SelectImageFromQuery(ConnectionID, QueryID, Query, SelectQueryStatus, ErrorMessage);
+		MySQLDBConnector->SelectImageFromQuery(ConnectionID, QueryID, Query, *Image, SelectQueryStatus, ErrorMessage);
 	}
 	else
 	{
@@ -216,12 +581,14 @@ void SelectMySQLImageAsyncTask::DoWork()
 		SelectQueryStatus = false;
 	}
 	
-	AsyncTask(ENamedThreads::GameThread, [this, SelectQueryStatus, ErrorMessage, SelectedTexture]()
+	AsyncTask(ENamedThreads::GameThread, [DBConnectionActor = CurrentDBConnectionActor, CurrentConnectionID = ConnectionID, CurrentQueryID = QueryID,
+		SelectQueryStatus, ErrorMessage, Image = MoveTemp(Image)]() mutable
 		{
-			if (CurrentDBConnectionActor.IsValid() && CurrentDBConnectionActor->IsValidLowLevel())
+			if (DBConnectionActor.IsValid() && DBConnectionActor->IsValidLowLevel())
 			{
-				CurrentDBConnectionActor->bIsConnectionBusy = false;
-				CurrentDBConnectionActor->OnImageSelectStatusChanged(ConnectionID, QueryID, SelectQueryStatus, ErrorMessage, SelectedTexture);
+				UTexture2D* SelectedTexture = SelectQueryStatus ? UMySQLBPLibrary::CreateTextureFromImage(MoveTemp(Image)) : nullptr;
+				DBConnectionActor->OnImageSelectStatusChanged(CurrentConnectionID, CurrentQueryID, SelectQueryStatus, ErrorMessage, SelectedTexture);
+				DBConnectionActor->OnQueryTaskFinished(CurrentConnectionID, CurrentQueryID);
 			}
 		});
 
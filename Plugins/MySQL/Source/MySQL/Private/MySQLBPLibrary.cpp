@@ -4,144 +4,288 @@
 #include "MySQLBPLibrary.h"
 #include "Misc/Paths.h"
 #include "Misc/FileHelper.h"
+#include "HAL/FileManager.h"
 #include "TextureResource.h"
 #include "RenderingThread.h"
+#include "RHICommandList.h"
+#include "ImageCore.h"
+#include "ImageCoreUtils.h"
+#include "RHIGPUReadback.h"
+#include "Containers/Ticker.h"
 #include "Templates/SharedPointer.h"
 #include "IImageWrapperModule.h"
 #include "IImageWrapper.h"
 
 IImageWrapperModule* ImageWrapperModule = nullptr;
 
-void UMySQLBPLibrary::GetTexturePixels(UTexture2D* Texture, TArray<FColor>& OutPixels)
+bool UMySQLBPLibrary::DecodeImage(const uint8* ImageData, int64 Length, EImageFormat Format, FMySQLDecodedImage& OutImage)
 {
-	OutPixels.Reset();
+	if (!ImageWrapperModule || Length <= 0)
+	{
+		return false;
+	}
 
-	ENQUEUE_RENDER_COMMAND(FSaveMySQLImageResource)(
-		[OutPixels, Texture](FRHICommandListImmediate& RHICmdList)
-		{
-			TArray<FColor> OutData = OutPixels;
-			FTextureResource* TextureResource = Texture->GetResource();
-			FTexture2DRHIRef Texture2DRHIRef = TextureResource->TextureRHI->GetTexture2D();
-
-			FIntRect Rect = FIntRect(0, 0, Texture->GetImportedSize().X, Texture->GetImportedSize().Y);
-			FReadSurfaceDataFlags Flags = FReadSurfaceDataFlags(RCM_UNorm, CubeFace_MAX);
-
-			RHICmdList.ReadSurfaceData(
-				Texture2DRHIRef,
-				Rect,
-				OutData,
-				Flags
-			);
-		});
+	if (Format == EImageFormat::Invalid)
+	{
+		Format = ImageWrapperModule->DetectFormat(ImageData, Length);
+	}
+
+	TSharedPtr<IImageWrapper> ImageWrapper = Format != EImageFormat::Invalid ? ImageWrapperModule->CreateImageWrapper(Format) : nullptr;
+	if (!ImageWrapper.IsValid() || !ImageWrapper->SetCompressed(ImageData, Length))
+	{
+		return false;
+	}
+
+	OutImage.Width = static_cast<int32>(ImageWrapper->GetWidth());
+	OutImage.Height = static_cast<int32>(ImageWrapper->GetHeight());
+	return ImageWrapper->GetRaw(ERGBFormat::BGRA, 8, OutImage.Pixels) && OutImage.Pixels.Num() == int64(OutImage.Width) * OutImage.Height * 4;
 }
 
+UTexture2D* UMySQLBPLibrary::CreateTextureFromImage(TUniquePtr<FMySQLDecodedImage> Image)
+{
+	check(IsInGameThread());
+
+	if (!Image.IsValid() || Image->Width <= 0 || Image->Height <= 0)
+	{
+		return nullptr;
+	}
 
-UTexture2D* UMySQLBPLibrary::LoadTexturefromCharData(char* ImageChar)
+	UTexture2D* Texture = UTexture2D::CreateTransient(Image->Width, Image->Height, PF_B8G8R8A8);
+	if (!Texture)
+	{
+		return nullptr;
+	}
+	Texture->UpdateResource();
+	if (!Texture->GetResource())
+	{
+		return Texture;
+	}
+
+	// The render command owns the pixels and the region until it has copied them
+	FUpdateTextureRegion2D* Region = new FUpdateTextureRegion2D(0, 0, 0, 0, Image->Width, Image->Height);
+	const uint32 SourcePitch = Image->Width * 4;
+	uint8* SourceData = Image->Pixels.GetData();
+	Texture->UpdateTextureRegions(0, 1, Region, SourcePitch, 4, SourceData, [PendingImage = Image.Release()](uint8*, const FUpdateTextureRegion2D* Regions)
+	{
+		delete PendingImage;
+		delete Regions;
+	});
+
+	return Texture;
+}
+
+static FCriticalSection ImageBufferMutex;
+static TArray<TArray<uint8>> ImageBuffers;
+static constexpr int32 MaxPooledImageBuffers = 4;
+static constexpr SIZE_T MaxPooledImageBufferBytes = 64 * 1024 * 1024;
+
+TArray<uint8> UMySQLBPLibrary::AcquireImageBuffer()
 {
-	CreateImageWrapperModule();
+	FScopeLock Lock(&ImageBufferMutex);
+	return ImageBuffers.Num() > 0 ? ImageBuffers.Pop(EAllowShrinking::No) : TArray<uint8>();
+}
 
-	if (ImageWrapperModule)
+void UMySQLBPLibrary::ReleaseImageBuffer(TArray<uint8>&& Buffer)
+{
+	// Buffers of unusually large images are not kept around
+	Buffer.Reset();
+	if (Buffer.GetAllocatedSize() == 0 || Buffer.GetAllocatedSize() > MaxPooledImageBufferBytes)
 	{
-		TSharedPtr<IImageWrapper> ImageWrapper = ImageWrapperModule->CreateImageWrapper(EImageFormat::PNG);
+		return;
+	}
+
+	FScopeLock Lock(&ImageBufferMutex);
+	if (ImageBuffers.Num() < MaxPooledImageBuffers)
+	{
+		ImageBuffers.Add(MoveTemp(Buffer));
+	}
+}
 
-		int length = reinterpret_cast<size_t>(ImageChar);
-		TArray<uint8> CompressedImageData;
-		CompressedImageData.AddUninitialized(length);
+bool UMySQLBPLibrary::EncodeImage(const FMySQLDecodedImage& Image, EImageFormat Format, TArray64<uint8>& OutData)
+{
+	OutData.Reset();
+	TSharedPtr<IImageWrapper> ImageWrapper = ImageWrapperModule ? ImageWrapperModule->CreateImageWrapper(Format) : nullptr;
+	if (!ImageWrapper.IsValid() || !ImageWrapper->SetRaw(Image.Pixels.GetData(), Image.Pixels.Num(), Image.Width, Image.Height, ERGBFormat::BGRA, 8))
+	{
+		return false;
+	}
 
-		for (int i = 0; i < length; i++)
+	OutData = ImageWrapper->GetCompressed();
+	return OutData.Num() > 0;
+}
+
+// 8 bit images keep their gamma; float images are converted to sRGB
+static TUniquePtr<FMySQLDecodedImage> ToDecodedImage(const FImageView& SourceImage)
+{
+	FImage BGRAImage;
+	SourceImage.CopyTo(BGRAImage, ERawImageFormat::BGRA8, ERawImageFormat::IsHDR(SourceImage.Format) ? EGammaSpace::sRGB : SourceImage.GammaSpace);
+
+	TUniquePtr<FMySQLDecodedImage> Image = MakeUnique<FMySQLDecodedImage>();
+	Image->Width = BGRAImage.SizeX;
+	Image->Height = BGRAImage.SizeY;
+	Image->Pixels = MoveTemp(BGRAImage.RawData);
+	return Image;
+}
+
+// A GPU copy of mip 0 in flight. It is only touched on the render thread once the copy is enqueued
+struct FMySQLTextureReadback
+{
+	TUniquePtr<FRHIGPUTextureReadback> Readback;
+	ERawImageFormat::Type RawFormat = ERawImageFormat::BGRA8;
+	EGammaSpace GammaSpace = EGammaSpace::sRGB;
+	FIntPoint Size = FIntPoint::ZeroValue;
+	TFunction<void(FMySQLTextureReader Reader)> OnRead;
+};
+
+typedef TSharedRef<FMySQLTextureReadback, ESPMode::ThreadSafe> FMySQLTextureReadbackRef;
+
+static void FinishTextureReadback(FMySQLTextureReadback& State)
+{
+	FMySQLTextureReader Reader;
+	int32 RowPitchInPixels = 0;
+	if (const uint8* Data = static_cast<const uint8*>(State.Readback->Lock(RowPitchInPixels)))
+	{
+		// Only the rows are copied here; the conversion runs on the reader's thread
+		FImage Image(State.Size.X, State.Size.Y, State.RawFormat, State.GammaSpace);
+		const int64 BytesPerPixel = Image.GetBytesPerPixel();
+		const int64 RowBytes = BytesPerPixel * State.Size.X;
+		for (int32 Row = 0; Row < State.Size.Y; Row++)
 		{
-			CompressedImageData[i] = ImageChar[i];
+			FMemory::Memcpy(Image.RawData.GetData() + Row * RowBytes, Data + static_cast<int64>(Row) * RowPitchInPixels * BytesPerPixel, RowBytes);
 		}
+		State.Readback->Unlock();
 
-		if (ImageWrapper.IsValid() && ImageWrapper->SetCompressed(CompressedImageData.GetData(),
-		                                                          CompressedImageData.Num()))
+		Reader = [Image = MoveTemp(Image)]()
 		{
-			TArray<uint8> UncompressedBGRA;
-			if (ImageWrapper->GetRaw(ERGBFormat::BGRA, 8, UncompressedBGRA))
-			{
-				if (UTexture2D* Texture = UTexture2D::CreateTransient(ImageWrapper->GetWidth(),
-				                                                      ImageWrapper->GetHeight(), PF_B8G8R8A8))
-				{
-					void* TextureData = Texture->GetPlatformData()->Mips[0].BulkData.Lock(LOCK_READ_WRITE);
-					FMemory::Memcpy(TextureData, UncompressedBGRA.GetData(), UncompressedBGRA.Num());
-					Texture->GetPlatformData()->Mips[0].BulkData.Unlock();
-
-					Texture->UpdateResource();
-					return Texture;
-				}
-			}
-		}
+			return ToDecodedImage(Image);
+		};
 	}
 
-	return nullptr;
+	// The staging texture is released here on the render thread, not by whichever thread drops the last reference
+	State.Readback.Reset();
+	State.OnRead(MoveTemp(Reader));
 }
 
-char* UMySQLBPLibrary::GetCharFromTextureData(UTexture2D* Texture, FString Path)
+// Checks the copy once per tick instead of blocking the render thread until the GPU has caught up
+static void PollTextureReadbackNextTick(FMySQLTextureReadbackRef State)
 {
-	FVector2D ImageSize = FVector2D(Texture->GetSurfaceWidth(), Texture->GetSurfaceHeight());
-	char* imagebytes = new char[ImageSize.X * ImageSize.Y * 4];
+	FTSTicker::GetCoreTicker().AddTicker(TEXT("MySQLTextureReadback"), 0.0f, [State](float)
+	{
+		ENQUEUE_RENDER_COMMAND(PollMySQLTextureReadback)([State](FRHICommandListImmediate&)
+		{
+			if (State->Readback->IsReady())
+			{
+				FinishTextureReadback(*State);
+			}
+			else
+			{
+				PollTextureReadbackNextTick(State);
+			}
+		});
+		return false;
+	});
+}
 
+// bWaitForGPU is for callers that need the pixels before they return and stall the GPU for them anyway
+static void ReadTexture(UTexture2D* Texture, TFunction<void(FMySQLTextureReader Reader)> OnRead, bool bWaitForGPU)
+{
+	check(IsInGameThread());
 
-	if (Texture->GetPlatformData()->Mips.Num() > 0)
+	if (!Texture)
 	{
-		TextureCompressionSettings OldCompressionSettings = Texture->CompressionSettings;
-#if WITH_EDITORONLY_DATA
-		TextureMipGenSettings OldMipGenSettings = Texture->MipGenSettings;
-#endif
-		bool OldSRGB = Texture->SRGB;
+		OnRead(nullptr);
+		return;
+	}
 
-		Texture->CompressionSettings = TextureCompressionSettings::TC_VectorDisplacementmap;
 #if WITH_EDITORONLY_DATA
-		Texture->MipGenSettings = TextureMipGenSettings::TMGS_NoMipmaps;
+	if (Texture->Source.IsValid())
+	{
+		// The torn off copy shares the source bulk data, so the reader can decompress it on any thread
+		OnRead([Source = Texture->Source.CopyTornOff()]() mutable -> TUniquePtr<FMySQLDecodedImage>
+		{
+			FImage SourceImage;
+			return Source.GetMipImage(SourceImage, 0, 0, 0) ? ToDecodedImage(SourceImage) : nullptr;
+		});
+		return;
+	}
 #endif
 
-		Texture->SRGB = false;
-		Texture->UpdateResource();
+	// Cooked and transient textures only have their GPU copy in full
+	FTextureResource* TextureResource = Texture->GetResource();
+	if (!TextureResource)
+	{
+		OnRead(nullptr);
+		return;
+	}
 
-		FTexture2DMipMap* Mip = &Texture->GetPlatformData()->Mips[0];
-		uint8* TextureData = static_cast<uint8*>(Mip->BulkData.Lock(LOCK_READ_WRITE));
+	const EPixelFormat PixelFormat = Texture->GetPixelFormat();
+	bool bIsExactFormat = false;
+	const ERawImageFormat::Type RawFormat = FImageCoreUtils::GetRawImageFormatForPixelFormat(PixelFormat, &bIsExactFormat);
+	if (GPixelFormats[PixelFormat].BlockSizeX > 1 || !bIsExactFormat)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Cannot read the pixels of %s: its GPU format %s is block compressed or has no matching image format"),
+			*Texture->GetName(), GPixelFormats[PixelFormat].Name);
+		OnRead(nullptr);
+		return;
+	}
 
+	FMySQLTextureReadbackRef State = MakeShared<FMySQLTextureReadback, ESPMode::ThreadSafe>();
+	State->RawFormat = RawFormat;
+	State->GammaSpace = Texture->SRGB && ERawImageFormat::GetFormatNeedsGammaSpace(RawFormat) ? EGammaSpace::sRGB : EGammaSpace::Linear;
+	State->OnRead = MoveTemp(OnRead);
 
-		for (int i = 0; i < (ImageSize.X * ImageSize.Y); i += 4)
+	// The resource is released by a render command queued after this one, so it outlives the copy
+	ENQUEUE_RENDER_COMMAND(ReadMySQLTexturePixels)([TextureResource, State, bWaitForGPU](FRHICommandListImmediate& RHICmdList)
+	{
+		FRHITexture* TextureRHI = TextureResource->GetTexture2DRHI();
+		if (!TextureRHI)
 		{
-			imagebytes[i] = TextureData[i];
-			imagebytes[i + 1] = TextureData[i + 1];
-			imagebytes[i + 2] = TextureData[i + 2];
-			imagebytes[i + 3] = TextureData[i + 3];
+			State->OnRead(nullptr);
+			return;
 		}
 
+		State->Size = TextureRHI->GetSizeXY();
+		State->Readback = MakeUnique<FRHIGPUTextureReadback>(TEXT("MySQLTextureReadback"));
+		State->Readback->EnqueueCopy(RHICmdList, TextureRHI);
 
-		TArray<FColor> OutPixels;
-		GetTexturePixels(Texture, OutPixels);
-
-
-		Texture->CompressionSettings = OldCompressionSettings;
-#if WITH_EDITORONLY_DATA
-		Texture->MipGenSettings = OldMipGenSettings;
-#endif
-		Texture->SRGB = OldSRGB;
-
-		Mip->BulkData.Unlock();
-		Texture->UpdateResource();
-	}
+		if (bWaitForGPU)
+		{
+			RHICmdList.SubmitCommandsAndFlushGPU();
+			RHICmdList.BlockUntilGPUIdle();
+			FinishTextureReadback(*State);
+		}
+		else
+		{
+			PollTextureReadbackNextTick(State);
+		}
+	});
+}
 
-	return imagebytes;
+void UMySQLBPLibrary::ReadTexturePixels(UTexture2D* Texture, TFunction<void(FMySQLTextureReader Reader)> OnRead)
+{
+	ReadTexture(Texture, MoveTemp(OnRead), false);
 }
 
 
 bool UMySQLBPLibrary::SaveTextureToPath(UTexture2D* Texture, const FString Path)
 {
-	if (Texture && FPaths::ValidatePath(Path))
+	if (!Texture || !FPaths::ValidatePath(Path))
 	{
-		FVector2D ImageSize = FVector2D(Texture->GetSurfaceWidth(), Texture->GetSurfaceHeight());
-
-		if (char* imagebytes = GetCharFromTextureData(Texture, Path))
-		{
-			char* path = TCHAR_TO_ANSI(*Path);
-			return false;
-		}
+		return false;
 	}
-	return false;
+
+	CreateImageWrapperModule();
+	FMySQLTextureReader Reader;
+	ReadTexture(Texture, [&Reader](FMySQLTextureReader ReadImage)
+	{
+		Reader = MoveTemp(ReadImage);
+	}, true);
+	FlushRenderingCommands();
+
+	const TUniquePtr<FMySQLDecodedImage> Image = Reader ? Reader() : nullptr;
+	const EImageFormat Format = GetImageFormatFromName(FPaths::GetExtension(Path)) == EImageFormat::JPEG ? EImageFormat::JPEG : EImageFormat::PNG;
+	TArray64<uint8> ImageData;
+	return Image.IsValid() && EncodeImage(*Image, Format, ImageData) && FFileHelper::SaveArrayToFile(ImageData, *Path);
 }
 
 
@@ -153,47 +297,90 @@ void UMySQLBPLibrary::CreateImageWrapperModule()
 	}
 }
 
-char* UMySQLBPLibrary::GetRawImageFromPath(FString ImagePath)
+bool UMySQLBPLibrary::GetImageInfoFromPath(const FString& ImagePath, FMySQLImageInfo& OutInfo)
 {
-	CreateImageWrapperModule();
-	void* imagebytes = nullptr;
-	if (ImageWrapperModule)
+	OutInfo = FMySQLImageInfo();
+	TUniquePtr<FArchive> Reader(IFileManager::Get().CreateFileReader(*ImagePath));
+	if (!Reader)
 	{
-		FString Extension = FPaths::GetExtension(ImagePath);
-		EImageFormat ImageFormat;
+		return false;
+	}
 
-		if (Extension.Equals("jpeg", ESearchCase::IgnoreCase) || Extension.Equals("jpg", ESearchCase::IgnoreCase))
-		{
-			ImageFormat = EImageFormat::JPEG;
-		}
-		else if (Extension.Equals("png", ESearchCase::IgnoreCase))
-		{
-			ImageFormat = EImageFormat::PNG;
-		}
-		else
-		{
-			ImageFormat = EImageFormat::BMP;
-		}
+	const int64 FileSize = Reader->TotalSize();
+	uint8 Header[26] = {};
+	const int64 HeaderSize = FMath::Min<int64>(FileSize, sizeof(Header));
+	Reader->Serialize(Header, HeaderSize);
 
-		TSharedPtr<IImageWrapper> ImageWrapper = ImageWrapperModule->CreateImageWrapper(ImageFormat);
+	auto ReadBigEndian16 = [](const uint8* Bytes) { return static_cast<int32>((Bytes[0] << 8) | Bytes[1]); };
+	auto ReadBigEndian32 = [](const uint8* Bytes) { return static_cast<int32>((Bytes[0] << 24) | (Bytes[1] << 16) | (Bytes[2] << 8) | Bytes[3]); };
+	auto ReadLittleEndian32 = [](const uint8* Bytes) { return static_cast<int32>(Bytes[0] | (Bytes[1] << 8) | (Bytes[2] << 16) | (Bytes[3] << 24)); };
 
-		TArray<uint8> RawFileData;
-		if (FFileHelper::LoadFileToArray(RawFileData, *ImagePath))
+	static const uint8 PngSignature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	if (HeaderSize >= 24 && FMemory::Memcmp(Header, PngSignature, sizeof(PngSignature)) == 0)
+	{
+		// IHDR is always the first chunk
+		OutInfo.Format = EImageFormat::PNG;
+		OutInfo.Width = ReadBigEndian32(Header + 16);
+		OutInfo.Height = ReadBigEndian32(Header + 20);
+	}
+	else if (HeaderSize >= 26 && Header[0] == 'B' && Header[1] == 'M')
+	{
+		OutInfo.Format = EImageFormat::BMP;
+		OutInfo.Width = ReadLittleEndian32(Header + 18);
+		OutInfo.Height = FMath::Abs(ReadLittleEndian32(Header + 22));
+	}
+	else if (HeaderSize >= 4 && Header[0] == 0xFF && Header[1] == 0xD8)
+	{
+		// The size is in the start of frame segment, found by skipping the segments before it
+		int64 Offset = 2;
+		uint8 Segment[9];
+		while (Offset + 4 <= FileSize)
 		{
-			if (ImageWrapper.IsValid() && ImageWrapper->SetCompressed(RawFileData.GetData(), RawFileData.Num()))
+			Reader->Seek(Offset);
+			Reader->Serialize(Segment, FMath::Min<int64>(sizeof(Segment), FileSize - Offset));
+			if (Reader->IsError() || Segment[0] != 0xFF)
 			{
-				TArray<uint8> UncompressedBGRA;
-				if (ImageWrapper->GetRaw(ERGBFormat::BGRA, 8, UncompressedBGRA))
-				{
-					const int64 RawNum = UncompressedBGRA.Num();
-					imagebytes = FMemory::Malloc(RawNum);
-					FMemory::Memcpy(imagebytes, UncompressedBGRA.GetData(), RawNum);
-				}
+				break;
 			}
+
+			const uint8 Marker = Segment[1];
+			if (Marker == 0xFF || Marker == 0x01 || (Marker >= 0xD0 && Marker <= 0xD7))
+			{
+				// Fill byte or a marker without a segment
+				Offset += Marker == 0xFF ? 1 : 2;
+				continue;
+			}
+
+			const bool bStartOfFrame = Marker >= 0xC0 && Marker <= 0xCF && Marker != 0xC4 && Marker != 0xC8 && Marker != 0xCC;
+			if (bStartOfFrame && Offset + 9 <= FileSize)
+			{
+				OutInfo.Format = EImageFormat::JPEG;
+				OutInfo.Height = ReadBigEndian16(Segment + 5);
+				OutInfo.Width = ReadBigEndian16(Segment + 7);
+				break;
+			}
+			if (Marker == 0xD9 || Marker == 0xDA)
+			{
+				// End of image, or the scan started before any frame header
+				break;
+			}
+			Offset += 2 + ReadBigEndian16(Segment + 2);
 		}
 	}
 
-	return static_cast<char*>(imagebytes);
+	return OutInfo.Format != EImageFormat::Invalid && OutInfo.Width > 0 && OutInfo.Height > 0;
+}
+
+FString UMySQLBPLibrary::GetImageFormatName(EImageFormat Format)
+{
+	CreateImageWrapperModule();
+	return ImageWrapperModule ? FString(ImageWrapperModule->GetExtension(Format)) : FString();
+}
+
+EImageFormat UMySQLBPLibrary::GetImageFormatFromName(const FString& FormatName)
+{
+	CreateImageWrapperModule();
+	return ImageWrapperModule && !FormatName.IsEmpty() ? ImageWrapperModule->GetImageFormatFromExtension(*FormatName) : EImageFormat::Invalid;
 }
 
 
@@ -260,3 +447,48 @@ TArray<FString> UMySQLBPLibrary::GetSplitStringArray(FString Input, FString Patt
 
 	return Results;
 }
+
+FMySQLParameter UMySQLBPLibrary::MakeNullParameter()
+{
+	return FMySQLParameter();
+}
+
+FMySQLParameter UMySQLBPLibrary::MakeIntegerParameter(int64 Value)
+{
+	FMySQLParameter Parameter;
+	Parameter.Type = EMySQLParameterType::Integer;
+	Parameter.IntegerValue = Value;
+	return Parameter;
+}
+
+FMySQLParameter UMySQLBPLibrary::MakeFloatParameter(double Value)
+{
+	FMySQLParameter Parameter;
+	Parameter.Type = EMySQLParameterType::Float;
+	Parameter.FloatValue = Value;
+	return Parameter;
+}
+
+FMySQLParameter UMySQLBPLibrary::MakeStringParameter(const FString& Value)
+{
+	FMySQLParameter Parameter;
+	Parameter.Type = EMySQLParameterType::String;
+	Parameter.StringValue = Value;
+	return Parameter;
+}
+
+FMySQLParameter UMySQLBPLibrary::MakeDateTimeParameter(FDateTime Value)
+{
+	FMySQLParameter Parameter;
+	Parameter.Type = EMySQLParameterType::DateTime;
+	Parameter.DateTimeValue = Value;
+	return Parameter;
+}
+
+FMySQLParameter UMySQLBPLibrary::MakeBlobParameter(const TArray<uint8>& Value)
+{
+	FMySQLParameter Parameter;
+	Parameter.Type = EMySQLParameterType::Blob;
+	Parameter.BlobValue = Value;
+	return Parameter;
+}
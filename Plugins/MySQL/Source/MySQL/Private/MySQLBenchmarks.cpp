@@ -0,0 +1,484 @@
+// Copyright 2021-2023, Athian Games. All Rights Reserved.
+
+#include "CoreMinimal.h"
+
+#if !UE_BUILD_SHIPPING
+
+#include "Async/ParallelFor.h"
+#include "Engine/Texture2D.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "IImageWrapper.h"
+#include "IImageWrapperModule.h"
+#include "Modules/ModuleManager.h"
+#include "MySQLMain.h"
+#include "MySQLResultSet.h"
+#include "MySQLBPLibrary.h"
+
+#include <atomic>
+#include <future>
+
+/**
+* Console benchmarks against a live server. Every command that needs one takes the connection
+* as its first five arguments: Server DBName UserID Password Port
+*/
+struct FMySQLBenchmarkConnection
+{
+	MySQLConnection Connection;
+	bool bIsOpen = false;
+
+	FMySQLBenchmarkConnection(const TArray<FString>& Args, int32 PoolSize)
+	{
+		if (Args.Num() < 5)
+		{
+			UE_LOG(LogTemp, Error, TEXT("Usage: <command> Server DBName UserID Password Port [arguments]"));
+			return;
+		}
+
+		string server(TCHAR_TO_UTF8(*Args[0]));
+		string dbname(TCHAR_TO_UTF8(*Args[1]));
+		string userid(TCHAR_TO_UTF8(*Args[2]));
+		string password(TCHAR_TO_UTF8(*Args[3]));
+		string errormessage;
+
+		bIsOpen = Connection.CreateConnection(0, &server[0], &dbname[0], &userid[0], &password[0], FCString::Atoi(*Args[4]),
+			TArray<FMySQLOptionPair>(), PoolSize, errormessage);
+		if (!bIsOpen)
+		{
+			UE_LOG(LogTemp, Error, TEXT("MySQL benchmark could not connect: %s"), UTF8_TO_TCHAR(errormessage.c_str()));
+		}
+	}
+
+	~FMySQLBenchmarkConnection()
+	{
+		Connection.CloseAllConnections();
+	}
+};
+
+static int32 GetBenchmarkArgument(const TArray<FString>& Args, int32 Index, int32 DefaultValue)
+{
+	return Args.IsValidIndex(Index) ? FMath::Max(1, FCString::Atoi(*Args[Index])) : DefaultValue;
+}
+
+// MySQL.Benchmark.Latency Server DBName UserID Password Port [Queries=1000]
+static void BenchmarkQueryLatency(const TArray<FString>& Args)
+{
+	FMySQLBenchmarkConnection Benchmark(Args, 1);
+	if (!Benchmark.bIsOpen)
+	{
+		return;
+	}
+
+	const int32 NumQueries = GetBenchmarkArgument(Args, 5, 1000);
+	FMySQLResultSet Result;
+	string ErrorMessage;
+
+	// Two pings per query is what the old GetDBConnection cost on every call
+	double PingedSeconds = 0.0;
+	double PlainSeconds = 0.0;
+	for (int32 Index = 0; Index < NumQueries; ++Index)
+	{
+		double StartTime = FPlatformTime::Seconds();
+		{
+			MySQLPooledHandle Handle = Benchmark.Connection.GetDBConnection(0, ErrorMessage);
+			if (Handle)
+			{
+				mysql_ping(Handle.Get());
+				mysql_ping(Handle.Get());
+			}
+		}
+		Benchmark.Connection.SelectResultSet(0, "SELECT 1", Result, ErrorMessage);
+		PingedSeconds += FPlatformTime::Seconds() - StartTime;
+
+		StartTime = FPlatformTime::Seconds();
+		Benchmark.Connection.SelectResultSet(0, "SELECT 1", Result, ErrorMessage);
+		PlainSeconds += FPlatformTime::Seconds() - StartTime;
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("MySQL query latency over %d queries: %.3f ms with two pings, %.3f ms without"),
+		NumQueries, PingedSeconds * 1000.0 / NumQueries, PlainSeconds * 1000.0 / NumQueries);
+}
+
+static FAutoConsoleCommand MySQLBenchmarkLatencyCommand(
+	TEXT("MySQL.Benchmark.Latency"),
+	TEXT("Measures the round-trip of SELECT 1 with and without liveness pings. Arguments: Server DBName UserID Password Port [Queries=1000]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkQueryLatency));
+
+// MySQL.Benchmark.Prepared Server DBName UserID Password Port [Rows=10000]
+static void BenchmarkPreparedStatements(const TArray<FString>& Args)
+{
+	FMySQLBenchmarkConnection Benchmark(Args, 1);
+	if (!Benchmark.bIsOpen)
+	{
+		return;
+	}
+
+	// A pool of one keeps every query on the session that owns the temporary table
+	const int32 NumRows = GetBenchmarkArgument(Args, 5, 10000);
+	string ErrorMessage;
+	if (!Benchmark.Connection.UpdateDataFromQuery(0, "CREATE TEMPORARY TABLE mysql_benchmark_prepared (id INT PRIMARY KEY, name VARCHAR(64), score DOUBLE)",
+		ErrorMessage))
+	{
+		UE_LOG(LogTemp, Error, TEXT("MySQL benchmark could not create its table: %s"), UTF8_TO_TCHAR(ErrorMessage.c_str()));
+		return;
+	}
+
+	FMySQLResultSet Result;
+	uint64 AffectedRows = 0;
+	const string InsertStatement = "INSERT INTO mysql_benchmark_prepared (id, name, score) VALUES (?, ?, ?)";
+	const string SelectStatement = "SELECT name, score FROM mysql_benchmark_prepared WHERE id = ?";
+
+	// Text protocol: the values are formatted into the SQL and the server parses every statement
+	double StartTime = FPlatformTime::Seconds();
+	for (int32 Index = 0; Index < NumRows; ++Index)
+	{
+		const string Query = "INSERT INTO mysql_benchmark_prepared (id, name, score) VALUES (" + to_string(Index) + ", 'row " + to_string(Index) + "', "
+			+ to_string(Index * 0.5) + ")";
+		Benchmark.Connection.UpdateDataFromQuery(0, Query.c_str(), ErrorMessage);
+	}
+	const double TextInsertSeconds = FPlatformTime::Seconds() - StartTime;
+
+	StartTime = FPlatformTime::Seconds();
+	for (int32 Index = 0; Index < NumRows; ++Index)
+	{
+		const string Query = "SELECT name, score FROM mysql_benchmark_prepared WHERE id = " + to_string(Index);
+		Benchmark.Connection.SelectResultSet(0, Query.c_str(), Result, ErrorMessage);
+	}
+	const double TextSelectSeconds = FPlatformTime::Seconds() - StartTime;
+
+	// Binary protocol: both statements are prepared once and only the parameters are sent
+	TArray<FMySQLParameter> Parameters;
+	Parameters.SetNum(3);
+	StartTime = FPlatformTime::Seconds();
+	for (int32 Index = 0; Index < NumRows; ++Index)
+	{
+		Parameters[0] = UMySQLBPLibrary::MakeIntegerParameter(NumRows + Index);
+		Parameters[1] = UMySQLBPLibrary::MakeStringParameter(FString::Printf(TEXT("row %d"), Index));
+		Parameters[2] = UMySQLBPLibrary::MakeFloatParameter(Index * 0.5);
+		Benchmark.Connection.ExecuteStatement(0, InsertStatement, Parameters, Result, AffectedRows, ErrorMessage);
+	}
+	const double PreparedInsertSeconds = FPlatformTime::Seconds() - StartTime;
+
+	Parameters.SetNum(1);
+	StartTime = FPlatformTime::Seconds();
+	for (int32 Index = 0; Index < NumRows; ++Index)
+	{
+		Parameters[0] = UMySQLBPLibrary::MakeIntegerParameter(NumRows + Index);
+		Benchmark.Connection.ExecuteStatement(0, SelectStatement, Parameters, Result, AffectedRows, ErrorMessage);
+	}
+	const double PreparedSelectSeconds = FPlatformTime::Seconds() - StartTime;
+
+	UE_LOG(LogTemp, Log, TEXT("MySQL inserts over %d rows: %.0f rows/s as text, %.0f rows/s prepared"),
+		NumRows, NumRows / TextInsertSeconds, NumRows / PreparedInsertSeconds);
+	UE_LOG(LogTemp, Log, TEXT("MySQL point lookups over %d rows: %.0f queries/s as text, %.0f queries/s prepared"),
+		NumRows, NumRows / TextSelectSeconds, NumRows / PreparedSelectSeconds);
+}
+
+static FAutoConsoleCommand MySQLBenchmarkPreparedCommand(
+	TEXT("MySQL.Benchmark.Prepared"),
+	TEXT("Compares parameterized inserts and primary key lookups as text queries and as prepared statements. Arguments: Server DBName UserID Password Port [Rows=10000]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkPreparedStatements));
+
+// MySQL.Benchmark.Bulk Server DBName UserID Password Port [Rows=100000] [AutocommitRows=5000]
+static void BenchmarkBulkInsert(const TArray<FString>& Args)
+{
+	FMySQLBenchmarkConnection Benchmark(Args, 1);
+	if (!Benchmark.bIsOpen)
+	{
+		return;
+	}
+
+	const int32 NumRows = GetBenchmarkArgument(Args, 5, 100000);
+	const int32 NumAutocommitRows = FMath::Min(NumRows, GetBenchmarkArgument(Args, 6, 5000));
+	string ErrorMessage;
+	if (!Benchmark.Connection.UpdateDataFromQuery(0, "CREATE TEMPORARY TABLE mysql_benchmark_bulk (id INT PRIMARY KEY, name VARCHAR(64), score DOUBLE) ENGINE=InnoDB",
+		ErrorMessage))
+	{
+		UE_LOG(LogTemp, Error, TEXT("MySQL benchmark could not create its table: %s"), UTF8_TO_TCHAR(ErrorMessage.c_str()));
+		return;
+	}
+
+	// One statement and one commit per row, as UpdateDataFromMultipleQueries sends them; usually too slow for the full row count
+	double StartTime = FPlatformTime::Seconds();
+	for (int32 Index = 0; Index < NumAutocommitRows; ++Index)
+	{
+		const string Query = "INSERT INTO mysql_benchmark_bulk (id, name, score) VALUES (" + to_string(Index) + ", 'row " + to_string(Index) + "', "
+			+ to_string(Index * 0.5) + ")";
+		Benchmark.Connection.UpdateDataFromQuery(0, Query.c_str(), ErrorMessage);
+	}
+	const double AutocommitSeconds = FPlatformTime::Seconds() - StartTime;
+
+	// The same text inserts sent as one transaction
+	vector<string> TransactionQueries;
+	TransactionQueries.reserve(NumAutocommitRows);
+	for (int32 Index = 0; Index < NumAutocommitRows; ++Index)
+	{
+		const int32 ID = NumAutocommitRows + NumRows + Index;
+		TransactionQueries.push_back("INSERT INTO mysql_benchmark_bulk (id, name, score) VALUES (" + to_string(ID) + ", 'row " + to_string(Index) + "', "
+			+ to_string(Index * 0.5) + ")");
+	}
+
+	vector<EMySQLStatementStatus> StatementStatus;
+	StartTime = FPlatformTime::Seconds();
+	if (!Benchmark.Connection.ExecuteTransaction(0, TransactionQueries, StatementStatus, ErrorMessage))
+	{
+		UE_LOG(LogTemp, Error, TEXT("MySQL transaction benchmark failed: %s"), UTF8_TO_TCHAR(ErrorMessage.c_str()));
+		return;
+	}
+	const double TransactionSeconds = FPlatformTime::Seconds() - StartTime;
+
+	TArray<FMySQLParameterColumn> Columns;
+	Columns.SetNum(3);
+	Columns[0].Type = EMySQLParameterType::Integer;
+	Columns[1].Type = EMySQLParameterType::String;
+	Columns[2].Type = EMySQLParameterType::Float;
+	for (int32 Index = 0; Index < NumRows; ++Index)
+	{
+		Columns[0].IntegerValues.Add(NumAutocommitRows + Index);
+		Columns[1].StringValues.Add(FString::Printf(TEXT("row %d"), Index));
+		Columns[2].FloatValues.Add(Index * 0.5);
+	}
+
+	vector<MySQLConnection::FBatchRowError> FailedRows;
+	uint64 AffectedRows = 0;
+	StartTime = FPlatformTime::Seconds();
+	const bool bBatchSucceeded = Benchmark.Connection.ExecuteBatch(0, "INSERT INTO mysql_benchmark_bulk (id, name, score) VALUES (?, ?, ?)", Columns, true,
+		FailedRows, AffectedRows, ErrorMessage);
+	const double BatchSeconds = FPlatformTime::Seconds() - StartTime;
+
+	if (!bBatchSucceeded)
+	{
+		UE_LOG(LogTemp, Error, TEXT("MySQL bulk benchmark failed: %s"), UTF8_TO_TCHAR(ErrorMessage.c_str()));
+		return;
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("MySQL inserts: %.0f rows/s with a commit per row, %.0f rows/s as one transaction (%d rows each), %.0f rows/s as one batch (%d rows in %.2f s)"),
+		NumAutocommitRows / AutocommitSeconds, NumAutocommitRows / TransactionSeconds, NumAutocommitRows, NumRows / BatchSeconds, NumRows, BatchSeconds);
+}
+
+static FAutoConsoleCommand MySQLBenchmarkBulkCommand(
+	TEXT("MySQL.Benchmark.Bulk"),
+	TEXT("Compares row-by-row autocommit inserts with the same inserts in one transaction and with one ExecuteBatch call. Arguments: Server DBName UserID Password Port [Rows=100000] [AutocommitRows=5000]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkBulkInsert));
+
+// MySQL.Benchmark.NonBlocking Server DBName UserID Password Port [Queries=200] [PoolSize=16]
+static void BenchmarkNonBlockingQueries(const TArray<FString>& Args)
+{
+	const int32 PoolSize = GetBenchmarkArgument(Args, 6, 16);
+	FMySQLBenchmarkConnection Benchmark(Args, PoolSize);
+	if (!Benchmark.bIsOpen)
+	{
+		return;
+	}
+
+	// Every query keeps the server busy for 100 ms, the I/O thread only waits for the answers
+	const int32 NumQueries = GetBenchmarkArgument(Args, 5, 200);
+	atomic<int32> Remaining(NumQueries);
+	atomic<int32> Failed(0);
+	promise<void> AllDone;
+
+	const double StartTime = FPlatformTime::Seconds();
+	for (int32 Index = 0; Index < NumQueries; ++Index)
+	{
+		string ErrorMessage;
+		const bool bSubmitted = Benchmark.Connection.SubmitQueries(0, { "SELECT SLEEP(0.1)" },
+			[&Remaining, &Failed, &AllDone](bool bSuccess, const string&, FMySQLResultSet&, uint64_t)
+			{
+				if (!bSuccess)
+				{
+					Failed++;
+				}
+				if (--Remaining == 0)
+				{
+					AllDone.set_value();
+				}
+			}, ErrorMessage);
+
+		if (!bSubmitted && --Remaining == 0)
+		{
+			AllDone.set_value();
+		}
+	}
+	AllDone.get_future().wait();
+	const double ElapsedSeconds = FPlatformTime::Seconds() - StartTime;
+
+	UE_LOG(LogTemp, Log, TEXT("MySQL non-blocking: %d queries of 100 ms on %d handles in %.2f s (%d failed), using one I/O thread instead of %d worker threads"),
+		NumQueries, PoolSize, ElapsedSeconds, Failed.load(), FMath::Min(NumQueries, PoolSize));
+}
+
+static FAutoConsoleCommand MySQLBenchmarkNonBlockingCommand(
+	TEXT("MySQL.Benchmark.NonBlocking"),
+	TEXT("Runs many slow queries at once on the non-blocking engine. Arguments: Server DBName UserID Password Port [Queries=200] [PoolSize=16]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkNonBlockingQueries));
+
+static SIZE_T GetLegacyArraysSize(const TArray<FMySQLDataTable>& ResultByColumn, const TArray<FMySQLDataRow>& ResultByRow)
+{
+	SIZE_T Size = ResultByColumn.GetAllocatedSize() + ResultByRow.GetAllocatedSize();
+	for (const FMySQLDataTable& Column : ResultByColumn)
+	{
+		Size += Column.ColumnName.GetAllocatedSize() + Column.ColumnData.GetAllocatedSize();
+		for (const FString& Cell : Column.ColumnData)
+		{
+			Size += Cell.GetAllocatedSize();
+		}
+	}
+	for (const FMySQLDataRow& Row : ResultByRow)
+	{
+		Size += Row.RowData.GetAllocatedSize();
+		for (const FString& Cell : Row.RowData)
+		{
+			Size += Cell.GetAllocatedSize();
+		}
+	}
+	return Size;
+}
+
+// MySQL.Benchmark.Memory Server DBName UserID Password Port [Rows=200000]
+static void BenchmarkResultHandoff(const TArray<FString>& Args)
+{
+	FMySQLBenchmarkConnection Benchmark(Args, 1);
+	if (!Benchmark.bIsOpen)
+	{
+		return;
+	}
+
+	const int32 NumRows = GetBenchmarkArgument(Args, 5, 200000);
+	string ErrorMessage;
+	if (!Benchmark.Connection.UpdateDataFromQuery(0, "CREATE TEMPORARY TABLE mysql_benchmark_memory (id INT PRIMARY KEY, name VARCHAR(64), score DOUBLE)",
+		ErrorMessage))
+	{
+		UE_LOG(LogTemp, Error, TEXT("MySQL benchmark could not create its table: %s"), UTF8_TO_TCHAR(ErrorMessage.c_str()));
+		return;
+	}
+
+	TArray<FMySQLParameterColumn> Columns;
+	Columns.SetNum(3);
+	Columns[0].Type = EMySQLParameterType::Integer;
+	Columns[1].Type = EMySQLParameterType::String;
+	Columns[2].Type = EMySQLParameterType::Float;
+	for (int32 Index = 0; Index < NumRows; ++Index)
+	{
+		Columns[0].IntegerValues.Add(Index);
+		Columns[1].StringValues.Add(FString::Printf(TEXT("row %d"), Index));
+		Columns[2].FloatValues.Add(Index * 0.5);
+	}
+
+	vector<MySQLConnection::FBatchRowError> FailedRows;
+	uint64 AffectedRows = 0;
+	FMySQLResultSet Result;
+	if (!Benchmark.Connection.ExecuteBatch(0, "INSERT INTO mysql_benchmark_memory (id, name, score) VALUES (?, ?, ?)", Columns, true, FailedRows, AffectedRows, ErrorMessage)
+		|| !Benchmark.Connection.SelectResultSet(0, "SELECT id, name, score FROM mysql_benchmark_memory", Result, ErrorMessage))
+	{
+		UE_LOG(LogTemp, Error, TEXT("MySQL memory benchmark failed: %s"), UTF8_TO_TCHAR(ErrorMessage.c_str()));
+		return;
+	}
+
+	// The old handoff built the string arrays on the worker and copied them into the game thread call
+	double StartTime = FPlatformTime::Seconds();
+	TArray<FMySQLDataTable> ResultByColumn;
+	TArray<FMySQLDataRow> ResultByRow;
+	Result.ToColumns(ResultByColumn);
+	Result.ToRows(ResultByRow);
+	TArray<FMySQLDataTable> CopiedByColumn = ResultByColumn;
+	TArray<FMySQLDataRow> CopiedByRow = ResultByRow;
+	const double CopySeconds = FPlatformTime::Seconds() - StartTime;
+	const SIZE_T LegacySize = GetLegacyArraysSize(ResultByColumn, ResultByRow);
+
+	// The typed result is moved into the shared pointer and every reader after that shares it
+	StartTime = FPlatformTime::Seconds();
+	const SIZE_T ResultSetSize = Result.GetAllocatedSize();
+	FMySQLResultSetPtr ResultSet = MakeShared<FMySQLResultSet, ESPMode::ThreadSafe>(MoveTemp(Result));
+	FMySQLResultSetPtr GameThreadView = ResultSet;
+	const double ShareSeconds = FPlatformTime::Seconds() - StartTime;
+
+	UE_LOG(LogTemp, Log, TEXT("MySQL result handoff of %d rows: string arrays %.1f MB, %.1f MB at peak with the copy, built and copied in %.1f ms; ")
+		TEXT("shared result %.1f MB, handed off in %.3f ms"),
+		GameThreadView->GetNumRows(), LegacySize / 1048576.0, 2 * LegacySize / 1048576.0, CopySeconds * 1000.0, ResultSetSize / 1048576.0, ShareSeconds * 1000.0);
+}
+
+static FAutoConsoleCommand MySQLBenchmarkMemoryCommand(
+	TEXT("MySQL.Benchmark.Memory"),
+	TEXT("Compares the memory of the string array select results with the shared typed result. Arguments: Server DBName UserID Password Port [Rows=200000]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkResultHandoff));
+
+// MySQL.Benchmark.Image [Images=32] [Size=1024]
+static void BenchmarkImageDecode(const TArray<FString>& Args)
+{
+	const int32 NumImages = GetBenchmarkArgument(Args, 0, 32);
+	const int32 Size = GetBenchmarkArgument(Args, 1, 1024);
+
+	// A PNG of noisy gradients stands in for a selected image; no server is needed
+	UMySQLBPLibrary::CreateImageWrapperModule();
+	IImageWrapperModule& ImageWrapperModule = FModuleManager::LoadModuleChecked<IImageWrapperModule>(FName("ImageWrapper"));
+	TSharedPtr<IImageWrapper> Encoder = ImageWrapperModule.CreateImageWrapper(EImageFormat::PNG);
+	TArray<uint8> Pixels;
+	Pixels.SetNumUninitialized(Size * Size * 4);
+	FRandomStream Random(Size);
+	for (int32 Index = 0; Index < Size * Size; ++Index)
+	{
+		Pixels[Index * 4 + 0] = uint8(Index % Size);
+		Pixels[Index * 4 + 1] = uint8(Index / Size);
+		Pixels[Index * 4 + 2] = uint8(Random.RandRange(0, 255));
+		Pixels[Index * 4 + 3] = 255;
+	}
+	if (!Encoder.IsValid() || !Encoder->SetRaw(Pixels.GetData(), Pixels.Num(), Size, Size, ERGBFormat::BGRA, 8))
+	{
+		UE_LOG(LogTemp, Error, TEXT("MySQL image benchmark could not encode its image"));
+		return;
+	}
+	const TArray64<uint8> Compressed = Encoder->GetCompressed();
+
+	// Decoding runs on the workers, as the select tasks do
+	TArray<TUniquePtr<FMySQLDecodedImage>> Images;
+	for (int32 Index = 0; Index < NumImages; ++Index)
+	{
+		Images.Add(MakeUnique<FMySQLDecodedImage>());
+	}
+	std::atomic<int32> NumFailed{ 0 };
+	double StartTime = FPlatformTime::Seconds();
+	ParallelFor(NumImages, [&](int32 Index)
+	{
+		if (!UMySQLBPLibrary::DecodeImage(Compressed.GetData(), Compressed.Num(), EImageFormat::PNG, *Images[Index]))
+		{
+			++NumFailed;
+		}
+	});
+	const double DecodeSeconds = FPlatformTime::Seconds() - StartTime;
+	if (NumFailed > 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("MySQL image benchmark could not decode %d images"), NumFailed.load());
+		return;
+	}
+
+	// The old path created the texture, copied the pixels into mip 0 and updated the resource on the calling thread
+	StartTime = FPlatformTime::Seconds();
+	for (int32 Index = 0; Index < NumImages; ++Index)
+	{
+		UTexture2D* Texture = UTexture2D::CreateTransient(Size, Size, PF_B8G8R8A8);
+		void* TextureData = Texture->GetPlatformData()->Mips[0].BulkData.Lock(LOCK_READ_WRITE);
+		FMemory::Memcpy(TextureData, Images[Index]->Pixels.GetData(), Images[Index]->Pixels.Num());
+		Texture->GetPlatformData()->Mips[0].BulkData.Unlock();
+		Texture->UpdateResource();
+	}
+	const double LegacySeconds = FPlatformTime::Seconds() - StartTime;
+
+	// The pixels are handed to the render thread instead of being copied on the game thread
+	StartTime = FPlatformTime::Seconds();
+	for (TUniquePtr<FMySQLDecodedImage>& Image : Images)
+	{
+		UMySQLBPLibrary::CreateTextureFromImage(MoveTemp(Image));
+	}
+	const double HandoffSeconds = FPlatformTime::Seconds() - StartTime;
+
+	UE_LOG(LogTemp, Log, TEXT("MySQL image decode of %d %dx%d PNGs (%.1f KB each): %.1f images/s, %.1f MB/s of pixels; ")
+		TEXT("game thread %.3f ms per image with the lock and copy, %.3f ms with the render thread handoff"),
+		NumImages, Size, Size, Compressed.Num() / 1024.0, NumImages / DecodeSeconds, NumImages * double(Size) * Size * 4 / 1048576.0 / DecodeSeconds,
+		LegacySeconds * 1000.0 / NumImages, HandoffSeconds * 1000.0 / NumImages);
+}
+
+static FAutoConsoleCommand MySQLBenchmarkImageCommand(
+	TEXT("MySQL.Benchmark.Image"),
+	TEXT("Measures worker image decode throughput and game thread texture creation per image. Arguments: [Images=32] [Size=1024]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkImageDecode));
+
+#endif
@@ -2,14 +2,30 @@
 
 
 #include "MySQLDBConnectionActor.h"
+#include "HAL/PlatformTime.h"
+#include "Async/Async.h"
 
 
 // Sets default values
 AMySQLDBConnectionActor::AMySQLDBConnectionActor()
 {
-	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = true;
+	// Tasks report their own completion, so the actor has no per-frame work
+	PrimaryActorTick.bCanEverTick = false;
+	TaskTracker = MakeShared<FMySQLTaskTracker, ESPMode::ThreadSafe>([DBConnectionActor = TWeakObjectPtr<AMySQLDBConnectionActor>(this)]()
+	{
+		if (DBConnectionActor.IsValid())
+		{
+			DBConnectionActor->UpdateBusyState();
+		}
+	});
 	bIsConnectionBusy = false;
+	bIsQueryTaskRunning = false;
+	bIsDispatchingTasks = false;
+	bDispatchAgain = false;
+	ConnectionPoolSize = 4;
+	bUseNonBlockingQueries = false;
+	NonBlockingQueriesInFlight = 0;
+	NextStatementID = 0;
 
 	CopyDLL(TEXT("mysqlcppconn-9-vs14.dll"));
 	CopyDLL(TEXT("libcrypto-1_1-x64.dll"));
@@ -24,60 +40,42 @@ void AMySQLDBConnectionActor::BeginPlay()
 
 }
 
-FCriticalSection Mutex;
-
-// Called every frame
-void AMySQLDBConnectionActor::Tick(float DeltaTime)
+void AMySQLDBConnectionActor::UpdateBusyState()
 {
-	Super::Tick(DeltaTime);
+	bIsConnectionBusy = TaskTracker->Num() > 0 || NonBlockingQueriesInFlight > 0;
 
-	Mutex.Lock(); // Lock access to shared resources
-	// Clean up finished tasks
-	CleanUpFinishedTasks<OpenMySQLConnectionTask>(OpenConnectionTasks);
-	CleanUpFinishedTasks<UpdateMySQLQueryAsyncTask>(UpdateQueryTasks);
-	CleanUpFinishedTasks<SelectMySQLQueryAsyncTask>(SelectQueryTasks);
-	CleanUpFinishedTasks<UpdateMySQLImageAsyncTask>(UpdateImageQueryTasks);
-	CleanUpFinishedTasks<SelectMySQLImageAsyncTask>(SelectImageQueryTasks);
-	Mutex.Unlock(); // Unlock access to shared resources
-	
-	// Update the busy state
-	bIsConnectionBusy = OpenConnectionTasks.Num() > 0
-		|| UpdateQueryTasks.Num() > 0
-		|| SelectQueryTasks.Num() > 0
-		|| UpdateImageQueryTasks.Num() > 0
-		|| SelectImageQueryTasks.Num() > 0;
-
-	if (!bIsConnectionBusy)
+	// Query IDs identify running tasks, so they are only reused when nothing is queued or waiting for completion
+	if (!bIsConnectionBusy && !HasQueuedTasks() && RunningQueryTasks.Num() == 0)
 	{
 		for (auto& entry : ConnectionToNextQueryIDMap)
 		{
 			entry.Value = 0;
 		}
 	}
-
 }
 
 void AMySQLDBConnectionActor::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
-	// Ensure all UpdateQueryTasks have completed
-	for(const auto& Task : UpdateQueryTasks)
+	// Streaming selects wait for the game thread to take their chunks, which it no longer will
+	for (const TWeakPtr<FMySQLChunkFlow, ESPMode::ThreadSafe>& ChunkFlow : ChunkFlows)
 	{
-		if(Task && !Task->IsDone())
+		if (TSharedPtr<FMySQLChunkFlow, ESPMode::ThreadSafe> Flow = ChunkFlow.Pin())
 		{
-			Task->EnsureCompletion();
+			Flow->Cancel();
 		}
 	}
-	UpdateQueryTasks.Empty();
-
-	// Ensure all SelectQueryTasks have completed
-	for(const auto& Task : SelectQueryTasks)
-	{
-		if(Task && !Task->IsDone())
-		{
-			Task->EnsureCompletion();
-		}
-	}
-	SelectQueryTasks.Empty();
+	ChunkFlows.Empty();
+
+	// Ensure all query tasks have completed
+	UpdateQueryTasks.EnsureCompletion();
+	SelectQueryTasks.EnsureCompletion();
+	SelectChunkedQueryTasks.EnsureCompletion();
+	PrepareStatementTasks.EnsureCompletion();
+	ExecuteStatementTasks.EnsureCompletion();
+	ExecuteBatchTasks.EnsureCompletion();
+	UpdateImageQueryTasks.EnsureCompletion();
+	UpdateTextureQueryTasks.EnsureCompletion();
+	SelectImageQueryTasks.EnsureCompletion();
 
 	// Now you can safely close all connections
 	CloseAllConnections();
@@ -126,15 +124,9 @@ UMySQLDBConnector* AMySQLDBConnectionActor::GetConnector(int32 ConnectionID)
 
 void AMySQLDBConnectionActor::CloseConnection(int32 ConnectionID)
 {
-	FQueryTaskData CloseConnectionTask;
-	CloseConnectionTask.ConnectionID = ConnectionID;
-	CloseConnectionTask.QueryType = EQueryType::Close;
-	QueryTaskQueue.Add(CloseConnectionTask);
-
-	if (!bIsQueryTaskRunning)
-	{
-		ExecuteNextQueryTask();
-	}
+	// The connection closes once the tasks it already has are done
+	GetDispatchState(ConnectionID).bCloseRequested = true;
+	ExecuteNextQueryTask();
 }
 
 void AMySQLDBConnectionActor::CloseAllConnections()
@@ -221,155 +213,625 @@ void AMySQLDBConnectionActor::CreateNewConnection(FString Server, FString DBName
 	{
 		MySQLOptions = MySQLOptionsAsset->ConnectionOptions;
 	}
-	FAsyncTask<OpenMySQLConnectionTask>* OpenConnectionTask = StartAsyncTask<OpenMySQLConnectionTask>(this, ConnectionID, NewConnector, Server, DBName,
-		UserID, Password, Port, MySQLOptions);
-	OpenConnectionTasks.Add(OpenConnectionTask);
 
+	const int32 PoolSize = FMath::Max(1, ConnectionPoolSize);
+	GetDispatchState(ConnectionID).PoolSize = PoolSize;
+
+	StartAsyncTask(OpenConnectionTasks, this, ConnectionID, NewConnector, Server, DBName, UserID, Password, Port, MySQLOptions, PoolSize);
+
+}
+
+const double FMySQLQueryLane::WaitBucketUpperMs[] = { 1.0, 2.0, 5.0, 10.0, 20.0, 50.0, 100.0, 200.0, 500.0, 1000.0 };
+
+void FMySQLQueryLane::RecordWait(double WaitSeconds)
+{
+	DispatchedQueries++;
+	TotalWaitSeconds += WaitSeconds;
+	MaxWaitSeconds = FMath::Max(MaxWaitSeconds, WaitSeconds);
+
+	const double WaitMs = WaitSeconds * 1000.0;
+	int32 Bucket = 0;
+	while (Bucket < NumWaitBuckets - 1 && WaitMs >= WaitBucketUpperMs[Bucket])
+	{
+		++Bucket;
+	}
+	WaitHistogram[Bucket]++;
+}
+
+FMySQLDispatchState& AMySQLDBConnectionActor::GetDispatchState(int32 ConnectionID)
+{
+	TUniquePtr<FMySQLDispatchState>& State = DispatchStates.FindOrAdd(ConnectionID);
+	if (!State.IsValid())
+	{
+		State = MakeUnique<FMySQLDispatchState>();
+	}
+	return *State;
+}
+
+bool AMySQLDBConnectionActor::HasQueuedTasks() const
+{
+	for (const TPair<int32, TUniquePtr<FMySQLDispatchState>>& Entry : DispatchStates)
+	{
+		if (Entry.Value->HasQueuedTasks())
+		{
+			return true;
+		}
+	}
+	return false;
 }
 
 void AMySQLDBConnectionActor::ExecuteNextQueryTask()
 {
-	if(IsValidLowLevel())
+	if(!IsValidLowLevel())
+	{
+		return;
+	}
+
+	// Completion callbacks and close requests can come back here while the queues are being walked;
+	// what they queue is picked up by one more pass
+	if (bIsDispatchingTasks)
+	{
+		bDispatchAgain = true;
+		return;
+	}
+	bIsDispatchingTasks = true;
+
+	do
+	{
+		bDispatchAgain = false;
+
+		// Every connection has its own queues and handles, so a busy one does not hold up the others
+		TArray<int32> ConnectionIDs;
+		DispatchStates.GetKeys(ConnectionIDs);
+		for (const int32 ConnectionID : ConnectionIDs)
+		{
+			DispatchConnection(ConnectionID);
+		}
+	}
+	while (bDispatchAgain);
+
+	bIsDispatchingTasks = false;
+	bIsQueryTaskRunning = RunningQueryTasks.Num() > 0 || HasQueuedTasks();
+}
+
+void AMySQLDBConnectionActor::DispatchConnection(int32 ConnectionID)
+{
+	const TUniquePtr<FMySQLDispatchState>* StatePtr = DispatchStates.Find(ConnectionID);
+	if (!StatePtr)
+	{
+		return;
+	}
+
+	// The state is owned by the map through a pointer, so it stays put when callbacks add connections
+	FMySQLDispatchState* State = StatePtr->Get();
+	FQueryTaskData TaskData;
+
+	UMySQLDBConnector* CurrentConnector = GetConnector(ConnectionID);
+	if(CurrentConnector == nullptr)
+	{
+		if (State->HasQueuedTasks())
+		{
+			UE_LOG(LogTemp, Warning, TEXT("CurrentConnector is null"));
+		}
+
+		TQueue<FQueryTaskData, EQueueMode::Mpsc>* Queues[] = { &State->OrderedTasks, &State->Lanes[0].Tasks, &State->Lanes[1].Tasks };
+		for (TQueue<FQueryTaskData, EQueueMode::Mpsc>* Queue : Queues)
+		{
+			while (Queue->Dequeue(TaskData))
+			{
+				State->Lanes[static_cast<int32>(TaskData.Priority)].QueueDepth.Decrement();
+				FailQueryTask(TaskData, TEXT("Connection not Valid"));
+			}
+		}
+		DispatchStates.Remove(ConnectionID);
+		return;
+	}
+
+	while (DequeueNextTask(*State, TaskData))
+	{
+		DispatchQueryTask(CurrentConnector, TaskData);
+	}
+
+	if (State->bCloseRequested && State->InFlight == 0 && !State->HasQueuedTasks())
+	{
+		CurrentConnector->CloseConnection(ConnectionID);
+		SQLConnectors.Remove(ConnectionID);
+		ConnectionToNextQueryIDMap.Remove(ConnectionID);
+		DispatchStates.Remove(ConnectionID);
+		for (auto It = PreparedStatements.CreateIterator(); It; ++It)
+		{
+			if (It.Value().ConnectionID == ConnectionID)
+			{
+				It.RemoveCurrent();
+			}
+		}
+	}
+}
+
+bool AMySQLDBConnectionActor::DequeueNextTask(FMySQLDispatchState& State, FQueryTaskData& OutTask)
+{
+	// Only the oldest ordered task can start, and only once the one before it is done
+	const FQueryTaskData* OrderedTask = State.bOrderedInFlight ? nullptr : State.OrderedTasks.Peek();
+
+	for (int32 LaneIndex = 0; LaneIndex < FMySQLDispatchState::NumLanes; ++LaneIndex)
+	{
+		const EMySQLQueryPriority Priority = static_cast<EMySQLQueryPriority>(LaneIndex);
+		if (!State.HasFreeHandle(Priority))
+		{
+			continue;
+		}
+
+		FMySQLQueryLane& Lane = State.Lanes[LaneIndex];
+		const FQueryTaskData* UnorderedTask = Lane.Tasks.Peek();
+		const bool bOrderedTaskFirst = OrderedTask && OrderedTask->Priority == Priority
+			&& (!UnorderedTask || OrderedTask->EnqueueTime <= UnorderedTask->EnqueueTime);
+
+		if ((bOrderedTaskFirst && State.OrderedTasks.Dequeue(OutTask)) || (UnorderedTask && Lane.Tasks.Dequeue(OutTask)))
+		{
+			Lane.QueueDepth.Decrement();
+			return true;
+		}
+	}
+	return false;
+}
+
+void AMySQLDBConnectionActor::DispatchQueryTask(UMySQLDBConnector* CurrentConnector, FQueryTaskData& TaskData)
+{
+	FMySQLDispatchState& State = GetDispatchState(TaskData.ConnectionID);
+
+	State.Lanes[static_cast<int32>(TaskData.Priority)].RecordWait(FPlatformTime::Seconds() - TaskData.EnqueueTime);
+	State.InFlight++;
+	if (TaskData.Priority == EMySQLQueryPriority::Background)
+	{
+		State.BackgroundInFlight++;
+	}
+	if (TaskData.bOrdered)
+	{
+		State.bOrderedInFlight = true;
+	}
+
+	// Only the bookkeeping of a running task is kept, its queries and parameters go to the worker
+	FQueryTaskData& RunningTask = RunningQueryTasks.AddDefaulted_GetRef();
+	RunningTask.ConnectionID = TaskData.ConnectionID;
+	RunningTask.QueryID = TaskData.QueryID;
+	RunningTask.QueryType = TaskData.QueryType;
+	RunningTask.bOrdered = TaskData.bOrdered;
+	RunningTask.Priority = TaskData.Priority;
+	RunningTask.StatementID = TaskData.StatementID;
+	RunningTask.EnqueueTime = TaskData.EnqueueTime;
+
+	if (bUseNonBlockingQueries && (TaskData.QueryType == EQueryType::Update || TaskData.QueryType == EQueryType::Select))
+	{
+		RunningTask.bNonBlocking = true;
+		NonBlockingQueriesInFlight++;
+		bIsConnectionBusy = true;
+		DispatchNonBlockingQuery(CurrentConnector, TaskData);
+		return;
+	}
+
+	switch (TaskData.QueryType)
+	{
+	case EQueryType::Update:
+		{
+			StartAsyncTask(UpdateQueryTasks, this, CurrentConnector, TaskData.ConnectionID, TaskData.QueryID, MoveTemp(TaskData.Queries));
+		}
+		break;
+	case EQueryType::Transaction:
+		{
+			StartAsyncTask(UpdateQueryTasks, this, CurrentConnector, TaskData.ConnectionID, TaskData.QueryID, MoveTemp(TaskData.Queries), true);
+		}
+		break;
+	case EQueryType::Select:
+		{
+			bool bBuildLegacyArrays, bKeepResultSet;
+			GetSelectListeners(bBuildLegacyArrays, bKeepResultSet);
+			StartAsyncTask(SelectQueryTasks, this, CurrentConnector, TaskData.ConnectionID, TaskData.QueryID, TaskData.Queries[0], bBuildLegacyArrays, bKeepResultSet);
+		}
+		break;
+	case EQueryType::SelectChunked:
+		{
+			ChunkFlows.RemoveAllSwap([](const TWeakPtr<FMySQLChunkFlow, ESPMode::ThreadSafe>& ChunkFlow) { return !ChunkFlow.IsValid(); });
+			TSharedRef<FMySQLChunkFlow, ESPMode::ThreadSafe> ChunkFlow = MakeShared<FMySQLChunkFlow, ESPMode::ThreadSafe>();
+			ChunkFlows.Add(ChunkFlow);
+			StartAsyncTask(SelectChunkedQueryTasks, this, CurrentConnector, TaskData.ConnectionID, TaskData.QueryID, TaskData.Queries[0], TaskData.ChunkSize, ChunkFlow);
+		}
+		break;
+	case EQueryType::PrepareStatement:
+		{
+			StartAsyncTask(PrepareStatementTasks, this, CurrentConnector, TaskData.ConnectionID, TaskData.QueryID, TaskData.StatementID, TaskData.Queries[0]);
+		}
+		break;
+	case EQueryType::ExecuteStatement:
+		{
+			StartAsyncTask(ExecuteStatementTasks, this, CurrentConnector, TaskData.ConnectionID, TaskData.QueryID, TaskData.StatementID, TaskData.Queries[0],
+				MoveTemp(TaskData.Parameters));
+		}
+		break;
+	case EQueryType::ExecuteBatch:
+		{
+			StartAsyncTask(ExecuteBatchTasks, this, CurrentConnector, TaskData.ConnectionID, TaskData.QueryID, TaskData.Queries[0], MoveTemp(TaskData.ParameterColumns),
+				TaskData.bAllOrNothing);
+		}
+		break;
+	case EQueryType::UpdateImage:
+		{
+			StartAsyncTask(UpdateImageQueryTasks, this, CurrentConnector, TaskData.ConnectionID, TaskData.QueryID, TaskData.Queries[0], TaskData.UpdateParameter,
+				TaskData.ParameterID, TaskData.ImagePath);
+		}
+		break;
+	case EQueryType::UpdateTexture:
+		{
+			StartAsyncTask(UpdateTextureQueryTasks, this, CurrentConnector, TaskData.ConnectionID, TaskData.QueryID, TaskData.Queries[0], TaskData.UpdateParameter,
+				TaskData.ParameterID, MoveTemp(*TaskData.TextureReader));
+		}
+		break;
+	case EQueryType::SelectImage:
+		{
+			StartAsyncTask(SelectImageQueryTasks, this, CurrentConnector, TaskData.ConnectionID, TaskData.QueryID, TaskData.Queries[0]);
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+void AMySQLDBConnectionActor::GetSelectListeners(bool& bBuildLegacyArrays, bool& bKeepResultSet) const
+{
+	// Copying every cell into strings is the expensive part of a select, skip it when nobody listens.
+	// Without an OnQuerySelectResult the typed result is released on the worker instead of on the game thread
+	bBuildLegacyArrays = GetClass()->IsFunctionImplementedInScript(GET_FUNCTION_NAME_CHECKED(AMySQLDBConnectionActor, OnQuerySelectStatusChanged));
+	bKeepResultSet = GetClass()->IsFunctionImplementedInScript(GET_FUNCTION_NAME_CHECKED(AMySQLDBConnectionActor, OnQuerySelectResult));
+}
+
+void AMySQLDBConnectionActor::DispatchNonBlockingQuery(UMySQLDBConnector* CurrentConnector, FQueryTaskData& TaskData)
+{
+	TWeakObjectPtr<AMySQLDBConnectionActor> DBConnectionActor(this);
+	const int32 CurrentConnectionID = TaskData.ConnectionID;
+	const int32 CurrentQueryID = TaskData.QueryID;
+
+	if (TaskData.QueryType == EQueryType::Select)
 	{
-		if(QueryTaskQueue.Num() > 0)
+		bool bBuildLegacyArrays, bKeepResultSet;
+		GetSelectListeners(bBuildLegacyArrays, bKeepResultSet);
+		CurrentConnector->RunQueriesNonBlocking(CurrentConnectionID, TaskData.Queries, [DBConnectionActor, CurrentConnectionID, CurrentQueryID, bBuildLegacyArrays, bKeepResultSet](
+			bool IsSuccessful, const FString& ErrorMessage, FMySQLResultSet& Result)
 		{
-			FQueryTaskData& TaskData = QueryTaskQueue.Last();
-			UMySQLDBConnector* CurrentConnector = GetConnector(TaskData.ConnectionID);
-			if(CurrentConnector == nullptr)
+			FMySQLResultSetPtr ResultSet = MakeShared<FMySQLResultSet, ESPMode::ThreadSafe>(MoveTemp(Result));
+			if (!IsSuccessful || !bBuildLegacyArrays)
 			{
-				UE_LOG(LogTemp, Warning, TEXT("CurrentConnector is null"));
+				SelectMySQLQueryAsyncTask::CompleteSelect(DBConnectionActor, CurrentConnectionID, CurrentQueryID, IsSuccessful, ErrorMessage, MoveTemp(ResultSet), false, bKeepResultSet);
 				return;
 			}
 
-			bIsQueryTaskRunning = true;
-			switch (TaskData.QueryType)
+			// The string copies are too slow for the I/O thread
+			AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, [DBConnectionActor, CurrentConnectionID, CurrentQueryID, ErrorMessage, ResultSet = MoveTemp(ResultSet), bKeepResultSet]()
+			{
+				SelectMySQLQueryAsyncTask::CompleteSelect(DBConnectionActor, CurrentConnectionID, CurrentQueryID, true, ErrorMessage, ResultSet, true, bKeepResultSet);
+			});
+		});
+		return;
+	}
+
+	CurrentConnector->RunQueriesNonBlocking(CurrentConnectionID, TaskData.Queries, [DBConnectionActor, CurrentConnectionID, CurrentQueryID](
+		bool IsSuccessful, const FString& ErrorMessage, FMySQLResultSet& Result)
+	{
+		AsyncTask(ENamedThreads::GameThread, [DBConnectionActor, CurrentConnectionID, CurrentQueryID, IsSuccessful, ErrorMessage]()
+		{
+			if (DBConnectionActor.IsValid() && DBConnectionActor->IsValidLowLevel())
+			{
+				DBConnectionActor->OnQueryUpdateStatusChanged(CurrentConnectionID, CurrentQueryID, IsSuccessful, ErrorMessage);
+				DBConnectionActor->OnQueryTaskFinished(CurrentConnectionID, CurrentQueryID);
+			}
+		});
+	});
+}
+
+void AMySQLDBConnectionActor::FailQueryTask(const FQueryTaskData& TaskData, const FString& ErrorMessage)
+{
+	switch (TaskData.QueryType)
+	{
+	case EQueryType::Update:
+		OnQueryUpdateStatusChanged(TaskData.ConnectionID, TaskData.QueryID, false, ErrorMessage);
+		break;
+	case EQueryType::Transaction:
+		{
+			TArray<EMySQLStatementStatus> StatementStatus;
+			StatementStatus.Init(EMySQLStatementStatus::NotExecuted, TaskData.Queries.Num());
+			OnTransactionStatusChanged(TaskData.ConnectionID, TaskData.QueryID, false, ErrorMessage, StatementStatus);
+		}
+		break;
+	case EQueryType::Select:
+		OnQuerySelectResult(TaskData.ConnectionID, TaskData.QueryID, false, ErrorMessage, nullptr);
+		OnQuerySelectStatusChanged(TaskData.ConnectionID, TaskData.QueryID, false, ErrorMessage, TArray<FMySQLDataTable>(), TArray<FMySQLDataRow>());
+		break;
+	case EQueryType::SelectChunked:
+		OnQuerySelectChunk(TaskData.ConnectionID, TaskData.QueryID, 0, TArray<FString>(), TArray<FMySQLDataRow>(), true, false, ErrorMessage);
+		break;
+	case EQueryType::PrepareStatement:
+		OnStatementPrepared(TaskData.ConnectionID, TaskData.QueryID, TaskData.StatementID, false, ErrorMessage, 0);
+		break;
+	case EQueryType::ExecuteStatement:
+		OnStatementExecuted(TaskData.ConnectionID, TaskData.QueryID, TaskData.StatementID, false, ErrorMessage, 0, nullptr);
+		break;
+	case EQueryType::ExecuteBatch:
+		OnBatchExecuted(TaskData.ConnectionID, TaskData.QueryID, false, ErrorMessage, 0, TArray<FMySQLBatchRowError>());
+		break;
+	case EQueryType::UpdateImage:
+	case EQueryType::UpdateTexture:
+		OnImageUpdateStatusChanged(TaskData.ConnectionID, TaskData.QueryID, false, ErrorMessage);
+		break;
+	case EQueryType::SelectImage:
+		OnImageSelectStatusChanged(TaskData.ConnectionID, TaskData.QueryID, false, ErrorMessage, nullptr);
+		break;
+	default:
+		break;
+	}
+}
+
+void AMySQLDBConnectionActor::OnQueryTaskFinished(int32 ConnectionID, int32 QueryID)
+{
+	const int32 RunningIndex = RunningQueryTasks.IndexOfByPredicate([ConnectionID, QueryID](const FQueryTaskData& TaskData)
+	{
+		return TaskData.ConnectionID == ConnectionID && TaskData.QueryID == QueryID;
+	});
+
+	if (RunningIndex != INDEX_NONE)
+	{
+		if (const TUniquePtr<FMySQLDispatchState>* State = DispatchStates.Find(ConnectionID))
+		{
+			(*State)->InFlight = FMath::Max(0, (*State)->InFlight - 1);
+			if (RunningQueryTasks[RunningIndex].Priority == EMySQLQueryPriority::Background)
+			{
+				(*State)->BackgroundInFlight = FMath::Max(0, (*State)->BackgroundInFlight - 1);
+			}
+			if (RunningQueryTasks[RunningIndex].bOrdered)
+			{
+				(*State)->bOrderedInFlight = false;
+			}
+		}
+		if (RunningQueryTasks[RunningIndex].bNonBlocking)
+		{
+			NonBlockingQueriesInFlight = FMath::Max(0, NonBlockingQueriesInFlight - 1);
+		}
+		RunningQueryTasks.RemoveAtSwap(RunningIndex);
+	}
+
+	ExecuteNextQueryTask();
+	UpdateBusyState();
+}
+
+FMySQLPoolMetrics AMySQLDBConnectionActor::GetConnectionPoolMetrics(int32 ConnectionID)
+{
+	FMySQLPoolMetrics Metrics;
+
+	if (const TUniquePtr<FMySQLDispatchState>* StatePtr = DispatchStates.Find(ConnectionID))
+	{
+		const FMySQLDispatchState& State = **StatePtr;
+		Metrics.PoolSize = State.PoolSize;
+		Metrics.InFlight = State.InFlight;
+
+		double TotalWaitSeconds = 0.0;
+		double MaxWaitSeconds = 0.0;
+		for (int32 LaneIndex = 0; LaneIndex < FMySQLDispatchState::NumLanes; ++LaneIndex)
+		{
+			const FMySQLQueryLane& Lane = State.Lanes[LaneIndex];
+			FMySQLQueueLatency& Latency = static_cast<EMySQLQueryPriority>(LaneIndex) == EMySQLQueryPriority::Interactive ? Metrics.Interactive : Metrics.Background;
+			Latency.QueueDepth = Lane.QueueDepth.GetValue();
+			Latency.DispatchedQueries = Lane.DispatchedQueries;
+			if (Lane.DispatchedQueries > 0)
+			{
+				Latency.AverageWaitMs = static_cast<float>(Lane.TotalWaitSeconds * 1000.0 / Lane.DispatchedQueries);
+			}
+			Latency.MaxWaitMs = static_cast<float>(Lane.MaxWaitSeconds * 1000.0);
+			for (const double UpperMs : FMySQLQueryLane::WaitBucketUpperMs)
 			{
-			case EQueryType::Update:
-				{
-					FAsyncTask<UpdateMySQLQueryAsyncTask>* UpdateQueryTask = StartAsyncTask<UpdateMySQLQueryAsyncTask>(this, CurrentConnector, TaskData.ConnectionID, TaskData.QueryID, TaskData.Queries);
-					if(UpdateQueryTask == nullptr)
-					{
-						UE_LOG(LogTemp, Warning, TEXT("UpdateQueryTask is null"));
-						return;
-					}
-					UpdateQueryTasks.Add(UpdateQueryTask);
-				}
-				break;
-			case EQueryType::Select:
-				{
-				
-					FAsyncTask<SelectMySQLQueryAsyncTask>* SelectQueryTask = StartAsyncTask<SelectMySQLQueryAsyncTask>(this, CurrentConnector, TaskData.ConnectionID, TaskData.QueryID, TaskData.Queries[0]);
-					if(SelectQueryTask == nullptr)
-					{
-						UE_LOG(LogTemp, Warning, TEXT("SelectQueryTask is null"));
-						return;
-					}
-					SelectQueryTasks.Add(SelectQueryTask);
-				}
-				break;
-			case EQueryType::Close:
-				{
-					CurrentConnector->CloseConnection(TaskData.ConnectionID);
-					SQLConnectors.Remove(TaskData.ConnectionID);
-					ConnectionToNextQueryIDMap.Remove(TaskData.ConnectionID);
-					bIsQueryTaskRunning = false;
-				}
-				break;
-			case EQueryType::Endplay:
-				{
-					QueryTaskQueue.Empty();
-					CloseAllConnections();
-					Super::EndPlay(EEndPlayReason::Type::Quit);
-				}
-				break;
-			default:
-				break;
+				Latency.BucketUpperMs.Add(static_cast<float>(UpperMs));
 			}
-			QueryTaskQueue.RemoveAt(QueryTaskQueue.Num() - 1);
+			Latency.Counts.Append(Lane.WaitHistogram, FMySQLQueryLane::NumWaitBuckets);
+
+			Metrics.QueueDepth += Latency.QueueDepth;
+			Metrics.DispatchedQueries += Lane.DispatchedQueries;
+			TotalWaitSeconds += Lane.TotalWaitSeconds;
+			MaxWaitSeconds = FMath::Max(MaxWaitSeconds, Lane.MaxWaitSeconds);
 		}
-		else
+		if (Metrics.DispatchedQueries > 0)
 		{
-			bIsQueryTaskRunning = false;
+			Metrics.AverageWaitMs = static_cast<float>(TotalWaitSeconds * 1000.0 / Metrics.DispatchedQueries);
 		}
+		Metrics.MaxWaitMs = static_cast<float>(MaxWaitSeconds * 1000.0);
 	}
+
+	if (UMySQLDBConnector* CurrentConnector = GetConnector(ConnectionID))
+	{
+		int32 PoolSize = 0;
+		CurrentConnector->GetPoolCounts(ConnectionID, PoolSize, Metrics.OpenHandles, Metrics.IdleHandles);
+	}
+
+	return Metrics;
 }
 
 
-void AMySQLDBConnectionActor::CreateTaskData(int32 ConnectionID, TArray<FString> Queries, EQueryType QueryType)
+FQueryTaskData AMySQLDBConnectionActor::CreateTaskData(int32 ConnectionID, TArray<FString> Queries, EQueryType QueryType, bool bOrdered,
+	EMySQLQueryPriority Priority)
 {
-	// Create a struct with the query data and add it to the queue
+	// Create a struct with the query data, to be queued by EnqueueTask
 	FQueryTaskData TaskData;
 	TaskData.ConnectionID = ConnectionID;
 	TaskData.QueryID = GenerateQueryID(ConnectionID);
-	TaskData.Queries = Queries;
+	TaskData.Queries = MoveTemp(Queries);
 	TaskData.QueryType = QueryType;
-	QueryTaskQueue.Add(TaskData);
+	TaskData.bOrdered = bOrdered;
+	TaskData.Priority = Priority;
+	return TaskData;
+}
 
-	// If no task is currently running, execute the next task
-	if (!bIsQueryTaskRunning)
+void AMySQLDBConnectionActor::EnqueueTask(FQueryTaskData&& TaskData)
+{
+	FMySQLDispatchState& State = GetDispatchState(TaskData.ConnectionID);
+	FMySQLQueryLane& Lane = State.Lanes[static_cast<int32>(TaskData.Priority)];
+
+	// Counted before it is queued, so the depth never drops below zero when it is taken out
+	Lane.QueueDepth.Increment();
+	TaskData.EnqueueTime = FPlatformTime::Seconds();
+	if (TaskData.bOrdered)
+	{
+		State.OrderedTasks.Enqueue(MoveTemp(TaskData));
+	}
+	else
 	{
-		ExecuteNextQueryTask();
+		Lane.Tasks.Enqueue(MoveTemp(TaskData));
 	}
+
+	ExecuteNextQueryTask();
 }
 
-void AMySQLDBConnectionActor::UpdateDataFromQuery(int32 ConnectionID, FString Query)
+void AMySQLDBConnectionActor::UpdateDataFromQuery(int32 ConnectionID, FString Query, bool bOrdered, EMySQLQueryPriority Priority)
 {
 	TArray<FString> Queries;
 	Queries.Add(Query);
-	CreateTaskData(ConnectionID, Queries, EQueryType::Update);
+	EnqueueTask(CreateTaskData(ConnectionID, Queries, EQueryType::Update, bOrdered, Priority));
 	
 }
 
-void AMySQLDBConnectionActor::UpdateDataFromMultipleQueries(int32 ConnectionID, TArray<FString> Queries)
+void AMySQLDBConnectionActor::UpdateDataFromMultipleQueries(int32 ConnectionID, TArray<FString> Queries, bool bOrdered, EMySQLQueryPriority Priority)
+{
+	EnqueueTask(CreateTaskData(ConnectionID, Queries, EQueryType::Update, bOrdered, Priority));
+}
+
+void AMySQLDBConnectionActor::UpdateDataInTransaction(int32 ConnectionID, TArray<FString> Queries, bool bOrdered, EMySQLQueryPriority Priority)
 {
-	CreateTaskData(ConnectionID, Queries, EQueryType::Update);
+	EnqueueTask(CreateTaskData(ConnectionID, Queries, EQueryType::Transaction, bOrdered, Priority));
 }
 
-void AMySQLDBConnectionActor::SelectDataFromQuery(int32 ConnectionID, FString Query)
+void AMySQLDBConnectionActor::SelectDataFromQuery(int32 ConnectionID, FString Query, bool bOrdered, EMySQLQueryPriority Priority)
 {
 	TArray<FString> Queries;
 	Queries.Add(Query);
-	CreateTaskData(ConnectionID, Queries, EQueryType::Select);
+	EnqueueTask(CreateTaskData(ConnectionID, Queries, EQueryType::Select, bOrdered, Priority));
 }
 
-void AMySQLDBConnectionActor::UpdateImageFromPath(int32 ConnectionID, FString Query, FString UpdateParameter, int ParameterID, FString ImagePath)
+void AMySQLDBConnectionActor::SelectDataInChunks(int32 ConnectionID, FString Query, int32 ChunkSize, bool bOrdered, EMySQLQueryPriority Priority)
 {
-	if (UMySQLDBConnector* CurrentConnector = GetConnector(ConnectionID))
-	{
-		int32 QueryID = GenerateQueryID(ConnectionID);
-		FAsyncTask<UpdateMySQLImageAsyncTask>* UpdateImageQueryTask = StartAsyncTask<UpdateMySQLImageAsyncTask>(this, CurrentConnector, ConnectionID, QueryID, Query, UpdateParameter, ParameterID, ImagePath);
-		UpdateImageQueryTasks.Add(UpdateImageQueryTask);
+	TArray<FString> Queries;
+	Queries.Add(Query);
+	FQueryTaskData TaskData = CreateTaskData(ConnectionID, Queries, EQueryType::SelectChunked, bOrdered, Priority);
+	TaskData.ChunkSize = FMath::Max(1, ChunkSize);
+	EnqueueTask(MoveTemp(TaskData));
+}
+
+int32 AMySQLDBConnectionActor::PrepareStatement(int32 ConnectionID, FString Query)
+{
+	const int32 StatementID = NextStatementID++;
+	FMySQLPreparedStatement& Statement = PreparedStatements.Add(StatementID);
+	Statement.ConnectionID = ConnectionID;
+	Statement.Query = Query;
 
+	TArray<FString> Queries;
+	Queries.Add(Query);
+	FQueryTaskData TaskData = CreateTaskData(ConnectionID, Queries, EQueryType::PrepareStatement, false, EMySQLQueryPriority::Interactive);
+	TaskData.StatementID = StatementID;
+	EnqueueTask(MoveTemp(TaskData));
+	return StatementID;
+}
+
+void AMySQLDBConnectionActor::ExecuteStatement(int32 StatementID, const TArray<FMySQLParameter>& Parameters, bool bOrdered, EMySQLQueryPriority Priority)
+{
+	const FMySQLPreparedStatement* Statement = PreparedStatements.Find(StatementID);
+	if (!Statement)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Prepared statement %d not found"), StatementID);
+		return;
 	}
 
+	TArray<FString> Queries;
+	Queries.Add(Statement->Query);
+	FQueryTaskData TaskData = CreateTaskData(Statement->ConnectionID, Queries, EQueryType::ExecuteStatement, bOrdered, Priority);
+	TaskData.StatementID = StatementID;
+	TaskData.Parameters = Parameters;
+	EnqueueTask(MoveTemp(TaskData));
 }
 
-bool AMySQLDBConnectionActor::UpdateImageFromTexture(int32 ConnectionID, FString Query, FString UpdateParameter, int ParameterID, UTexture2D* Texture)
+void AMySQLDBConnectionActor::CloseStatement(int32 StatementID)
 {
+	PreparedStatements.Remove(StatementID);
+}
 
-	if (Texture)
-	{
-		FString TexturePath = FPaths::Combine(FPaths::ProjectDir(), TEXT("OutputImage.png"));
-		TexturePath = IFileManager::Get().ConvertToAbsolutePathForExternalAppForRead(*TexturePath);
+void AMySQLDBConnectionActor::ExecuteBatch(int32 ConnectionID, FString Query, const TArray<FMySQLParameterColumn>& Columns, bool bAllOrNothing, bool bOrdered,
+	EMySQLQueryPriority Priority)
+{
+	TArray<FString> Queries;
+	Queries.Add(Query);
+	FQueryTaskData TaskData = CreateTaskData(ConnectionID, Queries, EQueryType::ExecuteBatch, bOrdered, Priority);
+	TaskData.ParameterColumns = Columns;
+	TaskData.bAllOrNothing = bAllOrNothing;
+	EnqueueTask(MoveTemp(TaskData));
+}
 
-		if (UMySQLBPLibrary::SaveTextureToPath(Texture, TexturePath))
-		{
-			UpdateImageFromPath(ConnectionID, Query, UpdateParameter, ParameterID, TexturePath);
-			return true;
-		}
+void AMySQLDBConnectionActor::UpdateImageFromPath(int32 ConnectionID, FString Query, FString UpdateParameter, int ParameterID, FString ImagePath, bool bOrdered,
+	EMySQLQueryPriority Priority)
+{
+	UMySQLBPLibrary::CreateImageWrapperModule();
+
+	TArray<FString> Queries;
+	Queries.Add(Query);
+	FQueryTaskData TaskData = CreateTaskData(ConnectionID, Queries, EQueryType::UpdateImage, bOrdered, Priority);
+	TaskData.UpdateParameter = UpdateParameter;
+	TaskData.ParameterID = ParameterID;
+	TaskData.ImagePath = ImagePath;
+	EnqueueTask(MoveTemp(TaskData));
+}
+
+bool AMySQLDBConnectionActor::UpdateImageFromTexture(int32 ConnectionID, FString Query, FString UpdateParameter, int ParameterID, UTexture2D* Texture, bool bOrdered,
+	EMySQLQueryPriority Priority)
+{
 
+	UMySQLDBConnector* CurrentConnector = GetConnector(ConnectionID);
+	if (!Texture || !CurrentConnector)
+	{
+		return false;
 	}
 
-	return false;
+	UMySQLBPLibrary::CreateImageWrapperModule();
+	bIsConnectionBusy = true;
+
+	// The query ID is taken now; the task only joins the queue, ordered or not, once the pixels are read
+	TArray<FString> Queries;
+	Queries.Add(Query);
+	FQueryTaskData TaskData = CreateTaskData(ConnectionID, Queries, EQueryType::UpdateTexture, bOrdered, Priority);
+	TaskData.UpdateParameter = UpdateParameter;
+	TaskData.ParameterID = ParameterID;
+
+	// The reader may arrive on the render thread; the task is queued from the game thread either way and converts the pixels itself
+	UMySQLBPLibrary::ReadTexturePixels(Texture, [DBConnectionActor = TWeakObjectPtr<AMySQLDBConnectionActor>(this), TaskData = MoveTemp(TaskData)](
+		FMySQLTextureReader Reader) mutable
+	{
+		AsyncTask(ENamedThreads::GameThread, [DBConnectionActor, TaskData = MoveTemp(TaskData), Reader = MoveTemp(Reader)]() mutable
+		{
+			if (!DBConnectionActor.IsValid())
+			{
+				return;
+			}
+			if (Reader)
+			{
+				TaskData.TextureReader = MakeShared<FMySQLTextureReader, ESPMode::ThreadSafe>(MoveTemp(Reader));
+				DBConnectionActor->EnqueueTask(MoveTemp(TaskData));
+			}
+			else
+			{
+				DBConnectionActor->OnImageUpdateStatusChanged(TaskData.ConnectionID, TaskData.QueryID, false, TEXT("The texture has no source data or readable GPU resource"));
+				DBConnectionActor->UpdateBusyState();
+			}
+		});
+	});
+
+	return true;
 }
 
-void AMySQLDBConnectionActor::SelectImageFromQuery(int32 ConnectionID, FString Query)
+void AMySQLDBConnectionActor::SelectImageFromQuery(int32 ConnectionID, FString Query, bool bOrdered, EMySQLQueryPriority Priority)
 {
-	if (UMySQLDBConnector* CurrentConnector = GetConnector(ConnectionID))
-	{
-		int32 QueryID = GenerateQueryID(ConnectionID);
-		FAsyncTask<SelectMySQLImageAsyncTask>* SelectImageQueryTask = StartAsyncTask<SelectMySQLImageAsyncTask>(this, CurrentConnector, ConnectionID, QueryID, Query);
-		SelectImageQueryTasks.Add(SelectImageQueryTask);
+	UMySQLBPLibrary::CreateImageWrapperModule();
 
-	}
+	TArray<FString> Queries;
+	Queries.Add(Query);
+	EnqueueTask(CreateTaskData(ConnectionID, Queries, EQueryType::SelectImage, bOrdered, Priority));
 }
\ No newline at end of file
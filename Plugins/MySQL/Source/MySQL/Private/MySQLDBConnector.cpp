@@ -2,6 +2,7 @@
 
 
 #include "MySQLDBConnector.h"
+#include "HAL/FileManager.h"
 
 UMySQLDBConnector::UMySQLDBConnector()
 {
@@ -18,7 +19,8 @@ void UMySQLDBConnector::BeginDestroy()
 }
 
 
-bool UMySQLDBConnector::CreateNewConnection(int32 ConnectionID, FString Server, FString DBName, FString UserID, FString Password, int32 Port, TArray<FMySQLOptionPair> Options, FString& ErrorMessage)
+bool UMySQLDBConnector::CreateNewConnection(int32 ConnectionID, FString Server, FString DBName, FString UserID, FString Password, int32 Port, TArray<FMySQLOptionPair> Options, int32 PoolSize,
+	FString& ErrorMessage)
 {
 	if(!mysqlConnection)
 	{
@@ -39,10 +41,10 @@ bool UMySQLDBConnector::CreateNewConnection(int32 ConnectionID, FString Server,
 
 	string Eparamstring;
 
-	const char* errormessage = "";
+	string errormessage;
 	
-	bool isConnectionSet = mysqlConnection->CreateConnection(ConnectionID, server, dbname, userid, password, Port, Options, errormessage);
-	ErrorMessage = FString(UTF8_TO_TCHAR(errormessage));
+	bool isConnectionSet = mysqlConnection->CreateConnection(ConnectionID, server, dbname, userid, password, Port, Options, PoolSize, errormessage);
+	ErrorMessage = FString(UTF8_TO_TCHAR(errormessage.c_str()));
 	return isConnectionSet;
 }
 
@@ -69,20 +71,14 @@ void UMySQLDBConnector::UpdateDataFromQuery(int32 ConnectionID, int32 QueryID, F
 		{
 		
 			char* query = UMySQLBPLibrary::GetCharfromFString(Query);
-			const char* errormessage = "";
+			string errormessage;
 	
 			if (mysqlConnection->UpdateDataFromQuery(ConnectionID, query, errormessage))
 			{
 				IsSuccessful = true;
-				// Save the query ID and associated connection ID
-				QueryToConnectionMap.Add(QueryID, ConnectionID);
-			}
-			else
-			{
-				ErrorMessage = FString(UTF8_TO_TCHAR(errormessage));
 			}
 	
-			ErrorMessage = FString(UTF8_TO_TCHAR(errormessage));
+			ErrorMessage = FString(UTF8_TO_TCHAR(errormessage.c_str()));
 		
 		}
 		else
@@ -92,57 +88,277 @@ void UMySQLDBConnector::UpdateDataFromQuery(int32 ConnectionID, int32 QueryID, F
 	}
 }
 
+void UMySQLDBConnector::UpdateDataFromQueries(int32 ConnectionID, int32 QueryID, const TArray<FString>& Queries, bool& IsSuccessful,
+	FString& ErrorMessage)
+{
+	IsSuccessful = false;
+
+	if (mysqlConnection && mysqlConnection->IsValidConnection(ConnectionID))
+	{
+		std::vector<std::string> queries;
+		queries.reserve(Queries.Num());
+		for (const FString& Query : Queries)
+		{
+			queries.push_back(TCHAR_TO_UTF8(*Query));
+		}
+
+		string errormessage;
+		IsSuccessful = mysqlConnection->UpdateDataFromQueries(ConnectionID, queries, errormessage);
+		ErrorMessage = FString(UTF8_TO_TCHAR(errormessage.c_str()));
+	}
+	else
+	{
+		ErrorMessage = "Connection not Valid";
+	}
+}
+
+void UMySQLDBConnector::UpdateDataInTransaction(int32 ConnectionID, const TArray<FString>& Queries, bool& IsSuccessful, FString& ErrorMessage,
+	TArray<EMySQLStatementStatus>& StatementStatus)
+{
+	IsSuccessful = false;
+	StatementStatus.Init(EMySQLStatementStatus::NotExecuted, Queries.Num());
+
+	if (mysqlConnection && mysqlConnection->IsValidConnection(ConnectionID))
+	{
+		std::vector<std::string> queries;
+		queries.reserve(Queries.Num());
+		for (const FString& Query : Queries)
+		{
+			queries.push_back(TCHAR_TO_UTF8(*Query));
+		}
+
+		string errormessage;
+		std::vector<EMySQLStatementStatus> statementstatus;
+		IsSuccessful = mysqlConnection->ExecuteTransaction(ConnectionID, queries, statementstatus, errormessage);
+		ErrorMessage = FString(UTF8_TO_TCHAR(errormessage.c_str()));
+		StatementStatus = TArray<EMySQLStatementStatus>(statementstatus.data(), static_cast<int32>(statementstatus.size()));
+	}
+	else
+	{
+		ErrorMessage = "Connection not Valid";
+	}
+}
+
 
 void UMySQLDBConnector::SelectDataFromQuery(int32 ConnectionID, FString Query, bool& IsSuccessful, FString& ErrorMessage,
 	TArray<FMySQLDataTable>& ResultByColumn, TArray<FMySQLDataRow>& ResultByRow)
+{
+	FMySQLResultSet Result;
+	SelectResultSet(ConnectionID, Query, IsSuccessful, ErrorMessage, Result);
+
+	if (IsSuccessful)
+	{
+		Result.ToColumns(ResultByColumn);
+		Result.ToRows(ResultByRow);
+	}
+}
+
+void UMySQLDBConnector::RunQueriesNonBlocking(int32 ConnectionID, const TArray<FString>& Queries,
+	TFunction<void(bool IsSuccessful, const FString& ErrorMessage, FMySQLResultSet& Result)> OnComplete)
+{
+	std::string error;
+	if (mysqlConnection && mysqlConnection->IsValidConnection(ConnectionID))
+	{
+		std::vector<std::string> queries;
+		queries.reserve(Queries.Num());
+		for (const FString& Query : Queries)
+		{
+			queries.push_back(TCHAR_TO_UTF8(*Query));
+		}
+
+		const bool bSubmitted = mysqlConnection->SubmitQueries(ConnectionID, std::move(queries),
+			[OnComplete](bool bSuccess, const std::string& errormessage, FMySQLResultSet& Result, uint64_t AffectedRows)
+			{
+				if (bSuccess)
+				{
+					Result.Shrink();
+				}
+				OnComplete(bSuccess, FString(UTF8_TO_TCHAR(errormessage.c_str())), Result);
+			}, error);
+
+		if (bSubmitted)
+		{
+			return;
+		}
+	}
+	else
+	{
+		error = "Connection not Valid";
+	}
+
+	FMySQLResultSet EmptyResult;
+	OnComplete(false, FString(UTF8_TO_TCHAR(error.c_str())), EmptyResult);
+}
+
+void UMySQLDBConnector::SelectResultSet(int32 ConnectionID, FString Query, bool& IsSuccessful, FString& ErrorMessage, FMySQLResultSet& Result)
 {
 	IsSuccessful = false;
 
 	if (mysqlConnection && mysqlConnection->IsValidConnection(ConnectionID))
 	{
 		std::string query(TCHAR_TO_UTF8(*Query));
-		std::vector<std::string> ColumnNames;
-		std::vector<std::vector<std::string>> ColumnData;
 		std::string error;
 
-		if (mysqlConnection->SelectDataFromQuery(ConnectionID, query.c_str(), ColumnNames, ColumnData, error))
+		if (mysqlConnection->SelectResultSet(ConnectionID, query.c_str(), Result, error))
 		{
 			IsSuccessful = true;
+			Result.Shrink();
+		}
+		else
+		{
+			ErrorMessage = FString(UTF8_TO_TCHAR(error.c_str()));
+		}
+	}
+	else
+	{
+		ErrorMessage = "Connection not Valid";
+	}
+}
 
-			for (const auto& ColumnName : ColumnNames)
-			{
-				FMySQLDataTable NewDataTable;
-				NewDataTable.ColumnName = FString(ColumnName.c_str());
-				ResultByColumn.Add(NewDataTable);
-			}
+void UMySQLDBConnector::SelectDataInChunks(int32 ConnectionID, FString Query, int32 ChunkSize,
+	TFunctionRef<bool(const TArray<FString>& ColumnNames, TArray<FMySQLDataRow>& Rows)> OnChunk, bool& IsSuccessful, FString& ErrorMessage,
+	TArray<FString>& ColumnNames, TArray<FMySQLDataRow>& LastRows)
+{
+	IsSuccessful = false;
+	ChunkSize = FMath::Max(1, ChunkSize);
 
-			for (const auto& rowdata : ColumnData)
-			{
-				FMySQLDataRow Row;
+	if (mysqlConnection && mysqlConnection->IsValidConnection(ConnectionID))
+	{
+		std::string query(TCHAR_TO_UTF8(*Query));
+		std::string error;
+		LastRows.Reset(ChunkSize);
 
-				for (const auto& cdata : rowdata)
+		IsSuccessful = mysqlConnection->SelectDataStreaming(ConnectionID, query.c_str(),
+			[&ColumnNames](MYSQL_FIELD* Fields, unsigned int NumFields)
+			{
+				ColumnNames.Reset(NumFields);
+				for (unsigned int i = 0; i < NumFields; i++)
+				{
+					ColumnNames.Add(UTF8_TO_TCHAR(Fields[i].name));
+				}
+			},
+			[&ColumnNames, &LastRows, &OnChunk, ChunkSize](MYSQL_ROW Row, unsigned long* Lengths, unsigned int NumFields)
+			{
+				// Cells go straight from the socket buffer into FStrings
+				FMySQLDataRow& DataRow = LastRows.AddDefaulted_GetRef();
+				DataRow.RowData.Reserve(NumFields);
+				for (unsigned int i = 0; i < NumFields; i++)
 				{
-					int32 CIndex = &cdata - &rowdata[0];
-					if (ResultByColumn.Num() > CIndex)
+					if (Row[i])
+					{
+						const FUTF8ToTCHAR Cell(Row[i], Lengths[i]);
+						DataRow.RowData.Emplace(Cell.Length(), Cell.Get());
+					}
+					else
 					{
-						ResultByColumn[CIndex].ColumnData.Add(FString(cdata.c_str()));
+						DataRow.RowData.Add(TEXT("NULL"));
 					}
-					Row.RowData.Add(FString(cdata.c_str()));
 				}
 
-				ResultByRow.Add(Row);
-			}
+				if (LastRows.Num() < ChunkSize)
+				{
+					return true;
+				}
+
+				const bool bContinue = OnChunk(ColumnNames, LastRows);
+				LastRows.Reset(ChunkSize);
+				return bContinue;
+			},
+			error);
+
+		if (!IsSuccessful)
+		{
+			ErrorMessage = FString(UTF8_TO_TCHAR(error.c_str()));
+		}
+	}
+	else
+	{
+		ErrorMessage = "Connection not Valid";
+	}
+}
+
+void UMySQLDBConnector::PrepareStatement(int32 ConnectionID, const FString& Query, int32& ParameterCount, bool& IsSuccessful, FString& ErrorMessage)
+{
+	IsSuccessful = false;
+	ParameterCount = 0;
+
+	if (mysqlConnection && mysqlConnection->IsValidConnection(ConnectionID))
+	{
+		std::string error;
+		unsigned long parametercount = 0;
+
+		if (mysqlConnection->PrepareStatement(ConnectionID, TCHAR_TO_UTF8(*Query), parametercount, error))
+		{
+			IsSuccessful = true;
+			ParameterCount = static_cast<int32>(parametercount);
 		}
 		else
 		{
-			ErrorMessage = FString(error.c_str());
+			ErrorMessage = FString(UTF8_TO_TCHAR(error.c_str()));
 		}
 	}
 	else
 	{
 		ErrorMessage = "Connection not Valid";
 	}
+}
+
+void UMySQLDBConnector::ExecuteStatement(int32 ConnectionID, const FString& Query, const TArray<FMySQLParameter>& Parameters, bool& IsSuccessful,
+	FString& ErrorMessage, FMySQLResultSet& Result, int64& AffectedRows)
+{
+	IsSuccessful = false;
+	AffectedRows = 0;
+
+	if (mysqlConnection && mysqlConnection->IsValidConnection(ConnectionID))
+	{
+		std::string error;
+		uint64 affectedrows = 0;
 
+		if (mysqlConnection->ExecuteStatement(ConnectionID, TCHAR_TO_UTF8(*Query), Parameters, Result, affectedrows, error))
+		{
+			IsSuccessful = true;
+			AffectedRows = static_cast<int64>(affectedrows);
+			Result.Shrink();
+		}
+		else
+		{
+			ErrorMessage = FString(UTF8_TO_TCHAR(error.c_str()));
+		}
+	}
+	else
+	{
+		ErrorMessage = "Connection not Valid";
+	}
+}
+
+void UMySQLDBConnector::ExecuteBatch(int32 ConnectionID, const FString& Query, const TArray<FMySQLParameterColumn>& Columns, bool bAllOrNothing,
+	bool& IsSuccessful, FString& ErrorMessage, int64& AffectedRows, TArray<FMySQLBatchRowError>& FailedRows)
+{
+	IsSuccessful = false;
+	AffectedRows = 0;
+
+	if (mysqlConnection && mysqlConnection->IsValidConnection(ConnectionID))
+	{
+		std::string error;
+		uint64 affectedrows = 0;
+		std::vector<MySQLConnection::FBatchRowError> failedrows;
+
+		IsSuccessful = mysqlConnection->ExecuteBatch(ConnectionID, TCHAR_TO_UTF8(*Query), Columns, bAllOrNothing, failedrows, affectedrows, error);
+		AffectedRows = static_cast<int64>(affectedrows);
+		ErrorMessage = FString(UTF8_TO_TCHAR(error.c_str()));
+
+		FailedRows.Reset(static_cast<int32>(failedrows.size()));
+		for (const MySQLConnection::FBatchRowError& failedrow : failedrows)
+		{
+			FMySQLBatchRowError& RowError = FailedRows.AddDefaulted_GetRef();
+			RowError.RowIndex = failedrow.RowIndex;
+			RowError.ErrorMessage = FString(UTF8_TO_TCHAR(failedrow.ErrorMessage.c_str()));
+		}
+	}
+	else
+	{
+		ErrorMessage = "Connection not Valid";
+	}
 }
 
 void UMySQLDBConnector::UpdateImageFromPath(int32 ConnectionID, int32 QueryID, FString Query,
@@ -152,26 +368,24 @@ void UMySQLDBConnector::UpdateImageFromPath(int32 ConnectionID, int32 QueryID, F
 	IsSuccessful = false;
 	if(mysqlConnection)
 	{
-		string query(TCHAR_TO_UTF8(*Query));
-		char* querychar = _strdup(query.c_str());
-
-		char* ImageChar = UMySQLBPLibrary::GetRawImageFromPath(ImagePath);
-
-		const char* errormessage = "";
-
-		if (mysqlConnection->UpdateImageFromPath(ConnectionID, querychar, ImageChar, errormessage))
+		// Only the header is parsed; the file itself is stored as it is
+		FMySQLImageInfo ImageInfo;
+		TUniquePtr<FArchive> Reader(IFileManager::Get().CreateFileReader(*ImagePath));
+		if (!Reader || !UMySQLBPLibrary::GetImageInfoFromPath(ImagePath, ImageInfo))
 		{
-			IsSuccessful = true;
-			
-			// Save the query ID and associated connection ID
-			QueryToConnectionMap.Add(QueryID, ConnectionID);
+			ErrorMessage = FString::Printf(TEXT("%s is not a PNG, JPEG or BMP image"), *ImagePath);
+			return;
 		}
-		else
+
+		// The file goes out in chunks as it is read, so it is never in memory as a whole
+		auto ReadChunk = [&Reader](char* Buffer, size_t Capacity) -> int64
 		{
-			ErrorMessage = FString(UTF8_TO_TCHAR(errormessage));
-		}
-		
-		
+			const int64 ChunkLength = FMath::Min<int64>(Capacity, Reader->TotalSize() - Reader->Tell());
+			Reader->Serialize(Buffer, ChunkLength);
+			return Reader->IsError() ? -1 : ChunkLength;
+		};
+
+		IsSuccessful = UpdateImageBlob(ConnectionID, Query, ImageInfo, ReadChunk, ErrorMessage);
 	}
 	else
 	{
@@ -180,41 +394,108 @@ void UMySQLDBConnector::UpdateImageFromPath(int32 ConnectionID, int32 QueryID, F
 	
 }
 
-UTexture2D* UMySQLDBConnector::SelectImageFromQuery(int32 ConnectionID, int32 QueryID, FString Query,
+void UMySQLDBConnector::UpdateImageFromData(int32 ConnectionID, int32 QueryID, FString Query, FString UpdateParameter, int ParameterID,
+	const TArray64<uint8>& ImageData, const FMySQLImageInfo& ImageInfo, bool& IsSuccessful, FString& ErrorMessage)
+{
+
+	IsSuccessful = false;
+	if(mysqlConnection)
+	{
+		int64 Offset = 0;
+		auto ReadChunk = [&ImageData, &Offset](char* Buffer, size_t Capacity) -> int64
+		{
+			const int64 ChunkLength = FMath::Min<int64>(Capacity, ImageData.Num() - Offset);
+			FMemory::Memcpy(Buffer, ImageData.GetData() + Offset, ChunkLength);
+			Offset += ChunkLength;
+			return ChunkLength;
+		};
+
+		IsSuccessful = UpdateImageBlob(ConnectionID, Query, ImageInfo, ReadChunk, ErrorMessage);
+	}
+	else
+	{
+		ErrorMessage = "Connection not Valid";
+	}
+
+}
+
+bool UMySQLDBConnector::UpdateImageBlob(int32 ConnectionID, const FString& Query, const FMySQLImageInfo& ImageInfo,
+	const MySQLConnection::FBlobReader& ReadChunk, FString& ErrorMessage)
+{
+	string query(TCHAR_TO_UTF8(*Query));
+	string errormessage;
+	const vector<string> ImageMetadata = { TCHAR_TO_UTF8(*UMySQLBPLibrary::GetImageFormatName(ImageInfo.Format)), to_string(ImageInfo.Width),
+		to_string(ImageInfo.Height) };
+
+	if (!mysqlConnection->UpdateBlobStreaming(ConnectionID, query, ReadChunk, ImageMetadata, errormessage))
+	{
+		ErrorMessage = FString(UTF8_TO_TCHAR(errormessage.c_str()));
+		return false;
+	}
+	return true;
+}
+
+void UMySQLDBConnector::SelectImageFromQuery(int32 ConnectionID, int32 QueryID, FString Query, FMySQLDecodedImage& Image,
 	bool& IsSuccessful, FString& ErrorMessage)
 {
 
-	UTexture2D* ImageTexture = nullptr;
 	IsSuccessful = false;
 
 	if(mysqlConnection)
 	{
 		string query(TCHAR_TO_UTF8(*Query));
-		char* querychar = _strdup(query.c_str());
+		string errormessage;
 
-		char* ichar = nullptr;
-		const char* errormessage = "";
-		if(mysqlConnection->SelectImageFromQuery(ConnectionID, querychar, ichar,
-		                                         errormessage))
+		// Sized once from the column length, then filled chunk by chunk; the buffer goes back to the pool once decoded.
+		// Until the statement closes the row is also buffered by the client library, so the image is in memory twice
+		TArray<uint8> ImageData = UMySQLBPLibrary::AcquireImageBuffer();
+		auto OnChunk = [&ImageData](const char* Data, size_t Length, uint64 Offset, uint64 TotalLength)
 		{
-			IsSuccessful = true;
-			// Save the query ID and associated connection ID
-			QueryToConnectionMap.Add(QueryID, ConnectionID);
-			
-			char* ImageChar = const_cast<char*>(ichar);
-			ImageTexture = UMySQLBPLibrary::LoadTexturefromCharData(ImageChar);
+			if (Offset == 0)
+			{
+				ImageData.Reserve(static_cast<int32>(TotalLength));
+			}
+			ImageData.Append(reinterpret_cast<const uint8*>(Data), static_cast<int32>(Length));
+			return true;
+		};
+
+		// A format column after the image saves detecting it from the bytes
+		vector<string> ImageMetadata;
+		if(mysqlConnection->SelectBlobStreaming(ConnectionID, query, OnChunk, ImageMetadata, errormessage))
+		{
+			const EImageFormat Format = ImageMetadata.empty() ? EImageFormat::Invalid
+				: UMySQLBPLibrary::GetImageFormatFromName(UTF8_TO_TCHAR(ImageMetadata[0].c_str()));
+			IsSuccessful = UMySQLBPLibrary::DecodeImage(ImageData.GetData(), ImageData.Num(), Format, Image);
+			if (!IsSuccessful)
+			{
+				ErrorMessage = "The selected value is not a PNG, JPEG or BMP image";
+			}
 		}
 		else
 		{
-			ErrorMessage = FString(UTF8_TO_TCHAR(errormessage));
+			ErrorMessage = FString(UTF8_TO_TCHAR(errormessage.c_str()));
 		}
+		UMySQLBPLibrary::ReleaseImageBuffer(MoveTemp(ImageData));
 	}
 	else
 	{
 		ErrorMessage = "Connection not Valid";
 	}
-	
-	return ImageTexture;
 
 }
 
+bool UMySQLDBConnector::GetPoolCounts(int32 ConnectionID, int32& PoolSize, int32& OpenHandles, int32& IdleHandles)
+{
+	int poolsize = 0;
+	int openhandles = 0;
+	int idlehandles = 0;
+	if (mysqlConnection && mysqlConnection->GetPoolCounts(ConnectionID, poolsize, openhandles, idlehandles))
+	{
+		PoolSize = poolsize;
+		OpenHandles = openhandles;
+		IdleHandles = idlehandles;
+		return true;
+	}
+	return false;
+}
+
@@ -0,0 +1,352 @@
+// Copyright 2021-2023, Athian Games. All Rights Reserved.
+
+#include "MySQLHandlePool.h"
+
+#include <algorithm>
+
+
+MySQLHandlePool::MySQLHandlePool(int InMaxHandles, FOpenHandleFunction InOpenHandle, FStartOpenHandleFunction InStartOpenHandle)
+	: OpenHandle(std::move(InOpenHandle))
+	, StartOpenHandleFunction(std::move(InStartOpenHandle))
+	, MaxHandles(InMaxHandles > 0 ? InMaxHandles : 1)
+{
+}
+
+MySQLHandlePool::~MySQLHandlePool()
+{
+	Close();
+}
+
+void MySQLHandlePool::AddHandle(MYSQL* Handle)
+{
+	{
+		lock_guard<mutex> Lock(PoolMutex);
+		if (!bClosed)
+		{
+			NumHandles++;
+			IdleHandles.push_back({ Handle, FClock::now() });
+			Handle = nullptr;
+		}
+	}
+
+	if (Handle)
+	{
+		mysql_close(Handle);
+	}
+	else
+	{
+		NotifyHandleReleased();
+	}
+}
+
+MYSQL* MySQLHandlePool::Acquire(string& ErrorMessage, double& IdleSeconds)
+{
+	IdleSeconds = 0.0;
+
+	unique_lock<mutex> Lock(PoolMutex);
+	for (;;)
+	{
+		if (bClosed)
+		{
+			ErrorMessage = "Connection Not Found";
+			return nullptr;
+		}
+
+		if (!IdleHandles.empty())
+		{
+			// The most recently used handle is the one most likely to be alive
+			const FIdleHandle IdleHandle = IdleHandles.back();
+			IdleHandles.pop_back();
+			IdleSeconds = chrono::duration<double>(FClock::now() - IdleHandle.LastIOTime).count();
+			return IdleHandle.Handle;
+		}
+
+		if (NumHandles < MaxHandles)
+		{
+			// Reserve the slot first so that concurrent callers do not open more than MaxHandles
+			NumHandles++;
+			Lock.unlock();
+			MYSQL* Handle = OpenHandle(ErrorMessage);
+			Lock.lock();
+
+			if (Handle && !bClosed)
+			{
+				return Handle;
+			}
+
+			NumHandles--;
+			Lock.unlock();
+			if (Handle)
+			{
+				ErrorMessage = "Connection Not Found";
+				mysql_close(Handle);
+			}
+			NotifyHandleReleased();
+			return nullptr;
+		}
+
+		HandleReleased.wait(Lock);
+	}
+}
+
+MYSQL* MySQLHandlePool::TryAcquire(string& ErrorMessage, double& IdleSeconds, bool& bOpenSlot)
+{
+	IdleSeconds = 0.0;
+	bOpenSlot = false;
+	ErrorMessage.clear();
+
+	lock_guard<mutex> Lock(PoolMutex);
+	if (bClosed)
+	{
+		ErrorMessage = "Connection Not Found";
+		return nullptr;
+	}
+
+	if (!IdleHandles.empty())
+	{
+		const FIdleHandle IdleHandle = IdleHandles.back();
+		IdleHandles.pop_back();
+		IdleSeconds = chrono::duration<double>(FClock::now() - IdleHandle.LastIOTime).count();
+		return IdleHandle.Handle;
+	}
+
+	if (NumHandles < MaxHandles)
+	{
+		NumHandles++;
+		bOpenSlot = true;
+	}
+	return nullptr;
+}
+
+MYSQL* MySQLHandlePool::StartOpenHandle(int& WaitStatus, MYSQL*& Connected, string& ErrorMessage)
+{
+	if (StartOpenHandleFunction)
+	{
+		return StartOpenHandleFunction(WaitStatus, Connected, ErrorMessage);
+	}
+
+	WaitStatus = 0;
+	Connected = OpenHandle(ErrorMessage);
+	return Connected;
+}
+
+bool MySQLHandlePool::FinishOpenHandle(MYSQL* Handle, bool bConnected, string& ErrorMessage)
+{
+	{
+		lock_guard<mutex> Lock(PoolMutex);
+		if (Handle && bConnected && !bClosed)
+		{
+			return true;
+		}
+		if (bConnected)
+		{
+			ErrorMessage = "Connection Not Found";
+		}
+		NumHandles--;
+	}
+
+	if (Handle)
+	{
+		mysql_close(Handle);
+	}
+	NotifyHandleReleased();
+	return false;
+}
+
+void MySQLHandlePool::Release(MYSQL* Handle, bool bBroken)
+{
+	if (!Handle)
+	{
+		return;
+	}
+
+	{
+		lock_guard<mutex> Lock(PoolMutex);
+		if (bClosed || bBroken)
+		{
+			NumHandles--;
+		}
+		else
+		{
+			IdleHandles.push_back({ Handle, FClock::now() });
+			Handle = nullptr;
+		}
+	}
+
+	if (Handle)
+	{
+		CloseHandle(Handle);
+	}
+	NotifyHandleReleased();
+}
+
+void MySQLHandlePool::PingIdleHandles(double IdleSeconds)
+{
+	// Stale handles are taken out of the idle list, so they count as busy while being pinged
+	vector<MYSQL*> HandlesToPing;
+	{
+		lock_guard<mutex> Lock(PoolMutex);
+		const FClock::time_point Now = FClock::now();
+		for (size_t Index = 0; Index < IdleHandles.size();)
+		{
+			if (chrono::duration<double>(Now - IdleHandles[Index].LastIOTime).count() > IdleSeconds)
+			{
+				HandlesToPing.push_back(IdleHandles[Index].Handle);
+				IdleHandles.erase(IdleHandles.begin() + Index);
+			}
+			else
+			{
+				++Index;
+			}
+		}
+	}
+
+	for (MYSQL* Handle : HandlesToPing)
+	{
+		Release(Handle, mysql_ping(Handle) != 0);
+	}
+}
+
+void MySQLHandlePool::Close()
+{
+	vector<FIdleHandle> HandlesToClose;
+	{
+		lock_guard<mutex> Lock(PoolMutex);
+		bClosed = true;
+		HandlesToClose.swap(IdleHandles);
+		NumHandles -= static_cast<int>(HandlesToClose.size());
+	}
+
+	for (const FIdleHandle& IdleHandle : HandlesToClose)
+	{
+		CloseHandle(IdleHandle.Handle);
+	}
+	NotifyHandleReleased(true);
+}
+
+void MySQLHandlePool::AddReleaseListener(const void* Owner, function<void()> Listener)
+{
+	lock_guard<mutex> Lock(ListenerMutex);
+	for (pair<const void*, function<void()>>& Entry : ReleaseListeners)
+	{
+		if (Entry.first == Owner)
+		{
+			Entry.second = std::move(Listener);
+			return;
+		}
+	}
+	ReleaseListeners.emplace_back(Owner, std::move(Listener));
+}
+
+void MySQLHandlePool::RemoveReleaseListener(const void* Owner)
+{
+	lock_guard<mutex> Lock(ListenerMutex);
+	ReleaseListeners.erase(remove_if(ReleaseListeners.begin(), ReleaseListeners.end(),
+		[Owner](const pair<const void*, function<void()>>& Entry) { return Entry.first == Owner; }), ReleaseListeners.end());
+}
+
+void MySQLHandlePool::NotifyHandleReleased(bool bAll)
+{
+	if (bAll)
+	{
+		HandleReleased.notify_all();
+	}
+	else
+	{
+		HandleReleased.notify_one();
+	}
+
+	lock_guard<mutex> Lock(ListenerMutex);
+	for (const pair<const void*, function<void()>>& Entry : ReleaseListeners)
+	{
+		Entry.second();
+	}
+}
+
+MySQLStatementCache& MySQLHandlePool::GetStatementCache(MYSQL* Handle)
+{
+	lock_guard<mutex> Lock(PoolMutex);
+	unique_ptr<MySQLStatementCache>& StatementCache = StatementCaches[Handle];
+	if (!StatementCache)
+	{
+		StatementCache = make_unique<MySQLStatementCache>();
+	}
+	return *StatementCache;
+}
+
+void MySQLHandlePool::CloseHandle(MYSQL* Handle)
+{
+	unique_ptr<MySQLStatementCache> StatementCache;
+	{
+		lock_guard<mutex> Lock(PoolMutex);
+		auto Found = StatementCaches.find(Handle);
+		if (Found != StatementCaches.end())
+		{
+			StatementCache = std::move(Found->second);
+			StatementCaches.erase(Found);
+		}
+	}
+
+	// Statements go before their handle, so that the address can be reused by a new handle right away
+	StatementCache.reset();
+	mysql_close(Handle);
+}
+
+bool MySQLHandlePool::IsClosed() const
+{
+	lock_guard<mutex> Lock(PoolMutex);
+	return bClosed;
+}
+
+void MySQLHandlePool::GetHandleCounts(int& OpenHandles, int& IdleHandles) const
+{
+	lock_guard<mutex> Lock(PoolMutex);
+	OpenHandles = NumHandles;
+	IdleHandles = static_cast<int>(this->IdleHandles.size());
+}
+
+
+MySQLPooledHandle::MySQLPooledHandle(shared_ptr<MySQLHandlePool> InPool, MYSQL* InHandle)
+	: Pool(std::move(InPool))
+	, Handle(InHandle)
+{
+}
+
+MySQLPooledHandle::~MySQLPooledHandle()
+{
+	Reset(false);
+}
+
+MySQLPooledHandle::MySQLPooledHandle(MySQLPooledHandle&& Other) noexcept
+	: Pool(std::move(Other.Pool))
+	, Handle(Other.Handle)
+{
+	Other.Handle = nullptr;
+}
+
+MySQLPooledHandle& MySQLPooledHandle::operator=(MySQLPooledHandle&& Other) noexcept
+{
+	if (this != &Other)
+	{
+		Reset(false);
+		Pool = std::move(Other.Pool);
+		Handle = Other.Handle;
+		Other.Handle = nullptr;
+	}
+	return *this;
+}
+
+void MySQLPooledHandle::Discard()
+{
+	Reset(true);
+}
+
+void MySQLPooledHandle::Reset(bool bBroken)
+{
+	if (Pool && Handle)
+	{
+		Pool->Release(Handle, bBroken);
+	}
+	Pool.reset();
+	Handle = nullptr;
+}
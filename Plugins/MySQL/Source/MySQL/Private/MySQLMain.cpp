@@ -1,6 +1,8 @@
 // Copyright 2021-2023, Athian Games. All Rights Reserved. 
 
 #include "MySQLMain.h"
+#include "MySQLResultSet.h"
+#include "MySQLBPLibrary.h"
 
 #define WIN32_LEAN_AND_MEAN
 #include <algorithm>
@@ -10,8 +12,30 @@
 #include <vector>
 #include <tchar.h>
 #include <codecvt>
+#include <cctype>
 #include <map>
 #include <mutex>
+#include <mysql/errmsg.h>
+#include <mysql/mysqld_error.h>
+
+// The keepalive wakes up every KeepAliveIntervalSeconds and pings handles idle for longer than KeepAliveIdleSeconds
+static constexpr int KeepAliveIntervalSeconds = 15;
+static constexpr double KeepAliveIdleSeconds = 60.0;
+
+// Handles idle for longer than this have missed the keepalive and are pinged once before use
+static constexpr double HandleTrustSeconds = KeepAliveIdleSeconds + 2 * KeepAliveIntervalSeconds;
+
+static bool IsConnectionLostError(unsigned int ErrorCode)
+{
+	return ErrorCode == CR_SERVER_GONE_ERROR || ErrorCode == CR_SERVER_LOST;
+}
+
+// Errors after which the server may have rolled back the whole transaction, not just the failed statement.
+// A lock wait timeout does so only with innodb_rollback_on_timeout, which the client cannot see
+static bool IsTransactionAbortedError(unsigned int ErrorCode)
+{
+	return ErrorCode == ER_LOCK_DEADLOCK || ErrorCode == ER_LOCK_WAIT_TIMEOUT;
+}
 
 std::wstring s2ws(const std::string& str) {
 	int slength = static_cast<int>(str.length()) + 1;
@@ -21,58 +45,231 @@ std::wstring s2ws(const std::string& str) {
 	return basic_string<wchar_t, char_traits<wchar_t>, allocator<wchar_t>>(buf.begin(), buf.end());
 }
 
+MySQLConnection::~MySQLConnection()
+{
+	StopKeepAlive();
+
+	// The last connection to let go of the engine stops it, which fails its unfinished queries
+	lock_guard<mutex> Lock(AsyncEngineMutex);
+	AsyncEngine.reset();
+}
+
+shared_ptr<MySQLHandlePool> MySQLConnection::GetPool(int ConnectionID)
+{
+	lock_guard<mutex> Lock(PoolsMutex);
+	if (ConnectionID >= 0 && ConnectionID < DBConnections.size())
+	{
+		return DBConnections[ConnectionID];
+	}
+	return nullptr;
+}
+
 void MySQLConnection::CloseConnection(int ConnectionID)
 {
-	if (ConnectionID < DBConnections.size())
+	shared_ptr<MySQLHandlePool> Pool;
 	{
-		if (MYSQL* CurrentDBConnection = DBConnections[ConnectionID])
+		lock_guard<mutex> Lock(PoolsMutex);
+		if (ConnectionID >= 0 && ConnectionID < DBConnections.size())
 		{
-			mysql_close(CurrentDBConnection);  // Close the connection
-			DBConnections[ConnectionID] = nullptr;  // Nullify the pointer in the vector for safety
+			Pool = std::move(DBConnections[ConnectionID]);  // Nullify the pointer in the vector for safety
 		}
 	}
+
+	if (Pool)
+	{
+		Pool->Close();  // Handles still in use are closed when their queries finish
+	}
 }
 
 void MySQLConnection::CloseAllConnections()
 {
-	for (int iIndex = 0; iIndex < DBConnections.size(); iIndex++)
+	StopKeepAlive();
+
+	vector<shared_ptr<MySQLHandlePool>> Pools;
+	{
+		lock_guard<mutex> Lock(PoolsMutex);
+		Pools.swap(DBConnections);
+	}
+
+	for (const shared_ptr<MySQLHandlePool>& Pool : Pools)
 	{
-		CloseConnection(iIndex);
+		if (Pool)
+		{
+			Pool->Close();
+		}
 	}
 }
 
-MYSQL* MySQLConnection::GetDBConnection(int ConnectionID)
+MySQLPooledHandle MySQLConnection::GetDBConnection(int ConnectionID, string& ErrorMessage)
 {
-	if (ConnectionID < DBConnections.size())
+	shared_ptr<MySQLHandlePool> Pool = GetPool(ConnectionID);
+	if (!Pool)
+	{
+		ErrorMessage = "Connection Not Found";
+		return MySQLPooledHandle();
+	}
+
+	for (;;)
 	{
-		if (MYSQL* CurrentDBConnection = DBConnections[ConnectionID])
+		double IdleSeconds = 0.0;
+		MySQLPooledHandle CurrentDBConnection(Pool, Pool->Acquire(ErrorMessage, IdleSeconds));
+
+		// A recently used handle is trusted; a lost connection shows up in the query's own error code
+		if (!CurrentDBConnection || IdleSeconds <= HandleTrustSeconds || mysql_ping(CurrentDBConnection.Get()) == 0)
 		{
-			// Check if the connection is down (mysql_ping returns non-zero when the connection is down)
-			if (mysql_ping(CurrentDBConnection) != 0)
-			{
-				// Try to reconnect (using mysql_ping as an example, replace with mariadb_reconnect if that's valid)
-				if (mysql_ping(CurrentDBConnection) != 0)  // Check again after trying to reconnect
-					{
-						return nullptr;  // If still down after reconnect attempt, return nullptr
-					}
-			}
 			return CurrentDBConnection;
 		}
+
+		// Dead handle: drop it and take the next one, or open a new one once the idle ones run out
+		CurrentDBConnection.Discard();
 	}
-	return nullptr;
 }
 
+bool MySQLConnection::ExecuteOnHandle(int ConnectionID, bool bRetryOnLostConnection, string& ErrorMessage, const FHandleOperation& Operation)
+{
+	return ExecuteOnPooledHandle(ConnectionID, bRetryOnLostConnection, ErrorMessage, [&Operation](MySQLPooledHandle& CurrentDBConnection, string& OperationError)
+	{
+		return Operation(CurrentDBConnection.Get(), OperationError);
+	});
+}
 
-bool MySQLConnection::IsValidConnection(int ConnectionID)
+bool MySQLConnection::ExecuteOnPooledHandle(int ConnectionID, bool bRetryOnLostConnection, string& ErrorMessage, const FPooledHandleOperation& Operation)
 {
-	if (GetDBConnection(ConnectionID))
+	for (int Attempt = 0; ; Attempt++)
 	{
-		return true;
+		MySQLPooledHandle CurrentDBConnection = GetDBConnection(ConnectionID, ErrorMessage);
+		if (!CurrentDBConnection)
+		{
+			return false;
+		}
+
+		unsigned int ErrorCode = 0;
+		try
+		{
+			ErrorCode = Operation(CurrentDBConnection, ErrorMessage);
+		}
+		catch (const std::exception& ex)
+		{
+			ErrorMessage = ex.what();
+			return false;
+		}
+
+		if (ErrorCode == 0)
+		{
+			return true;
+		}
+
+		if (!IsConnectionLostError(ErrorCode))
+		{
+			return false;
+		}
+
+		CurrentDBConnection.Discard();
+		if (!bRetryOnLostConnection || Attempt > 0)
+		{
+			return false;
+		}
+	}
+}
+
+bool MySQLConnection::IsIdempotentStatement(const char* Query)
+{
+	if (!Query)
+	{
+		return false;
+	}
+
+	while (*Query && (isspace(static_cast<unsigned char>(*Query)) || *Query == '('))
+	{
+		Query++;
+	}
+
+	string Keyword;
+	while (*Query && isalpha(static_cast<unsigned char>(*Query)))
+	{
+		Keyword.push_back(static_cast<char>(toupper(static_cast<unsigned char>(*Query))));
+		Query++;
+	}
+
+	return Keyword == "SELECT" || Keyword == "SHOW" || Keyword == "DESCRIBE" || Keyword == "DESC" || Keyword == "EXPLAIN";
+}
+
+void MySQLConnection::StartKeepAlive()
+{
+	lock_guard<mutex> ControlLock(KeepAliveControlMutex);
+	if (KeepAliveThread.joinable())
+	{
+		return;
+	}
+
+	{
+		lock_guard<mutex> Lock(KeepAliveMutex);
+		bStopKeepAlive = false;
+	}
+	KeepAliveThread = thread(&MySQLConnection::KeepAliveLoop, this);
+}
+
+void MySQLConnection::StopKeepAlive()
+{
+	lock_guard<mutex> ControlLock(KeepAliveControlMutex);
+	if (!KeepAliveThread.joinable())
+	{
+		return;
+	}
+
+	{
+		lock_guard<mutex> Lock(KeepAliveMutex);
+		bStopKeepAlive = true;
+	}
+	KeepAliveWakeUp.notify_all();
+	KeepAliveThread.join();
+}
+
+void MySQLConnection::KeepAliveLoop()
+{
+	unique_lock<mutex> Lock(KeepAliveMutex);
+	while (!KeepAliveWakeUp.wait_for(Lock, chrono::seconds(KeepAliveIntervalSeconds), [this] { return bStopKeepAlive; }))
+	{
+		Lock.unlock();
+
+		vector<shared_ptr<MySQLHandlePool>> Pools;
+		{
+			lock_guard<mutex> PoolsLock(PoolsMutex);
+			Pools = DBConnections;
+		}
+
+		// Busy handles are left alone, their queries keep them alive
+		for (const shared_ptr<MySQLHandlePool>& Pool : Pools)
+		{
+			if (Pool)
+			{
+				Pool->PingIdleHandles(KeepAliveIdleSeconds);
+			}
+		}
+
+		Lock.lock();
 	}
-	else
+}
+
+
+bool MySQLConnection::IsValidConnection(int ConnectionID)
+{
+	// Liveness of the handles is checked when one is taken from the pool
+	shared_ptr<MySQLHandlePool> Pool = GetPool(ConnectionID);
+	return Pool && !Pool->IsClosed();
+}
+
+bool MySQLConnection::GetPoolCounts(int ConnectionID, int& PoolSize, int& OpenHandles, int& IdleHandles)
+{
+	shared_ptr<MySQLHandlePool> Pool = GetPool(ConnectionID);
+	if (!Pool)
 	{
 		return false;
 	}
+
+	PoolSize = Pool->GetMaxHandles();
+	Pool->GetHandleCounts(OpenHandles, IdleHandles);
+	return true;
 }
 
 unsigned int get_mysql_option(const std::string& key)
@@ -147,43 +344,99 @@ void MySQLConnection::SetMySQLBulkOptions(MYSQL* MySQLHandle, const TArray<FMySQ
 }
 
 
-bool MySQLConnection::CreateConnection(int ConnectionID, char* Server, char* DBName, char* UserID, char* Password, int Port,  TArray<FMySQLOptionPair> Options, const char*& ErrorMessage)
+MYSQL* MySQLConnection::InitHandle(const FMySQLConnectionSettings& Settings, string& ErrorMessage)
+{
+	MYSQL* CurrentDBConnection = mysql_init(nullptr);
+	if (!CurrentDBConnection)
+	{
+		ErrorMessage = "Failed to initialize MySQL connection.";
+		return nullptr;
+	}
+
+	SetMySQLBulkOptions(CurrentDBConnection, Settings.Options);
+
+	// Lets the async engine drive the handle; blocking calls work on it as before
+	mysql_options(CurrentDBConnection, MYSQL_OPT_NONBLOCK, 0);
+
+	mysql_ssl_set(CurrentDBConnection, NULL, NULL, NULL, NULL, NULL);
+
+	return CurrentDBConnection;
+}
+
+MYSQL* MySQLConnection::OpenHandle(const FMySQLConnectionSettings& Settings, string& ErrorMessage)
+{
+	MYSQL* CurrentDBConnection = InitHandle(Settings, ErrorMessage);
+	if (!CurrentDBConnection)
+	{
+		return nullptr;
+	}
+
+	if (!mysql_real_connect(CurrentDBConnection, Settings.Server.c_str(), Settings.UserID.c_str(), Settings.Password.c_str(), Settings.DBName.c_str(),
+		Settings.Port, NULL, 0))
+	{
+		ErrorMessage = mysql_error(CurrentDBConnection);
+		mysql_close(CurrentDBConnection);
+		return nullptr;
+	}
+
+	return CurrentDBConnection;
+}
+
+MYSQL* MySQLConnection::StartOpenHandle(const FMySQLConnectionSettings& Settings, int& WaitStatus, MYSQL*& Connected, string& ErrorMessage)
+{
+	MYSQL* CurrentDBConnection = InitHandle(Settings, ErrorMessage);
+	if (CurrentDBConnection)
+	{
+		// The client keeps reading the connection strings until the last mysql_real_connect_cont
+		WaitStatus = mysql_real_connect_start(&Connected, CurrentDBConnection, Settings.Server.c_str(), Settings.UserID.c_str(), Settings.Password.c_str(),
+			Settings.DBName.c_str(), Settings.Port, NULL, 0);
+	}
+	return CurrentDBConnection;
+}
+
+bool MySQLConnection::CreateConnection(int ConnectionID, char* Server, char* DBName, char* UserID, char* Password, int Port,  TArray<FMySQLOptionPair> Options,
+	int PoolSize, string& ErrorMessage)
 {
     try
     {
-        if (MYSQL* CurrentDBConnection = GetDBConnection(ConnectionID))
-    	{
-    		CloseConnection(ConnectionID);
-    	}
+    	CloseConnection(ConnectionID);
+
+    	FMySQLConnectionSettings Settings;
+    	Settings.Server = Server;
+    	Settings.DBName = DBName;
+    	Settings.UserID = UserID;
+    	Settings.Password = Password;
+    	Settings.Port = Port;
+    	Settings.Options = Options;
 
-    	MYSQL* CurrentDBConnection = mysql_init(nullptr);
+    	// The first handle is opened right away so that connection errors reach the caller,
+    	// the rest of the pool is opened when the load needs it
+    	MYSQL* CurrentDBConnection = OpenHandle(Settings, ErrorMessage);
     	if (!CurrentDBConnection)
     	{
-    		ErrorMessage = "Failed to initialize MySQL connection.";
     		return false;
     	}
 
-   
-      	SetMySQLBulkOptions(CurrentDBConnection, Options);
-
-      	mysql_ssl_set(CurrentDBConnection, NULL, NULL, NULL, NULL, NULL);
-
-		if (!mysql_real_connect(CurrentDBConnection, Server, UserID, Password, DBName, Port, NULL, 0))
+    	// The engine connects its handles on its own thread; the settings stay alive in the pool's copy of the lambda
+    	shared_ptr<MySQLHandlePool> Pool = make_shared<MySQLHandlePool>(PoolSize, [this, Settings](string& HandleErrorMessage)
     	{
-    		ErrorMessage = mysql_error(CurrentDBConnection);
-    		mysql_close(CurrentDBConnection);
-    		return false;
-    	}
-    	
-    	if (DBConnections.size() <= ConnectionID)
+    		return OpenHandle(Settings, HandleErrorMessage);
+    	}, [this, Settings](int& WaitStatus, MYSQL*& Connected, string& HandleErrorMessage)
     	{
-    		DBConnections.push_back(CurrentDBConnection);
-    	}
-    	else
+    		return StartOpenHandle(Settings, WaitStatus, Connected, HandleErrorMessage);
+    	});
+    	Pool->AddHandle(CurrentDBConnection);
+
     	{
-    		DBConnections[ConnectionID] = CurrentDBConnection;
+    		lock_guard<mutex> Lock(PoolsMutex);
+    		if (DBConnections.size() <= ConnectionID)
+    		{
+    			DBConnections.resize(ConnectionID + 1);
+    		}
+    		DBConnections[ConnectionID] = Pool;
     	}
 
+    	StartKeepAlive();
     	return true;
     }
     catch (const std::exception& ex)
@@ -194,184 +447,1118 @@ bool MySQLConnection::CreateConnection(int ConnectionID, char* Server, char* DBN
     }
 }
 
-bool MySQLConnection::UpdateDataFromQuery(int ConnectionID, char* Query, const char*& ErrorMessage)
+bool MySQLConnection::UpdateDataFromQuery(int ConnectionID, const char* Query, string& ErrorMessage)
 {
-	if (MYSQL* CurrentDBConnection = GetDBConnection(ConnectionID))
+	return ExecuteOnHandle(ConnectionID, IsIdempotentStatement(Query), ErrorMessage, [Query](MYSQL* CurrentDBConnection, string& OperationError) -> unsigned int
 	{
-		try
+		if (mysql_query(CurrentDBConnection, Query) == 0)  // Successfully executed
 		{
-			if (mysql_query(CurrentDBConnection, Query) == 0)  // Successfully executed
-			{
-				return true;
-			}
-			else
-			{
-				ErrorMessage = mysql_error(CurrentDBConnection);
-			}
+			return 0;
 		}
-		catch (const std::exception& ex)
+
+		OperationError = mysql_error(CurrentDBConnection);
+		return mysql_errno(CurrentDBConnection);
+	});
+
+}
+
+bool MySQLConnection::UpdateDataFromQueries(int ConnectionID, const vector<string>& Queries, string& ErrorMessage)
+{
+	const bool bIdempotent = all_of(Queries.begin(), Queries.end(), [](const string& Query)
+	{
+		return IsIdempotentStatement(Query.c_str());
+	});
+
+	return ExecuteOnHandle(ConnectionID, bIdempotent, ErrorMessage, [&Queries](MYSQL* CurrentDBConnection, string& OperationError) -> unsigned int
+	{
+		unsigned int ErrorCode = 0;
+		for (const string& Query : Queries)
 		{
-			ErrorMessage = ex.what();
+			ErrorCode = mysql_query(CurrentDBConnection, Query.c_str()) == 0 ? 0 : mysql_errno(CurrentDBConnection);
+			OperationError = ErrorCode == 0 ? "" : mysql_error(CurrentDBConnection);
+
+			// The rest of the batch cannot run without a server
+			if (IsConnectionLostError(ErrorCode))
+			{
+				break;
+			}
 		}
-	}
-	else
+		return ErrorCode;
+	});
+}
+
+bool MySQLConnection::ExecuteTransaction(int ConnectionID, const vector<string>& Queries, vector<EMySQLStatementStatus>& StatementStatus, string& ErrorMessage)
+{
+	StatementStatus.assign(Queries.size(), EMySQLStatementStatus::NotExecuted);
+	if (Queries.empty())
 	{
-		ErrorMessage = "Connection Not Found";
+		return true;
 	}
 
-	return false;
-
+	// Not retried: a connection lost during COMMIT leaves it open whether the transaction was written
+	return ExecuteOnHandle(ConnectionID, false, ErrorMessage, [&](MYSQL* CurrentDBConnection, string& OperationError)
+	{
+		return ExecuteTransactionOnHandle(CurrentDBConnection, Queries, StatementStatus, OperationError);
+	});
 }
 
-bool MySQLConnection::SelectDataFromQuery(int ConnectionID, const char* Query, std::vector<std::string>& ColumnNames,
-	std::vector<std::vector<std::string>>& ColumnData, std::string& ErrorMessage)
+// Appends Statement to a multi-statement packet without its trailing separators. The ; goes on a line of its own
+// so that a statement ending in a -- comment does not swallow it
+static void AppendStatement(string& Packet, const string& Statement)
 {
-	bool bStatus = false;
-
-	MYSQL* CurrentDBConnection = GetDBConnection(ConnectionID);
-	if (!CurrentDBConnection)
+	size_t Length = Statement.size();
+	while (Length > 0 && (Statement[Length - 1] == ';' || isspace(static_cast<unsigned char>(Statement[Length - 1]))))
 	{
-		ErrorMessage = "Connection Not Found";
-		return bStatus;
+		Length--;
 	}
 
-	if (mysql_query(CurrentDBConnection, Query))
+	if (!Packet.empty())
 	{
-		ErrorMessage = mysql_error(CurrentDBConnection);
-		return bStatus;
+		Packet += "\n;";
 	}
+	Packet.append(Statement, 0, Length);
+}
 
-	MYSQL_RES* result = mysql_store_result(CurrentDBConnection);
-	if (!result)
+unsigned int MySQLConnection::ExecuteTransactionOnHandle(MYSQL* CurrentDBConnection, const vector<string>& Queries,
+	vector<EMySQLStatementStatus>& StatementStatus, string& ErrorMessage)
+{
+	// Handles opened with multi statements keep them, the others only allow them for this transaction
+	const bool bToggleMultiStatements = (CurrentDBConnection->client_flag & CLIENT_MULTI_STATEMENTS) == 0;
+	if (bToggleMultiStatements && mysql_set_server_option(CurrentDBConnection, MYSQL_OPTION_MULTI_STATEMENTS_ON))
 	{
-		ErrorMessage = "No result set returned from query.";
-		return bStatus;
+		ErrorMessage = mysql_error(CurrentDBConnection);
+		return mysql_errno(CurrentDBConnection);
 	}
 
-	int num_fields = mysql_num_fields(result);
-	MYSQL_FIELD* fields = mysql_fetch_fields(result);
+	// Statement 0 is START TRANSACTION and the last one COMMIT, the queries are in between
+	static const string BeginStatement = "START TRANSACTION";
+	static const string CommitStatement = "COMMIT";
+	const size_t NumStatements = Queries.size() + 2;
+	auto GetStatement = [&Queries, NumStatements](size_t Index) -> const string&
+	{
+		return Index == 0 ? BeginStatement : Index == NumStatements - 1 ? CommitStatement : Queries[Index - 1];
+	};
 
-	// Retrieve column names only once
-	if (ColumnNames.empty())
+	unsigned int ErrorCode = 0;
+	size_t NextStatement = 0;
+	string Packet;
+	while (NextStatement < NumStatements && ErrorCode == 0)
 	{
-		for (int i = 0; i < num_fields; i++)
+		// Statements are grouped into packets of about TransactionPacketBytes to stay below max_allowed_packet
+		Packet.clear();
+		size_t EndStatement = NextStatement;
+		do
 		{
-			ColumnNames.push_back(fields[i].name);
+			AppendStatement(Packet, GetStatement(EndStatement++));
 		}
-	}
-
-	MYSQL_ROW row = mysql_fetch_row(result);
-	while (row != nullptr)
-	{
-		std::vector<std::string> RowData;
-		RowData.reserve(num_fields);
+		while (EndStatement < NumStatements && Packet.size() + GetStatement(EndStatement).size() < TransactionPacketBytes);
 
-		for (int i = 0; i < num_fields; i++)
+		// Every statement of the packet answers with one result, in order; the server stops at the first error
+		size_t Statement = NextStatement;
+		int Status = mysql_real_query(CurrentDBConnection, Packet.data(), static_cast<unsigned long>(Packet.size())) == 0 ? 0 : 1;
+		while (Status == 0)
 		{
-			if (row[i])
+			if (MYSQL_RES* Result = mysql_store_result(CurrentDBConnection))
 			{
-				RowData.push_back(row[i]);
+				mysql_free_result(Result);
 			}
-			else
+			else if (mysql_field_count(CurrentDBConnection) != 0)
+			{
+				Status = 1;
+				break;
+			}
+
+			if (Statement > 0 && Statement <= Queries.size())
+			{
+				StatementStatus[Statement - 1] = EMySQLStatementStatus::Committed;
+			}
+			Statement++;
+			Status = mysql_next_result(CurrentDBConnection);
+		}
+
+		if (Status > 0)
+		{
+			ErrorCode = mysql_errno(CurrentDBConnection);
+			ErrorMessage = mysql_error(CurrentDBConnection);
+			if (Statement > 0 && Statement <= Queries.size())
 			{
-				RowData.push_back("NULL");
+				StatementStatus[Statement - 1] = EMySQLStatementStatus::Failed;
 			}
 		}
-		ColumnData.push_back(RowData);
-		row = mysql_fetch_row(result);
+		NextStatement = EndStatement;
 	}
 
+	if (ErrorCode != 0)
+	{
+		// The handle goes back to the pool, so the open transaction is ended here; a lost session was rolled back by the server
+		if (!IsConnectionLostError(ErrorCode))
+		{
+			mysql_rollback(CurrentDBConnection);
+		}
+		replace(StatementStatus.begin(), StatementStatus.end(), EMySQLStatementStatus::Committed, EMySQLStatementStatus::RolledBack);
+	}
 
-	mysql_free_result(result); // It's important to free the result after processing
+	if (bToggleMultiStatements && !IsConnectionLostError(ErrorCode))
+	{
+		mysql_set_server_option(CurrentDBConnection, MYSQL_OPTION_MULTI_STATEMENTS_OFF);
+	}
 
-	bStatus = true;
-	return bStatus;
+	return ErrorCode;
 }
 
-bool MySQLConnection::UpdateImageFromPath(int ConnectionID, const char* Query, const char* ImageChar, const char*& ErrorMessage)
+bool MySQLConnection::SelectDataStreaming(int ConnectionID, const char* Query, const FColumnsCallback& OnColumns, const FRowCallback& OnRow,
+	string& ErrorMessage)
 {
-	MYSQL* CurrentDBConnection = GetDBConnection(ConnectionID);
-	if (!CurrentDBConnection)
+	return ExecuteOnHandle(ConnectionID, false, ErrorMessage, [&](MYSQL* CurrentDBConnection, string& OperationError)
 	{
-		ErrorMessage = "Connection Not Found";
-		return false;
-	}
+		return StreamSelectOnHandle(CurrentDBConnection, Query, OnColumns, OnRow, OperationError);
+	});
+}
 
-	MYSQL_STMT* stmt = mysql_stmt_init(CurrentDBConnection);
-	if (!stmt)
+bool MySQLConnection::SelectResultSet(int ConnectionID, const char* Query, FMySQLResultSet& Result, string& ErrorMessage)
+{
+	// Rows are parsed into their columns as they come off the socket; a retried select starts over in Reset
+	return ExecuteOnHandle(ConnectionID, true, ErrorMessage, [&](MYSQL* CurrentDBConnection, string& OperationError)
 	{
-		ErrorMessage = "Failed to initialize statement.";
-		return false;
+		return StreamSelectOnHandle(CurrentDBConnection, Query,
+			[&Result](MYSQL_FIELD* Fields, unsigned int NumFields)
+			{
+				Result.Reset(Fields, NumFields);
+			},
+			[&Result](MYSQL_ROW Row, unsigned long* Lengths, unsigned int NumFields)
+			{
+				Result.AddRow(Row, Lengths);
+				return true;
+			},
+			OperationError);
+	});
+}
+
+unsigned int MySQLConnection::StreamSelectOnHandle(MYSQL* CurrentDBConnection, const char* Query, const FColumnsCallback& OnColumns,
+	const FRowCallback& OnRow, string& ErrorMessage)
+{
+	if (mysql_query(CurrentDBConnection, Query))
+	{
+		ErrorMessage = mysql_error(CurrentDBConnection);
+		return mysql_errno(CurrentDBConnection);
 	}
 
-	if (mysql_stmt_prepare(stmt, Query, strlen(Query)))
+	MYSQL_RES* result = mysql_use_result(CurrentDBConnection);
+	if (!result)
 	{
-		ErrorMessage = mysql_stmt_error(stmt);
-		mysql_stmt_close(stmt);
-		return false;
+		if (const unsigned int ErrorCode = mysql_errno(CurrentDBConnection))
+		{
+			ErrorMessage = mysql_error(CurrentDBConnection);
+			return ErrorCode;
+		}
+		ErrorMessage = "No result set returned from query.";
+		return CR_UNKNOWN_ERROR;
 	}
 
-	MYSQL_BIND bind;
-	memset(&bind, 0, sizeof(bind));
-	bind.buffer_type = MYSQL_TYPE_BLOB;
-	bind.buffer = (void*)ImageChar;
-	bind.buffer_length = strlen(ImageChar);
+	const unsigned int num_fields = mysql_num_fields(result);
+	OnColumns(mysql_fetch_fields(result), num_fields);
 
-	if (mysql_stmt_bind_param(stmt, &bind))
+	bool bStopped = false;
+	while (MYSQL_ROW row = mysql_fetch_row(result))
 	{
-		ErrorMessage = mysql_stmt_error(stmt);
-		mysql_stmt_close(stmt);
-		return false;
+		if (!OnRow(row, mysql_fetch_lengths(result), num_fields))
+		{
+			bStopped = true;
+			break;
+		}
 	}
 
-	if (mysql_stmt_execute(stmt))
+	// mysql_fetch_row returns NULL both at the end of the data and on a read error
+	unsigned int ErrorCode = bStopped ? 0 : mysql_errno(CurrentDBConnection);
+	if (ErrorCode)
 	{
-		ErrorMessage = mysql_stmt_error(stmt);
-		mysql_stmt_close(stmt);
-		return false;
+		ErrorMessage = mysql_error(CurrentDBConnection);
 	}
 
-	mysql_stmt_close(stmt);
-	return true;
+	// Reads and throws away whatever the server still has to send for a stopped select
+	mysql_free_result(result);
+
+	if (bStopped)
+	{
+		ErrorMessage = "Select was cancelled.";
+		ErrorCode = CR_UNKNOWN_ERROR;
+	}
+	return ErrorCode;
 }
 
-bool MySQLConnection::SelectImageFromQuery(int ConnectionID, const char* Query, char*& ImageChar, const char*& ErrorMessage)
+bool MySQLConnection::SubmitQueries(int ConnectionID, vector<string> Queries, MySQLAsyncEngine::FCompletion OnComplete, string& ErrorMessage)
 {
-	MYSQL* CurrentDBConnection = GetDBConnection(ConnectionID);
-	if (!CurrentDBConnection)
+	shared_ptr<MySQLHandlePool> Pool = GetPool(ConnectionID);
+	if (!Pool || Queries.empty())
 	{
-		ErrorMessage = "Connection Not Found";
+		ErrorMessage = Pool ? "No query to run" : "Connection Not Found";
 		return false;
 	}
 
-	if (mysql_query(CurrentDBConnection, Query))
+	const bool bIdempotent = all_of(Queries.begin(), Queries.end(), [](const string& Query)
 	{
-		ErrorMessage = mysql_error(CurrentDBConnection);
-		return false;
-	}
+		return IsIdempotentStatement(Query.c_str());
+	});
 
-	MYSQL_RES* res = mysql_store_result(CurrentDBConnection);
-	if (res == nullptr)
+	shared_ptr<MySQLAsyncEngine> Engine;
 	{
-		ErrorMessage = mysql_error(CurrentDBConnection);
-		return false;
+		lock_guard<mutex> Lock(AsyncEngineMutex);
+		if (!AsyncEngine)
+		{
+			AsyncEngine = MySQLAsyncEngine::GetShared();
+		}
+		Engine = AsyncEngine;
 	}
 
-	MYSQL_ROW row = mysql_fetch_row(res);
-	if (row)
+	Engine->Submit(std::move(Pool), std::move(Queries), bIdempotent, HandleTrustSeconds, std::move(OnComplete));
+	return true;
+}
+
+bool MySQLConnection::PrepareStatement(int ConnectionID, const string& Query, unsigned long& ParameterCount, string& ErrorMessage)
+{
+	return ExecuteOnPooledHandle(ConnectionID, true, ErrorMessage, [&](MySQLPooledHandle& CurrentDBConnection, string& OperationError)
+	{
+		unsigned int ErrorCode = 0;
+		if (MYSQL_STMT* Statement = CurrentDBConnection.GetStatementCache().Prepare(CurrentDBConnection.Get(), Query, OperationError, ErrorCode))
+		{
+			ParameterCount = mysql_stmt_param_count(Statement);
+		}
+		return ErrorCode;
+	});
+}
+
+bool MySQLConnection::ExecuteStatement(int ConnectionID, const string& Query, const TArray<FMySQLParameter>& Parameters, FMySQLResultSet& Result,
+	uint64& AffectedRows, string& ErrorMessage)
+{
+	return ExecuteOnPooledHandle(ConnectionID, IsIdempotentStatement(Query.c_str()), ErrorMessage, [&](MySQLPooledHandle& CurrentDBConnection, string& OperationError)
+	{
+		return ExecuteStatementOnHandle(CurrentDBConnection, Query, Parameters, Result, AffectedRows, OperationError);
+	});
+}
+
+static MYSQL_TIME ToMySQLTime(const FDateTime& Value)
+{
+	MYSQL_TIME Time;
+	memset(&Time, 0, sizeof(Time));
+	Time.year = Value.GetYear();
+	Time.month = Value.GetMonth();
+	Time.day = Value.GetDay();
+	Time.hour = Value.GetHour();
+	Time.minute = Value.GetMinute();
+	Time.second = Value.GetSecond();
+	Time.second_part = static_cast<unsigned long>((Value.GetTicks() % ETimespan::TicksPerSecond) / ETimespan::TicksPerMicrosecond);
+	Time.time_type = MYSQL_TIMESTAMP_DATETIME;
+	return Time;
+}
+
+// Buffers referenced by the MYSQL_BINDs of one execution
+struct FMySQLParameterBuffers
+{
+	vector<MYSQL_BIND> Binds;
+	vector<string> Strings;
+	vector<MYSQL_TIME> Times;
+};
+
+static void BindParameters(const TArray<FMySQLParameter>& Parameters, FMySQLParameterBuffers& Buffers)
+{
+	// Reserved up front, the binds point into these vectors
+	Buffers.Binds.assign(Parameters.Num(), MYSQL_BIND());
+	Buffers.Strings.reserve(Parameters.Num());
+	Buffers.Times.reserve(Parameters.Num());
+
+	for (int32 Index = 0; Index < Parameters.Num(); Index++)
 	{
-		unsigned long* lengths = mysql_fetch_lengths(res);
-		ImageChar = new char[lengths[0] + 1];
-		memcpy(ImageChar, row[0], lengths[0]);
-		ImageChar[lengths[0]] = 0;
+		const FMySQLParameter& Parameter = Parameters[Index];
+		MYSQL_BIND& Bind = Buffers.Binds[Index];
+
+		switch (Parameter.Type)
+		{
+		case EMySQLParameterType::Integer:
+			Bind.buffer_type = MYSQL_TYPE_LONGLONG;
+			Bind.buffer = const_cast<int64*>(&Parameter.IntegerValue);
+			break;
+
+		case EMySQLParameterType::Float:
+			Bind.buffer_type = MYSQL_TYPE_DOUBLE;
+			Bind.buffer = const_cast<double*>(&Parameter.FloatValue);
+			break;
+
+		case EMySQLParameterType::String:
+			{
+				const FTCHARToUTF8 Utf8Value(*Parameter.StringValue, Parameter.StringValue.Len());
+				const string& Value = Buffers.Strings.emplace_back(Utf8Value.Get(), Utf8Value.Length());
+				Bind.buffer_type = MYSQL_TYPE_STRING;
+				Bind.buffer = const_cast<char*>(Value.data());
+				Bind.buffer_length = static_cast<unsigned long>(Value.size());
+			}
+			break;
+
+		case EMySQLParameterType::DateTime:
+			{
+				MYSQL_TIME& Time = Buffers.Times.emplace_back(ToMySQLTime(Parameter.DateTimeValue));
+				Bind.buffer_type = MYSQL_TYPE_DATETIME;
+				Bind.buffer = &Time;
+			}
+			break;
+
+		case EMySQLParameterType::Blob:
+			Bind.buffer_type = MYSQL_TYPE_BLOB;
+			Bind.buffer = const_cast<uint8*>(Parameter.BlobValue.GetData());
+			Bind.buffer_length = static_cast<unsigned long>(Parameter.BlobValue.Num());
+			break;
+
+		default:
+			Bind.buffer_type = MYSQL_TYPE_NULL;
+			break;
+		}
 	}
-	else
+}
+
+unsigned int MySQLConnection::ExecuteStatementOnHandle(MySQLPooledHandle& CurrentDBConnection, const string& Query, const TArray<FMySQLParameter>& Parameters,
+	FMySQLResultSet& Result, uint64& AffectedRows, string& ErrorMessage)
+{
+	MySQLStatementCache& Statements = CurrentDBConnection.GetStatementCache();
+
+	unsigned int ErrorCode = 0;
+	MYSQL_STMT* Statement = Statements.Prepare(CurrentDBConnection.Get(), Query, ErrorMessage, ErrorCode);
+	if (!Statement)
+	{
+		return ErrorCode;
+	}
+
+	const unsigned long ParameterCount = mysql_stmt_param_count(Statement);
+	if (ParameterCount != static_cast<unsigned long>(Parameters.Num()))
+	{
+		ErrorMessage = "Statement expects " + to_string(ParameterCount) + " parameters, got " + to_string(Parameters.Num()) + ".";
+		return CR_UNKNOWN_ERROR;
+	}
+
+	FMySQLParameterBuffers Buffers;
+	BindParameters(Parameters, Buffers);
+
+	if ((ParameterCount > 0 && mysql_stmt_bind_param(Statement, Buffers.Binds.data())) || mysql_stmt_execute(Statement))
+	{
+		ErrorMessage = mysql_stmt_error(Statement);
+		ErrorCode = mysql_stmt_errno(Statement);
+
+		// The server or a reconnect dropped the statement; the next execution prepares it again
+		if (ErrorCode == ER_UNKNOWN_STMT_HANDLER || ErrorCode >= CR_MIN_ERROR)
+		{
+			Statements.Remove(Query);
+		}
+		return ErrorCode;
+	}
+
+	MYSQL_RES* Metadata = mysql_stmt_result_metadata(Statement);
+	if (!Metadata)
+	{
+		AffectedRows = mysql_stmt_affected_rows(Statement);
+		return 0;
+	}
+
+	ErrorCode = FetchStatementResult(Statement, Metadata, Result, ErrorMessage);
+	mysql_free_result(Metadata);
+
+	// Leaves the cached statement ready for its next execution
+	mysql_stmt_free_result(Statement);
+	return ErrorCode;
+}
+
+bool MySQLConnection::ExecuteBatch(int ConnectionID, const string& Query, const TArray<FMySQLParameterColumn>& Columns, bool bAllOrNothing,
+	vector<FBatchRowError>& FailedRows, uint64& AffectedRows, string& ErrorMessage)
+{
+	const int32 NumRows = Columns.Num() > 0 ? Columns[0].GetNumRows() : 0;
+	for (const FMySQLParameterColumn& Column : Columns)
+	{
+		if (Column.GetNumRows() < 0)
+		{
+			ErrorMessage = "Batch columns can not be of type Blob.";
+			return false;
+		}
+		if (Column.GetNumRows() != NumRows || (Column.Nulls.Num() > 0 && Column.Nulls.Num() != NumRows))
+		{
+			ErrorMessage = "Every batch column needs the same number of rows.";
+			return false;
+		}
+	}
+
+	// Not retried: rows of a lost transaction may or may not have been written
+	return ExecuteOnPooledHandle(ConnectionID, false, ErrorMessage, [&](MySQLPooledHandle& CurrentDBConnection, string& OperationError)
+	{
+		return ExecuteBatchOnHandle(CurrentDBConnection, Query, Columns, NumRows, bAllOrNothing, FailedRows, AffectedRows, OperationError);
+	});
+}
+
+// Values of one batch column for the rows of one execution, in the layout MariaDB array binding expects
+struct FMySQLBatchColumn
+{
+	enum_field_types BufferType = MYSQL_TYPE_NULL;
+	void* Values = nullptr;
+	vector<string> Strings;
+	vector<char*> StringPointers;
+	vector<unsigned long> Lengths;
+	vector<MYSQL_TIME> Times;
+	vector<char> Indicators;
+	vector<my_bool> IsNull;
+
+	void Fill(const FMySQLParameterColumn& Column, int32 Start, int32 Count)
+	{
+		Strings.clear();
+		StringPointers.clear();
+		Lengths.clear();
+		Times.clear();
+		Indicators.assign(Count, STMT_INDICATOR_NONE);
+		IsNull.assign(Count, 0);
+		Values = nullptr;
+
+		for (int32 Row = 0; Row < Count && Column.Nulls.Num() > 0; Row++)
+		{
+			if (Column.Nulls[Start + Row])
+			{
+				Indicators[Row] = STMT_INDICATOR_NULL;
+				IsNull[Row] = 1;
+			}
+		}
+
+		switch (Column.Type)
+		{
+		case EMySQLParameterType::Integer:
+			BufferType = MYSQL_TYPE_LONGLONG;
+			Values = const_cast<int64*>(Column.IntegerValues.GetData() + Start);
+			break;
+
+		case EMySQLParameterType::Float:
+			BufferType = MYSQL_TYPE_DOUBLE;
+			Values = const_cast<double*>(Column.FloatValues.GetData() + Start);
+			break;
+
+		case EMySQLParameterType::String:
+			BufferType = MYSQL_TYPE_STRING;
+			Strings.reserve(Count);
+			for (int32 Row = 0; Row < Count; Row++)
+			{
+				const FString& Value = Column.StringValues[Start + Row];
+				const FTCHARToUTF8 Utf8Value(*Value, Value.Len());
+				Strings.emplace_back(Utf8Value.Get(), Utf8Value.Length());
+				StringPointers.push_back(const_cast<char*>(Strings.back().data()));
+				Lengths.push_back(static_cast<unsigned long>(Strings.back().size()));
+			}
+			Values = StringPointers.data();
+			break;
+
+		case EMySQLParameterType::DateTime:
+			BufferType = MYSQL_TYPE_DATETIME;
+			Times.reserve(Count);
+			for (int32 Row = 0; Row < Count; Row++)
+			{
+				Times.push_back(ToMySQLTime(Column.DateTimeValues[Start + Row]));
+			}
+			Values = Times.data();
+			break;
+
+		default:
+			BufferType = MYSQL_TYPE_NULL;
+			Indicators.assign(Count, STMT_INDICATOR_NULL);
+			IsNull.assign(Count, 1);
+			break;
+		}
+	}
+
+	// Column-wise bind of all rows; strings are passed as an array of pointers with their lengths
+	MYSQL_BIND MakeArrayBind()
+	{
+		MYSQL_BIND Bind = MYSQL_BIND();
+		Bind.buffer_type = BufferType;
+		Bind.buffer = Values;
+		Bind.length = Lengths.empty() ? nullptr : Lengths.data();
+		Bind.u.indicator = Indicators.data();
+		return Bind;
+	}
+
+	// Ordinary bind of one row
+	MYSQL_BIND MakeRowBind(int32 Row)
+	{
+		MYSQL_BIND Bind = MYSQL_BIND();
+		Bind.buffer_type = BufferType;
+		Bind.is_null = &IsNull[Row];
+		switch (BufferType)
+		{
+		case MYSQL_TYPE_LONGLONG:
+			Bind.buffer = static_cast<int64*>(Values) + Row;
+			break;
+		case MYSQL_TYPE_DOUBLE:
+			Bind.buffer = static_cast<double*>(Values) + Row;
+			break;
+		case MYSQL_TYPE_STRING:
+			Bind.buffer = StringPointers[Row];
+			Bind.buffer_length = Lengths[Row];
+			break;
+		case MYSQL_TYPE_DATETIME:
+			Bind.buffer = &Times[Row];
+			break;
+		default:
+			break;
+		}
+		return Bind;
+	}
+};
+
+static bool SupportsArrayBinding(MYSQL* Handle)
+{
+	unsigned long ExtendedCapabilities = 0;
+	return mariadb_connection(Handle)
+		&& mariadb_get_infov(Handle, MARIADB_CONNECTION_EXTENDED_SERVER_CAPABILITIES, &ExtendedCapabilities) == 0
+		&& (ExtendedCapabilities & (MARIADB_CLIENT_STMT_BULK_OPERATIONS >> 32)) != 0;
+}
+
+unsigned int MySQLConnection::ExecuteBatchOnHandle(MySQLPooledHandle& CurrentDBConnection, const string& Query, const TArray<FMySQLParameterColumn>& Columns,
+	int32 NumRows, bool bAllOrNothing, vector<FBatchRowError>& FailedRows, uint64& AffectedRows, string& ErrorMessage)
+{
+	MYSQL* Handle = CurrentDBConnection.Get();
+	MySQLStatementCache& Statements = CurrentDBConnection.GetStatementCache();
+
+	FailedRows.clear();
+	AffectedRows = 0;
+
+	unsigned int ErrorCode = 0;
+	MYSQL_STMT* Statement = Statements.Prepare(Handle, Query, ErrorMessage, ErrorCode);
+	if (!Statement)
+	{
+		return ErrorCode;
+	}
+
+	if (mysql_stmt_param_count(Statement) != static_cast<unsigned long>(Columns.Num()))
+	{
+		ErrorMessage = "Statement expects " + to_string(mysql_stmt_param_count(Statement)) + " parameters, got " + to_string(Columns.Num()) + " columns.";
+		return CR_UNKNOWN_ERROR;
+	}
+
+	if (mysql_query(Handle, "START TRANSACTION"))
+	{
+		ErrorMessage = mysql_error(Handle);
+		return mysql_errno(Handle);
+	}
+
+	// The handle goes back to the pool, so every way out of here ends the transaction
+	auto RollBack = [Handle, &AffectedRows](unsigned int FailureCode)
+	{
+		if (!IsConnectionLostError(FailureCode))
+		{
+			mysql_rollback(Handle);
+		}
+		AffectedRows = 0;
+		return FailureCode;
+	};
+
+	const bool bArrayBinding = SupportsArrayBinding(Handle);
+	vector<FMySQLBatchColumn> BatchColumns(Columns.Num());
+	vector<MYSQL_BIND> Binds(Columns.Num());
+
+	for (int32 Start = 0; Start < NumRows; Start += BatchRowsPerExecute)
+	{
+		const int32 Count = FMath::Min(BatchRowsPerExecute, NumRows - Start);
+		for (int32 Index = 0; Index < Columns.Num(); Index++)
+		{
+			BatchColumns[Index].Fill(Columns[Index], Start, Count);
+		}
+
+		if (bArrayBinding)
+		{
+			// A failed array keeps the rows it applied before the bad one; the savepoint lets the row pass start from a clean chunk
+			if (mysql_query(Handle, "SAVEPOINT mysql_batch"))
+			{
+				ErrorMessage = mysql_error(Handle);
+				return RollBack(mysql_errno(Handle));
+			}
+
+			unsigned int ArraySize = static_cast<unsigned int>(Count);
+			for (int32 Index = 0; Index < Columns.Num(); Index++)
+			{
+				Binds[Index] = BatchColumns[Index].MakeArrayBind();
+			}
+
+			const bool bFailed = mysql_stmt_attr_set(Statement, STMT_ATTR_ARRAY_SIZE, &ArraySize)
+				|| (Columns.Num() > 0 && mysql_stmt_bind_param(Statement, Binds.data()))
+				|| mysql_stmt_execute(Statement);
+			ErrorCode = bFailed ? mysql_stmt_errno(Statement) : 0;
+			if (bFailed)
+			{
+				ErrorMessage = mysql_stmt_error(Statement);
+			}
+			else
+			{
+				AffectedRows += mysql_stmt_affected_rows(Statement);
+			}
+
+			// The cached statement is shared with single executions
+			ArraySize = 0;
+			mysql_stmt_attr_set(Statement, STMT_ATTR_ARRAY_SIZE, &ArraySize);
+
+			// The savepoint and the chunks before it may already be gone, so retrying row by row would commit a partial batch
+			if (IsConnectionLostError(ErrorCode) || IsTransactionAbortedError(ErrorCode))
+			{
+				return RollBack(ErrorCode);
+			}
+			if (mysql_query(Handle, bFailed ? "ROLLBACK TO SAVEPOINT mysql_batch" : "RELEASE SAVEPOINT mysql_batch"))
+			{
+				ErrorMessage = mysql_error(Handle);
+				return RollBack(mysql_errno(Handle));
+			}
+			if (!bFailed)
+			{
+				continue;
+			}
+		}
+
+		// One execution per row: the path for servers without array binding, and how a failed array finds its bad rows.
+		// A failed row only undoes its own statement, the rest of the transaction stays - unless the server aborted it
+		for (int32 Row = 0; Row < Count; Row++)
+		{
+			for (int32 Index = 0; Index < Columns.Num(); Index++)
+			{
+				Binds[Index] = BatchColumns[Index].MakeRowBind(Row);
+			}
+
+			if ((Columns.Num() > 0 && mysql_stmt_bind_param(Statement, Binds.data())) || mysql_stmt_execute(Statement))
+			{
+				ErrorCode = mysql_stmt_errno(Statement);
+				if (IsConnectionLostError(ErrorCode) || IsTransactionAbortedError(ErrorCode))
+				{
+					ErrorMessage = mysql_stmt_error(Statement);
+					return RollBack(ErrorCode);
+				}
+				FailedRows.push_back({ Start + Row, mysql_stmt_error(Statement) });
+			}
+			else
+			{
+				AffectedRows += mysql_stmt_affected_rows(Statement);
+			}
+		}
+	}
+
+	if (!FailedRows.empty() && bAllOrNothing)
+	{
+		ErrorMessage = to_string(FailedRows.size()) + " of " + to_string(NumRows) + " rows failed, the batch was rolled back.";
+		return RollBack(CR_UNKNOWN_ERROR);
+	}
+
+	if (mysql_commit(Handle))
+	{
+		ErrorMessage = mysql_error(Handle);
+		return RollBack(mysql_errno(Handle));
+	}
+
+	ErrorMessage = FailedRows.empty() ? "" : to_string(FailedRows.size()) + " of " + to_string(NumRows) + " rows failed.";
+	return 0;
+}
+
+// Fetch target of one column; text, blob and read-as-text cells are read separately once their length is known
+struct FMySQLBinaryCell
+{
+	union
+	{
+		long long Integer;
+		double Double;
+	};
+	MYSQL_TIME Time;
+	unsigned long Length;
+	my_bool IsNull;
+	my_bool Error;
+};
+
+static bool ToDateTime(const MYSQL_TIME& Time, FDateTime& OutDateTime)
+{
+	if (!FDateTime::Validate(Time.year, Time.month, Time.day, Time.hour, Time.minute, Time.second, 0))
 	{
-		ErrorMessage = "No data returned.";
-		mysql_free_result(res);
 		return false;
 	}
 
-	mysql_free_result(res);
+	OutDateTime = FDateTime(Time.year, Time.month, Time.day, Time.hour, Time.minute, Time.second)
+		+ FTimespan(static_cast<int64>(Time.second_part) * ETimespan::TicksPerMicrosecond);
 	return true;
 }
+
+// The text the server sends for a date ToDateTime rejects, e.g. '0000-00-00 00:00:00'
+static string ToWireText(const MYSQL_TIME& Time, const MYSQL_FIELD& Field)
+{
+	char Buffer[40];
+	int Length = snprintf(Buffer, sizeof(Buffer), "%04u-%02u-%02u", Time.year, Time.month, Time.day);
+	if (Field.type != MYSQL_TYPE_DATE && Field.type != MYSQL_TYPE_NEWDATE)
+	{
+		Length += snprintf(Buffer + Length, sizeof(Buffer) - Length, " %02u:%02u:%02u", Time.hour, Time.minute, Time.second);
+		const unsigned int FractionDigits = FMath::Min<unsigned int>(Field.decimals, 6);
+		if (FractionDigits > 0)
+		{
+			char Fraction[8];
+			snprintf(Fraction, sizeof(Fraction), "%06lu", Time.second_part);
+			Length += snprintf(Buffer + Length, sizeof(Buffer) - Length, ".%.*s", static_cast<int>(FractionDigits), Fraction);
+		}
+	}
+	return string(Buffer, Length);
+}
+
+unsigned int MySQLConnection::FetchStatementResult(MYSQL_STMT* Statement, MYSQL_RES* Metadata, FMySQLResultSet& Result, string& ErrorMessage)
+{
+	const unsigned int NumFields = mysql_num_fields(Metadata);
+	MYSQL_FIELD* Fields = mysql_fetch_fields(Metadata);
+	Result.Reset(Fields, NumFields);
+
+	vector<FMySQLBinaryCell> Cells(NumFields);
+	vector<MYSQL_BIND> Binds(NumFields, MYSQL_BIND());
+	for (unsigned int Index = 0; Index < NumFields; Index++)
+	{
+		FMySQLBinaryCell& Cell = Cells[Index];
+		MYSQL_BIND& Bind = Binds[Index];
+		Bind.length = &Cell.Length;
+		Bind.is_null = &Cell.IsNull;
+		Bind.error = &Cell.Error;
+
+		if (Result.IsReadAsText(Index))
+		{
+			// The client library formats these like the server's text protocol, ZEROFILL padding included
+			Bind.buffer_type = MYSQL_TYPE_STRING;
+			continue;
+		}
+
+		switch (Result.GetColumnType(Index))
+		{
+		case EMySQLColumnType::Integer:
+			Bind.buffer_type = MYSQL_TYPE_LONGLONG;
+			Bind.buffer = &Cell.Integer;
+			Bind.is_unsigned = (Fields[Index].flags & UNSIGNED_FLAG) != 0;
+			break;
+
+		case EMySQLColumnType::Double:
+			Bind.buffer_type = MYSQL_TYPE_DOUBLE;
+			Bind.buffer = &Cell.Double;
+			break;
+
+		case EMySQLColumnType::DateTime:
+			Bind.buffer_type = MYSQL_TYPE_DATETIME;
+			Bind.buffer = &Cell.Time;
+			Bind.buffer_length = sizeof(Cell.Time);
+			break;
+
+		default:
+			// No buffer: the fetch only reports the length, the bytes are read into the result below
+			Bind.buffer_type = Result.GetColumnType(Index) == EMySQLColumnType::Blob ? MYSQL_TYPE_BLOB : MYSQL_TYPE_STRING;
+			break;
+		}
+	}
+
+	if (mysql_stmt_bind_result(Statement, Binds.data()))
+	{
+		ErrorMessage = mysql_stmt_error(Statement);
+		return mysql_stmt_errno(Statement);
+	}
+
+	// Reads the whole value of a column bound without a buffer
+	auto FetchColumn = [&](unsigned int Index, void* Target, unsigned long Length)
+	{
+		MYSQL_BIND ColumnBind = Binds[Index];
+		unsigned long ColumnLength = 0;
+		ColumnBind.buffer = Target;
+		ColumnBind.buffer_length = Length;
+		ColumnBind.length = &ColumnLength;
+		return mysql_stmt_fetch_column(Statement, &ColumnBind, Index, 0) == 0;
+	};
+
+	string WireText;
+	int Status;
+	while ((Status = mysql_stmt_fetch(Statement)) == 0 || Status == MYSQL_DATA_TRUNCATED)
+	{
+		for (unsigned int Index = 0; Index < NumFields; Index++)
+		{
+			const FMySQLBinaryCell& Cell = Cells[Index];
+			if (Cell.IsNull)
+			{
+				Result.AddNullCell(Index);
+				continue;
+			}
+
+			if (Result.IsReadAsText(Index))
+			{
+				WireText.assign(Cell.Length, '\0');
+				if (Cell.Length > 0 && !FetchColumn(Index, &WireText[0], Cell.Length))
+				{
+					ErrorMessage = mysql_stmt_error(Statement);
+					return mysql_stmt_errno(Statement) ? mysql_stmt_errno(Statement) : CR_UNKNOWN_ERROR;
+				}
+				Result.AddTextCell(Index, WireText.c_str(), static_cast<int32>(WireText.size()));
+				continue;
+			}
+
+			switch (Result.GetColumnType(Index))
+			{
+			case EMySQLColumnType::Integer:
+				Result.AddInt64Cell(Index, Cell.Integer);
+				break;
+
+			case EMySQLColumnType::Double:
+				Result.AddDoubleCell(Index, Cell.Double);
+				break;
+
+			case EMySQLColumnType::DateTime:
+				{
+					FDateTime Value;
+					if (ToDateTime(Cell.Time, Value))
+					{
+						Result.AddDateTimeCell(Index, Value);
+					}
+					else
+					{
+						WireText = ToWireText(Cell.Time, Fields[Index]);
+						Result.AddTextCell(Index, WireText.c_str(), static_cast<int32>(WireText.size()));
+					}
+				}
+				break;
+
+			default:
+				{
+					uint8* Target = Result.AddBytesCell(Index, static_cast<int32>(Cell.Length));
+					if (Cell.Length > 0 && !FetchColumn(Index, Target, Cell.Length))
+					{
+						ErrorMessage = mysql_stmt_error(Statement);
+						return mysql_stmt_errno(Statement) ? mysql_stmt_errno(Statement) : CR_UNKNOWN_ERROR;
+					}
+				}
+				break;
+			}
+		}
+		Result.FinishRow();
+	}
+
+	if (Status != MYSQL_NO_DATA)
+	{
+		ErrorMessage = mysql_stmt_error(Statement);
+		return mysql_stmt_errno(Statement);
+	}
+	return 0;
+}
+
+bool MySQLConnection::UpdateBlobStreaming(int ConnectionID, const string& Query, const FBlobReader& ReadChunk, const vector<string>& ExtraParameters,
+	string& ErrorMessage)
+{
+	return ExecuteOnHandle(ConnectionID, false, ErrorMessage, [&](MYSQL* CurrentDBConnection, string& OperationError)
+	{
+		return UpdateBlobOnHandle(CurrentDBConnection, Query, ReadChunk, ExtraParameters, OperationError);
+	});
+}
+
+unsigned int MySQLConnection::UpdateBlobOnHandle(MYSQL* CurrentDBConnection, const string& Query, const FBlobReader& ReadChunk,
+	const vector<string>& ExtraParameters, string& ErrorMessage)
+{
+	MYSQL_STMT* stmt = mysql_stmt_init(CurrentDBConnection);
+	if (!stmt)
+	{
+		ErrorMessage = "Failed to initialize statement.";
+		return CR_OUT_OF_MEMORY;
+	}
+
+	auto FailStatement = [stmt, &ErrorMessage]()
+	{
+		ErrorMessage = mysql_stmt_error(stmt);
+		const unsigned int ErrorCode = mysql_stmt_errno(stmt);
+		mysql_stmt_close(stmt);
+		return ErrorCode;
+	};
+
+	if (mysql_stmt_prepare(stmt, Query.c_str(), static_cast<unsigned long>(Query.size())))
+	{
+		return FailStatement();
+	}
+
+	const unsigned long ParamCount = mysql_stmt_param_count(stmt);
+	if (ParamCount != 1 && ParamCount != 1 + ExtraParameters.size())
+	{
+		ErrorMessage = "The query needs one ? marker for the BLOB value, or one more for each of its " + to_string(ExtraParameters.size()) + " extra values.";
+		mysql_stmt_close(stmt);
+		return CR_UNKNOWN_ERROR;
+	}
+
+	// No buffer for the value: it is sent as long data before the execute
+	vector<MYSQL_BIND> binds(ParamCount);
+	vector<unsigned long> ExtraLengths(ParamCount, 0);
+	memset(binds.data(), 0, sizeof(MYSQL_BIND) * ParamCount);
+	binds[0].buffer_type = MYSQL_TYPE_LONG_BLOB;
+	for (unsigned long Index = 1; Index < ParamCount; ++Index)
+	{
+		const string& Value = ExtraParameters[Index - 1];
+		ExtraLengths[Index] = static_cast<unsigned long>(Value.size());
+		binds[Index].buffer_type = MYSQL_TYPE_STRING;
+		binds[Index].buffer = const_cast<char*>(Value.data());
+		binds[Index].buffer_length = ExtraLengths[Index];
+		binds[Index].length = &ExtraLengths[Index];
+	}
+
+	if (mysql_stmt_bind_param(stmt, binds.data()))
+	{
+		return FailStatement();
+	}
+
+	vector<char> Chunk(BlobChunkBytes);
+	bool bSentData = false;
+	while (true)
+	{
+		const int64 ChunkLength = ReadChunk(Chunk.data(), Chunk.size());
+		if (ChunkLength < 0)
+		{
+			ErrorMessage = "Failed to read the BLOB value.";
+			mysql_stmt_close(stmt);
+			return CR_UNKNOWN_ERROR;
+		}
+		if (ChunkLength == 0 && bSentData)
+		{
+			break;
+		}
+
+		// An empty value is still sent once, so the parameter is not left without data
+		if (mysql_stmt_send_long_data(stmt, 0, Chunk.data(), static_cast<unsigned long>(ChunkLength)))
+		{
+			return FailStatement();
+		}
+		bSentData = true;
+		if (ChunkLength == 0)
+		{
+			break;
+		}
+	}
+
+	if (mysql_stmt_execute(stmt))
+	{
+		return FailStatement();
+	}
+
+	mysql_stmt_close(stmt);
+	return 0;
+}
+
+bool MySQLConnection::SelectBlobStreaming(int ConnectionID, const string& Query, const FBlobWriter& OnChunk, vector<string>& OtherColumns, string& ErrorMessage)
+{
+	// Like the other streams, a select that already handed out chunks is not run again
+	return ExecuteOnHandle(ConnectionID, false, ErrorMessage, [&](MYSQL* CurrentDBConnection, string& OperationError)
+	{
+		return SelectBlobOnHandle(CurrentDBConnection, Query, OnChunk, OtherColumns, OperationError);
+	});
+}
+
+unsigned int MySQLConnection::SelectBlobOnHandle(MYSQL* CurrentDBConnection, const string& Query, const FBlobWriter& OnChunk, vector<string>& OtherColumns,
+	string& ErrorMessage)
+{
+	MYSQL_STMT* stmt = mysql_stmt_init(CurrentDBConnection);
+	if (!stmt)
+	{
+		ErrorMessage = "Failed to initialize statement.";
+		return CR_OUT_OF_MEMORY;
+	}
+
+	auto FailStatement = [stmt, &ErrorMessage]()
+	{
+		ErrorMessage = mysql_stmt_error(stmt);
+		const unsigned int ErrorCode = mysql_stmt_errno(stmt);
+		mysql_stmt_close(stmt);
+		return ErrorCode;
+	};
+
+	if (mysql_stmt_prepare(stmt, Query.c_str(), static_cast<unsigned long>(Query.size())) || mysql_stmt_execute(stmt))
+	{
+		return FailStatement();
+	}
+
+	const unsigned int NumFields = mysql_stmt_field_count(stmt);
+	if (NumFields == 0)
+	{
+		ErrorMessage = "No result set returned from query.";
+		mysql_stmt_close(stmt);
+		return CR_UNKNOWN_ERROR;
+	}
+
+	// Every column is bound without a buffer, so the fetch only reports lengths. The row itself is already in the
+	// library's buffer after the fetch; the chunks below only bound the copy into the caller's memory
+	vector<MYSQL_BIND> Columns(NumFields);
+	vector<unsigned long> Lengths(NumFields, 0);
+	vector<my_bool> IsNull(NumFields, 0);
+	memset(Columns.data(), 0, sizeof(MYSQL_BIND) * NumFields);
+	for (unsigned int Index = 0; Index < NumFields; ++Index)
+	{
+		Columns[Index].buffer_type = MYSQL_TYPE_LONG_BLOB;
+		Columns[Index].length = &Lengths[Index];
+		Columns[Index].is_null = &IsNull[Index];
+	}
+
+	if (mysql_stmt_bind_result(stmt, Columns.data()))
+	{
+		return FailStatement();
+	}
+
+	const int FetchStatus = mysql_stmt_fetch(stmt);
+	if (FetchStatus == MYSQL_NO_DATA)
+	{
+		ErrorMessage = "No data returned.";
+		mysql_stmt_close(stmt);
+		return CR_UNKNOWN_ERROR;
+	}
+	if (FetchStatus != 0 && FetchStatus != MYSQL_DATA_TRUNCATED)
+	{
+		return FailStatement();
+	}
+
+	// The other columns are small metadata and are read whole
+	OtherColumns.assign(NumFields - 1, string());
+	for (unsigned int Index = 1; Index < NumFields; ++Index)
+	{
+		string& Value = OtherColumns[Index - 1];
+		if (IsNull[Index] || Lengths[Index] == 0)
+		{
+			continue;
+		}
+
+		Value.resize(Lengths[Index]);
+		MYSQL_BIND ValueBind;
+		memset(&ValueBind, 0, sizeof(ValueBind));
+		unsigned long ValueLength = 0;
+		ValueBind.buffer_type = MYSQL_TYPE_STRING;
+		ValueBind.buffer = &Value[0];
+		ValueBind.buffer_length = Lengths[Index];
+		ValueBind.length = &ValueLength;
+		if (mysql_stmt_fetch_column(stmt, &ValueBind, Index, 0))
+		{
+			return FailStatement();
+		}
+	}
+
+	const uint64 TotalLength = IsNull[0] ? 0 : Lengths[0];
+	vector<char> Chunk(static_cast<size_t>(min<uint64>(BlobChunkBytes, max<uint64>(TotalLength, 1))));
+
+	MYSQL_BIND ChunkBind;
+	memset(&ChunkBind, 0, sizeof(ChunkBind));
+	unsigned long ColumnLength = 0;
+	ChunkBind.buffer_type = MYSQL_TYPE_LONG_BLOB;
+	ChunkBind.buffer = Chunk.data();
+	ChunkBind.buffer_length = static_cast<unsigned long>(Chunk.size());
+	ChunkBind.length = &ColumnLength;
+
+	if (TotalLength == 0)
+	{
+		OnChunk(Chunk.data(), 0, 0, 0);
+	}
+
+	for (uint64 Offset = 0; Offset < TotalLength;)
+	{
+		if (mysql_stmt_fetch_column(stmt, &ChunkBind, 0, static_cast<unsigned long>(Offset)))
+		{
+			return FailStatement();
+		}
+
+		const size_t ChunkLength = static_cast<size_t>(min<uint64>(Chunk.size(), TotalLength - Offset));
+		if (!OnChunk(Chunk.data(), ChunkLength, Offset, TotalLength))
+		{
+			break;
+		}
+		Offset += ChunkLength;
+	}
+
+	// Closing the statement discards any rows after the first
+	mysql_stmt_close(stmt);
+	return 0;
+}
@@ -0,0 +1,538 @@
+// Copyright 2021-2023, Athian Games. All Rights Reserved.
+
+#include "MySQLResultSet.h"
+
+#include <charconv>
+#include <cstdlib>
+
+// charsetnr of binary strings and blobs
+static constexpr unsigned int BinaryCharsetNumber = 63;
+
+static EMySQLColumnType GetColumnTypeForField(const MYSQL_FIELD& Field)
+{
+	switch (Field.type)
+	{
+	case MYSQL_TYPE_TINY:
+	case MYSQL_TYPE_SHORT:
+	case MYSQL_TYPE_LONG:
+	case MYSQL_TYPE_INT24:
+	case MYSQL_TYPE_LONGLONG:
+	case MYSQL_TYPE_YEAR:
+		return EMySQLColumnType::Integer;
+
+	case MYSQL_TYPE_FLOAT:
+	case MYSQL_TYPE_DOUBLE:
+		return EMySQLColumnType::Double;
+
+	case MYSQL_TYPE_DATE:
+	case MYSQL_TYPE_NEWDATE:
+	case MYSQL_TYPE_DATETIME:
+	case MYSQL_TYPE_TIMESTAMP:
+		return EMySQLColumnType::DateTime;
+
+	case MYSQL_TYPE_TINY_BLOB:
+	case MYSQL_TYPE_MEDIUM_BLOB:
+	case MYSQL_TYPE_LONG_BLOB:
+	case MYSQL_TYPE_BLOB:
+	case MYSQL_TYPE_STRING:
+	case MYSQL_TYPE_VAR_STRING:
+	case MYSQL_TYPE_VARCHAR:
+	case MYSQL_TYPE_BIT:
+	case MYSQL_TYPE_GEOMETRY:
+		return Field.charsetnr == BinaryCharsetNumber ? EMySQLColumnType::Blob : EMySQLColumnType::Text;
+
+	// DECIMAL keeps its exact text, TIME can be negative or over 24 hours
+	default:
+		return EMySQLColumnType::Text;
+	}
+}
+
+static bool IsDateOnlyField(enum_field_types FieldType)
+{
+	return FieldType == MYSQL_TYPE_DATE || FieldType == MYSQL_TYPE_NEWDATE;
+}
+
+static int32 ParseDigits(const char*& Text, const char* End, int32 MaxDigits)
+{
+	int32 Value = 0;
+	for (int32 Digit = 0; Digit < MaxDigits && Text < End && *Text >= '0' && *Text <= '9'; Digit++, Text++)
+	{
+		Value = Value * 10 + (*Text - '0');
+	}
+	return Value;
+}
+
+// "YYYY-MM-DD[ HH:MM:SS[.ffffff]]"; false for zero and otherwise invalid dates
+static bool ParseDateTime(const char* Text, unsigned long Length, FDateTime& OutDateTime)
+{
+	const char* End = Text + Length;
+	const int32 Year = ParseDigits(Text, End, 4);
+	Text += Text < End ? 1 : 0;
+	const int32 Month = ParseDigits(Text, End, 2);
+	Text += Text < End ? 1 : 0;
+	const int32 Day = ParseDigits(Text, End, 2);
+
+	int32 Hour = 0;
+	int32 Minute = 0;
+	int32 Second = 0;
+	int32 Microsecond = 0;
+	if (Text < End)
+	{
+		Text++;
+		Hour = ParseDigits(Text, End, 2);
+		Text += Text < End ? 1 : 0;
+		Minute = ParseDigits(Text, End, 2);
+		Text += Text < End ? 1 : 0;
+		Second = ParseDigits(Text, End, 2);
+
+		if (Text < End && *Text == '.')
+		{
+			Text++;
+			const char* FractionStart = Text;
+			Microsecond = ParseDigits(Text, End, 6);
+			for (int64 Digits = Text - FractionStart; Digits < 6; Digits++)
+			{
+				Microsecond *= 10;
+			}
+		}
+	}
+
+	if (!FDateTime::Validate(Year, Month, Day, Hour, Minute, Second, 0))
+	{
+		return false;
+	}
+
+	OutDateTime = FDateTime(Year, Month, Day, Hour, Minute, Second) + FTimespan(static_cast<int64>(Microsecond) * ETimespan::TicksPerMicrosecond);
+	return true;
+}
+
+void FMySQLResultSet::Reset(const MYSQL_FIELD* Fields, unsigned int NumFields)
+{
+	NumRows = 0;
+	Columns.Reset(NumFields);
+
+	for (unsigned int Index = 0; Index < NumFields; Index++)
+	{
+		const MYSQL_FIELD& Field = Fields[Index];
+		FColumn& Column = Columns.AddDefaulted_GetRef();
+		Column.Name = UTF8_TO_TCHAR(Field.name);
+		Column.Type = GetColumnTypeForField(Field);
+		Column.FieldType = Field.type;
+		Column.Decimals = Field.decimals;
+
+		// Doubles printed by to_chars and integers without their ZEROFILL padding would not match the server's text
+		Column.bReadAsText = Column.Type == EMySQLColumnType::Double || (Column.Type == EMySQLColumnType::Integer && (Field.flags & ZEROFILL_FLAG) != 0);
+
+		if (Column.Type == EMySQLColumnType::Text || Column.Type == EMySQLColumnType::Blob)
+		{
+			Column.Offsets.Add(0);
+		}
+		if (Column.bReadAsText || Column.Type == EMySQLColumnType::DateTime)
+		{
+			Column.WireTextOffsets.Add(0);
+		}
+	}
+}
+
+void FMySQLResultSet::AddRow(const MYSQL_ROW Row, const unsigned long* Lengths)
+{
+	for (int32 Index = 0; Index < Columns.Num(); Index++)
+	{
+		if (Row[Index])
+		{
+			AddTextCell(Index, Row[Index], static_cast<int32>(Lengths[Index]));
+		}
+		else
+		{
+			AddNullCell(Index);
+		}
+	}
+
+	FinishRow();
+}
+
+void FMySQLResultSet::AddTextCell(int32 Column, const char* Text, int32 Length)
+{
+	FColumn& CurrentColumn = Columns[Column];
+	switch (CurrentColumn.Type)
+	{
+	case EMySQLColumnType::Integer:
+		// BIGINT UNSIGNED above INT64_MAX wraps around
+		AddFixed<int64>(CurrentColumn, *Text == '-' ? strtoll(Text, nullptr, 10) : static_cast<int64>(strtoull(Text, nullptr, 10)), false);
+		AddWireText(CurrentColumn, Text, CurrentColumn.bReadAsText ? Length : 0);
+		break;
+
+	case EMySQLColumnType::Double:
+		AddFixed<double>(CurrentColumn, strtod(Text, nullptr), false);
+		AddWireText(CurrentColumn, Text, Length);
+		break;
+
+	case EMySQLColumnType::DateTime:
+		{
+			// Zero dates ('0000-00-00') have no FDateTime: they read as an empty date and keep their text
+			FDateTime Value;
+			const bool bParsed = ParseDateTime(Text, Length, Value);
+			AddFixed<int64>(CurrentColumn, bParsed ? Value.GetTicks() : 0, false);
+			AddWireText(CurrentColumn, Text, bParsed ? 0 : Length);
+		}
+		break;
+
+	default:
+		FMemory::Memcpy(AddBytesCell(Column, Length), Text, Length);
+		break;
+	}
+}
+
+void FMySQLResultSet::AddWireText(FColumn& Column, const char* Text, int32 Length)
+{
+	if (Column.WireTextOffsets.Num() > 0)
+	{
+		Column.WireText.Append(reinterpret_cast<const uint8*>(Text), Length);
+		Column.WireTextOffsets.Add(Column.WireText.Num());
+	}
+}
+
+void FMySQLResultSet::AddNullCell(int32 Column)
+{
+	FColumn& CurrentColumn = Columns[Column];
+	AddWireText(CurrentColumn, nullptr, 0);
+	switch (CurrentColumn.Type)
+	{
+	case EMySQLColumnType::Integer:
+	case EMySQLColumnType::DateTime:
+		AddFixed<int64>(CurrentColumn, 0, true);
+		break;
+
+	case EMySQLColumnType::Double:
+		AddFixed<double>(CurrentColumn, 0.0, true);
+		break;
+
+	default:
+		CurrentColumn.Offsets.Add(CurrentColumn.Data.Num());
+		CurrentColumn.Nulls.Add(true);
+		break;
+	}
+}
+
+void FMySQLResultSet::AddInt64Cell(int32 Column, int64 Value)
+{
+	AddFixed<int64>(Columns[Column], Value, false);
+	AddWireText(Columns[Column], nullptr, 0);
+}
+
+void FMySQLResultSet::AddDoubleCell(int32 Column, double Value)
+{
+	AddFixed<double>(Columns[Column], Value, false);
+	AddWireText(Columns[Column], nullptr, 0);
+}
+
+void FMySQLResultSet::AddDateTimeCell(int32 Column, const FDateTime& Value)
+{
+	AddFixed<int64>(Columns[Column], Value.GetTicks(), false);
+	AddWireText(Columns[Column], nullptr, 0);
+}
+
+uint8* FMySQLResultSet::AddBytesCell(int32 Column, int32 Length)
+{
+	FColumn& CurrentColumn = Columns[Column];
+	const int32 Start = CurrentColumn.Data.AddUninitialized(Length);
+	CurrentColumn.Offsets.Add(CurrentColumn.Data.Num());
+	CurrentColumn.Nulls.Add(false);
+	return CurrentColumn.Data.GetData() + Start;
+}
+
+void FMySQLResultSet::Shrink()
+{
+	for (FColumn& Column : Columns)
+	{
+		Column.Data.Shrink();
+		Column.Offsets.Shrink();
+		Column.WireText.Shrink();
+		Column.WireTextOffsets.Shrink();
+	}
+}
+
+int32 FMySQLResultSet::FindColumn(const FString& Name) const
+{
+	return Columns.IndexOfByPredicate([&Name](const FColumn& Column)
+	{
+		return Column.Name.Equals(Name, ESearchCase::IgnoreCase);
+	});
+}
+
+int64 FMySQLResultSet::GetInt64(int32 Row, int32 Column) const
+{
+	const FColumn& CurrentColumn = Columns[Column];
+	if (CurrentColumn.Nulls[Row])
+	{
+		return 0;
+	}
+
+	switch (CurrentColumn.Type)
+	{
+	case EMySQLColumnType::Integer:
+		return GetFixed<int64>(CurrentColumn, Row);
+	case EMySQLColumnType::Double:
+		return static_cast<int64>(GetFixed<double>(CurrentColumn, Row));
+	default:
+		return 0;
+	}
+}
+
+double FMySQLResultSet::GetDouble(int32 Row, int32 Column) const
+{
+	const FColumn& CurrentColumn = Columns[Column];
+	if (CurrentColumn.Nulls[Row])
+	{
+		return 0.0;
+	}
+
+	switch (CurrentColumn.Type)
+	{
+	case EMySQLColumnType::Integer:
+		return static_cast<double>(GetFixed<int64>(CurrentColumn, Row));
+	case EMySQLColumnType::Double:
+		return GetFixed<double>(CurrentColumn, Row);
+	case EMySQLColumnType::Text:
+		{
+			// DECIMAL columns are kept as text
+			const TArrayView<const uint8> Bytes = GetBytes(Row, Column);
+			const std::string Text(reinterpret_cast<const char*>(Bytes.GetData()), Bytes.Num());
+			return strtod(Text.c_str(), nullptr);
+		}
+	default:
+		return 0.0;
+	}
+}
+
+FDateTime FMySQLResultSet::GetDateTime(int32 Row, int32 Column) const
+{
+	const FColumn& CurrentColumn = Columns[Column];
+	if (CurrentColumn.Type != EMySQLColumnType::DateTime || CurrentColumn.Nulls[Row])
+	{
+		return FDateTime(0);
+	}
+	return FDateTime(GetFixed<int64>(CurrentColumn, Row));
+}
+
+TArrayView<const uint8> FMySQLResultSet::GetBytes(int32 Row, int32 Column) const
+{
+	const FColumn& CurrentColumn = Columns[Column];
+	if (CurrentColumn.Offsets.Num() == 0)
+	{
+		return TArrayView<const uint8>();
+	}
+
+	const int64 Start = CurrentColumn.Offsets[Row];
+	return TArrayView<const uint8>(CurrentColumn.Data.GetData() + Start, static_cast<int32>(CurrentColumn.Offsets[Row + 1] - Start));
+}
+
+FString FMySQLResultSet::GetString(int32 Row, int32 Column, const TCHAR* NullText) const
+{
+	const FColumn& CurrentColumn = Columns[Column];
+	if (CurrentColumn.Nulls[Row])
+	{
+		return NullText;
+	}
+
+	if (CurrentColumn.WireTextOffsets.Num() > 0)
+	{
+		const int64 Start = CurrentColumn.WireTextOffsets[Row];
+		const int32 Length = static_cast<int32>(CurrentColumn.WireTextOffsets[Row + 1] - Start);
+		if (Length > 0)
+		{
+			const FUTF8ToTCHAR Text(reinterpret_cast<const ANSICHAR*>(CurrentColumn.WireText.GetData() + Start), Length);
+			return FString(Text.Length(), Text.Get());
+		}
+	}
+
+	switch (CurrentColumn.Type)
+	{
+	case EMySQLColumnType::Integer:
+		return LexToString(GetFixed<int64>(CurrentColumn, Row));
+
+	case EMySQLColumnType::Double:
+		{
+			// Only for doubles added without their wire text: the shortest text that reads back as the same value
+			char Buffer[32];
+			const std::to_chars_result Result = std::to_chars(Buffer, Buffer + sizeof(Buffer), GetFixed<double>(CurrentColumn, Row));
+			return FString(static_cast<int32>(Result.ptr - Buffer), Buffer);
+		}
+
+	case EMySQLColumnType::DateTime:
+		{
+			const FDateTime DateTime(GetFixed<int64>(CurrentColumn, Row));
+			if (IsDateOnlyField(CurrentColumn.FieldType))
+			{
+				return DateTime.ToString(TEXT("%Y-%m-%d"));
+			}
+
+			FString Text = DateTime.ToString(TEXT("%Y-%m-%d %H:%M:%S"));
+			const uint32 FractionDigits = FMath::Min<uint32>(CurrentColumn.Decimals, 6);
+			if (FractionDigits > 0)
+			{
+				const int64 Microseconds = (DateTime.GetTicks() % ETimespan::TicksPerSecond) / ETimespan::TicksPerMicrosecond;
+				Text += FString::Printf(TEXT(".%06lld"), Microseconds).Left(FractionDigits + 1);
+			}
+			return Text;
+		}
+
+	default:
+		{
+			const TArrayView<const uint8> Bytes = GetBytes(Row, Column);
+			const FUTF8ToTCHAR Text(reinterpret_cast<const ANSICHAR*>(Bytes.GetData()), Bytes.Num());
+			return FString(Text.Length(), Text.Get());
+		}
+	}
+}
+
+void FMySQLResultSet::GetRow(int32 Row, FMySQLDataRow& OutRow) const
+{
+	OutRow.RowData.Reset(Columns.Num());
+	for (int32 Column = 0; Column < Columns.Num(); Column++)
+	{
+		OutRow.RowData.Add(GetString(Row, Column));
+	}
+}
+
+void FMySQLResultSet::GetColumn(int32 Column, FMySQLDataTable& OutColumn) const
+{
+	OutColumn.ColumnName = Columns[Column].Name;
+	OutColumn.ColumnData.Reset(NumRows);
+	for (int32 Row = 0; Row < NumRows; Row++)
+	{
+		OutColumn.ColumnData.Add(GetString(Row, Column));
+	}
+}
+
+void FMySQLResultSet::ToRows(TArray<FMySQLDataRow>& OutRows) const
+{
+	OutRows.SetNum(NumRows);
+	for (int32 Row = 0; Row < NumRows; Row++)
+	{
+		GetRow(Row, OutRows[Row]);
+	}
+}
+
+void FMySQLResultSet::ToColumns(TArray<FMySQLDataTable>& OutColumns) const
+{
+	OutColumns.SetNum(Columns.Num());
+	for (int32 Column = 0; Column < Columns.Num(); Column++)
+	{
+		GetColumn(Column, OutColumns[Column]);
+	}
+}
+
+SIZE_T FMySQLResultSet::GetAllocatedSize() const
+{
+	SIZE_T Size = Columns.GetAllocatedSize();
+	for (const FColumn& Column : Columns)
+	{
+		Size += Column.Name.GetAllocatedSize() + Column.Data.GetAllocatedSize() + Column.Offsets.GetAllocatedSize() + Column.Nulls.GetAllocatedSize()
+			+ Column.WireText.GetAllocatedSize() + Column.WireTextOffsets.GetAllocatedSize();
+	}
+	return Size;
+}
+
+
+UMySQLResult* UMySQLResult::Create(UObject* Outer, FMySQLResultSetPtr InResultSet)
+{
+	UMySQLResult* Result = NewObject<UMySQLResult>(Outer);
+	Result->ResultSet = MoveTemp(InResultSet);
+	return Result;
+}
+
+bool UMySQLResult::IsValidCell(int32 Row, int32 Column) const
+{
+	return ResultSet.IsValid() && Row >= 0 && Row < ResultSet->GetNumRows() && Column >= 0 && Column < ResultSet->GetNumColumns();
+}
+
+int32 UMySQLResult::GetNumRows() const
+{
+	return ResultSet.IsValid() ? ResultSet->GetNumRows() : 0;
+}
+
+int32 UMySQLResult::GetNumColumns() const
+{
+	return ResultSet.IsValid() ? ResultSet->GetNumColumns() : 0;
+}
+
+FString UMySQLResult::GetColumnName(int32 Column) const
+{
+	return ResultSet.IsValid() && Column >= 0 && Column < ResultSet->GetNumColumns() ? ResultSet->GetColumnName(Column) : FString();
+}
+
+int32 UMySQLResult::FindColumn(const FString& Name) const
+{
+	return ResultSet.IsValid() ? ResultSet->FindColumn(Name) : INDEX_NONE;
+}
+
+EMySQLColumnType UMySQLResult::GetColumnType(int32 Column) const
+{
+	return ResultSet.IsValid() && Column >= 0 && Column < ResultSet->GetNumColumns() ? ResultSet->GetColumnType(Column) : EMySQLColumnType::Text;
+}
+
+bool UMySQLResult::IsNull(int32 Row, int32 Column) const
+{
+	return !IsValidCell(Row, Column) || ResultSet->IsNull(Row, Column);
+}
+
+FString UMySQLResult::GetString(int32 Row, int32 Column) const
+{
+	return IsValidCell(Row, Column) ? ResultSet->GetString(Row, Column) : FString();
+}
+
+int64 UMySQLResult::GetInteger(int32 Row, int32 Column) const
+{
+	return IsValidCell(Row, Column) ? ResultSet->GetInt64(Row, Column) : 0;
+}
+
+double UMySQLResult::GetFloat(int32 Row, int32 Column) const
+{
+	return IsValidCell(Row, Column) ? ResultSet->GetDouble(Row, Column) : 0.0;
+}
+
+FDateTime UMySQLResult::GetDateTime(int32 Row, int32 Column) const
+{
+	return IsValidCell(Row, Column) ? ResultSet->GetDateTime(Row, Column) : FDateTime(0);
+}
+
+FMySQLDataRow UMySQLResult::GetRow(int32 Row) const
+{
+	FMySQLDataRow DataRow;
+	if (ResultSet.IsValid() && Row >= 0 && Row < ResultSet->GetNumRows())
+	{
+		ResultSet->GetRow(Row, DataRow);
+	}
+	return DataRow;
+}
+
+FMySQLDataTable UMySQLResult::GetColumn(int32 Column) const
+{
+	FMySQLDataTable DataTable;
+	if (ResultSet.IsValid() && Column >= 0 && Column < ResultSet->GetNumColumns())
+	{
+		ResultSet->GetColumn(Column, DataTable);
+	}
+	return DataTable;
+}
+
+TArray<FMySQLDataRow> UMySQLResult::GetAllRows() const
+{
+	TArray<FMySQLDataRow> Rows;
+	if (ResultSet.IsValid())
+	{
+		ResultSet->ToRows(Rows);
+	}
+	return Rows;
+}
+
+TArray<FMySQLDataTable> UMySQLResult::GetAllColumns() const
+{
+	TArray<FMySQLDataTable> DataColumns;
+	if (ResultSet.IsValid())
+	{
+		ResultSet->ToColumns(DataColumns);
+	}
+	return DataColumns;
+}
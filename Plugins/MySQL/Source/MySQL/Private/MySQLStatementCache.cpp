@@ -0,0 +1,76 @@
+// Copyright 2021-2023, Athian Games. All Rights Reserved.
+
+#include "MySQLStatementCache.h"
+
+#include <mysql/errmsg.h>
+
+
+MySQLStatementCache::MySQLStatementCache(size_t InMaxStatements)
+	: MaxStatements(InMaxStatements > 0 ? InMaxStatements : 1)
+{
+}
+
+MySQLStatementCache::~MySQLStatementCache()
+{
+	Clear();
+}
+
+MYSQL_STMT* MySQLStatementCache::Prepare(MYSQL* Handle, const string& Query, string& ErrorMessage, unsigned int& ErrorCode)
+{
+	ErrorCode = 0;
+
+	auto Found = StatementsByQuery.find(Query);
+	if (Found != StatementsByQuery.end())
+	{
+		Statements.splice(Statements.begin(), Statements, Found->second);
+		return Found->second->second;
+	}
+
+	MYSQL_STMT* Statement = mysql_stmt_init(Handle);
+	if (!Statement)
+	{
+		ErrorMessage = "Failed to initialize statement.";
+		ErrorCode = CR_OUT_OF_MEMORY;
+		return nullptr;
+	}
+
+	if (mysql_stmt_prepare(Statement, Query.c_str(), static_cast<unsigned long>(Query.size())))
+	{
+		ErrorMessage = mysql_stmt_error(Statement);
+		ErrorCode = mysql_stmt_errno(Statement);
+		mysql_stmt_close(Statement);
+		return nullptr;
+	}
+
+	if (Statements.size() >= MaxStatements)
+	{
+		StatementsByQuery.erase(Statements.back().first);
+		mysql_stmt_close(Statements.back().second);
+		Statements.pop_back();
+	}
+
+	Statements.emplace_front(Query, Statement);
+	StatementsByQuery.emplace(Query, Statements.begin());
+	return Statement;
+}
+
+void MySQLStatementCache::Remove(const string& Query)
+{
+	auto Found = StatementsByQuery.find(Query);
+	if (Found != StatementsByQuery.end())
+	{
+		mysql_stmt_close(Found->second->second);
+		Statements.erase(Found->second);
+		StatementsByQuery.erase(Found);
+	}
+}
+
+void MySQLStatementCache::Clear()
+{
+	for (const pair<string, MYSQL_STMT*>& Statement : Statements)
+	{
+		mysql_stmt_close(Statement.second);
+	}
+	Statements.clear();
+	StatementsByQuery.clear();
+}
@@ -0,0 +1,25 @@
+// Copyright 2021-2023, Athian Games. All Rights Reserved.
+
+#include "MySQLTaskPool.h"
+
+#include "Async/Async.h"
+
+
+FMySQLTaskTracker::FMySQLTaskTracker(TFunction<void()> InOnIdle)
+	: OnIdle(MoveTemp(InOnIdle))
+{
+}
+
+void FMySQLTaskTracker::TaskStarted()
+{
+	InFlight.Increment();
+}
+
+void FMySQLTaskTracker::TaskDone()
+{
+	// Posted after the task's own game thread callbacks, so the owner sees them first
+	if (InFlight.Decrement() == 0 && OnIdle)
+	{
+		AsyncTask(ENamedThreads::GameThread, CopyTemp(OnIdle));
+	}
+}
@@ -0,0 +1,118 @@
+// Copyright 2021-2023, Athian Games. All Rights Reserved.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <mysql/mysql.h>
+
+#include "MySQLHandlePool.h"
+
+using namespace std;
+
+class FMySQLResultSet;
+
+
+/**
+* Runs queries with the non-blocking MariaDB client API on one I/O thread shared by all connections.
+* Each request leases a handle from its pool and drives it with the _start/_cont calls, connecting
+* new handles the same way; while the servers work, the thread waits in poll() on the sockets of
+* every request at once, so queries in flight do not hold a thread each. Requests beyond the size of their pool wait for a free handle;
+* the pool wakes the thread when one is released.
+* Completion callbacks run on the I/O thread and should only hand their result off.
+*/
+class MySQLAsyncEngine
+{
+
+public:
+
+	// Result holds the rows of the last query that returned any
+	typedef function<void(bool bSuccess, const string& ErrorMessage, FMySQLResultSet& Result, uint64_t AffectedRows)> FCompletion;
+
+	// Rows read from one request before the others get their turn
+	static constexpr int MaxRowsPerTurn = 256;
+
+	// The engine of the process, started on first use and stopped when the last user lets go of it
+	static shared_ptr<MySQLAsyncEngine> GetShared();
+
+	MySQLAsyncEngine();
+	// Fails the requests that have not completed yet
+	~MySQLAsyncEngine();
+
+	MySQLAsyncEngine(const MySQLAsyncEngine&) = delete;
+	MySQLAsyncEngine& operator=(const MySQLAsyncEngine&) = delete;
+
+	/**
+	* Runs Queries in order on one handle of Pool; like MySQLConnection::UpdateDataFromQueries the request
+	* reports the status of its last query. Handles idle for longer than PingIdleSeconds are pinged first.
+	* A request that lost the server is run once more on a fresh handle when bRetryOnLostConnection is set.
+	*/
+	void Submit(shared_ptr<MySQLHandlePool> Pool, vector<string> Queries, bool bRetryOnLostConnection, double PingIdleSeconds, FCompletion OnComplete);
+
+	// Requests submitted and not completed yet
+	int GetNumRequests() const { return NumRequests.load(); }
+
+private:
+
+	typedef chrono::steady_clock FClock;
+
+	enum class EStep : uint8_t
+	{
+		AcquireHandle,
+		Connect,
+		Ping,
+		Query,
+		FetchRow,
+		FreeResult,
+		NextResult,
+		Done
+	};
+
+	struct FRequest;
+
+	void Loop();
+	void Wake();
+
+	// Leases handles for waiting requests and starts connecting new ones; the ones whose pool is busy stay in the queue
+	void AcquireHandles();
+	static void OnConnectDone(FRequest& Request);
+
+	// Drives the request until it waits for its socket, yields after MaxRowsPerTurn rows or is done.
+	// ReadyStatus holds the MYSQL_WAIT_* events that ended the wait, if the request was waiting
+	void Run(FRequest& Request, int ReadyStatus);
+	static void OnResultReady(FRequest& Request, int QueryStatus);
+	static void OnStatementDone(FRequest& Request);
+
+	void Complete(unique_ptr<FRequest> Request);
+	void FailAll(const string& ErrorMessage);
+
+	mutex IncomingMutex;
+	vector<unique_ptr<FRequest>> Incoming;
+	bool bStop = false;
+
+	// Owned by the I/O thread
+	deque<unique_ptr<FRequest>> WaitingForHandle;
+	vector<unique_ptr<FRequest>> Running;
+
+	// Pools that wake the thread when they free a handle, registered on first use; owned by the I/O thread
+	unordered_map<MySQLHandlePool*, weak_ptr<MySQLHandlePool>> ListenedPools;
+	// Set while requests wait for a handle, so that releases nobody waits for do not wake the thread
+	atomic<bool> bWaitingForHandle{ false };
+
+	// Loopback datagram socket that Submit writes to, to wake the thread from poll
+	my_socket WakeSocket;
+	bool bHasWakeSocket = false;
+
+	atomic<int> NumRequests{ 0 };
+	thread IOThread;
+
+};
@@ -29,11 +29,12 @@ class MYSQL_API OpenMySQLConnectionTask : public FNonAbandonableTask
 	TWeakObjectPtr<UMySQLDBConnector> MySQLDBConnector;
 	int32 ConnectionID;
 	TArray<FMySQLOptionPair> MySQLOptions;
+	int32 PoolSize;
 
 public:
 
 	OpenMySQLConnectionTask(TWeakObjectPtr<AMySQLDBConnectionActor> dbConnectionActor, int32 connectionID, TWeakObjectPtr<UMySQLDBConnector> dbConnector,
-		FString server, FString dBName, FString userID, FString password, int32 Port, TArray<FMySQLOptionPair> options);
+		FString server, FString dBName, FString userID, FString password, int32 Port, TArray<FMySQLOptionPair> options, int32 poolSize);
 
 	virtual ~OpenMySQLConnectionTask();
 	virtual void DoWork();
@@ -54,12 +55,15 @@ class MYSQL_API UpdateMySQLQueryAsyncTask : public FNonAbandonableTask
 	TWeakObjectPtr<UMySQLDBConnector> MySQLDBConnector;
 	int32 ConnectionID;
 	int32 QueryID;
+
+	// Runs the queries as one transaction and reports them through OnTransactionStatusChanged
+	bool bAsTransaction;
 	
 public:
 
 
 	UpdateMySQLQueryAsyncTask(TWeakObjectPtr<AMySQLDBConnectionActor> dbConnectionActor, TWeakObjectPtr<UMySQLDBConnector> dbConnector, int32 connectionID, int32 queryID,
-		TArray<FString> queries);
+		TArray<FString> queries, bool asTransaction = false);
 
 	virtual ~UpdateMySQLQueryAsyncTask();
 	virtual void DoWork();
@@ -80,15 +84,28 @@ class MYSQL_API SelectMySQLQueryAsyncTask : public FNonAbandonableTask
 	TWeakObjectPtr<UMySQLDBConnector> MySQLDBConnector;
 	int32 ConnectionID;
 	int32 QueryID;
+
+	// The string arrays of OnQuerySelectStatusChanged are only built when that event is implemented,
+	// and the typed result only travels to the game thread when OnQuerySelectResult is
+	bool bBuildLegacyArrays;
+	bool bKeepResultSet;
 	
 public:
 
 
 
-	SelectMySQLQueryAsyncTask(TWeakObjectPtr<AMySQLDBConnectionActor> dbConnectionActor, TWeakObjectPtr<UMySQLDBConnector> dbConnector, int32 connectionID, int32 queryID, FString query);
+	SelectMySQLQueryAsyncTask(TWeakObjectPtr<AMySQLDBConnectionActor> dbConnectionActor, TWeakObjectPtr<UMySQLDBConnector> dbConnector, int32 connectionID, int32 queryID, FString query,
+		bool buildLegacyArrays, bool keepResultSet = true);
 	virtual ~SelectMySQLQueryAsyncTask();
 	virtual void DoWork();
 
+	/**
+	* Builds the string arrays if asked to, on the calling thread, and fires the select events on the game thread.
+	* Everything is moved into the game thread call; a result that is only needed for the string arrays is released first.
+	*/
+	static void CompleteSelect(TWeakObjectPtr<AMySQLDBConnectionActor> DBConnectionActor, int32 CurrentConnectionID, int32 CurrentQueryID,
+		bool SelectQueryStatus, const FString& ErrorMessage, FMySQLResultSetPtr ResultSet, bool bBuildLegacyArrays, bool bKeepResultSet);
+
 	FORCEINLINE TStatId GetStatId() const
 	{
 		RETURN_QUICK_DECLARE_CYCLE_STAT(SelectQueryAsyncTask, STATGROUP_ThreadPoolAsyncTasks);
@@ -97,6 +114,137 @@ public:
 };
 
 
+/**
+* Limits how many streamed chunks wait for the game thread. The worker blocks in WaitForRoom
+* until the game thread has handed enough of them to Blueprint, so a slow consumer slows the
+* select down instead of piling rows up in memory.
+*/
+class MYSQL_API FMySQLChunkFlow
+{
+
+	mutex FlowMutex;
+	condition_variable ChunkConsumed;
+	int32 PendingChunks = 0;
+	bool bCancelled = false;
+
+public:
+
+	static constexpr int32 MaxPendingChunks = 2;
+
+	// Returns false when the stream was cancelled
+	bool WaitForRoom();
+	void ChunkQueued();
+	void ChunkDelivered();
+
+	// Stops the stream at the next chunk, e.g. when the actor goes away while chunks are waiting for it
+	void Cancel();
+
+};
+
+
+class MYSQL_API SelectMySQLQueryChunkedAsyncTask : public FNonAbandonableTask
+{
+
+	FString Query;
+	TWeakObjectPtr<AMySQLDBConnectionActor> CurrentDBConnectionActor;
+	TWeakObjectPtr<UMySQLDBConnector> MySQLDBConnector;
+	int32 ConnectionID;
+	int32 QueryID;
+	int32 ChunkSize;
+	TSharedRef<FMySQLChunkFlow, ESPMode::ThreadSafe> ChunkFlow;
+
+public:
+
+	SelectMySQLQueryChunkedAsyncTask(TWeakObjectPtr<AMySQLDBConnectionActor> dbConnectionActor, TWeakObjectPtr<UMySQLDBConnector> dbConnector, int32 connectionID,
+		int32 queryID, FString query, int32 chunkSize, TSharedRef<FMySQLChunkFlow, ESPMode::ThreadSafe> chunkFlow);
+	virtual ~SelectMySQLQueryChunkedAsyncTask();
+	virtual void DoWork();
+
+	FORCEINLINE TStatId GetStatId() const
+	{
+		RETURN_QUICK_DECLARE_CYCLE_STAT(SelectQueryChunkedAsyncTask, STATGROUP_ThreadPoolAsyncTasks);
+	}
+
+};
+
+
+class MYSQL_API PrepareMySQLStatementAsyncTask : public FNonAbandonableTask
+{
+
+	FString Query;
+	TWeakObjectPtr<AMySQLDBConnectionActor> CurrentDBConnectionActor;
+	TWeakObjectPtr<UMySQLDBConnector> MySQLDBConnector;
+	int32 ConnectionID;
+	int32 QueryID;
+	int32 StatementID;
+
+public:
+
+	PrepareMySQLStatementAsyncTask(TWeakObjectPtr<AMySQLDBConnectionActor> dbConnectionActor, TWeakObjectPtr<UMySQLDBConnector> dbConnector, int32 connectionID,
+		int32 queryID, int32 statementID, FString query);
+	virtual ~PrepareMySQLStatementAsyncTask();
+	virtual void DoWork();
+
+	FORCEINLINE TStatId GetStatId() const
+	{
+		RETURN_QUICK_DECLARE_CYCLE_STAT(PrepareStatementAsyncTask, STATGROUP_ThreadPoolAsyncTasks);
+	}
+
+};
+
+
+class MYSQL_API ExecuteMySQLStatementAsyncTask : public FNonAbandonableTask
+{
+
+	FString Query;
+	TArray<FMySQLParameter> Parameters;
+	TWeakObjectPtr<AMySQLDBConnectionActor> CurrentDBConnectionActor;
+	TWeakObjectPtr<UMySQLDBConnector> MySQLDBConnector;
+	int32 ConnectionID;
+	int32 QueryID;
+	int32 StatementID;
+
+public:
+
+	ExecuteMySQLStatementAsyncTask(TWeakObjectPtr<AMySQLDBConnectionActor> dbConnectionActor, TWeakObjectPtr<UMySQLDBConnector> dbConnector, int32 connectionID,
+		int32 queryID, int32 statementID, FString query, TArray<FMySQLParameter> parameters);
+	virtual ~ExecuteMySQLStatementAsyncTask();
+	virtual void DoWork();
+
+	FORCEINLINE TStatId GetStatId() const
+	{
+		RETURN_QUICK_DECLARE_CYCLE_STAT(ExecuteStatementAsyncTask, STATGROUP_ThreadPoolAsyncTasks);
+	}
+
+};
+
+
+class MYSQL_API ExecuteMySQLBatchAsyncTask : public FNonAbandonableTask
+{
+
+	FString Query;
+	TArray<FMySQLParameterColumn> Columns;
+	bool bAllOrNothing;
+	TWeakObjectPtr<AMySQLDBConnectionActor> CurrentDBConnectionActor;
+	TWeakObjectPtr<UMySQLDBConnector> MySQLDBConnector;
+	int32 ConnectionID;
+	int32 QueryID;
+
+public:
+
+	ExecuteMySQLBatchAsyncTask(TWeakObjectPtr<AMySQLDBConnectionActor> dbConnectionActor, TWeakObjectPtr<UMySQLDBConnector> dbConnector, int32 connectionID,
+		int32 queryID, FString query, TArray<FMySQLParameterColumn> columns, bool allOrNothing);
+	virtual ~ExecuteMySQLBatchAsyncTask();
+	virtual void DoWork();
+
+	FORCEINLINE TStatId GetStatId() const
+	{
+		RETURN_QUICK_DECLARE_CYCLE_STAT(ExecuteBatchAsyncTask, STATGROUP_ThreadPoolAsyncTasks);
+	}
+
+};
+
+
 class MYSQL_API UpdateMySQLImageAsyncTask : public FNonAbandonableTask
 {
 
@@ -128,6 +276,38 @@ public:
 };
 
 
+// Encodes the pixels read from a texture as PNG and stores them like UpdateMySQLImageAsyncTask
+class MYSQL_API UpdateMySQLTextureAsyncTask : public FNonAbandonableTask
+{
+
+private:
+
+	FString Query;
+	TWeakObjectPtr<AMySQLDBConnectionActor> CurrentDBConnectionActor;
+	FString UpdateParameter;
+	int ParameterID;
+	FMySQLTextureReader ReadImage;
+	TWeakObjectPtr<UMySQLDBConnector> MySQLDBConnector;
+	
+	int32 ConnectionID;
+	int32 QueryID;
+
+public:
+
+
+	UpdateMySQLTextureAsyncTask(TWeakObjectPtr<AMySQLDBConnectionActor> dbConnectionActor, TWeakObjectPtr<UMySQLDBConnector> dbConnector, int32 connectionID, int32 queryID, FString query, FString updateParameter, int parameterID, FMySQLTextureReader readImage);
+
+	virtual ~UpdateMySQLTextureAsyncTask();
+	virtual void DoWork();
+
+	FORCEINLINE TStatId GetStatId() const
+	{
+		RETURN_QUICK_DECLARE_CYCLE_STAT(UpdateTextureAsyncTask, STATGROUP_ThreadPoolAsyncTasks);
+	}
+
+};
+
+
 class MYSQL_API SelectMySQLImageAsyncTask : public FNonAbandonableTask
 {
 
@@ -5,6 +5,7 @@
 
 #include "CoreMinimal.h"
 #include "Engine/Texture2D.h"
+#include "IImageWrapper.h"
 #include "Kismet/BlueprintFunctionLibrary.h"
 #include "Modules/ModuleManager.h"
 
@@ -37,6 +38,136 @@ struct FMySQLDataRow
 		TArray<FString> RowData;
 };
 
+UENUM(BlueprintType)
+enum class EMySQLParameterType : uint8
+{
+	Null,
+	Integer,
+	Float,
+	String,
+	DateTime,
+	Blob
+};
+
+/**
+* Value bound to a ? marker of a prepared statement. Only the value matching Type is sent.
+*/
+USTRUCT(BlueprintType, Category = "MySql|Statements")
+struct FMySQLParameter
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SQLParameter")
+		EMySQLParameterType Type = EMySQLParameterType::Null;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SQLParameter")
+		int64 IntegerValue = 0;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SQLParameter")
+		double FloatValue = 0.0;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SQLParameter")
+		FString StringValue;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SQLParameter")
+		FDateTime DateTimeValue;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SQLParameter")
+		TArray<uint8> BlobValue;
+};
+
+/**
+* All values of one ? marker across the rows of a batch. The array matching Type holds one value per row;
+* rows flagged in Nulls are sent as NULL. A Null column only needs Nulls.
+*/
+USTRUCT(BlueprintType, Category = "MySql|Statements")
+struct FMySQLParameterColumn
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SQLParameterColumn")
+		EMySQLParameterType Type = EMySQLParameterType::Null;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SQLParameterColumn")
+		TArray<int64> IntegerValues;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SQLParameterColumn")
+		TArray<double> FloatValues;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SQLParameterColumn")
+		TArray<FString> StringValues;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SQLParameterColumn")
+		TArray<FDateTime> DateTimeValues;
+
+	// Empty, or one flag per row
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SQLParameterColumn")
+		TArray<bool> Nulls;
+
+	// Rows described by this column, -1 for a column of an unsupported type
+	int32 GetNumRows() const
+	{
+		switch (Type)
+		{
+		case EMySQLParameterType::Null: return Nulls.Num();
+		case EMySQLParameterType::Integer: return IntegerValues.Num();
+		case EMySQLParameterType::Float: return FloatValues.Num();
+		case EMySQLParameterType::String: return StringValues.Num();
+		case EMySQLParameterType::DateTime: return DateTimeValues.Num();
+		default: return -1;
+		}
+	}
+};
+
+USTRUCT(BlueprintType, Category = "MySql|Statements")
+struct FMySQLBatchRowError
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SQLBatchRowError")
+		int32 RowIndex = 0;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SQLBatchRowError")
+		FString ErrorMessage;
+};
+
+/**
+* Outcome of one query of a transaction
+*/
+UENUM(BlueprintType)
+enum class EMySQLStatementStatus : uint8
+{
+	// The transaction stopped before this query
+	NotExecuted,
+	Committed,
+	// The query ran, but a later failure undid it
+	RolledBack,
+	// The query the transaction stopped at
+	Failed
+};
+
+
+// Format and size of a compressed image file, read from its header without decoding the pixels
+struct FMySQLImageInfo
+{
+	EImageFormat Format = EImageFormat::Invalid;
+	int32 Width = 0;
+	int32 Height = 0;
+};
+
+// BGRA8 pixels of an image, decoded for a texture or read from one to be encoded
+struct FMySQLDecodedImage
+{
+	int32 Width = 0;
+	int32 Height = 0;
+	TArray64<uint8> Pixels;
+};
+
+/**
+* Produces the BGRA8 pixels of a texture read by ReadTexturePixels, or null when they cannot be converted. It
+* decompresses the editor source or converts the GPU copy, so it is called on the worker that uses the pixels.
+*/
+typedef TUniqueFunction<TUniquePtr<FMySQLDecodedImage>()> FMySQLTextureReader;
 
 /**
 * Contains all the methods that are used to connect to the C# dll 
@@ -57,18 +188,63 @@ private:
 
 public:
 
-	static char* GetCharFromTextureData(UTexture2D *Texture, FString Path);
-	static UTexture2D* LoadTexturefromCharData(char* ImageChar);
+	// Decodes compressed image bytes to BGRA8 on the calling thread; without a Format it is detected from the data
+	static bool DecodeImage(const uint8* ImageData, int64 Length, EImageFormat Format, FMySQLDecodedImage& OutImage);
+
+	/**
+	* Creates a transient texture for Image on the game thread. The pixels are copied into the texture resource on
+	* the render thread through UpdateTextureRegions and freed there, so the game thread only creates the object.
+	*/
+	static UTexture2D* CreateTextureFromImage(TUniquePtr<FMySQLDecodedImage> Image);
+
+	// Buffers that selected image bytes are read into, kept for the next select instead of being reallocated
+	static TArray<uint8> AcquireImageBuffer();
+	static void ReleaseImageBuffer(TArray<uint8>&& Buffer);
+
+	// Encodes Image as PNG, JPEG or BMP on the calling thread
+	static bool EncodeImage(const FMySQLDecodedImage& Image, EImageFormat Format, TArray64<uint8>& OutData);
+
+	/**
+	* Reads the pixels of Texture without touching its settings or resource. Editor builds read the source mip;
+	* otherwise mip 0 is copied from the GPU and polled each tick until the copy lands, without stalling the render
+	* thread. OnRead gets a reader for the pixels, or null when the texture has neither or is block compressed, on the
+	* game thread for source data and on the render thread after a readback.
+	*/
+	static void ReadTexturePixels(UTexture2D* Texture, TFunction<void(FMySQLTextureReader Reader)> OnRead);
 	
+	// Loads the module on the game thread, before workers use it
 	static void CreateImageWrapperModule();
-	static char* GetRawImageFromPath(FString ImagePath);
 
-	static bool SaveTextureToPath(UTexture2D* Texture, const FString Path);
+	// Reads the format and dimensions of a PNG, JPEG or BMP file from its header
+	static bool GetImageInfoFromPath(const FString& ImagePath, FMySQLImageInfo& OutInfo);
+
+	// Extension that names the format in the database, e.g. "png", and back
+	static FString GetImageFormatName(EImageFormat Format);
+	static EImageFormat GetImageFormatFromName(const FString& FormatName);
 
-	static void GetTexturePixels(UTexture2D* Texture, TArray<FColor>& OutPixels);
+	// Saves Texture as a JPEG for .jpg and .jpeg paths and as a PNG otherwise; waits for the readback when there is one
+	static bool SaveTextureToPath(UTexture2D* Texture, const FString Path);
 
 	static wchar_t* GetWCharfromChar(const char* Input);
 	static char* GetCharfromFString(FString Query);
 	static TArray<FString> GetSplitStringArray(FString Input, FString Pattern);
 
+	UFUNCTION(BlueprintPure, Category = "MySql|Statements")
+		static FMySQLParameter MakeNullParameter();
+
+	UFUNCTION(BlueprintPure, Category = "MySql|Statements")
+		static FMySQLParameter MakeIntegerParameter(int64 Value);
+
+	UFUNCTION(BlueprintPure, Category = "MySql|Statements")
+		static FMySQLParameter MakeFloatParameter(double Value);
+
+	UFUNCTION(BlueprintPure, Category = "MySql|Statements")
+		static FMySQLParameter MakeStringParameter(const FString& Value);
+
+	UFUNCTION(BlueprintPure, Category = "MySql|Statements")
+		static FMySQLParameter MakeDateTimeParameter(FDateTime Value);
+
+	UFUNCTION(BlueprintPure, Category = "MySql|Statements")
+		static FMySQLParameter MakeBlobParameter(const TArray<uint8>& Value);
+
 };
@@ -6,8 +6,11 @@
 #include "GameFramework/Actor.h"
 #include "MySQLBPLibrary.h"
 #include "MySQLAsyncTasks.h"
+#include "MySQLTaskPool.h"
 #include "Interfaces/IPluginManager.h"
 #include "MySQLDBConnector.h"
+#include "Containers/Queue.h"
+#include "HAL/ThreadSafeCounter.h"
 
 #include "MySQLDBConnectionActor.generated.h"
 
@@ -15,9 +18,24 @@ UENUM()
 enum EQueryType
 {
 	Update,
+	Transaction,
 	Select,
-	Close,
-	Endplay
+	SelectChunked,
+	PrepareStatement,
+	ExecuteStatement,
+	ExecuteBatch,
+	UpdateImage,
+	UpdateTexture,
+	SelectImage
+};
+
+UENUM(BlueprintType)
+enum class EMySQLQueryPriority : uint8
+{
+	// Queries someone is waiting for; they start before background queries and always have a handle left for them
+	Interactive,
+	// Bulk work such as syncs and batches, run on the handles interactive queries leave free
+	Background
 };
 
 USTRUCT()
@@ -30,7 +48,32 @@ struct FQueryTaskData
 	TArray<FString> Queries;
 		
 	EQueryType QueryType; // Define an enumeration EQueryType with values like Select, Update, etc.
-	// Add any other required parameters for the query
+
+	// Rows per OnQuerySelectChunk call for SelectChunked tasks
+	int32 ChunkSize = 0;
+
+	// Ordered tasks of a connection run one at a time in submission order
+	bool bOrdered = false;
+	EMySQLQueryPriority Priority = EMySQLQueryPriority::Interactive;
+	double EnqueueTime = 0.0;
+
+	// Prepared statement tasks carry the statement's SQL in Queries[0]
+	int32 StatementID = INDEX_NONE;
+	TArray<FMySQLParameter> Parameters;
+
+	TArray<FMySQLParameterColumn> ParameterColumns;
+	bool bAllOrNothing = true;
+
+	// Image updates: the marker the image is bound to, and the file UpdateImage tasks read it from
+	FString UpdateParameter;
+	int32 ParameterID = 0;
+	FString ImagePath;
+
+	// Reader of the texture pixels of an UpdateTexture task; shared so that the task data stays copyable
+	TSharedPtr<FMySQLTextureReader, ESPMode::ThreadSafe> TextureReader;
+
+	// Running on the non-blocking engine rather than on a worker thread
+	bool bNonBlocking = false;
 
 	friend bool operator==(const FQueryTaskData& lhs, const FQueryTaskData& rhs)
 	{
@@ -38,6 +81,136 @@ struct FQueryTaskData
 	}
 };
 
+/**
+* How long the queries of one priority lane waited in the queue. Counts[i] is the number of queries that waited
+* less than BucketUpperMs[i] and more than the bound before it; the last count has no upper bound.
+*/
+USTRUCT(BlueprintType, Category = "MySql|Pool")
+struct FMySQLQueueLatency
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MySQLQueueLatency")
+		int32 QueueDepth = 0;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MySQLQueueLatency")
+		int32 DispatchedQueries = 0;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MySQLQueueLatency")
+		float AverageWaitMs = 0.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MySQLQueueLatency")
+		float MaxWaitMs = 0.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MySQLQueueLatency")
+		TArray<float> BucketUpperMs;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MySQLQueueLatency")
+		TArray<int32> Counts;
+};
+
+/**
+* Snapshot of the query dispatch state of one connection
+*/
+USTRUCT(BlueprintType, Category = "MySql|Pool")
+struct FMySQLPoolMetrics
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MySQLPoolMetrics")
+		int32 PoolSize = 0;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MySQLPoolMetrics")
+		int32 OpenHandles = 0;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MySQLPoolMetrics")
+		int32 IdleHandles = 0;
+
+	// Queries running on worker threads right now
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MySQLPoolMetrics")
+		int32 InFlight = 0;
+
+	// Queries waiting in the actor's queue for a free handle or for an earlier ordered query
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MySQLPoolMetrics")
+		int32 QueueDepth = 0;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MySQLPoolMetrics")
+		int32 DispatchedQueries = 0;
+
+	// Time from queuing to dispatch
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MySQLPoolMetrics")
+		float AverageWaitMs = 0.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MySQLPoolMetrics")
+		float MaxWaitMs = 0.0f;
+
+	// The same figures for each lane, with the spread of the waits
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MySQLPoolMetrics")
+		FMySQLQueueLatency Interactive;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MySQLPoolMetrics")
+		FMySQLQueueLatency Background;
+};
+
+struct FMySQLQueryLane
+{
+	// Upper bounds of the wait histogram buckets; one more bucket holds the longer waits
+	static constexpr int32 NumWaitBuckets = 11;
+	static const double WaitBucketUpperMs[NumWaitBuckets - 1];
+
+	// Unordered tasks of the lane, started in the order they were queued
+	TQueue<FQueryTaskData, EQueueMode::Mpsc> Tasks;
+
+	// Queued tasks of the lane, ordered ones included
+	FThreadSafeCounter QueueDepth;
+
+	int32 DispatchedQueries = 0;
+	double TotalWaitSeconds = 0.0;
+	double MaxWaitSeconds = 0.0;
+	int32 WaitHistogram[NumWaitBuckets] = {};
+
+	void RecordWait(double WaitSeconds);
+};
+
+/**
+* The queues of one connection. Every queue is a lock-free MPSC FIFO: tasks can be queued from any thread,
+* and only the game thread takes them out to dispatch them.
+*/
+struct FMySQLDispatchState
+{
+	int32 PoolSize = 1;
+	int32 InFlight = 0;
+	int32 BackgroundInFlight = 0;
+	bool bOrderedInFlight = false;
+
+	// Closes the connection once its queued and running tasks are done
+	bool bCloseRequested = false;
+
+	// Ordered tasks of both lanes, so that they keep the order they were made in
+	TQueue<FQueryTaskData, EQueueMode::Mpsc> OrderedTasks;
+
+	// Indexed by EMySQLQueryPriority
+	static constexpr int32 NumLanes = 2;
+	FMySQLQueryLane Lanes[NumLanes];
+
+	// Background tasks leave one handle of a larger pool to interactive ones
+	bool HasFreeHandle(EMySQLQueryPriority Priority) const
+	{
+		return InFlight < PoolSize && (Priority == EMySQLQueryPriority::Interactive || PoolSize == 1 || BackgroundInFlight < PoolSize - 1);
+	}
+
+	bool HasQueuedTasks() const
+	{
+		return !OrderedTasks.IsEmpty() || !Lanes[0].Tasks.IsEmpty() || !Lanes[1].Tasks.IsEmpty();
+	}
+};
+
+struct FMySQLPreparedStatement
+{
+	int32 ConnectionID = 0;
+	FString Query;
+};
+
 UCLASS()
 class MYSQL_API AMySQLDBConnectionActor : public AActor
 {
@@ -46,26 +219,10 @@ class MYSQL_API AMySQLDBConnectionActor : public AActor
 	TMap<int32, int32> ConnectionToNextQueryIDMap;
 
 template<typename TaskType, typename... Args>
-FAsyncTask<TaskType>* StartAsyncTask(Args&&... args)
-{
-	TaskType Task(std::forward<Args>(args)...);
-	FAsyncTask<TaskType>* AsyncTask = new FAsyncTask<TaskType>(std::move(Task));
-	AsyncTask->StartBackgroundTask();
-	return AsyncTask;
-}
-
-template<class T>
-void CleanUpFinishedTasks(TArray<FAsyncTask<T>*> &TaskArray)
+void StartAsyncTask(TMySQLTaskPool<TaskType>& TaskPool, Args&&... args)
 {
-	for (int32 Index = 0; Index < TaskArray.Num(); ++Index)
-	{
-		FAsyncTask<T>* Task = TaskArray[Index];
-		if (Task->IsDone())
-		{
-			delete Task;
-			TaskArray.RemoveAt(Index--);
-		}
-	}
+	TaskPool.Start(TaskTracker.ToSharedRef(), std::forward<Args>(args)...);
+	bIsConnectionBusy = true;
 }
 	
 public:
@@ -82,22 +239,63 @@ protected:
 
 	UMySQLDBConnector* GetConnector(int32 ConnectionID);
 
-	TArray<FAsyncTask<OpenMySQLConnectionTask>*> OpenConnectionTasks;
-	TArray<FAsyncTask<UpdateMySQLQueryAsyncTask>*> UpdateQueryTasks;
-	TArray<FAsyncTask<SelectMySQLQueryAsyncTask>*> SelectQueryTasks;
-	TArray<FAsyncTask<UpdateMySQLImageAsyncTask>*> UpdateImageQueryTasks;
-	TArray<FAsyncTask<SelectMySQLImageAsyncTask>*> SelectImageQueryTasks;
+	// Counts the tasks of all pools below; shared with them so it outlives the last one
+	TSharedPtr<FMySQLTaskTracker, ESPMode::ThreadSafe> TaskTracker;
+
+	TMySQLTaskPool<OpenMySQLConnectionTask> OpenConnectionTasks;
+	TMySQLTaskPool<UpdateMySQLQueryAsyncTask> UpdateQueryTasks;
+	TMySQLTaskPool<SelectMySQLQueryAsyncTask> SelectQueryTasks;
+	TMySQLTaskPool<SelectMySQLQueryChunkedAsyncTask> SelectChunkedQueryTasks;
+	TMySQLTaskPool<PrepareMySQLStatementAsyncTask> PrepareStatementTasks;
+	TMySQLTaskPool<ExecuteMySQLStatementAsyncTask> ExecuteStatementTasks;
+	TMySQLTaskPool<ExecuteMySQLBatchAsyncTask> ExecuteBatchTasks;
+	TMySQLTaskPool<UpdateMySQLImageAsyncTask> UpdateImageQueryTasks;
+	TMySQLTaskPool<UpdateMySQLTextureAsyncTask> UpdateTextureQueryTasks;
+	TMySQLTaskPool<SelectMySQLImageAsyncTask> SelectImageQueryTasks;
+
+	// Streams of the running chunked selects, cancelled when the actor ends play
+	TArray<TWeakPtr<FMySQLChunkFlow, ESPMode::ThreadSafe>> ChunkFlows;
 	
 private:
 
 	
 
-	// Declare a queue to store the pending query tasks
-	TArray<FQueryTaskData> QueryTaskQueue;
+	// Tasks dispatched to worker threads and not finished yet
+	TArray<FQueryTaskData> RunningQueryTasks;
 
-	// Declare a boolean to indicate whether a query task is currently running
+	// Queues and dispatch counts of each connection
+	TMap<int32, TUniquePtr<FMySQLDispatchState>> DispatchStates;
+	FMySQLDispatchState& GetDispatchState(int32 ConnectionID);
+
+	TMap<int32, FMySQLPreparedStatement> PreparedStatements;
+	int32 NextStatementID;
+
+	// Declare a boolean to indicate whether a query task is currently running or queued
 	bool bIsQueryTaskRunning;
-	void CreateTaskData(int32 ConnectionID, TArray<FString> Queries, EQueryType QueryType);
+	bool bIsDispatchingTasks;
+	bool bDispatchAgain;
+	FQueryTaskData CreateTaskData(int32 ConnectionID, TArray<FString> Queries, EQueryType QueryType, bool bOrdered, EMySQLQueryPriority Priority);
+
+	// Queues the task in its connection's lane and dispatches what can start
+	void EnqueueTask(FQueryTaskData&& TaskData);
+
+	// Takes the next task the connection can start: interactive before background, and in each lane the one queued first
+	bool DequeueNextTask(FMySQLDispatchState& State, FQueryTaskData& OutTask);
+	void DispatchConnection(int32 ConnectionID);
+
+	// Moves the task's payload into its async task
+	void DispatchQueryTask(UMySQLDBConnector* CurrentConnector, FQueryTaskData& TaskData);
+	void DispatchNonBlockingQuery(UMySQLDBConnector* CurrentConnector, FQueryTaskData& TaskData);
+
+	// Which select events are implemented; a select only produces what they receive
+	void GetSelectListeners(bool& bBuildLegacyArrays, bool& bKeepResultSet) const;
+
+	int32 NonBlockingQueriesInFlight;
+
+	// Recomputes bIsConnectionBusy when tasks finish, and reuses query IDs once nothing is left
+	void UpdateBusyState();
+
+	void FailQueryTask(const FQueryTaskData& TaskData, const FString& ErrorMessage);
 
 	UMySQLDBConnector* CreateDBConnector(int32& ConnectionID);
 
@@ -105,8 +303,10 @@ private:
 
 public:	
 
-	// Method to initiate execution of next query in the queue
+	// Dispatches every queued task that has a free pooled handle and is not held back by ordering
 	void ExecuteNextQueryTask();
+	bool HasQueuedTasks() const;
+	void OnQueryTaskFinished(int32 ConnectionID, int32 QueryID);
 	void ResetLastConnection();
 
 	UPROPERTY()
@@ -120,9 +320,6 @@ public:
 
 	FTimerHandle SelectDataTaskTimer;
 	
-	// Called every frame
-	virtual void Tick(float DeltaTime) override;
-	
 	/**
 	* Creates a New Database Connection
 	*/
@@ -132,6 +329,20 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="MySQLOptions")
 	UMySQLConnectionOptions* MySQLOptionsAsset;
 
+	/**
+	* Number of server connections opened for each new logical connection, which is
+	* how many of its queries can run at the same time
+	*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="MySQLOptions", meta = (ClampMin = "1"))
+	int32 ConnectionPoolSize;
+
+	/**
+	* Runs updates and selects with the non-blocking client API on one I/O thread shared by all connections,
+	* instead of holding a worker thread for each query while the server works
+	*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="MySQLOptions")
+	bool bUseNonBlockingQueries;
+
 	UFUNCTION(BlueprintCallable, Category = "MySql Server")
 		void CloseAllConnections();
 
@@ -150,54 +361,161 @@ public:
 		return bIsQueryTaskRunning;
 	}
 
+	UFUNCTION(BlueprintPure, Category = "MySql Server")
+	FMySQLPoolMetrics GetConnectionPoolMetrics(int32 ConnectionID);
+
 	/**
 	* Executes a Query to the database
+	* Ordered queries of a connection run one after another in the order they were made,
+	* other queries run in parallel on the connection pool.
+	* Each connection queues interactive and background queries separately, first in first out; queued interactive
+	* queries start first, and background queries never take the last free handle of a pool of two or more.
 	*/
 	UFUNCTION(BlueprintCallable, Category = "MySql Server")
-	void UpdateDataFromQuery(int32 ConnectionID, FString Query);
+	void UpdateDataFromQuery(int32 ConnectionID, FString Query, bool bOrdered = false, EMySQLQueryPriority Priority = EMySQLQueryPriority::Interactive);
 
 	/**
 	* Executes Multiple Queries Simultaneously to the database
 	*/
 	UFUNCTION(BlueprintCallable, Category = "MySql Server")
-		void UpdateDataFromMultipleQueries(int32 ConnectionID, TArray<FString> Queries);
+		void UpdateDataFromMultipleQueries(int32 ConnectionID, TArray<FString> Queries, bool bOrdered = false, EMySQLQueryPriority Priority = EMySQLQueryPriority::Interactive);
 
 	UFUNCTION(BlueprintImplementableEvent, Category = "MySql Server")
 		void OnQueryUpdateStatusChanged(int32 ConnectionID, int32 QueryID, bool IsSuccessful, const FString& ErrorMessage);
 
+	/**
+	* Executes the queries as one transaction, sent together instead of one round-trip and commit per query.
+	* The first failing query rolls back the whole transaction. Each query must be a single statement.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "MySql Server")
+		void UpdateDataInTransaction(int32 ConnectionID, TArray<FString> Queries, bool bOrdered = false, EMySQLQueryPriority Priority = EMySQLQueryPriority::Interactive);
+
+	/**
+	* StatementStatus has one entry per query: committed, rolled back, the query that failed, or not executed
+	*/
+	UFUNCTION(BlueprintImplementableEvent, Category = "MySql Server")
+		void OnTransactionStatusChanged(int32 ConnectionID, int32 QueryID, bool IsSuccessful, const FString& ErrorMessage,
+			const TArray<EMySQLStatementStatus>& StatementStatus);
+
 
 	/**
 	* Selects data from the database
    */
 	UFUNCTION(BlueprintCallable, Category = "MySql Server")
-		void SelectDataFromQuery(int32 ConnectionID, FString Query);
+		void SelectDataFromQuery(int32 ConnectionID, FString Query, bool bOrdered = false, EMySQLQueryPriority Priority = EMySQLQueryPriority::Interactive);
+
+	/**
+	* Called when a select finishes. Result reads typed values straight from the columnar result,
+	* which is shared with the worker that read it rather than copied; it is null when the select failed.
+	*/
+	UFUNCTION(BlueprintImplementableEvent, Category = "MySql Server")
+		void OnQuerySelectResult(int32 ConnectionID, int32 QueryID, bool IsSuccessful, const FString& ErrorMessage, UMySQLResult* Result);
 
+	/**
+	* Same select as OnQuerySelectResult with every cell copied into strings.
+	* The copies are only made when this event is implemented, and Blueprint copies the arrays once more
+	* when it calls the event, so large selects should use OnQuerySelectResult.
+	*/
 	UFUNCTION(BlueprintImplementableEvent, Category = "MySql Server")
 		void OnQuerySelectStatusChanged(int32 ConnectionID, int32 QueryID, bool IsSuccessful, const FString& ErrorMessage, const TArray<FMySQLDataTable>& ResultByColumn, 
 			const TArray<FMySQLDataRow>& ResultByRow);
 
+	/**
+	* Selects data from the database and delivers it in chunks of ChunkSize rows through OnQuerySelectChunk,
+	* so memory use depends on the chunk size rather than on the size of the result.
+	* The connection reads the next rows only while at most two chunks are waiting for the game thread.
+   */
+	UFUNCTION(BlueprintCallable, Category = "MySql Server")
+		void SelectDataInChunks(int32 ConnectionID, FString Query, int32 ChunkSize = 1000, bool bOrdered = false, EMySQLQueryPriority Priority = EMySQLQueryPriority::Background);
+
+	/**
+	* Called for every chunk of SelectDataInChunks in order. The last call has IsLastChunk set, may carry
+	* fewer rows than the chunk size, and reports whether the whole select succeeded.
+	*/
+	UFUNCTION(BlueprintImplementableEvent, Category = "MySql Server")
+		void OnQuerySelectChunk(int32 ConnectionID, int32 QueryID, int32 ChunkIndex, const TArray<FString>& ColumnNames, const TArray<FMySQLDataRow>& Rows,
+			bool IsLastChunk, bool IsSuccessful, const FString& ErrorMessage);
+
+
+	/**
+	* Prepares a statement with ? markers in place of its values and returns its StatementID.
+	* OnStatementPrepared reports whether the server accepted it. Every pooled connection keeps its own
+	* prepared copy, made the first time that connection runs the statement.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "MySql Server")
+		int32 PrepareStatement(int32 ConnectionID, FString Query);
+
+	/**
+	* Runs a prepared statement with one parameter per ? marker, in order. The values travel in binary form
+	* and never become part of the SQL text.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "MySql Server")
+		void ExecuteStatement(int32 StatementID, const TArray<FMySQLParameter>& Parameters, bool bOrdered = false, EMySQLQueryPriority Priority = EMySQLQueryPriority::Interactive);
+
+	/**
+	* Forgets a prepared statement. Connections close their copy when it falls out of their cache or when they close.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "MySql Server")
+		void CloseStatement(int32 StatementID);
+
+	UFUNCTION(BlueprintImplementableEvent, Category = "MySql Server")
+		void OnStatementPrepared(int32 ConnectionID, int32 QueryID, int32 StatementID, bool IsSuccessful, const FString& ErrorMessage, int32 ParameterCount);
+
+	/**
+	* Result holds the rows of a statement that returns them and is null otherwise; AffectedRows is set for the others.
+	*/
+	UFUNCTION(BlueprintImplementableEvent, Category = "MySql Server")
+		void OnStatementExecuted(int32 ConnectionID, int32 QueryID, int32 StatementID, bool IsSuccessful, const FString& ErrorMessage, int64 AffectedRows,
+			UMySQLResult* Result);
+
+
+	/**
+	* Runs Query once per row of Columns, where each column holds the values of one ? marker, all in one transaction.
+	* MariaDB servers receive the rows with array binding in large groups, other servers one row at a time.
+	* With bAllOrNothing a failed row rolls back the whole batch; otherwise the other rows are committed.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "MySql Server")
+		void ExecuteBatch(int32 ConnectionID, FString Query, const TArray<FMySQLParameterColumn>& Columns, bool bAllOrNothing = true, bool bOrdered = false,
+			EMySQLQueryPriority Priority = EMySQLQueryPriority::Background);
+
+	/**
+	* FailedRows lists every row the server rejected, by its index in the batch
+	*/
+	UFUNCTION(BlueprintImplementableEvent, Category = "MySql Server")
+		void OnBatchExecuted(int32 ConnectionID, int32 QueryID, bool IsSuccessful, const FString& ErrorMessage, int64 AffectedRows,
+			const TArray<FMySQLBatchRowError>& FailedRows);
+
 
 	/**
-		* Updates image to the database from the hard drive Asynchronously
+	* Updates image to the database from the texture Asynchronously, as a PNG with the same markers as UpdateImageFromPath.
+	* Editor builds read the texture's source data, packaged builds read the GPU texture back once; encoding and the upload
+	* run on a worker thread. Returns false when there is no texture or connection; the outcome is reported to
+	* OnImageUpdateStatusChanged. The upload is queued like any other query once the pixels are read.
 	*/
 	UFUNCTION(BlueprintCallable, Category = "MySql Server")
-		bool UpdateImageFromTexture(int32 ConnectionID, FString Query, FString UpdateParameter, int ParameterID, UTexture2D* Texture);
+		bool UpdateImageFromTexture(int32 ConnectionID, FString Query, FString UpdateParameter, int ParameterID, UTexture2D* Texture, bool bOrdered = false,
+			EMySQLQueryPriority Priority = EMySQLQueryPriority::Background);
 
 	/**
-	* Updates image to the database from the hard drive Asynchronously
+	* Updates image to the database from the hard drive Asynchronously.
+	* The PNG, JPEG or BMP file is stored as it is for the first ? of Query. When Query has three more markers,
+	* they get the image's format ("png", "jpg" or "bmp"), width and height.
 	*/
 	UFUNCTION(BlueprintCallable, Category = "MySql Server")
-		void UpdateImageFromPath(int32 ConnectionID, FString Query, FString UpdateParameter, int ParameterID, FString ImagePath);
+		void UpdateImageFromPath(int32 ConnectionID, FString Query, FString UpdateParameter, int ParameterID, FString ImagePath, bool bOrdered = false,
+			EMySQLQueryPriority Priority = EMySQLQueryPriority::Background);
 
 
 	UFUNCTION(BlueprintImplementableEvent, Category = "MySql Server")
 		void OnImageUpdateStatusChanged(int32 ConnectionID, int32 QueryID, bool IsSuccessful, const FString& ErrorMessage);
 
 	/**
-	* Selects image from the database and returns Texture2D format of the selected image
+	* Selects image from the database and returns Texture2D format of the selected image.
+	* The image is the first column of the first row; a second column with its format is used when present,
+	* otherwise the format is detected from the data. The image is decoded on the worker thread.
 	*/
 	UFUNCTION(BlueprintCallable, Category = "MySql Server")
-		void SelectImageFromQuery(int32 ConnectionID, FString Query);
+		void SelectImageFromQuery(int32 ConnectionID, FString Query, bool bOrdered = false, EMySQLQueryPriority Priority = EMySQLQueryPriority::Background);
 
 	UFUNCTION(BlueprintImplementableEvent, Category = "MySql Server")
 		void OnImageSelectStatusChanged(int32 ConnectionID, int32 QueryID, bool IsSuccessful, const FString& ErrorMessage, UTexture2D* SelectedTexture);
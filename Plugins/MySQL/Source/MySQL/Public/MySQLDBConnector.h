@@ -5,6 +5,7 @@
 #include "CoreMinimal.h"
 #include "MySQLBPLibrary.h"
 #include "MySQLMain.h"
+#include "MySQLResultSet.h"
 #include "MySQLDBConnector.generated.h"
 
 
@@ -15,7 +16,9 @@ class MYSQL_API UMySQLDBConnector : public UObject
 
 	UMySQLDBConnector();
 
-	TMap<int, int> QueryToConnectionMap;
+	// Stores the image read by ReadChunk for the first ? of Query and its format and size for the next three, if there are
+	bool UpdateImageBlob(int32 ConnectionID, const FString& Query, const FMySQLImageInfo& ImageInfo, const MySQLConnection::FBlobReader& ReadChunk,
+	                     FString& ErrorMessage);
 	
 	
 public:
@@ -23,20 +26,54 @@ public:
 	MySQLConnection* mysqlConnection;
 	
 	bool CreateNewConnection(int32 ConnectionID, FString Server, FString DBName, FString UserID, FString Password, int32 Port, TArray<FMySQLOptionPair> Options, 
-	                         FString& ErrorMessage);
+	                         int32 PoolSize, FString& ErrorMessage);
 
 	
 	void  CloseConnection(int32 ConnectionID);
 
 	void UpdateDataFromQuery(int32 ConnectionID, int32 QueryID, FString Query, bool& IsSuccessful, FString& ErrorMessage);
+	void UpdateDataFromQueries(int32 ConnectionID, int32 QueryID, const TArray<FString>& Queries, bool& IsSuccessful, FString& ErrorMessage);
+	void UpdateDataInTransaction(int32 ConnectionID, const TArray<FString>& Queries, bool& IsSuccessful, FString& ErrorMessage,
+	                             TArray<EMySQLStatementStatus>& StatementStatus);
 
 	void SelectDataFromQuery(int32 ConnectionID, FString Query, bool& IsSuccessful, FString& ErrorMessage,
 	                         TArray<FMySQLDataTable>& ResultByColumn, TArray<FMySQLDataRow>& ResultByRow);
 
+	// Typed, columnar form of the select; the string arrays above are built from it
+	void SelectResultSet(int32 ConnectionID, FString Query, bool& IsSuccessful, FString& ErrorMessage, FMySQLResultSet& Result);
+
+	/**
+	* Runs the queries on the non-blocking I/O thread instead of the calling thread. OnComplete gets the status of
+	* the last query and the rows of the last select, on the I/O thread, and should only hand them off.
+	*/
+	void RunQueriesNonBlocking(int32 ConnectionID, const TArray<FString>& Queries,
+	                           TFunction<void(bool IsSuccessful, const FString& ErrorMessage, FMySQLResultSet& Result)> OnComplete);
+
+	/**
+	* Streams the result in chunks of ChunkSize rows. OnChunk gets every full chunk and may take its rows;
+	* returning false stops the select. Rows after the last full chunk are left in LastRows.
+	*/
+	void SelectDataInChunks(int32 ConnectionID, FString Query, int32 ChunkSize,
+	                        TFunctionRef<bool(const TArray<FString>& ColumnNames, TArray<FMySQLDataRow>& Rows)> OnChunk,
+	                        bool& IsSuccessful, FString& ErrorMessage, TArray<FString>& ColumnNames, TArray<FMySQLDataRow>& LastRows);
+
+
+	void PrepareStatement(int32 ConnectionID, const FString& Query, int32& ParameterCount, bool& IsSuccessful, FString& ErrorMessage);
+	void ExecuteStatement(int32 ConnectionID, const FString& Query, const TArray<FMySQLParameter>& Parameters, bool& IsSuccessful, FString& ErrorMessage,
+	                      FMySQLResultSet& Result, int64& AffectedRows);
+	void ExecuteBatch(int32 ConnectionID, const FString& Query, const TArray<FMySQLParameterColumn>& Columns, bool bAllOrNothing, bool& IsSuccessful,
+	                  FString& ErrorMessage, int64& AffectedRows, TArray<FMySQLBatchRowError>& FailedRows);
+
 
 	void UpdateImageFromPath(int32 ConnectionID, int32 QueryID, FString Query, FString UpdateParameter, int ParameterID, FString ImagePath, bool&
 	                         IsSuccessful, FString& ErrorMessage);
-	UTexture2D* SelectImageFromQuery(int32 ConnectionID, int32 QueryID, FString Query, bool& IsSuccessful, FString& ErrorMessage);
+	// Same as UpdateImageFromPath for an image already encoded in memory
+	void UpdateImageFromData(int32 ConnectionID, int32 QueryID, FString Query, FString UpdateParameter, int ParameterID, const TArray64<uint8>& ImageData,
+	                         const FMySQLImageInfo& ImageInfo, bool& IsSuccessful, FString& ErrorMessage);
+	// Selects and decodes the image on the calling thread; the texture is created from Image on the game thread
+	void SelectImageFromQuery(int32 ConnectionID, int32 QueryID, FString Query, FMySQLDecodedImage& Image, bool& IsSuccessful, FString& ErrorMessage);
+
+	bool GetPoolCounts(int32 ConnectionID, int32& PoolSize, int32& OpenHandles, int32& IdleHandles);
 
 
 	virtual void BeginDestroy() override;
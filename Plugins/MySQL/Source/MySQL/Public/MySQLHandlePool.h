@@ -0,0 +1,162 @@
+// Copyright 2021-2023, Athian Games. All Rights Reserved.
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <mysql/mysql.h>
+
+#include "MySQLStatementCache.h"
+
+using namespace std;
+
+
+/**
+* Pool of MYSQL handles that belong to one logical connection.
+* A handle is used by one thread at a time; Acquire blocks while every handle is busy
+* and the pool has reached its size. New handles are opened on demand with the
+* parameters of the original connection.
+* Each idle handle remembers when it last talked to the server, which is what
+* callers and the keepalive use to decide whether it needs a ping.
+* Handles also carry their prepared statements, which are closed together with them.
+*/
+class MySQLHandlePool
+{
+
+public:
+
+	typedef function<MYSQL*(string& ErrorMessage)> FOpenHandleFunction;
+
+	// Opens a handle with mysql_real_connect_start and returns it with the MYSQL_WAIT_* status of that call
+	// (0 when it finished right away, with its result in Connected); nullptr when no handle could be made
+	typedef function<MYSQL*(int& WaitStatus, MYSQL*& Connected, string& ErrorMessage)> FStartOpenHandleFunction;
+
+	MySQLHandlePool(int InMaxHandles, FOpenHandleFunction InOpenHandle, FStartOpenHandleFunction InStartOpenHandle = nullptr);
+	~MySQLHandlePool();
+
+	MySQLHandlePool(const MySQLHandlePool&) = delete;
+	MySQLHandlePool& operator=(const MySQLHandlePool&) = delete;
+
+	// Adds an already connected handle as idle
+	void AddHandle(MYSQL* Handle);
+
+	// IdleSeconds is the time since the handle's last server round-trip, 0 for a new handle
+	MYSQL* Acquire(string& ErrorMessage, double& IdleSeconds);
+
+	/**
+	* Never blocks. Returns an idle handle, or nullptr with bOpenSlot set when the pool has room for another handle;
+	* that slot is then reserved for the caller, who opens the handle with StartOpenHandle and hands it to FinishOpenHandle.
+	* A busy pool returns nullptr and leaves ErrorMessage empty.
+	*/
+	MYSQL* TryAcquire(string& ErrorMessage, double& IdleSeconds, bool& bOpenSlot);
+
+	// Starts opening a handle for a reserved slot; without a start function the handle is opened right away
+	MYSQL* StartOpenHandle(int& WaitStatus, MYSQL*& Connected, string& ErrorMessage);
+
+	// Ends opening a handle for a reserved slot. A connected handle stays with the caller as a busy handle of the pool;
+	// otherwise the handle is closed, the slot freed and false returned
+	bool FinishOpenHandle(MYSQL* Handle, bool bConnected, string& ErrorMessage);
+
+	// Broken handles are closed instead of being returned to the idle list
+	void Release(MYSQL* Handle, bool bBroken = false);
+
+	// Pings the handles that have been idle for longer than IdleSeconds and closes the dead ones
+	void PingIdleHandles(double IdleSeconds);
+
+	// Closes idle handles now and busy handles as soon as they are released
+	void Close();
+
+	/**
+	* Listener is called, outside the pool lock, whenever a handle or a slot becomes free or the pool closes.
+	* For waiters that can not block in Acquire, such as the async engine's poll loop. One listener per Owner
+	*/
+	void AddReleaseListener(const void* Owner, function<void()> Listener);
+	// Once this returns the listener is not running and will not be called again
+	void RemoveReleaseListener(const void* Owner);
+
+	// Prepared statements of a handle taken from this pool, for the thread holding it
+	MySQLStatementCache& GetStatementCache(MYSQL* Handle);
+
+	bool IsClosed() const;
+	int GetMaxHandles() const { return MaxHandles; }
+	void GetHandleCounts(int& OpenHandles, int& IdleHandles) const;
+
+private:
+
+	typedef chrono::steady_clock FClock;
+
+	struct FIdleHandle
+	{
+		MYSQL* Handle;
+		FClock::time_point LastIOTime;
+	};
+
+	// Closes a handle that is no longer counted by the pool, with its statements
+	void CloseHandle(MYSQL* Handle);
+
+	// Wakes blocked Acquire calls and the release listeners
+	void NotifyHandleReleased(bool bAll = false);
+
+	mutable mutex PoolMutex;
+	condition_variable HandleReleased;
+
+	FOpenHandleFunction OpenHandle;
+	FStartOpenHandleFunction StartOpenHandleFunction;
+	int MaxHandles;
+
+	// Opened handles, including busy ones and the ones being connected right now
+	int NumHandles = 0;
+	vector<FIdleHandle> IdleHandles;
+	bool bClosed = false;
+
+	// Created the first time a handle prepares a statement
+	unordered_map<MYSQL*, unique_ptr<MySQLStatementCache>> StatementCaches;
+
+	// Separate from PoolMutex, so that listeners run without it
+	mutex ListenerMutex;
+	vector<pair<const void*, function<void()>>> ReleaseListeners;
+
+};
+
+
+/**
+* Handle taken from a MySQLHandlePool, returned to it when the lease goes out of scope.
+*/
+class MySQLPooledHandle
+{
+
+public:
+
+	MySQLPooledHandle() = default;
+	MySQLPooledHandle(shared_ptr<MySQLHandlePool> InPool, MYSQL* InHandle);
+	~MySQLPooledHandle();
+
+	MySQLPooledHandle(MySQLPooledHandle&& Other) noexcept;
+	MySQLPooledHandle& operator=(MySQLPooledHandle&& Other) noexcept;
+
+	MySQLPooledHandle(const MySQLPooledHandle&) = delete;
+	MySQLPooledHandle& operator=(const MySQLPooledHandle&) = delete;
+
+	MYSQL* Get() const { return Handle; }
+	explicit operator bool() const { return Handle != nullptr; }
+
+	MySQLStatementCache& GetStatementCache() const { return Pool->GetStatementCache(Handle); }
+
+	// Closes the handle instead of returning it to the pool
+	void Discard();
+
+private:
+
+	void Reset(bool bBroken);
+
+	shared_ptr<MySQLHandlePool> Pool;
+	MYSQL* Handle = nullptr;
+
+};
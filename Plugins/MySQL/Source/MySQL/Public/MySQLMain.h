@@ -5,45 +5,205 @@
 #include <vector>
 #include <vector>
 #include <xstring>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include <mysql/mysql.h>
 
 #include "MySQLConnectionOptions.h"
+#include "MySQLHandlePool.h"
+#include "MySQLAsyncEngine.h"
 
 using namespace std;
 
+class FMySQLResultSet;
+struct FMySQLParameter;
+struct FMySQLParameterColumn;
+enum class EMySQLStatementStatus : uint8;
+
+// Parameters of a logical connection, kept so that its pool can open more handles later
+struct FMySQLConnectionSettings
+{
+	string Server;
+	string DBName;
+	string UserID;
+	string Password;
+	int Port = 0;
+	TArray<FMySQLOptionPair> Options;
+};
+
 
 class MySQLConnection
 {
 
 
 	void SetMySQLBulkOptions(MYSQL* MySQLHandle, const TArray<FMySQLOptionPair>& OptionsArray);
+	MYSQL* InitHandle(const FMySQLConnectionSettings& Settings, string& ErrorMessage);
+	MYSQL* OpenHandle(const FMySQLConnectionSettings& Settings, string& ErrorMessage);
+
+	// Non-blocking open for the async engine, see MySQLHandlePool::FStartOpenHandleFunction. Settings must outlive the connect
+	MYSQL* StartOpenHandle(const FMySQLConnectionSettings& Settings, int& WaitStatus, MYSQL*& Connected, string& ErrorMessage);
 	template <typename T>
 void SetMySQLOption(MYSQL* MySQLHandle, EMySQLOptions Option, const T& Value)
 	{
 		mysql_options(MySQLHandle, static_cast<enum mysql_option>(Option), &Value);
 	}
 
+	// One pool per ConnectionID; leases keep a pool alive after it is replaced or closed
+	mutex PoolsMutex;
+	vector<shared_ptr<MySQLHandlePool>> DBConnections;
+	shared_ptr<MySQLHandlePool> GetPool(int ConnectionID);
+
+	/**
+	* Runs Operation on a pooled handle. Operation returns 0 or the client error code of its failure.
+	* A handle that lost the server is dropped, and when bRetryOnLostConnection is set the work
+	* is run once more on a fresh handle.
+	*/
+	typedef function<unsigned int(MYSQL* Handle, string& ErrorMessage)> FHandleOperation;
+	bool ExecuteOnHandle(int ConnectionID, bool bRetryOnLostConnection, string& ErrorMessage, const FHandleOperation& Operation);
+
+	// Same as above for work that needs more of the lease than the MYSQL handle, like its prepared statements
+	typedef function<unsigned int(MySQLPooledHandle& Handle, string& ErrorMessage)> FPooledHandleOperation;
+	bool ExecuteOnPooledHandle(int ConnectionID, bool bRetryOnLostConnection, string& ErrorMessage, const FPooledHandleOperation& Operation);
+
+	static unsigned int ExecuteStatementOnHandle(MySQLPooledHandle& CurrentDBConnection, const string& Query, const TArray<FMySQLParameter>& Parameters,
+	                                             FMySQLResultSet& Result, uint64& AffectedRows, string& ErrorMessage);
+	static unsigned int FetchStatementResult(MYSQL_STMT* Statement, MYSQL_RES* Metadata, FMySQLResultSet& Result, string& ErrorMessage);
+
+	// Pings idle handles in the background so that queries do not have to
+	mutex KeepAliveControlMutex;
+	mutex KeepAliveMutex;
+	condition_variable KeepAliveWakeUp;
+	bool bStopKeepAlive = false;
+	thread KeepAliveThread;
+	void StartKeepAlive();
+	void StopKeepAlive();
+	void KeepAliveLoop();
+
+	// Shared with the other connections, taken the first time this one submits a non-blocking query
+	mutex AsyncEngineMutex;
+	shared_ptr<MySQLAsyncEngine> AsyncEngine;
+
 public:
 
-	vector<MYSQL*> DBConnections;
-	MYSQL* GetDBConnection(int ConnectionID);
+	// Statements that can be sent again after the server connection dropped mid-query
+	static bool IsIdempotentStatement(const char* Query);
+
+	// Takes a live handle of the connection's pool, waiting while all of them are busy
+	MySQLPooledHandle GetDBConnection(int ConnectionID, string& ErrorMessage);
 
 	MySQLConnection() = default;
-	~MySQLConnection() = default;
+	~MySQLConnection();
     
 	void CloseAllConnections();
 
 	void CloseConnection(int ConnectionID);
 
-	bool CreateConnection(int ConnectionID, char* Server, char* DBName, char* UserID, char* Password, int Port, TArray<FMySQLOptionPair> Options, const char*& ErrorMessage);
-	bool UpdateDataFromQuery(int ConnectionID, char* Query, const char*& ErrorMessage);
-	bool SelectDataFromQuery(int ConnectionID, const char* Query, std::vector<std::string>& ColumnNames, std::vector<std::vector<std::string>>&
-	                         ColumnData, std::string& ErrorMessage);
-
-	bool UpdateImageFromPath(int ConnectionID, const char* Query, const char* ImageChar, const char*& ErrorMessage);
-	bool SelectImageFromQuery(int ConnectionID, const char* Query, char*& ImageChar, const char*& ErrorMessage);
+	bool CreateConnection(int ConnectionID, char* Server, char* DBName, char* UserID, char* Password, int Port, TArray<FMySQLOptionPair> Options, int PoolSize,
+	                      string& ErrorMessage);
+	bool UpdateDataFromQuery(int ConnectionID, const char* Query, string& ErrorMessage);
+	// Runs the queries in order on one handle; the result is the status of the last query
+	bool UpdateDataFromQueries(int ConnectionID, const vector<string>& Queries, string& ErrorMessage);
+
+	/**
+	* Runs the queries as one transaction. START TRANSACTION, the queries and COMMIT go to the server as multi-statement
+	* packets, so the batch costs one round-trip and one commit instead of one of each per query. The first failing query
+	* stops the server and the transaction is rolled back. Every query has to be a single statement, since its status is
+	* found by counting results; StatementStatus gets one entry per query.
+	*/
+	static constexpr size_t TransactionPacketBytes = 1 << 20;
+	bool ExecuteTransaction(int ConnectionID, const vector<string>& Queries, vector<EMySQLStatementStatus>& StatementStatus, string& ErrorMessage);
+
+	/**
+	* Unbuffered select: rows are read from the socket one at a time with mysql_use_result and handed
+	* to OnRow, which returns false to stop early. Nothing of the result is kept here, so memory
+	* use is up to the caller. A dropped stream is not retried, since the caller already saw part of it.
+	*/
+	typedef function<void(MYSQL_FIELD* Fields, unsigned int NumFields)> FColumnsCallback;
+	typedef function<bool(MYSQL_ROW Row, unsigned long* Lengths, unsigned int NumFields)> FRowCallback;
+	bool SelectDataStreaming(int ConnectionID, const char* Query, const FColumnsCallback& OnColumns, const FRowCallback& OnRow, string& ErrorMessage);
+
+	// Reads the whole result into Result, column by column; a select that lost the server is run again
+	bool SelectResultSet(int ConnectionID, const char* Query, FMySQLResultSet& Result, string& ErrorMessage);
+
+	/**
+	* Queues the queries on the non-blocking engine, which runs them in order on one pooled handle without
+	* holding a thread while the server works. OnComplete is called on the engine's I/O thread with the status
+	* of the last query and the rows of the last select. Returns false if the connection does not exist.
+	*/
+	bool SubmitQueries(int ConnectionID, vector<string> Queries, MySQLAsyncEngine::FCompletion OnComplete, string& ErrorMessage);
+
+	// Prepares Query on one of the connection's handles, which keeps it cached; ParameterCount is the number of ? markers
+	bool PrepareStatement(int ConnectionID, const string& Query, unsigned long& ParameterCount, string& ErrorMessage);
+
+	/**
+	* Runs Query as a server-side prepared statement with Parameters bound to its markers. The statement is taken from
+	* the cache of the handle that runs it, and prepared there first if that handle has not seen it yet.
+	* Rows are decoded from the binary protocol into Result; statements without rows report AffectedRows.
+	*/
+	bool ExecuteStatement(int ConnectionID, const string& Query, const TArray<FMySQLParameter>& Parameters, FMySQLResultSet& Result,
+	                      uint64& AffectedRows, string& ErrorMessage);
+
+	struct FBatchRowError
+	{
+		int RowIndex;
+		string ErrorMessage;
+	};
+
+	/**
+	* Runs Query once per row of a column-major parameter batch inside one transaction. On MariaDB servers the rows
+	* are sent with array binding, BatchRowsPerExecute at a time; other servers get one execution per row.
+	* Rows the server rejects are listed in FailedRows. With bAllOrNothing a single failed row rolls the whole
+	* batch back, otherwise the remaining rows are committed. A deadlock or lock wait timeout fails the whole batch,
+	* since the server may already have rolled back the rows before it.
+	*/
+	static constexpr int BatchRowsPerExecute = 1000;
+	bool ExecuteBatch(int ConnectionID, const string& Query, const TArray<FMySQLParameterColumn>& Columns, bool bAllOrNothing,
+	                  vector<FBatchRowError>& FailedRows, uint64& AffectedRows, string& ErrorMessage);
+
+	/**
+	* Writes send BLOB values in chunks of BlobChunkBytes, so the source is never held in one piece on this side.
+	* Reads are not streamed: mysql_stmt_fetch buffers the whole row first, and the chunks are only copied out of that buffer.
+	* The server limits a value to its max_allowed_packet either way.
+	*/
+	static constexpr size_t BlobChunkBytes = 256 * 1024;
+
+	// Fills Buffer with up to Capacity bytes of the value and returns how many it wrote, 0 at the end of the value or -1 on failure
+	typedef function<int64(char* Buffer, size_t Capacity)> FBlobReader;
+	// Receives the value in order; TotalLength is known from the first call on. Returns false to stop reading
+	typedef function<bool(const char* Data, size_t Length, uint64 Offset, uint64 TotalLength)> FBlobWriter;
+
+	/**
+	* Runs Query with the value sent through mysql_stmt_send_long_data for its first ? marker. When Query has more markers,
+	* they get ExtraParameters as strings; a Query with a single marker ignores them. Not retried, since the reader is used up
+	*/
+	bool UpdateBlobStreaming(int ConnectionID, const string& Query, const FBlobReader& ReadChunk, const vector<string>& ExtraParameters,
+	                         string& ErrorMessage);
+
+	/**
+	* Copies the first column of the first row of Query to OnChunk with mysql_stmt_fetch_column, one chunk at a time.
+	* The other columns of the row go to OtherColumns. The client library holds the whole row while this runs, so peak
+	* memory is the row plus whatever OnChunk keeps - a caller that assembles the value holds it twice at the end.
+	*/
+	bool SelectBlobStreaming(int ConnectionID, const string& Query, const FBlobWriter& OnChunk, vector<string>& OtherColumns, string& ErrorMessage);
 
 	bool IsValidConnection(int ConnectionID);
+	bool GetPoolCounts(int ConnectionID, int& PoolSize, int& OpenHandles, int& IdleHandles);
+
+private:
+
+	static unsigned int StreamSelectOnHandle(MYSQL* CurrentDBConnection, const char* Query, const FColumnsCallback& OnColumns, const FRowCallback& OnRow,
+	                                         string& ErrorMessage);
+	static unsigned int UpdateBlobOnHandle(MYSQL* CurrentDBConnection, const string& Query, const FBlobReader& ReadChunk, const vector<string>& ExtraParameters,
+	                                       string& ErrorMessage);
+	static unsigned int SelectBlobOnHandle(MYSQL* CurrentDBConnection, const string& Query, const FBlobWriter& OnChunk, vector<string>& OtherColumns,
+	                                       string& ErrorMessage);
+	static unsigned int ExecuteTransactionOnHandle(MYSQL* CurrentDBConnection, const vector<string>& Queries, vector<EMySQLStatementStatus>& StatementStatus,
+	                                               string& ErrorMessage);
+	static unsigned int ExecuteBatchOnHandle(MySQLPooledHandle& CurrentDBConnection, const string& Query, const TArray<FMySQLParameterColumn>& Columns,
+	                                         int32 NumRows, bool bAllOrNothing, vector<FBatchRowError>& FailedRows, uint64& AffectedRows, string& ErrorMessage);
 
 
 
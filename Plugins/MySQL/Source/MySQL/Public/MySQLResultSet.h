@@ -0,0 +1,209 @@
+// Copyright 2021-2023, Athian Games. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+#include "MySQLBPLibrary.h"
+
+#include <mysql/mysql.h>
+
+#include "MySQLResultSet.generated.h"
+
+
+UENUM(BlueprintType)
+enum class EMySQLColumnType : uint8
+{
+	Integer,
+	Double,
+	DateTime,
+	Text,
+	Blob
+};
+
+
+/**
+* Result of a select stored by column. Each column keeps its values in one contiguous buffer:
+* integers, doubles and dates as fixed-size values, text and blobs as bytes with an offset per row.
+* NULL cells are marked in a bitmap per column. Building a result of R rows and C columns
+* allocates O(C) buffers instead of a string per cell.
+* Cells whose typed value does not print back as the server sent it (FLOAT and DOUBLE,
+* ZEROFILL integers, zero and invalid dates) also keep their wire text, so the string views
+* match the server's text output byte for byte.
+*/
+class MYSQL_API FMySQLResultSet
+{
+
+public:
+
+	// Starts a new result with the given columns, dropping any previous rows
+	void Reset(const MYSQL_FIELD* Fields, unsigned int NumFields);
+
+	// Appends a row in the text protocol format returned by mysql_fetch_row
+	void AddRow(const MYSQL_ROW Row, const unsigned long* Lengths);
+
+	// Appends one non-NULL cell from its wire text, parsing it into the column's type.
+	// Text[Length] must be a NUL, as in the rows of mysql_fetch_row
+	void AddTextCell(int32 Column, const char* Text, int32 Length);
+
+	// True for typed columns that are read as text so their wire text is kept (FLOAT, DOUBLE, ZEROFILL)
+	bool IsReadAsText(int32 Column) const { return Columns[Column].bReadAsText; }
+
+	// Binary protocol rows are appended one cell per column, in column order, followed by FinishRow
+	void AddNullCell(int32 Column);
+	void AddInt64Cell(int32 Column, int64 Value);
+	void AddDoubleCell(int32 Column, double Value);
+	void AddDateTimeCell(int32 Column, const FDateTime& Value);
+	// Reserves Length bytes of a text or blob cell and returns where to write them
+	uint8* AddBytesCell(int32 Column, int32 Length);
+	void FinishRow() { NumRows++; }
+
+	// Releases the slack left by growing the column buffers
+	void Shrink();
+
+	int32 GetNumRows() const { return NumRows; }
+	int32 GetNumColumns() const { return Columns.Num(); }
+	const FString& GetColumnName(int32 Column) const { return Columns[Column].Name; }
+	EMySQLColumnType GetColumnType(int32 Column) const { return Columns[Column].Type; }
+	int32 FindColumn(const FString& Name) const;
+
+	bool IsNull(int32 Row, int32 Column) const { return Columns[Column].Nulls[Row]; }
+
+	// Typed getters return 0, an empty date or no bytes for NULL cells and cells of another type.
+	// Zero and invalid dates are not NULL; they read as an empty date and print their wire text
+	int64 GetInt64(int32 Row, int32 Column) const;
+	double GetDouble(int32 Row, int32 Column) const;
+	FDateTime GetDateTime(int32 Row, int32 Column) const;
+	TArrayView<const uint8> GetBytes(int32 Row, int32 Column) const;
+
+	// Text form of any cell; NULL cells give NullText
+	FString GetString(int32 Row, int32 Column, const TCHAR* NullText = TEXT("NULL")) const;
+
+	// The string views used by the original select events
+	void GetRow(int32 Row, FMySQLDataRow& OutRow) const;
+	void GetColumn(int32 Column, FMySQLDataTable& OutColumn) const;
+	void ToRows(TArray<FMySQLDataRow>& OutRows) const;
+	void ToColumns(TArray<FMySQLDataTable>& OutColumns) const;
+
+	SIZE_T GetAllocatedSize() const;
+
+private:
+
+	struct FColumn
+	{
+		FString Name;
+		EMySQLColumnType Type = EMySQLColumnType::Text;
+		enum_field_types FieldType = MYSQL_TYPE_NULL;
+		uint32 Decimals = 0;
+
+		// Integer and DateTime hold int64 values (dates as ticks), Double holds doubles,
+		// Text (UTF-8) and Blob hold the bytes of all rows back to back
+		TArray<uint8> Data;
+
+		// Text and Blob: row R is Data[Offsets[R] .. Offsets[R + 1])
+		TArray<int64> Offsets;
+
+		TBitArray<> Nulls;
+
+		// Wire text of typed cells, laid out like Data and Offsets. Kept for every cell of a
+		// bReadAsText column and for the dates that do not parse; empty otherwise
+		TArray<uint8> WireText;
+		TArray<int64> WireTextOffsets;
+		bool bReadAsText = false;
+	};
+
+	void AddWireText(FColumn& Column, const char* Text, int32 Length);
+
+	template <typename T>
+	const T& GetFixed(const FColumn& Column, int32 Row) const
+	{
+		return reinterpret_cast<const T*>(Column.Data.GetData())[Row];
+	}
+
+	template <typename T>
+	void AddFixed(FColumn& Column, T Value, bool bIsNull)
+	{
+		Column.Data.Append(reinterpret_cast<const uint8*>(&Value), sizeof(Value));
+		Column.Nulls.Add(bIsNull);
+	}
+
+	TArray<FColumn> Columns;
+	int32 NumRows = 0;
+
+};
+
+/**
+* A finished result. It is filled on the thread that read it, moved into the shared pointer once,
+* and from then on only read, so the game thread and every UMySQLResult share it without copies.
+*/
+typedef TSharedPtr<const FMySQLResultSet, ESPMode::ThreadSafe> FMySQLResultSetPtr;
+
+
+/**
+* Blueprint handle to a select result. Values are read from the shared columnar result on
+* demand; the row and column string arrays are only built when asked for.
+*/
+UCLASS(BlueprintType)
+class MYSQL_API UMySQLResult : public UObject
+{
+	GENERATED_BODY()
+
+	FMySQLResultSetPtr ResultSet;
+
+	bool IsValidCell(int32 Row, int32 Column) const;
+
+public:
+
+	static UMySQLResult* Create(UObject* Outer, FMySQLResultSetPtr InResultSet);
+
+	FMySQLResultSetPtr GetResultSet() const { return ResultSet; }
+
+	UFUNCTION(BlueprintPure, Category = "MySql|Result")
+		int32 GetNumRows() const;
+
+	UFUNCTION(BlueprintPure, Category = "MySql|Result")
+		int32 GetNumColumns() const;
+
+	UFUNCTION(BlueprintPure, Category = "MySql|Result")
+		FString GetColumnName(int32 Column) const;
+
+	/**
+	* Index of the column with the given name, -1 when there is none
+	*/
+	UFUNCTION(BlueprintPure, Category = "MySql|Result")
+		int32 FindColumn(const FString& Name) const;
+
+	UFUNCTION(BlueprintPure, Category = "MySql|Result")
+		EMySQLColumnType GetColumnType(int32 Column) const;
+
+	UFUNCTION(BlueprintPure, Category = "MySql|Result")
+		bool IsNull(int32 Row, int32 Column) const;
+
+	UFUNCTION(BlueprintPure, Category = "MySql|Result")
+		FString GetString(int32 Row, int32 Column) const;
+
+	UFUNCTION(BlueprintPure, Category = "MySql|Result")
+		int64 GetInteger(int32 Row, int32 Column) const;
+
+	UFUNCTION(BlueprintPure, Category = "MySql|Result")
+		double GetFloat(int32 Row, int32 Column) const;
+
+	UFUNCTION(BlueprintPure, Category = "MySql|Result")
+		FDateTime GetDateTime(int32 Row, int32 Column) const;
+
+	UFUNCTION(BlueprintPure, Category = "MySql|Result")
+		FMySQLDataRow GetRow(int32 Row) const;
+
+	UFUNCTION(BlueprintPure, Category = "MySql|Result")
+		FMySQLDataTable GetColumn(int32 Column) const;
+
+	/**
+	* Copies the whole result into string rows, as OnQuerySelectStatusChanged delivers it
+	*/
+	UFUNCTION(BlueprintCallable, Category = "MySql|Result")
+		TArray<FMySQLDataRow> GetAllRows() const;
+
+	UFUNCTION(BlueprintCallable, Category = "MySql|Result")
+		TArray<FMySQLDataTable> GetAllColumns() const;
+
+};
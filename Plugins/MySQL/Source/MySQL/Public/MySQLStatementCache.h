@@ -0,0 +1,51 @@
+// Copyright 2021-2023, Athian Games. All Rights Reserved.
+
+#pragma once
+
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <mysql/mysql.h>
+
+using namespace std;
+
+
+/**
+* Prepared statements of one MYSQL handle, keyed by their SQL text.
+* Server-side statements belong to the session that prepared them, so every pooled handle
+* has its own cache, and only the thread holding the handle uses it.
+* The least recently used statement is closed once the cache is full.
+*/
+class MySQLStatementCache
+{
+
+public:
+
+	static constexpr size_t DefaultMaxStatements = 64;
+
+	explicit MySQLStatementCache(size_t InMaxStatements = DefaultMaxStatements);
+	~MySQLStatementCache();
+
+	MySQLStatementCache(const MySQLStatementCache&) = delete;
+	MySQLStatementCache& operator=(const MySQLStatementCache&) = delete;
+
+	// Statement for Query, prepared on Handle the first time it is asked for. On failure ErrorCode is set and nullptr returned
+	MYSQL_STMT* Prepare(MYSQL* Handle, const string& Query, string& ErrorMessage, unsigned int& ErrorCode);
+
+	// Closes the statement of Query, e.g. after the server forgot it
+	void Remove(const string& Query);
+
+	void Clear();
+	size_t Num() const { return Statements.size(); }
+
+private:
+
+	// Most recently used first
+	typedef list<pair<string, MYSQL_STMT*>> FStatementList;
+
+	FStatementList Statements;
+	unordered_map<string, FStatementList::iterator> StatementsByQuery;
+	size_t MaxStatements;
+
+};
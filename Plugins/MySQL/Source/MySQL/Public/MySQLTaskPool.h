@@ -0,0 +1,117 @@
+// Copyright 2021-2023, Athian Games. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "Async/AsyncWork.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "Misc/Optional.h"
+
+
+/**
+* Counts the tasks of one owner across all of its task pools. Tasks count themselves out on
+* their worker thread; when the last one is done, OnIdle runs on the game thread.
+*/
+class MYSQL_API FMySQLTaskTracker
+{
+
+	FThreadSafeCounter InFlight;
+	TFunction<void()> OnIdle;
+
+public:
+
+	explicit FMySQLTaskTracker(TFunction<void()> InOnIdle);
+
+	void TaskStarted();
+	void TaskDone();
+
+	int32 Num() const { return InFlight.GetValue(); }
+
+};
+
+
+/**
+* Reusable async tasks of one type. A task is constructed in place in a finished wrapper of
+* the pool when there is one, so starting queries does not allocate once the pool has grown
+* to the number running at the same time, and nothing has to poll for finished tasks.
+*/
+template<typename TaskType>
+class TMySQLTaskPool
+{
+
+	class FPooledTask : public FNonAbandonableTask
+	{
+
+	public:
+
+		TOptional<TaskType> Task;
+		TSharedPtr<FMySQLTaskTracker, ESPMode::ThreadSafe> Tracker;
+
+		void DoWork()
+		{
+			Task->DoWork();
+
+			// The payload is released on the worker; the wrapper stays in the pool
+			Task.Reset();
+			Tracker->TaskDone();
+		}
+
+		FORCEINLINE TStatId GetStatId() const
+		{
+			RETURN_QUICK_DECLARE_CYCLE_STAT(MySQLPooledTask, STATGROUP_ThreadPoolAsyncTasks);
+		}
+
+	};
+
+	TArray<TUniquePtr<FAsyncTask<FPooledTask>>> Tasks;
+
+public:
+
+	TMySQLTaskPool() = default;
+	TMySQLTaskPool(const TMySQLTaskPool&) = delete;
+	TMySQLTaskPool& operator=(const TMySQLTaskPool&) = delete;
+
+	~TMySQLTaskPool()
+	{
+		EnsureCompletion();
+	}
+
+	template<typename... ArgTypes>
+	void Start(const TSharedRef<FMySQLTaskTracker, ESPMode::ThreadSafe>& Tracker, ArgTypes&&... Args)
+	{
+		FAsyncTask<FPooledTask>* PooledTask = nullptr;
+		for (const TUniquePtr<FAsyncTask<FPooledTask>>& Candidate : Tasks)
+		{
+			if (Candidate->IsDone())
+			{
+				PooledTask = Candidate.Get();
+				break;
+			}
+		}
+		if (!PooledTask)
+		{
+			PooledTask = Tasks.Add_GetRef(MakeUnique<FAsyncTask<FPooledTask>>()).Get();
+		}
+
+		FPooledTask& Wrapper = PooledTask->GetTask();
+		Wrapper.Task.Emplace(Forward<ArgTypes>(Args)...);
+		Wrapper.Tracker = Tracker;
+
+		Tracker->TaskStarted();
+		PooledTask->StartBackgroundTask();
+	}
+
+	// Waits for every running task of the pool
+	void EnsureCompletion()
+	{
+		for (const TUniquePtr<FAsyncTask<FPooledTask>>& Task : Tasks)
+		{
+			Task->EnsureCompletion();
+		}
+	}
+
+	// Wrappers kept for reuse, running or not
+	int32 Num() const { return Tasks.Num(); }
+
+};
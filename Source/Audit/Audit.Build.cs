@@ -12,7 +12,7 @@ public class Audit : ModuleRules
             "Core", "CoreUObject", "Engine", "InputCore"
         });
 
-        PrivateDependencyModuleNames.AddRange(new string[] { });
+        PrivateDependencyModuleNames.AddRange(new string[] { "Json" });
 
         PublicIncludePaths.Add(ModuleDirectory);
 
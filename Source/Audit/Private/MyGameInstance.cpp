@@ -1,45 +1,255 @@
 #include "MyGameInstance.h"
 #include "Misc/Paths.h"
 #include "HAL/PlatformFilemanager.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformTime.h"
+#include "Async/Async.h"
+#include "ScheduleDatabase.h"
+#include "RoomScheduleIndex.h"
+#include "SchedulePatch.h"
+#include "ScheduleResultCache.h"
+
+static TWeakPtr<FScheduleDatabase> GScheduleDatabase;
+static TWeakPtr<FRoomScheduleIndex> GScheduleIndex;
+static TWeakPtr<FScheduleResultCache> GScheduleResultCache;
 
 void UMyGameInstance::Init()
 {
     Super::Init();
 
     UE_LOG(LogTemp, Log, TEXT("GameInstance инициализирован."));
-    CopyDatabaseIfNeeded();
+
+    const double StartTime = FPlatformTime::Seconds();
+
+    EScheduleDatabaseProvisioning Provisioning = DatabaseProvisioning;
+    if (Provisioning == EScheduleDatabaseProvisioning::OpenInPlace && !IsBundledDatabaseOnDisk())
+    {
+        UE_LOG(LogTemp, Warning, TEXT("База из сборки не открывается на месте (%s), копируем её в Persistent"), *GetBundledDatabasePath());
+        Provisioning = EScheduleDatabaseProvisioning::CopyOnStartup;
+    }
+
+    ScheduleDatabase = MakeShared<FScheduleDatabase>();
+    if (Provisioning == EScheduleDatabaseProvisioning::CopyOnStartup)
+    {
+        if (IsDatabaseCopyNeeded())
+        {
+            // Копируется весь файл базы: в пуле потоков, до конца копирования общей базы нет
+            TWeakObjectPtr<UMyGameInstance> WeakThis(this);
+            Async(EAsyncExecution::ThreadPool, [WeakThis, Database = ScheduleDatabase.ToSharedRef(), StartTime]()
+            {
+                if (CopyBundledDatabase())
+                {
+                    Database->Open(GetWritableDatabasePath());
+                }
+
+                AsyncTask(ENamedThreads::GameThread, [WeakThis, Database, StartTime]()
+                {
+                    UMyGameInstance* This = WeakThis.Get();
+                    if (This && This->ScheduleDatabase == Database)
+                    {
+                        This->StartScheduleServices(StartTime);
+                    }
+                });
+            });
+            return;
+        }
+        ScheduleDatabase->Open(GetWritableDatabasePath());
+    }
+    else
+    {
+        ScheduleDatabase->OpenLayered(GetBundledDatabasePath(), GetWritableDatabasePath());
+    }
+
+    StartScheduleServices(StartTime);
 }
 
-void UMyGameInstance::CopyDatabaseIfNeeded()
+void UMyGameInstance::StartScheduleServices(double StartTime)
 {
-    FString SourcePath = FPaths::ProjectContentDir() + "Movies/TestDB.db";
-    FString DestPath = FPaths::ProjectPersistentDownloadDir() + "TestDB.db";
-
-    UE_LOG(LogTemp, Log, TEXT("Попытка копирования базы данных"));
-    UE_LOG(LogTemp, Log, TEXT("Source: %s"), *SourcePath);
-    UE_LOG(LogTemp, Log, TEXT("Destination: %s"), *DestPath);
+    GScheduleDatabase = ScheduleDatabase;
 
-    IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+    DatabaseStartupSeconds = static_cast<float>(FPlatformTime::Seconds() - StartTime);
+    UE_LOG(LogTemp, Log, TEXT("База расписания готова за %.2f мс"), DatabaseStartupSeconds * 1000.0f);
 
-    if (!FPaths::FileExists(SourcePath))
+    if (!ScheduleDatabase->IsOpen())
     {
-        UE_LOG(LogTemp, Error, TEXT("Исходная база данных не найдена в Movies/: %s"), *SourcePath);
         return;
     }
 
-    if (!FPaths::FileExists(DestPath))
+    if (ScheduleResultCacheMaxKilobytes > 0)
+    {
+        ScheduleResultCache = MakeShared<FScheduleResultCache>(static_cast<SIZE_T>(ScheduleResultCacheMaxKilobytes) * 1024);
+        GScheduleResultCache = ScheduleResultCache;
+    }
+
+    // Патчи применяются в фоне до сборки индекса; до конца применения запросы видят прежнюю версию
+    TArray<FString> PatchFiles;
+    IFileManager::Get().FindFiles(PatchFiles, *(GetSchedulePatchDirectory() / TEXT("*.json")), true, false);
+
+    TFunction<void()> ApplyPatches;
+    if (PatchFiles.Num() > 0)
     {
-        if (PlatformFile.CopyFile(*DestPath, *SourcePath))
+        for (FString& PatchFile : PatchFiles)
         {
-            UE_LOG(LogTemp, Log, TEXT("База данных скопирована в: %s"), *DestPath);
+            PatchFile = GetSchedulePatchDirectory() / PatchFile;
         }
-        else
+        ApplyPatches = [Database = ScheduleDatabase.ToSharedRef(), PatchFiles]()
         {
-            UE_LOG(LogTemp, Error, TEXT("Не удалось скопировать базу данных в: %s"), *DestPath);
+            ApplySchedulePatchFiles(*Database, PatchFiles);
+        };
+    }
+
+    // Индекс строится в фоне; пока он не готов, запросы идут через SQL
+    if (bUseScheduleIndex)
+    {
+        ScheduleIndex = MakeShared<FRoomScheduleIndex>();
+        ScheduleIndex->BuildAsync(ScheduleDatabase.ToSharedRef(), MoveTemp(ApplyPatches));
+        GScheduleIndex = ScheduleIndex;
+    }
+    else if (ApplyPatches)
+    {
+        Async(EAsyncExecution::ThreadPool, MoveTemp(ApplyPatches));
+    }
+}
+
+FString UMyGameInstance::GetBundledDatabasePath()
+{
+    return IFileManager::Get().ConvertToAbsolutePathForExternalAppForRead(*(FPaths::ProjectContentDir() + "Movies/TestDB.db"));
+}
+
+bool UMyGameInstance::IsBundledDatabaseOnDisk()
+{
+    // Платформенный файл движка видит и содержимое архивов, а sqlite - только настоящие файлы
+    return IPlatformFile::GetPlatformPhysical().FileExists(*GetBundledDatabasePath());
+}
+
+FString UMyGameInstance::GetWritableDatabasePath()
+{
+    return FPaths::ProjectPersistentDownloadDir() + "TestDB.db";
+}
+
+FString UMyGameInstance::GetSchedulePatchDirectory()
+{
+    return FPaths::ProjectPersistentDownloadDir() + "SchedulePatches";
+}
+
+int32 UMyGameInstance::ApplySchedulePatchFiles(FScheduleDatabase& Database, const TArray<FString>& PatchFiles)
+{
+    TArray<TPair<FString, FSchedulePatch>> Patches;
+    for (const FString& PatchFile : PatchFiles)
+    {
+        FSchedulePatch Patch;
+        if (Patch.LoadFromFile(PatchFile))
+        {
+            Patches.Emplace(PatchFile, MoveTemp(Patch));
         }
     }
-    else
+
+    // Цепочка 1 -> 2 -> 3 применяется по порядку независимо от имён файлов
+    Patches.StableSort([](const TPair<FString, FSchedulePatch>& A, const TPair<FString, FSchedulePatch>& B)
+    {
+        return A.Value.FromVersion < B.Value.FromVersion;
+    });
+
+    int32 NumApplied = 0;
+    for (const TPair<FString, FSchedulePatch>& Patch : Patches)
     {
-        UE_LOG(LogTemp, Log, TEXT("База уже существует: %s"), *DestPath);
+        // Неподходящий патч оставляем на месте: возможно, его базовая версия ещё придёт
+        if (Database.ApplyPatch(Patch.Value))
+        {
+            IFileManager::Get().Delete(*Patch.Key, false, true, true);
+            ++NumApplied;
+        }
     }
+    return NumApplied;
+}
+
+void UMyGameInstance::Shutdown()
+{
+    if (ScheduleDatabase.IsValid())
+    {
+        UE_LOG(LogTemp, Log, TEXT("Кэш запросов расписания: попаданий %d, промахов %d"),
+            ScheduleDatabase->GetStatementCacheHits(), ScheduleDatabase->GetStatementCacheMisses());
+        ScheduleDatabase->Close();
+        ScheduleDatabase.Reset();
+    }
+    GScheduleDatabase.Reset();
+    GScheduleIndex.Reset();
+    ScheduleIndex.Reset();
+    if (ScheduleResultCache.IsValid())
+    {
+        UE_LOG(LogTemp, Log, TEXT("Кэш ответов расписания: попаданий %d, промахов %d, вытеснений %d"),
+            ScheduleResultCache->GetHits(), ScheduleResultCache->GetMisses(), ScheduleResultCache->GetEvictions());
+    }
+    GScheduleResultCache.Reset();
+    ScheduleResultCache.Reset();
+
+    Super::Shutdown();
+}
+
+TSharedPtr<FScheduleDatabase> UMyGameInstance::GetScheduleDatabase()
+{
+    check(IsInGameThread());
+    return GScheduleDatabase.Pin();
+}
+
+TSharedPtr<FRoomScheduleIndex> UMyGameInstance::GetScheduleIndex()
+{
+    check(IsInGameThread());
+    return GScheduleIndex.Pin();
+}
+
+TSharedPtr<FScheduleResultCache> UMyGameInstance::GetScheduleResultCache()
+{
+    check(IsInGameThread());
+    return GScheduleResultCache.Pin();
+}
+
+bool UMyGameInstance::IsDatabaseCopyNeeded() const
+{
+    const FString SourcePath = FPaths::ProjectContentDir() + "Movies/TestDB.db";
+    const FString DestPath = GetWritableDatabasePath();
+
+    if (!FPaths::FileExists(SourcePath))
+    {
+        UE_LOG(LogTemp, Error, TEXT("Исходная база данных не найдена в Movies/: %s"), *SourcePath);
+        return false;
+    }
+
+    if (!FPaths::FileExists(DestPath))
+    {
+        return true;
+    }
+
+    // Копия живёт между обновлениями приложения: если в сборке расписание новее, копируем заново.
+    // Базу из архива sqlite не откроет, поэтому её версия берётся из конфига, а не из самого файла
+    const int64 SourceVersion = IsBundledDatabaseOnDisk() ? FScheduleDatabase::ReadSchemaVersion(GetBundledDatabasePath()) : BundledDatabaseVersion;
+    const int64 DestVersion = FScheduleDatabase::ReadSchemaVersion(DestPath);
+    if (SourceVersion <= DestVersion)
+    {
+        UE_LOG(LogTemp, Log, TEXT("База уже существует: %s (версия %lld)"), *DestPath, DestVersion);
+        return false;
+    }
+
+    UE_LOG(LogTemp, Log, TEXT("Расписание в сборке новее копии: %lld > %lld"), SourceVersion, DestVersion);
+    return true;
+}
+
+bool UMyGameInstance::CopyBundledDatabase()
+{
+    const FString SourcePath = FPaths::ProjectContentDir() + "Movies/TestDB.db";
+    const FString DestPath = GetWritableDatabasePath();
+
+    UE_LOG(LogTemp, Log, TEXT("Попытка копирования базы данных"));
+    UE_LOG(LogTemp, Log, TEXT("Source: %s"), *SourcePath);
+    UE_LOG(LogTemp, Log, TEXT("Destination: %s"), *DestPath);
+
+    FScheduleDatabase::DeleteDatabaseFiles(DestPath);
+    if (FPlatformFileManager::Get().GetPlatformFile().CopyFile(*DestPath, *SourcePath))
+    {
+        UE_LOG(LogTemp, Log, TEXT("База данных скопирована в: %s"), *DestPath);
+        return true;
+    }
+
+    UE_LOG(LogTemp, Error, TEXT("Не удалось скопировать базу данных в: %s"), *DestPath);
+    return false;
 }
@@ -0,0 +1,323 @@
+#include "RoomScheduleIndex.h"
+#include "sqlite3.h"
+#include "Misc/ScopeRWLock.h"
+#include "Async/Async.h"
+#include "Misc/ScopeExit.h"
+#include "Algo/BinarySearch.h"
+
+DECLARE_CYCLE_STAT(TEXT("Build room index"), STAT_ScheduleIndexBuild, STATGROUP_ScheduleDB);
+DECLARE_CYCLE_STAT(TEXT("Room index time query"), STAT_ScheduleIndexQuery, STATGROUP_ScheduleDB);
+DECLARE_CYCLE_STAT(TEXT("Room index text search"), STAT_ScheduleIndexSearch, STATGROUP_ScheduleDB);
+
+void FRoomScheduleIndex::BuildAsync(TSharedRef<FScheduleDatabase> Database, TFunction<void()> BeforeBuild)
+{
+    // Счётчик поднимается до постановки задачи, чтобы RebuildIfStale не начал параллельную сборку
+    ++BuildsInFlight;
+    Async(EAsyncExecution::ThreadPool, [This = AsShared(), Database, BeforeBuild = MoveTemp(BeforeBuild)]()
+    {
+        ON_SCOPE_EXIT
+        {
+            --This->BuildsInFlight;
+        };
+        if (BeforeBuild)
+        {
+            BeforeBuild();
+        }
+        This->Build(*Database);
+    });
+}
+
+bool FRoomScheduleIndex::Build(FScheduleDatabase& Database)
+{
+    SCOPE_CYCLE_COUNTER(STAT_ScheduleIndexBuild);
+    ++BuildsInFlight;
+    ON_SCOPE_EXIT
+    {
+        --BuildsInFlight;
+    };
+
+    // Сборки могут перекрываться: публикует результат только последняя начатая
+    const uint32 Ticket = ++LatestBuildTicket;
+
+    struct FLoadedRow
+    {
+        int32 RoomString;
+        FScheduleEntry Entry;
+    };
+
+    // Поколение берём до чтения: патч, пришедший во время сборки, вызовет ещё одну
+    const uint32 Generation = Database.GetDataGeneration();
+
+    FScheduleStringPool NewStrings;
+    TMap<int32, int32> NewSpanByRoomString;
+    TArray<EScheduleWeekday> WeekdayByString;
+    TArray<FLoadedRow> Loaded;
+    bool bLossless = true;
+
+    // Порядок rowid совпадает с порядком полного сканирования в запросе по room_code
+    static const FString Query = TEXT("SELECT room_code, subject, teacher, start_time, end_time, weekday FROM ClassroomSchedule ORDER BY rowid;");
+
+    const bool bQueried = Database.WithStatement(Query, [&](sqlite3_stmt* Statement)
+    {
+        auto InternColumn = [&NewStrings, Statement](int32 Column)
+        {
+            const ANSICHAR* Text = (const ANSICHAR*)sqlite3_column_text(Statement, Column);
+            return NewStrings.InternUtf8(Text, sqlite3_column_bytes(Statement, Column));
+        };
+
+        while (sqlite3_step(Statement) == SQLITE_ROW)
+        {
+            FLoadedRow& Row = Loaded.AddDefaulted_GetRef();
+            Row.RoomString = InternColumn(0);
+            Row.Entry.Subject = InternColumn(1);
+            Row.Entry.Teacher = InternColumn(2);
+
+            const int32 StartMinute = FScheduleEntry::ParseMinutesUtf8((const ANSICHAR*)sqlite3_column_text(Statement, 3), sqlite3_column_bytes(Statement, 3));
+            const int32 EndMinute = FScheduleEntry::ParseMinutesUtf8((const ANSICHAR*)sqlite3_column_text(Statement, 4), sqlite3_column_bytes(Statement, 4));
+            Row.Entry.StartMinute = static_cast<int16>(StartMinute);
+            Row.Entry.EndMinute = static_cast<int16>(EndMinute);
+
+            // День недели разбираем один раз на уникальную строку
+            const int32 WeekdayString = InternColumn(5);
+            while (WeekdayByString.Num() < NewStrings.Num())
+            {
+                WeekdayByString.Add(EScheduleWeekday::Invalid);
+            }
+            if (WeekdayByString[WeekdayString] == EScheduleWeekday::Invalid)
+            {
+                WeekdayByString[WeekdayString] = FScheduleEntry::ParseWeekday(NewStrings.Get(WeekdayString));
+            }
+            Row.Entry.Weekday = WeekdayByString[WeekdayString];
+
+            if (StartMinute == INDEX_NONE || EndMinute == INDEX_NONE || Row.Entry.Weekday == EScheduleWeekday::Invalid)
+            {
+                bLossless = false;
+            }
+
+            if (!NewSpanByRoomString.Contains(Row.RoomString))
+            {
+                NewSpanByRoomString.Add(Row.RoomString, NewSpanByRoomString.Num());
+            }
+        }
+    });
+
+    if (!bQueried)
+    {
+        UE_LOG(LogTemp, Error, TEXT("Не удалось построить индекс расписания: %s"), *Database.GetPath());
+        FWriteScopeLock WriteLock(Lock);
+        if (Ticket != LatestBuildTicket)
+        {
+            return false;
+        }
+        bBuildFailed = true;
+        FailedGeneration = Generation;
+        return false;
+    }
+
+    if (!bLossless)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("Индекс расписания не построен: время или день недели в нестандартном формате, используется SQL"));
+        FWriteScopeLock WriteLock(Lock);
+        if (Ticket != LatestBuildTicket)
+        {
+            return false;
+        }
+        bBuilt = false;
+        bBuildFailed = true;
+        FailedGeneration = Generation;
+        return false;
+    }
+
+    // Сортировка подсчётом: отрезки кабинетов подряд, внутри отрезка сохраняется порядок rowid
+    TArray<FRoomSpan> NewSpans;
+    NewSpans.SetNum(NewSpanByRoomString.Num());
+    for (const FLoadedRow& Row : Loaded)
+    {
+        NewSpans[NewSpanByRoomString[Row.RoomString]].Num++;
+    }
+
+    int32 Offset = 0;
+    for (FRoomSpan& Span : NewSpans)
+    {
+        Span.First = Offset;
+        Offset += Span.Num;
+    }
+
+    TArray<int32> Cursor;
+    Cursor.SetNumZeroed(NewSpans.Num());
+
+    TArray<FScheduleEntry> NewEntries;
+    NewEntries.SetNumUninitialized(Loaded.Num());
+    for (const FLoadedRow& Row : Loaded)
+    {
+        const int32 SpanIndex = NewSpanByRoomString[Row.RoomString];
+        NewEntries[NewSpans[SpanIndex].First + Cursor[SpanIndex]++] = Row.Entry;
+    }
+
+    TArray<FScheduleEntry> NewSortedEntries = NewEntries;
+    for (const FRoomSpan& Span : NewSpans)
+    {
+        FScheduleQuery::SortByWeekTime(TArrayView<FScheduleEntry>(NewSortedEntries.GetData() + Span.First, Span.Num));
+    }
+
+    TArray<int32> NewRoomStringBySpan;
+    NewRoomStringBySpan.SetNumUninitialized(NewSpans.Num());
+    for (const TPair<int32, int32>& Room : NewSpanByRoomString)
+    {
+        NewRoomStringBySpan[Room.Value] = Room.Key;
+    }
+
+    FScheduleSearchIndex NewSearchIndex;
+    NewSearchIndex.Build(NewStrings, NewEntries);
+
+    FWriteScopeLock WriteLock(Lock);
+    if (Ticket != LatestBuildTicket)
+    {
+        UE_LOG(LogTemp, Verbose, TEXT("Индекс расписания: результат устаревшей сборки отброшен"));
+        return false;
+    }
+    Strings = MoveTemp(NewStrings);
+    SpanByRoomString = MoveTemp(NewSpanByRoomString);
+    Spans = MoveTemp(NewSpans);
+    RoomStringBySpan = MoveTemp(NewRoomStringBySpan);
+    Entries = MoveTemp(NewEntries);
+    SortedEntries = MoveTemp(NewSortedEntries);
+    SearchIndex = MoveTemp(NewSearchIndex);
+    SourceGeneration = Generation;
+    bBuilt = true;
+    bBuildFailed = false;
+
+    UE_LOG(LogTemp, Log, TEXT("Индекс расписания построен: кабинетов %d, строк %d, строк в пуле %d"), Spans.Num(), Entries.Num(), Strings.Num());
+    return true;
+}
+
+bool FRoomScheduleIndex::RebuildIfStale(FScheduleDatabase& Database)
+{
+    if (BuildsInFlight > 0)
+    {
+        return false;
+    }
+
+    // Переоткрытие, патч или подмена файла снаружи меняют поколение данных
+    const uint32 Generation = Database.RefreshDataGeneration();
+    {
+        FReadScopeLock ReadLock(Lock);
+        if (bBuilt && SourceGeneration == Generation)
+        {
+            return true;
+        }
+        // Те же данные соберутся так же неудачно: ждём смены поколения, запросы пока идут через SQL
+        if (bBuildFailed && FailedGeneration == Generation)
+        {
+            return false;
+        }
+    }
+
+    return Build(Database);
+}
+
+bool FRoomScheduleIndex::IsBuilt() const
+{
+    FReadScopeLock ReadLock(Lock);
+    return bBuilt;
+}
+
+bool FRoomScheduleIndex::Find(const FString& RoomCode, TArray<FClassroomScheduleRow>& OutRows) const
+{
+    FReadScopeLock ReadLock(Lock);
+
+    if (!bBuilt)
+    {
+        return false;
+    }
+
+    if (const FRoomSpan* Span = FindSpan(RoomCode))
+    {
+        OutRows.Reserve(OutRows.Num() + Span->Num);
+        for (int32 Index = Span->First; Index < Span->First + Span->Num; ++Index)
+        {
+            OutRows.Add(Entries[Index].ToBlueprintRow(Strings));
+        }
+    }
+    return true;
+}
+
+bool FRoomScheduleIndex::Query(const FString& RoomCode, EScheduleQueryKind Kind, int32 From, int32 To, TArray<FClassroomScheduleRow>& OutRows) const
+{
+    SCOPE_CYCLE_COUNTER(STAT_ScheduleIndexQuery);
+    FReadScopeLock ReadLock(Lock);
+
+    if (!bBuilt)
+    {
+        return false;
+    }
+
+    if (const FRoomSpan* Span = FindSpan(RoomCode))
+    {
+        TArray<const FScheduleEntry*> Matches;
+        FScheduleQuery::Run(TArrayView<const FScheduleEntry>(SortedEntries.GetData() + Span->First, Span->Num), Kind, From, To, Matches);
+
+        for (const FScheduleEntry* Entry : Matches)
+        {
+            OutRows.Add(Entry->ToBlueprintRow(Strings));
+        }
+    }
+    return true;
+}
+
+bool FRoomScheduleIndex::Search(const FString& Query, bool bSubjects, bool bTeachers, int32 MaxResults, TArray<FRoomScheduleSession>& OutSessions) const
+{
+    SCOPE_CYCLE_COUNTER(STAT_ScheduleIndexSearch);
+    FReadScopeLock ReadLock(Lock);
+
+    if (!bBuilt)
+    {
+        return false;
+    }
+
+    TArray<int32> Matches;
+    SearchIndex.Search(Query, bSubjects, bTeachers, Entries, MaxResults, Matches);
+
+    OutSessions.Reserve(OutSessions.Num() + Matches.Num());
+    for (const int32 EntryIndex : Matches)
+    {
+        // Отрезки кабинетов идут подряд: кабинет - последний отрезок, начинающийся не позже занятия
+        const int32 SpanIndex = Algo::UpperBoundBy(Spans, EntryIndex, &FRoomSpan::First) - 1;
+
+        FRoomScheduleSession& Session = OutSessions.AddDefaulted_GetRef();
+        Session.RoomCode = Strings.Get(RoomStringBySpan[SpanIndex]);
+        Session.Session = Entries[EntryIndex].ToBlueprintRow(Strings);
+    }
+    return true;
+}
+
+int32 FRoomScheduleIndex::GetNumRooms() const
+{
+    FReadScopeLock ReadLock(Lock);
+    return Spans.Num();
+}
+
+int32 FRoomScheduleIndex::GetNumRows() const
+{
+    FReadScopeLock ReadLock(Lock);
+    return Entries.Num();
+}
+
+SIZE_T FRoomScheduleIndex::GetAllocatedSize() const
+{
+    FReadScopeLock ReadLock(Lock);
+    return Strings.GetAllocatedSize() + SpanByRoomString.GetAllocatedSize() + Spans.GetAllocatedSize() + RoomStringBySpan.GetAllocatedSize()
+        + Entries.GetAllocatedSize() + SortedEntries.GetAllocatedSize() + SearchIndex.GetAllocatedSize();
+}
+
+const FRoomScheduleIndex::FRoomSpan* FRoomScheduleIndex::FindSpan(const FString& RoomCode) const
+{
+    const int32 RoomString = Strings.Find(RoomCode);
+    if (RoomString == INDEX_NONE)
+    {
+        return nullptr;
+    }
+
+    const int32* SpanIndex = SpanByRoomString.Find(RoomString);
+    return SpanIndex ? &Spans[*SpanIndex] : nullptr;
+}
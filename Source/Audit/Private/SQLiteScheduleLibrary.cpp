@@ -2,28 +2,336 @@
 #include "sqlite3.h"
 #include "Misc/Paths.h"
 #include "HAL/PlatformFilemanager.h"
+#include "Algo/AllOf.h"
+#include "Algo/AnyOf.h"
+#include "Async/Async.h"
+#include "MyGameInstance.h"
+#include "ScheduleDatabase.h"
+#include "RoomScheduleIndex.h"
+#include "ScheduleQuery.h"
+#include "ScheduleStringPool.h"
+#include "SchedulePatch.h"
+#include "ScheduleResultCache.h"
+#include "ScheduleSearchIndex.h"
+
+DECLARE_CYCLE_STAT(TEXT("SQL room lookup"), STAT_ScheduleSqlLookup, STATGROUP_ScheduleDB);
+DECLARE_CYCLE_STAT(TEXT("Full fetch time query"), STAT_ScheduleFullFetchQuery, STATGROUP_ScheduleDB);
+DECLARE_CYCLE_STAT(TEXT("SQL batch room lookup"), STAT_ScheduleSqlBatchLookup, STATGROUP_ScheduleDB);
+DECLARE_CYCLE_STAT(TEXT("SQL text search"), STAT_ScheduleSqlSearch, STATGROUP_ScheduleDB);
+
+// Кабинетов в одном запросе IN (...): с запасом ниже старого лимита SQLite в 999 параметров
+static constexpr int32 ScheduleBatchMaxRooms = 256;
+
+static TSharedPtr<FScheduleDatabase> GetOrOpenScheduleDatabase()
+{
+    TSharedPtr<FScheduleDatabase> Database = UMyGameInstance::GetScheduleDatabase();
+    if (!Database.IsValid())
+    {
+        // Без GameInstance (например, в редакторе) открываем базу только на этот вызов
+        Database = MakeShared<FScheduleDatabase>();
+        if (!Database->OpenLayered(UMyGameInstance::GetBundledDatabasePath(), UMyGameInstance::GetWritableDatabasePath()))
+        {
+            return nullptr;
+        }
+    }
+    return Database;
+}
+
+// Число параметров округляется до степени двойки, чтобы в кэше запросов было не больше девяти вариантов
+static FString MakeScheduleBatchQuery(int32 NumParams)
+{
+    FString Query = TEXT("SELECT room_code, subject, teacher, start_time, end_time, weekday FROM ClassroomSchedule WHERE room_code IN (?");
+    for (int32 Index = 1; Index < NumParams; ++Index)
+    {
+        Query += TEXT(", ?");
+    }
+    Query += TEXT(");");
+    return Query;
+}
 
 TArray<FClassroomScheduleRow> USQLiteScheduleLibrary::GetScheduleForRoom(const FString& RoomCode)
 {
-    TArray<FClassroomScheduleRow> Results;
+    TSharedPtr<FScheduleDatabase> Database = GetOrOpenScheduleDatabase();
+    if (!Database.IsValid())
+    {
+        return TArray<FClassroomScheduleRow>();
+    }
+
+    TSharedPtr<FRoomScheduleIndex> Index = UMyGameInstance::GetScheduleIndex();
+    TSharedPtr<FScheduleResultCache> Cache = UMyGameInstance::GetScheduleResultCache();
+    return LookupSchedule(*Database, Index.Get(), Cache.Get(), RoomCode);
+}
 
-    FString DBPath = FPaths::ProjectPersistentDownloadDir() + "TestDB.db";
-    sqlite3* DB;
-    if (sqlite3_open(TCHAR_TO_UTF8(*DBPath), &DB) != SQLITE_OK)
+TArray<FRoomSchedule> USQLiteScheduleLibrary::GetSchedulesForRooms(const TArray<FString>& RoomCodes)
+{
+    TSharedPtr<FScheduleDatabase> Database = GetOrOpenScheduleDatabase();
+    if (!Database.IsValid())
+    {
+        return TArray<FRoomSchedule>();
+    }
+
+    TSharedPtr<FRoomScheduleIndex> Index = UMyGameInstance::GetScheduleIndex();
+    return LookupSchedules(*Database, Index.Get(), RoomCodes);
+}
+
+TArray<FClassroomScheduleRow> USQLiteScheduleLibrary::LookupSchedule(FScheduleDatabase& Database, FRoomScheduleIndex* Index, FScheduleResultCache* Cache, const FString& RoomCode)
+{
+    // Поколение читаем до выборки: если данные сменятся по ходу, ответ не попадёт в кэш
+    const uint32 Generation = Database.RefreshDataGeneration();
+
+    TArray<FClassroomScheduleRow> Results;
+    if (Cache && Cache->Find(RoomCode, Generation, Results))
     {
-        UE_LOG(LogTemp, Error, TEXT("Не удалось открыть базу данных: %s"), *DBPath);
         return Results;
     }
 
-    FString Query = TEXT("SELECT subject, teacher, start_time, end_time, weekday FROM ClassroomSchedule WHERE room_code = ?;");
-    sqlite3_stmt* Statement = nullptr;
+    bool bComplete = true;
+    if (!Index || !Index->RebuildIfStale(Database) || !Index->Find(RoomCode, Results))
+    {
+        bComplete = QueryScheduleFromDatabase(Database, RoomCode, Results);
+    }
+
+    // Пустой ответ из-за сбоя запроса не кэшируем, иначе он переживёт саму ошибку
+    if (Cache && bComplete)
+    {
+        Cache->Add(RoomCode, Generation, Results);
+    }
+    return Results;
+}
+
+TArray<FRoomSchedule> USQLiteScheduleLibrary::LookupSchedules(FScheduleDatabase& Database, FRoomScheduleIndex* Index, const TArray<FString>& RoomCodes)
+{
+    if (Index && Index->RebuildIfStale(Database))
+    {
+        TArray<FRoomSchedule> Results;
+        Results.SetNum(RoomCodes.Num());
+
+        bool bFound = true;
+        for (int32 RoomIndex = 0; RoomIndex < RoomCodes.Num() && bFound; ++RoomIndex)
+        {
+            Results[RoomIndex].RoomCode = RoomCodes[RoomIndex];
+            bFound = Index->Find(RoomCodes[RoomIndex], Results[RoomIndex].Rows);
+        }
+
+        if (bFound)
+        {
+            return Results;
+        }
+    }
+
+    return QuerySchedulesFromDatabase(Database, RoomCodes);
+}
+
+TArray<FRoomSchedule> USQLiteScheduleLibrary::QuerySchedulesFromDatabase(FScheduleDatabase& Database, const TArray<FString>& RoomCodes)
+{
+    SCOPE_CYCLE_COUNTER(STAT_ScheduleSqlBatchLookup);
+
+    TArray<FRoomSchedule> Results;
+    Results.SetNum(RoomCodes.Num());
+
+    // Повторяющиеся кабинеты запрашиваем один раз; корзина - первый элемент с таким кодом
+    TMap<FString, int32, FDefaultSetAllocator, TCaseSensitiveStringKeyFuncs<int32>> BucketByRoom;
+    TArray<FString> UniqueRooms;
+    for (int32 RoomIndex = 0; RoomIndex < RoomCodes.Num(); ++RoomIndex)
+    {
+        Results[RoomIndex].RoomCode = RoomCodes[RoomIndex];
+        if (!BucketByRoom.Contains(RoomCodes[RoomIndex]))
+        {
+            BucketByRoom.Add(RoomCodes[RoomIndex], RoomIndex);
+            UniqueRooms.Add(RoomCodes[RoomIndex]);
+        }
+    }
+
+    for (int32 First = 0; First < UniqueRooms.Num(); First += ScheduleBatchMaxRooms)
+    {
+        const int32 NumRooms = FMath::Min(ScheduleBatchMaxRooms, UniqueRooms.Num() - First);
+        const int32 NumParams = static_cast<int32>(FMath::RoundUpToPowerOfTwo(static_cast<uint32>(NumRooms)));
+
+        Database.WithStatement(MakeScheduleBatchQuery(NumParams), [&](sqlite3_stmt* Statement)
+        {
+            // Лишние параметры остаются NULL и ни с чем не совпадают
+            for (int32 Param = 0; Param < NumRooms; ++Param)
+            {
+                const FTCHARToUTF8 RoomCode(*UniqueRooms[First + Param]);
+                sqlite3_bind_text(Statement, Param + 1, RoomCode.Get(), RoomCode.Length(), SQLITE_TRANSIENT);
+            }
+
+            // Строки приходят в порядке таблицы, поэтому внутри кабинета порядок тот же, что у GetScheduleForRoom
+            while (sqlite3_step(Statement) == SQLITE_ROW)
+            {
+                const int32* Bucket = BucketByRoom.Find(FString(UTF8_TO_TCHAR((const char*)sqlite3_column_text(Statement, 0))));
+                if (!Bucket)
+                {
+                    continue;
+                }
+
+                FClassroomScheduleRow& Row = Results[*Bucket].Rows.AddDefaulted_GetRef();
+                Row.Subject   = UTF8_TO_TCHAR((const char*)sqlite3_column_text(Statement, 1));
+                Row.Teacher   = UTF8_TO_TCHAR((const char*)sqlite3_column_text(Statement, 2));
+                Row.StartTime = UTF8_TO_TCHAR((const char*)sqlite3_column_text(Statement, 3));
+                Row.EndTime   = UTF8_TO_TCHAR((const char*)sqlite3_column_text(Statement, 4));
+                Row.Weekday   = UTF8_TO_TCHAR((const char*)sqlite3_column_text(Statement, 5));
+            }
+        });
+    }
+
+    for (int32 RoomIndex = 0; RoomIndex < RoomCodes.Num(); ++RoomIndex)
+    {
+        const int32 Bucket = BucketByRoom.FindChecked(RoomCodes[RoomIndex]);
+        if (Bucket != RoomIndex)
+        {
+            Results[RoomIndex].Rows = Results[Bucket].Rows;
+        }
+    }
+
+    return Results;
+}
+
+TArray<FRoomScheduleSession> USQLiteScheduleLibrary::SearchSchedule(const FString& Query, bool bSubjects, bool bTeachers, int32 MaxResults)
+{
+    TArray<FRoomScheduleSession> Sessions;
+    TSharedPtr<FScheduleDatabase> Database = GetOrOpenScheduleDatabase();
+    if (!Database.IsValid())
+    {
+        return Sessions;
+    }
+
+    TSharedPtr<FRoomScheduleIndex> Index = UMyGameInstance::GetScheduleIndex();
+    if (Index.IsValid() && Index->RebuildIfStale(*Database) && Index->Search(Query, bSubjects, bTeachers, MaxResults, Sessions))
+    {
+        return Sessions;
+    }
+
+    // Общего индекса нет или он ещё строится: проход по таблице без построения индекса
+    SearchScheduleFromDatabase(*Database, Query, bSubjects, bTeachers, MaxResults, Sessions);
+    return Sessions;
+}
+
+bool USQLiteScheduleLibrary::SearchScheduleFromDatabase(FScheduleDatabase& Database, const FString& Query, bool bSubjects, bool bTeachers, int32 MaxResults,
+    TArray<FRoomScheduleSession>& OutSessions)
+{
+    SCOPE_CYCLE_COUNTER(STAT_ScheduleSqlSearch);
+
+    TArray<FString> QueryWords;
+    FScheduleSearchIndex::Tokenize(Query, QueryWords);
+    if (QueryWords.Num() == 0 || (!bSubjects && !bTeachers))
+    {
+        return true;
+    }
+
+    // Те же правила, что у индекса: каждое слово запроса - начало какого-то слова поля.
+    // Предметы и преподаватели сильно повторяются, поэтому ответ запоминается на строку
+    TMap<FString, bool> MatchByText;
+    TArray<FString> Words;
+    auto Matches = [&](const FString& Text)
+    {
+        if (const bool* Known = MatchByText.Find(Text))
+        {
+            return *Known;
+        }
+
+        Words.Reset();
+        FScheduleSearchIndex::Tokenize(Text, Words);
+        const bool bMatch = Algo::AllOf(QueryWords, [&Words](const FString& QueryWord)
+        {
+            return Algo::AnyOf(Words, [&QueryWord](const FString& Word) { return Word.StartsWith(QueryWord, ESearchCase::CaseSensitive); });
+        });
+        MatchByText.Add(Text, bMatch);
+        return bMatch;
+    };
+
+    static const FString Sql = TEXT("SELECT room_code, subject, teacher, start_time, end_time, weekday FROM ClassroomSchedule;");
+
+    const int32 FirstResult = OutSessions.Num();
+    int32 StepResult = SQLITE_ERROR;
+    const bool bQueried = Database.WithStatement(Sql, [&](sqlite3_stmt* Statement)
+    {
+        while ((MaxResults <= 0 || OutSessions.Num() - FirstResult < MaxResults) && (StepResult = sqlite3_step(Statement)) == SQLITE_ROW)
+        {
+            const FString Subject = UTF8_TO_TCHAR((const char*)sqlite3_column_text(Statement, 1));
+            const FString Teacher = UTF8_TO_TCHAR((const char*)sqlite3_column_text(Statement, 2));
+            if (!(bSubjects && Matches(Subject)) && !(bTeachers && Matches(Teacher)))
+            {
+                continue;
+            }
+
+            FRoomScheduleSession& Session = OutSessions.AddDefaulted_GetRef();
+            Session.RoomCode          = UTF8_TO_TCHAR((const char*)sqlite3_column_text(Statement, 0));
+            Session.Session.Subject   = Subject;
+            Session.Session.Teacher   = Teacher;
+            Session.Session.StartTime = UTF8_TO_TCHAR((const char*)sqlite3_column_text(Statement, 3));
+            Session.Session.EndTime   = UTF8_TO_TCHAR((const char*)sqlite3_column_text(Statement, 4));
+            Session.Session.Weekday   = UTF8_TO_TCHAR((const char*)sqlite3_column_text(Statement, 5));
+        }
+    });
+
+    // Остановка на MaxResults оставляет последний шаг SQLITE_ROW - это не ошибка
+    return bQueried && (StepResult == SQLITE_DONE || StepResult == SQLITE_ROW);
+}
+
+bool USQLiteScheduleLibrary::RebuildScheduleIndex()
+{
+    TSharedPtr<FScheduleDatabase> Database = UMyGameInstance::GetScheduleDatabase();
+    TSharedPtr<FRoomScheduleIndex> Index = UMyGameInstance::GetScheduleIndex();
+    return Database.IsValid() && Index.IsValid() && Index->Build(*Database);
+}
+
+void USQLiteScheduleLibrary::ApplySchedulePatch(const FString& PatchFilePath, const FSchedulePatchAppliedDelegate& OnApplied)
+{
+    TSharedPtr<FScheduleDatabase> Database = UMyGameInstance::GetScheduleDatabase();
+    if (!Database.IsValid())
+    {
+        OnApplied.ExecuteIfBound(false);
+        return;
+    }
+
+    // Перенос таблицы из сборки, сама транзакция и пересборка индекса - полный проход по таблице, не для игрового потока
+    TSharedPtr<FRoomScheduleIndex> Index = UMyGameInstance::GetScheduleIndex();
+    Async(EAsyncExecution::ThreadPool, [Database, Index, PatchFilePath, OnApplied]()
+    {
+        FSchedulePatch Patch;
+        const uint32 Generation = Database->GetDataGeneration();
+        const bool bApplied = Patch.LoadFromFile(PatchFilePath) && Database->ApplyPatch(Patch);
+
+        // Индекс перечитываем до ответа, чтобы первый запрос после патча не ждал сборки
+        if (bApplied && Index.IsValid() && Database->GetDataGeneration() != Generation)
+        {
+            Index->Build(*Database);
+        }
+
+        AsyncTask(ENamedThreads::GameThread, [OnApplied, bApplied]()
+        {
+            OnApplied.ExecuteIfBound(bApplied);
+        });
+    });
+}
+
+int64 USQLiteScheduleLibrary::GetScheduleVersion()
+{
+    TSharedPtr<FScheduleDatabase> Database = UMyGameInstance::GetScheduleDatabase();
+    return Database.IsValid() ? Database->GetSchemaVersion() : 0;
+}
+
+TArray<FClassroomScheduleRow> USQLiteScheduleLibrary::QueryScheduleFromDatabase(FScheduleDatabase& Database, const FString& RoomCode)
+{
+    TArray<FClassroomScheduleRow> Results;
+    QueryScheduleFromDatabase(Database, RoomCode, Results);
+    return Results;
+}
+
+bool USQLiteScheduleLibrary::QueryScheduleFromDatabase(FScheduleDatabase& Database, const FString& RoomCode, TArray<FClassroomScheduleRow>& Results)
+{
+    SCOPE_CYCLE_COUNTER(STAT_ScheduleSqlLookup);
 
-    if (sqlite3_prepare_v2(DB, TCHAR_TO_UTF8(*Query), -1, &Statement, nullptr) == SQLITE_OK)
+    static const FString Query = TEXT("SELECT subject, teacher, start_time, end_time, weekday FROM ClassroomSchedule WHERE room_code = ?;");
+
+    int32 StepResult = SQLITE_ERROR;
+    const bool bQueried = Database.WithStatement(Query, [&Results, &RoomCode, &StepResult](sqlite3_stmt* Statement)
     {
         // Привязываем RoomCode как параметр
         sqlite3_bind_text(Statement, 1, TCHAR_TO_UTF8(*RoomCode), -1, SQLITE_TRANSIENT);
 
-        while (sqlite3_step(Statement) == SQLITE_ROW)
+        while ((StepResult = sqlite3_step(Statement)) == SQLITE_ROW)
         {
             FClassroomScheduleRow Row;
             Row.Subject   = UTF8_TO_TCHAR((const char*)sqlite3_column_text(Statement, 0));
@@ -33,12 +341,187 @@ TArray<FClassroomScheduleRow> USQLiteScheduleLibrary::GetScheduleForRoom(const F
             Row.Weekday   = UTF8_TO_TCHAR((const char*)sqlite3_column_text(Statement, 4));
             Results.Add(Row);
         }
+    });
+
+    return bQueried && StepResult == SQLITE_DONE;
+}
+
+bool USQLiteScheduleLibrary::GetCurrentSession(const FString& RoomCode, const FDateTime& Time, FClassroomScheduleRow& Session)
+{
+    TArray<FClassroomScheduleRow> Rows;
+    QuerySessions(RoomCode, EScheduleQueryKind::Current, FScheduleQuery::GetWeekMinute(Time), 0, Rows);
+    if (Rows.Num() > 0)
+    {
+        Session = MoveTemp(Rows[0]);
+        return true;
     }
+    return false;
+}
+
+bool USQLiteScheduleLibrary::GetNextSession(const FString& RoomCode, const FDateTime& Time, FClassroomScheduleRow& Session)
+{
+    TArray<FClassroomScheduleRow> Rows;
+    QuerySessions(RoomCode, EScheduleQueryKind::Next, FScheduleQuery::GetWeekMinute(Time), 0, Rows);
+    if (Rows.Num() > 0)
+    {
+        Session = MoveTemp(Rows[0]);
+        return true;
+    }
+    return false;
+}
 
+TArray<FClassroomScheduleRow> USQLiteScheduleLibrary::GetSessionsInRange(const FString& RoomCode, const FDateTime& From, const FDateTime& To)
+{
+    const int32 FromMinute = FScheduleQuery::GetWeekMinute(From);
+    const int32 ToMinute = FromMinute + FMath::CeilToInt((To - From).GetTotalMinutes());
 
-    sqlite3_finalize(Statement);
-    sqlite3_close(DB);
+    TArray<FClassroomScheduleRow> Rows;
+    QuerySessions(RoomCode, EScheduleQueryKind::Range, FromMinute, ToMinute, Rows);
+    return Rows;
+}
 
-    return Results;
+TArray<FRoomScheduleSession> USQLiteScheduleLibrary::GetCurrentSessionsForRooms(const TArray<FString>& RoomCodes, const FDateTime& Time)
+{
+    return QuerySessionsForRooms(RoomCodes, EScheduleQueryKind::Current, FScheduleQuery::GetWeekMinute(Time), 0);
+}
+
+TArray<FRoomScheduleSession> USQLiteScheduleLibrary::GetNextSessionsForRooms(const TArray<FString>& RoomCodes, const FDateTime& Time)
+{
+    return QuerySessionsForRooms(RoomCodes, EScheduleQueryKind::Next, FScheduleQuery::GetWeekMinute(Time), 0);
+}
+
+TArray<FRoomScheduleSession> USQLiteScheduleLibrary::GetSessionsInRangeForRooms(const TArray<FString>& RoomCodes, const FDateTime& From, const FDateTime& To)
+{
+    const int32 FromMinute = FScheduleQuery::GetWeekMinute(From);
+    const int32 ToMinute = FromMinute + FMath::CeilToInt((To - From).GetTotalMinutes());
+    return QuerySessionsForRooms(RoomCodes, EScheduleQueryKind::Range, FromMinute, ToMinute);
+}
+
+void USQLiteScheduleLibrary::QuerySessions(const FString& RoomCode, EScheduleQueryKind Kind, int32 From, int32 To, TArray<FClassroomScheduleRow>& OutRows)
+{
+    TSharedPtr<FScheduleDatabase> Database = GetOrOpenScheduleDatabase();
+    if (!Database.IsValid())
+    {
+        return;
+    }
+
+    TSharedPtr<FRoomScheduleIndex> Index = UMyGameInstance::GetScheduleIndex();
+    TSharedPtr<FScheduleResultCache> Cache = UMyGameInstance::GetScheduleResultCache();
+    LookupSessions(*Database, Index.Get(), Cache.Get(), RoomCode, Kind, From, To, OutRows);
 }
 
+void USQLiteScheduleLibrary::LookupSessions(FScheduleDatabase& Database, FRoomScheduleIndex* Index, FScheduleResultCache* Cache, const FString& RoomCode,
+    EScheduleQueryKind Kind, int32 From, int32 To, TArray<FClassroomScheduleRow>& OutRows)
+{
+    if (Index && Index->RebuildIfStale(Database) && Index->Query(RoomCode, Kind, From, To, OutRows))
+    {
+        return;
+    }
+
+    // Индекса нет: берём всё расписание кабинета и разбираем его на месте
+    FilterSessions(LookupSchedule(Database, Index, Cache, RoomCode), Kind, From, To, OutRows);
+}
+
+void USQLiteScheduleLibrary::FilterSessions(const TArray<FClassroomScheduleRow>& Rows, EScheduleQueryKind Kind, int32 From, int32 To, TArray<FClassroomScheduleRow>& OutRows)
+{
+    SCOPE_CYCLE_COUNTER(STAT_ScheduleFullFetchQuery);
+    FScheduleStringPool Strings;
+    TArray<FScheduleEntry> Entries;
+    for (const FClassroomScheduleRow& Row : Rows)
+    {
+        const FTCHARToUTF8 StartTime(*Row.StartTime);
+        const FTCHARToUTF8 EndTime(*Row.EndTime);
+
+        FScheduleEntry Entry;
+        const int32 StartMinute = FScheduleEntry::ParseMinutesUtf8(StartTime.Get(), StartTime.Length());
+        const int32 EndMinute = FScheduleEntry::ParseMinutesUtf8(EndTime.Get(), EndTime.Length());
+        Entry.Weekday = FScheduleEntry::ParseWeekday(Row.Weekday);
+        if (StartMinute == INDEX_NONE || EndMinute == INDEX_NONE || Entry.Weekday == EScheduleWeekday::Invalid)
+        {
+            continue;
+        }
+
+        const FTCHARToUTF8 Subject(*Row.Subject);
+        const FTCHARToUTF8 Teacher(*Row.Teacher);
+        Entry.Subject = Strings.InternUtf8(Subject.Get(), Subject.Length());
+        Entry.Teacher = Strings.InternUtf8(Teacher.Get(), Teacher.Length());
+        Entry.StartMinute = static_cast<int16>(StartMinute);
+        Entry.EndMinute = static_cast<int16>(EndMinute);
+        Entries.Add(Entry);
+    }
+
+    FScheduleQuery::SortByWeekTime(Entries);
+
+    TArray<const FScheduleEntry*> Matches;
+    FScheduleQuery::Run(Entries, Kind, From, To, Matches);
+    for (const FScheduleEntry* Entry : Matches)
+    {
+        OutRows.Add(Entry->ToBlueprintRow(Strings));
+    }
+}
+
+TArray<FRoomScheduleSession> USQLiteScheduleLibrary::QuerySessionsForRooms(const TArray<FString>& RoomCodes, EScheduleQueryKind Kind, int32 From, int32 To)
+{
+    TArray<FRoomScheduleSession> Sessions;
+    TSharedPtr<FScheduleDatabase> Database = GetOrOpenScheduleDatabase();
+    if (!Database.IsValid())
+    {
+        return Sessions;
+    }
+
+    TSharedPtr<FRoomScheduleIndex> Index = UMyGameInstance::GetScheduleIndex();
+    const bool bUseIndex = Index.IsValid() && Index->RebuildIfStale(*Database);
+
+    // Без индекса все кабинеты читаются одним проходом, а не запросом на каждый
+    TArray<FRoomSchedule> Schedules;
+    TArray<FClassroomScheduleRow> Rows;
+
+    for (int32 RoomIndex = 0; RoomIndex < RoomCodes.Num(); ++RoomIndex)
+    {
+        Rows.Reset();
+        if (!bUseIndex || !Index->Query(RoomCodes[RoomIndex], Kind, From, To, Rows))
+        {
+            if (Schedules.Num() == 0)
+            {
+                Schedules = QuerySchedulesFromDatabase(*Database, RoomCodes);
+            }
+            FilterSessions(Schedules[RoomIndex].Rows, Kind, From, To, Rows);
+        }
+
+        for (FClassroomScheduleRow& Row : Rows)
+        {
+            FRoomScheduleSession& Session = Sessions.AddDefaulted_GetRef();
+            Session.RoomCode = RoomCodes[RoomIndex];
+            Session.Session = MoveTemp(Row);
+        }
+    }
+    return Sessions;
+}
+
+void USQLiteScheduleLibrary::GetResultCacheStats(int32& Hits, int32& Misses, int32& Evictions, int64& UsedBytes)
+{
+    Hits = 0;
+    Misses = 0;
+    Evictions = 0;
+    UsedBytes = 0;
+
+    if (TSharedPtr<FScheduleResultCache> Cache = UMyGameInstance::GetScheduleResultCache())
+    {
+        Hits = Cache->GetHits();
+        Misses = Cache->GetMisses();
+        Evictions = Cache->GetEvictions();
+        UsedBytes = static_cast<int64>(Cache->GetUsedBytes());
+    }
+}
+
+void USQLiteScheduleLibrary::GetStatementCacheStats(int32& Hits, int32& Misses)
+{
+    Hits = 0;
+    Misses = 0;
+
+    if (TSharedPtr<FScheduleDatabase> Database = UMyGameInstance::GetScheduleDatabase())
+    {
+        Hits = Database->GetStatementCacheHits();
+        Misses = Database->GetStatementCacheMisses();
+    }
+}
@@ -0,0 +1,79 @@
+#include "ScheduleBenchmark.h"
+
+#if !UE_BUILD_SHIPPING
+
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "SQLiteScheduleLibrary.h"
+
+struct FBatchBenchmarkTiming
+{
+    double SingleSeconds = 0.0;
+    double BatchSeconds = 0.0;
+    int64 SingleRows = 0;
+    int64 BatchRows = 0;
+};
+
+// Index == nullptr - SQL-путь: запрос на каждый кабинет против одного room_code IN (...)
+static void RunBatchComparison(FScheduleDatabase& Database, FRoomScheduleIndex* Index, const TArray<FString>& RoomCodes,
+    int32 NumIterations, FBatchBenchmarkTiming& OutTiming)
+{
+    for (int32 Iteration = 0; Iteration < NumIterations; ++Iteration)
+    {
+        // Без кэша ответов: каждый вызов действительно идёт в индекс или в базу
+        double StartTime = FPlatformTime::Seconds();
+        for (const FString& RoomCode : RoomCodes)
+        {
+            OutTiming.SingleRows += USQLiteScheduleLibrary::LookupSchedule(Database, Index, nullptr, RoomCode).Num();
+        }
+        OutTiming.SingleSeconds += FPlatformTime::Seconds() - StartTime;
+
+        StartTime = FPlatformTime::Seconds();
+        const TArray<FRoomSchedule> Schedules = USQLiteScheduleLibrary::LookupSchedules(Database, Index, RoomCodes);
+        OutTiming.BatchSeconds += FPlatformTime::Seconds() - StartTime;
+
+        for (const FRoomSchedule& Schedule : Schedules)
+        {
+            OutTiming.BatchRows += Schedule.Rows.Num();
+        }
+    }
+}
+
+static void LogBatchComparison(const TCHAR* Label, int32 NumRooms, int32 NumIterations, const FBatchBenchmarkTiming& Timing)
+{
+    const double SingleMs = Timing.SingleSeconds * 1000.0 / FMath::Max(NumIterations, 1);
+    const double BatchMs = Timing.BatchSeconds * 1000.0 / FMath::Max(NumIterations, 1);
+    UE_LOG(LogTemp, Log, TEXT("%s: кабинетов %d, повторов %d, %d вызовов GetScheduleForRoom %.3f мс, GetSchedulesForRooms %.3f мс, ускорение x%.1f, строк %lld / %lld"),
+        Label, NumRooms, NumIterations, NumRooms, SingleMs, BatchMs, SingleMs / FMath::Max(BatchMs, 1e-6),
+        Timing.SingleRows / FMath::Max(NumIterations, 1), Timing.BatchRows / FMath::Max(NumIterations, 1));
+}
+
+// Schedule.BenchmarkBatch [строк=100000] [кабинетов=50] [повторов=20]
+static void BenchmarkScheduleBatch(const TArray<FString>& Args)
+{
+    const int32 NumRows = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 100000;
+    const int32 NumRooms = Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 50;
+    const int32 NumIterations = Args.Num() > 2 ? FCString::Atoi(*Args[2]) : 20;
+
+    FScheduleBenchmarkFixture Fixture(TEXT("ScheduleBatchBenchmark.db"), NumRows);
+    const TArray<FString> RoomCodes = Fixture.bIsReady ? Fixture.GetRoomCodes(NumRooms) : TArray<FString>();
+    if (RoomCodes.Num() == 0)
+    {
+        return;
+    }
+
+    FBatchBenchmarkTiming WithoutIndex;
+    FBatchBenchmarkTiming WithIndex;
+    RunBatchComparison(*Fixture.Database, nullptr, RoomCodes, NumIterations, WithoutIndex);
+    RunBatchComparison(*Fixture.Database, &Fixture.Index.Get(), RoomCodes, NumIterations, WithIndex);
+
+    LogBatchComparison(TEXT("Пакетная выборка без индекса (SQL)"), RoomCodes.Num(), NumIterations, WithoutIndex);
+    LogBatchComparison(TEXT("Пакетная выборка с индексом"), RoomCodes.Num(), NumIterations, WithIndex);
+}
+
+static FAutoConsoleCommand ScheduleBenchmarkBatchCommand(
+    TEXT("Schedule.BenchmarkBatch"),
+    TEXT("Замеряет GetSchedulesForRooms против отдельных вызовов GetScheduleForRoom, с индексом и без. Аргументы: [строк=100000] [кабинетов=50] [повторов=20]"),
+    FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkScheduleBatch));
+
+#endif
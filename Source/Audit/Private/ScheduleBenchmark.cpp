@@ -0,0 +1,131 @@
+#include "ScheduleBenchmark.h"
+
+#if !UE_BUILD_SHIPPING
+
+#include "sqlite3.h"
+#include "HAL/PlatformTime.h"
+#include "Math/RandomStream.h"
+#include "Misc/Paths.h"
+
+// Синтетическое расписание заданного размера; false, если файл не удалось заполнить
+static bool GenerateSyntheticSchedule(const FString& FilePath, int32 NumRows, FRandomStream& Random)
+{
+    static const TCHAR* Subjects[] =
+    {
+        TEXT("Математика"), TEXT("Физика"), TEXT("История"), TEXT("Химия"), TEXT("Биология"), TEXT("Информатика"),
+        TEXT("Литература"), TEXT("Философия"), TEXT("Экономика"), TEXT("Английский язык"), TEXT("Теория вероятностей"),
+        TEXT("Линейная алгебра"), TEXT("Математический анализ"), TEXT("Физическая культура"), TEXT("Сопротивление материалов"),
+    };
+    static const TCHAR* SubjectKinds[] = { TEXT(""), TEXT(" (лекция)"), TEXT(" (практика)"), TEXT(" (лабораторная)") };
+    static const TCHAR* Surnames[] =
+    {
+        TEXT("Иванов"), TEXT("Петров"), TEXT("Сидорова"), TEXT("Смирнов"), TEXT("Кузнецова"), TEXT("Попов"), TEXT("Васильев"),
+        TEXT("Соколова"), TEXT("Михайлов"), TEXT("Новиков"), TEXT("Фёдорова"), TEXT("Морозов"), TEXT("Волков"), TEXT("Алексеева"),
+        TEXT("Лебедев"), TEXT("Семёнов"), TEXT("Егорова"), TEXT("Павлов"), TEXT("Козлов"), TEXT("Степанова"),
+    };
+    static const TCHAR Initials[] = TEXT("АБВГДЕИКЛМНОПРСТ");
+    static const TCHAR* Weekdays[] = { TEXT("Понедельник"), TEXT("Вторник"), TEXT("Среда"), TEXT("Четверг"), TEXT("Пятница"), TEXT("Суббота") };
+    static const TCHAR* Slots[][2] =
+    {
+        { TEXT("08:30"), TEXT("10:00") }, { TEXT("10:10"), TEXT("11:40") }, { TEXT("12:10"), TEXT("13:40") },
+        { TEXT("13:50"), TEXT("15:20") }, { TEXT("15:30"), TEXT("17:00") }, { TEXT("17:10"), TEXT("18:40") },
+    };
+
+    sqlite3* Writer = nullptr;
+    if (sqlite3_open_v2(TCHAR_TO_UTF8(*FilePath), &Writer, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, nullptr) != SQLITE_OK)
+    {
+        sqlite3_close(Writer);
+        return false;
+    }
+
+    bool bSuccess = sqlite3_exec(Writer,
+        "CREATE TABLE ClassroomSchedule (id INTEGER PRIMARY KEY AUTOINCREMENT, room_code TEXT NOT NULL, subject TEXT NOT NULL,"
+        " teacher TEXT NOT NULL, start_time TEXT NOT NULL, end_time TEXT NOT NULL, weekday TEXT NOT NULL);"
+        "BEGIN;", nullptr, nullptr, nullptr) == SQLITE_OK;
+
+    sqlite3_stmt* Insert = nullptr;
+    bSuccess = bSuccess && sqlite3_prepare_v2(Writer,
+        "INSERT INTO ClassroomSchedule (room_code, subject, teacher, start_time, end_time, weekday) VALUES (?, ?, ?, ?, ?, ?);", -1, &Insert, nullptr) == SQLITE_OK;
+
+    auto BindText = [&Insert](int32 Index, const FString& Text)
+    {
+        const FTCHARToUTF8 Utf8(*Text);
+        sqlite3_bind_text(Insert, Index, Utf8.Get(), Utf8.Length(), SQLITE_TRANSIENT);
+    };
+
+    const int32 NumInitials = UE_ARRAY_COUNT(Initials) - 1;
+    for (int32 Row = 0; bSuccess && Row < NumRows; ++Row)
+    {
+        const int32 Slot = Random.RandHelper(UE_ARRAY_COUNT(Slots));
+        BindText(1, FString::Printf(TEXT("%d%02d%c"), 1 + Random.RandHelper(9), Random.RandHelper(60), TEXT('A') + Random.RandHelper(4)));
+        BindText(2, FString(Subjects[Random.RandHelper(UE_ARRAY_COUNT(Subjects))]) + SubjectKinds[Random.RandHelper(UE_ARRAY_COUNT(SubjectKinds))]);
+        BindText(3, FString::Printf(TEXT("%s %c.%c."), Surnames[Random.RandHelper(UE_ARRAY_COUNT(Surnames))],
+            Initials[Random.RandHelper(NumInitials)], Initials[Random.RandHelper(NumInitials)]));
+        BindText(4, Slots[Slot][0]);
+        BindText(5, Slots[Slot][1]);
+        BindText(6, Weekdays[Random.RandHelper(UE_ARRAY_COUNT(Weekdays))]);
+
+        bSuccess = sqlite3_step(Insert) == SQLITE_DONE;
+        sqlite3_reset(Insert);
+    }
+    sqlite3_finalize(Insert);
+
+    bSuccess = bSuccess && sqlite3_exec(Writer, "COMMIT;", nullptr, nullptr, nullptr) == SQLITE_OK;
+    sqlite3_close(Writer);
+    return bSuccess;
+}
+
+FScheduleBenchmarkFixture::FScheduleBenchmarkFixture(const TCHAR* FileName, int32 NumRows)
+    : FilePath(FPaths::ProjectSavedDir() / FileName)
+    , Database(MakeShared<FScheduleDatabase>())
+    , Index(MakeShared<FRoomScheduleIndex>())
+{
+    FScheduleDatabase::DeleteDatabaseFiles(FilePath);
+
+    // Одно и то же зерно во всех замерах, чтобы их цифры можно было сравнивать
+    FRandomStream Random(12345);
+    double StartTime = FPlatformTime::Seconds();
+    if (!GenerateSyntheticSchedule(FilePath, NumRows, Random))
+    {
+        UE_LOG(LogTemp, Error, TEXT("Не удалось создать синтетическое расписание: %s"), *FilePath);
+        return;
+    }
+    GenerateSeconds = FPlatformTime::Seconds() - StartTime;
+
+    StartTime = FPlatformTime::Seconds();
+    bIsReady = Database->Open(FilePath) && Index->Build(*Database);
+    BuildSeconds = FPlatformTime::Seconds() - StartTime;
+
+    if (!bIsReady)
+    {
+        UE_LOG(LogTemp, Error, TEXT("Не удалось построить индекс по синтетическому расписанию"));
+    }
+}
+
+FScheduleBenchmarkFixture::~FScheduleBenchmarkFixture()
+{
+    Database->Close();
+    FScheduleDatabase::DeleteDatabaseFiles(FilePath);
+}
+
+TArray<FString> FScheduleBenchmarkFixture::GetRoomCodes(int32 MaxRooms) const
+{
+    TArray<FString> RoomCodes;
+    Database->WithStatement(TEXT("SELECT DISTINCT room_code FROM ClassroomSchedule LIMIT ?;"), [&RoomCodes, MaxRooms](sqlite3_stmt* Statement)
+    {
+        // Отрицательный LIMIT в SQLite - без ограничения
+        sqlite3_bind_int(Statement, 1, MaxRooms > 0 ? MaxRooms : -1);
+        while (sqlite3_step(Statement) == SQLITE_ROW)
+        {
+            RoomCodes.Add(UTF8_TO_TCHAR(reinterpret_cast<const char*>(sqlite3_column_text(Statement, 0))));
+        }
+    });
+
+    if (RoomCodes.Num() == 0)
+    {
+        UE_LOG(LogTemp, Error, TEXT("В синтетическом расписании нет кабинетов: %s"), *FilePath);
+    }
+    return RoomCodes;
+}
+
+#endif
@@ -0,0 +1,543 @@
+#include "ScheduleDatabase.h"
+#include "sqlite3.h"
+#include "SchedulePatch.h"
+#include "Misc/ScopeLock.h"
+#include "Misc/Paths.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformTime.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Statement cache hits"), STAT_ScheduleStatementCacheHits, STATGROUP_ScheduleDB);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Statement cache misses"), STAT_ScheduleStatementCacheMisses, STATGROUP_ScheduleDB);
+DECLARE_CYCLE_STAT(TEXT("Materialize table"), STAT_ScheduleMaterializeTable, STATGROUP_ScheduleDB);
+DECLARE_CYCLE_STAT(TEXT("Apply schedule patch"), STAT_ScheduleApplyPatch, STATGROUP_ScheduleDB);
+
+// Не чаще раза в секунду проверяем, не подменили ли файл базы
+static constexpr double ScheduleFileCheckInterval = 1.0;
+
+// Версия из Schema.ScheduleVersion или INDEX_NONE, если такой таблицы нет
+static int64 ReadScheduleVersion(sqlite3* Connection, const char* Schema)
+{
+    int64 Version = INDEX_NONE;
+    sqlite3_stmt* Statement = nullptr;
+    const FString Sql = FString::Printf(TEXT("SELECT version FROM %s.ScheduleVersion WHERE id = 1;"), ANSI_TO_TCHAR(Schema));
+    if (sqlite3_prepare_v2(Connection, TCHAR_TO_UTF8(*Sql), -1, &Statement, nullptr) == SQLITE_OK)
+    {
+        Version = sqlite3_step(Statement) == SQLITE_ROW ? sqlite3_column_int64(Statement, 0) : 0;
+    }
+    sqlite3_finalize(Statement);
+    return Version;
+}
+
+// Версия, которую видят запросы: записываемая копия важнее базы из сборки
+static int64 ReadEffectiveScheduleVersion(sqlite3* Connection)
+{
+    const int64 MainVersion = ReadScheduleVersion(Connection, "main");
+    if (MainVersion != INDEX_NONE)
+    {
+        return MainVersion;
+    }
+    return FMath::Max<int64>(ReadScheduleVersion(Connection, "bundle"), 0);
+}
+
+static bool WriteScheduleVersion(sqlite3* Connection, int64 Version)
+{
+    if (sqlite3_exec(Connection, "CREATE TABLE IF NOT EXISTS main.ScheduleVersion (id INTEGER PRIMARY KEY CHECK (id = 1), version INTEGER NOT NULL);", nullptr, nullptr, nullptr) != SQLITE_OK)
+    {
+        return false;
+    }
+
+    bool bWritten = false;
+    sqlite3_stmt* Statement = nullptr;
+    if (sqlite3_prepare_v2(Connection, "INSERT OR REPLACE INTO main.ScheduleVersion (id, version) VALUES (1, ?);", -1, &Statement, nullptr) == SQLITE_OK)
+    {
+        sqlite3_bind_int64(Statement, 1, Version);
+        bWritten = sqlite3_step(Statement) == SQLITE_DONE;
+    }
+    sqlite3_finalize(Statement);
+    return bWritten;
+}
+
+// Отдельное соединение на запись, чтобы не блокировать чтение расписания; база из сборки подключается как bundle
+static sqlite3* OpenScheduleWriter(const FString& WritablePath, const FString& AttachedPath)
+{
+    sqlite3* Writer = nullptr;
+    if (sqlite3_open_v2(TCHAR_TO_UTF8(*WritablePath), &Writer, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_URI, nullptr) != SQLITE_OK)
+    {
+        UE_LOG(LogTemp, Error, TEXT("Не удалось открыть базу на запись: %s"), *WritablePath);
+        sqlite3_close(Writer);
+        return nullptr;
+    }
+    sqlite3_exec(Writer, "PRAGMA journal_mode=WAL;", nullptr, nullptr, nullptr);
+    sqlite3_busy_timeout(Writer, 1000);
+
+    if (!AttachedPath.IsEmpty())
+    {
+        bool bAttached = false;
+        sqlite3_stmt* Statement = nullptr;
+        if (sqlite3_prepare_v2(Writer, "ATTACH DATABASE ? AS bundle;", -1, &Statement, nullptr) == SQLITE_OK)
+        {
+            sqlite3_bind_text(Statement, 1, TCHAR_TO_UTF8(*FScheduleDatabase::MakeImmutableUri(AttachedPath)), -1, SQLITE_TRANSIENT);
+            bAttached = sqlite3_step(Statement) == SQLITE_DONE;
+        }
+        sqlite3_finalize(Statement);
+
+        if (!bAttached)
+        {
+            UE_LOG(LogTemp, Error, TEXT("Не удалось подключить базу из сборки: %s"), UTF8_TO_TCHAR(sqlite3_errmsg(Writer)));
+            sqlite3_close(Writer);
+            return nullptr;
+        }
+    }
+    return Writer;
+}
+
+FScheduleDatabase::~FScheduleDatabase()
+{
+    Close();
+}
+
+bool FScheduleDatabase::Open(const FString& InPath)
+{
+    FScopeLock ScopeLock(&Lock);
+
+    if (DB && Path == InPath && BundledPath.IsEmpty())
+    {
+        return true;
+    }
+
+    BundledPath.Empty();
+    OverlayPath.Empty();
+    return OpenLocked(InPath, false, FString());
+}
+
+bool FScheduleDatabase::OpenLayered(const FString& InBundledPath, const FString& InOverlayPath)
+{
+    FScopeLock ScopeLock(&Lock);
+
+    BundledPath = InBundledPath;
+    OverlayPath = InOverlayPath;
+
+    if (FPaths::FileExists(OverlayPath))
+    {
+        if (!OpenLocked(OverlayPath, false, BundledPath))
+        {
+            return false;
+        }
+
+        // В сборку приехало расписание новее, чем в копии: копия со всеми её патчами устарела
+        const int64 OverlayVersion = FMath::Max<int64>(ReadScheduleVersion(DB, "main"), 0);
+        const int64 BundleVersion = FMath::Max<int64>(ReadScheduleVersion(DB, "bundle"), 0);
+        if (BundleVersion <= OverlayVersion)
+        {
+            return true;
+        }
+
+        UE_LOG(LogTemp, Log, TEXT("Копия базы устарела (версия %lld, в сборке %lld), удаляем: %s"), OverlayVersion, BundleVersion, *OverlayPath);
+        CloseLocked();
+        DeleteDatabaseFiles(OverlayPath);
+    }
+    return OpenLocked(BundledPath, true, FString());
+}
+
+bool FScheduleDatabase::OpenLocked(const FString& MainPath, bool bImmutable, const FString& AttachedPath)
+{
+    CloseLocked();
+
+    Path = MainPath;
+
+    if (bImmutable)
+    {
+        const FString Uri = MakeImmutableUri(Path);
+        if (sqlite3_open_v2(TCHAR_TO_UTF8(*Uri), &DB, SQLITE_OPEN_READONLY | SQLITE_OPEN_URI | SQLITE_OPEN_NOMUTEX, nullptr) != SQLITE_OK)
+        {
+            UE_LOG(LogTemp, Error, TEXT("Не удалось открыть базу данных: %s"), *Path);
+            sqlite3_close(DB);
+            DB = nullptr;
+            return false;
+        }
+    }
+    // Пробуем открыть на запись, чтобы включить WAL; само соединение дальше только читает
+    else if (sqlite3_open_v2(TCHAR_TO_UTF8(*Path), &DB, SQLITE_OPEN_READWRITE | SQLITE_OPEN_URI | SQLITE_OPEN_NOMUTEX, nullptr) == SQLITE_OK)
+    {
+        sqlite3_exec(DB, "PRAGMA journal_mode=WAL;", nullptr, nullptr, nullptr);
+    }
+    else
+    {
+        sqlite3_close(DB);
+        DB = nullptr;
+
+        if (sqlite3_open_v2(TCHAR_TO_UTF8(*Path), &DB, SQLITE_OPEN_READONLY | SQLITE_OPEN_URI | SQLITE_OPEN_NOMUTEX, nullptr) != SQLITE_OK)
+        {
+            UE_LOG(LogTemp, Error, TEXT("Не удалось открыть базу данных: %s"), *Path);
+            sqlite3_close(DB);
+            DB = nullptr;
+            return false;
+        }
+    }
+
+    if (!AttachedPath.IsEmpty())
+    {
+        sqlite3_stmt* Attach = nullptr;
+        if (sqlite3_prepare_v2(DB, "ATTACH DATABASE ? AS bundle;", -1, &Attach, nullptr) == SQLITE_OK)
+        {
+            sqlite3_bind_text(Attach, 1, TCHAR_TO_UTF8(*MakeImmutableUri(AttachedPath)), -1, SQLITE_TRANSIENT);
+            if (sqlite3_step(Attach) != SQLITE_DONE)
+            {
+                UE_LOG(LogTemp, Warning, TEXT("Не удалось подключить базу из сборки: %s"), UTF8_TO_TCHAR(sqlite3_errmsg(DB)));
+            }
+        }
+        sqlite3_finalize(Attach);
+    }
+
+    sqlite3_exec(DB, "PRAGMA query_only=1;", nullptr, nullptr, nullptr);
+
+    FileTimeStamp = IFileManager::Get().GetTimeStamp(*Path);
+    FileSize = IFileManager::Get().FileSize(*Path);
+    LastFileCheckTime = FPlatformTime::Seconds();
+    DataGeneration.fetch_add(1, std::memory_order_release);
+
+    UE_LOG(LogTemp, Log, TEXT("База расписания открыта: %s"), *Path);
+    return true;
+}
+
+bool FScheduleDatabase::MaterializeTable(const FString& TableName)
+{
+    SCOPE_CYCLE_COUNTER(STAT_ScheduleMaterializeTable);
+
+    FString Bundled;
+    FString Overlay;
+    {
+        FScopeLock ScopeLock(&Lock);
+        Bundled = BundledPath;
+        Overlay = OverlayPath;
+    }
+
+    if (Bundled.IsEmpty() || Overlay.IsEmpty())
+    {
+        // Обычный режим: база уже целиком лежит в записываемой копии
+        return true;
+    }
+
+    IFileManager::Get().MakeDirectory(*FPaths::GetPath(Overlay), true);
+
+    sqlite3* Writer = OpenScheduleWriter(Overlay, Bundled);
+    if (!Writer)
+    {
+        return false;
+    }
+
+    bool bSuccess = false;
+    bool bCreated = false;
+    sqlite3_stmt* Statement = nullptr;
+
+    const FTCHARToUTF8 Table(*TableName);
+
+    if (sqlite3_exec(Writer, "BEGIN IMMEDIATE;", nullptr, nullptr, nullptr) == SQLITE_OK)
+    {
+        bSuccess = true;
+
+        // Таблица уже перенесена ранее - ничего не делаем
+        bool bExists = false;
+        if (sqlite3_prepare_v2(Writer, "SELECT 1 FROM main.sqlite_master WHERE type = 'table' AND name = ?;", -1, &Statement, nullptr) == SQLITE_OK)
+        {
+            sqlite3_bind_text(Statement, 1, Table.Get(), Table.Length(), SQLITE_TRANSIENT);
+            bExists = sqlite3_step(Statement) == SQLITE_ROW;
+        }
+        sqlite3_finalize(Statement);
+
+        if (!bExists)
+        {
+            // Схема таблицы и её индексов - ровно такая же, как в базе из сборки
+            TArray<FString> SchemaSql;
+            if (sqlite3_prepare_v2(Writer, "SELECT sql FROM bundle.sqlite_master WHERE tbl_name = ? AND sql IS NOT NULL ORDER BY type = 'index';", -1, &Statement, nullptr) == SQLITE_OK)
+            {
+                sqlite3_bind_text(Statement, 1, Table.Get(), Table.Length(), SQLITE_TRANSIENT);
+                while (sqlite3_step(Statement) == SQLITE_ROW)
+                {
+                    SchemaSql.Add(UTF8_TO_TCHAR((const char*)sqlite3_column_text(Statement, 0)));
+                }
+            }
+            sqlite3_finalize(Statement);
+
+            bSuccess = SchemaSql.Num() > 0;
+            for (const FString& Sql : SchemaSql)
+            {
+                bSuccess = bSuccess && sqlite3_exec(Writer, TCHAR_TO_UTF8(*Sql), nullptr, nullptr, nullptr) == SQLITE_OK;
+            }
+
+            const FString CopySql = FString::Printf(TEXT("INSERT INTO main.\"%s\" SELECT * FROM bundle.\"%s\";"), *TableName, *TableName);
+            bSuccess = bSuccess && sqlite3_exec(Writer, TCHAR_TO_UTF8(*CopySql), nullptr, nullptr, nullptr) == SQLITE_OK;
+
+            // Строку счётчика AUTOINCREMENT уже создала вставка; поднимаем его до значения из сборки,
+            // чтобы не переиспользовать id удалённых строк. Без таких таблиц sqlite_sequence нет, ошибку игнорируем
+            if (bSuccess && sqlite3_prepare_v2(Writer, "UPDATE main.sqlite_sequence SET seq = max(seq, IFNULL((SELECT seq FROM bundle.sqlite_sequence WHERE name = ?1), 0)) WHERE name = ?1;", -1, &Statement, nullptr) == SQLITE_OK)
+            {
+                sqlite3_bind_text(Statement, 1, Table.Get(), Table.Length(), SQLITE_TRANSIENT);
+                sqlite3_step(Statement);
+            }
+            sqlite3_finalize(Statement);
+
+            // Копия начинается с той версии расписания, что лежит в сборке
+            if (bSuccess && ReadScheduleVersion(Writer, "main") == INDEX_NONE)
+            {
+                bSuccess = WriteScheduleVersion(Writer, FMath::Max<int64>(ReadScheduleVersion(Writer, "bundle"), 0));
+            }
+
+            bCreated = bSuccess;
+        }
+
+        if (!bSuccess)
+        {
+            UE_LOG(LogTemp, Error, TEXT("Не удалось перенести таблицу %s: %s"), *TableName, UTF8_TO_TCHAR(sqlite3_errmsg(Writer)));
+        }
+        sqlite3_exec(Writer, bSuccess ? "COMMIT;" : "ROLLBACK;", nullptr, nullptr, nullptr);
+    }
+
+    sqlite3_close(Writer);
+
+    if (bCreated)
+    {
+        UE_LOG(LogTemp, Log, TEXT("Таблица %s перенесена в записываемую копию: %s"), *TableName, *Overlay);
+    }
+
+    if (bSuccess)
+    {
+        FScopeLock ScopeLock(&Lock);
+        if (Path != Overlay)
+        {
+            OpenLocked(Overlay, false, Bundled);
+        }
+    }
+    return bSuccess;
+}
+
+bool FScheduleDatabase::ApplyPatch(const FSchedulePatch& Patch)
+{
+    SCOPE_CYCLE_COUNTER(STAT_ScheduleApplyPatch);
+
+    // Быстрая проверка до переноса таблицы: чужой или уже применённый патч ничего не копирует
+    const int64 CurrentVersion = GetSchemaVersion();
+    if (CurrentVersion >= Patch.ToVersion)
+    {
+        UE_LOG(LogTemp, Log, TEXT("Патч расписания %lld -> %lld уже применён (версия %lld)"), Patch.FromVersion, Patch.ToVersion, CurrentVersion);
+        return true;
+    }
+    if (CurrentVersion != Patch.FromVersion)
+    {
+        UE_LOG(LogTemp, Error, TEXT("Патч расписания %lld -> %lld не подходит к версии %lld"), Patch.FromVersion, Patch.ToVersion, CurrentVersion);
+        return false;
+    }
+
+    if (!MaterializeTable(TEXT("ClassroomSchedule")))
+    {
+        return false;
+    }
+
+    FString WritablePath;
+    FString Bundled;
+    {
+        FScopeLock ScopeLock(&Lock);
+        WritablePath = OverlayPath.IsEmpty() ? Path : OverlayPath;
+        Bundled = BundledPath;
+    }
+
+    sqlite3* Writer = OpenScheduleWriter(WritablePath, Bundled);
+    if (!Writer)
+    {
+        return false;
+    }
+
+    bool bSuccess = false;
+    FString Error;
+    if (sqlite3_exec(Writer, "BEGIN IMMEDIATE;", nullptr, nullptr, nullptr) == SQLITE_OK)
+    {
+        // Повторная проверка под блокировкой записи: версию мог поднять другой писатель
+        const int64 LockedVersion = ReadEffectiveScheduleVersion(Writer);
+        if (LockedVersion != Patch.FromVersion)
+        {
+            Error = FString::Printf(TEXT("версия базы изменилась на %lld"), LockedVersion);
+        }
+        else if (Patch.ApplyRows(Writer, Error))
+        {
+            bSuccess = WriteScheduleVersion(Writer, Patch.ToVersion);
+        }
+
+        if (bSuccess && sqlite3_exec(Writer, "COMMIT;", nullptr, nullptr, nullptr) != SQLITE_OK)
+        {
+            bSuccess = false;
+        }
+        if (!bSuccess)
+        {
+            if (Error.IsEmpty())
+            {
+                Error = UTF8_TO_TCHAR(sqlite3_errmsg(Writer));
+            }
+            sqlite3_exec(Writer, "ROLLBACK;", nullptr, nullptr, nullptr);
+        }
+    }
+    else
+    {
+        Error = UTF8_TO_TCHAR(sqlite3_errmsg(Writer));
+    }
+
+    sqlite3_close(Writer);
+
+    if (!bSuccess)
+    {
+        UE_LOG(LogTemp, Error, TEXT("Патч расписания %lld -> %lld не применён: %s"), Patch.FromVersion, Patch.ToVersion, *Error);
+        return false;
+    }
+
+    DataGeneration.fetch_add(1, std::memory_order_release);
+    UE_LOG(LogTemp, Log, TEXT("Патч расписания %lld -> %lld применён: удалено %d, изменено %d, добавлено %d"),
+        Patch.FromVersion, Patch.ToVersion, Patch.Deletes.Num(), Patch.Updates.Num(), Patch.Inserts.Num());
+    return true;
+}
+
+uint32 FScheduleDatabase::RefreshDataGeneration()
+{
+    FScopeLock ScopeLock(&Lock);
+
+    const double Now = FPlatformTime::Seconds();
+    if (DB && Now - LastFileCheckTime >= ScheduleFileCheckInterval)
+    {
+        LastFileCheckTime = Now;
+
+        IFileManager& FileManager = IFileManager::Get();
+        const FDateTime TimeStamp = FileManager.GetTimeStamp(*Path);
+        const int64 Size = FileManager.FileSize(*Path);
+        if (TimeStamp != FileTimeStamp || Size != FileSize)
+        {
+            FileTimeStamp = TimeStamp;
+            FileSize = Size;
+            DataGeneration.fetch_add(1, std::memory_order_release);
+        }
+    }
+    return GetDataGeneration();
+}
+
+int64 FScheduleDatabase::GetSchemaVersion() const
+{
+    FScopeLock ScopeLock(&Lock);
+    return DB ? ReadEffectiveScheduleVersion(DB) : 0;
+}
+
+int64 FScheduleDatabase::ReadSchemaVersion(const FString& FilePath)
+{
+    sqlite3* Connection = nullptr;
+    int64 Version = 0;
+    if (sqlite3_open_v2(TCHAR_TO_UTF8(*FilePath), &Connection, SQLITE_OPEN_READONLY, nullptr) == SQLITE_OK)
+    {
+        Version = FMath::Max<int64>(ReadScheduleVersion(Connection, "main"), 0);
+    }
+    sqlite3_close(Connection);
+    return Version;
+}
+
+bool FScheduleDatabase::DeleteDatabaseFiles(const FString& FilePath)
+{
+    IFileManager& FileManager = IFileManager::Get();
+    FileManager.Delete(*(FilePath + TEXT("-wal")), false, true, true);
+    FileManager.Delete(*(FilePath + TEXT("-shm")), false, true, true);
+    return FileManager.Delete(*FilePath, false, true, true);
+}
+
+void FScheduleDatabase::Close()
+{
+    FScopeLock ScopeLock(&Lock);
+    CloseLocked();
+}
+
+void FScheduleDatabase::CloseLocked()
+{
+    FinalizeStatements();
+    if (DB)
+    {
+        sqlite3_close(DB);
+        DB = nullptr;
+    }
+}
+
+bool FScheduleDatabase::IsOpen() const
+{
+    FScopeLock ScopeLock(&Lock);
+    return DB != nullptr;
+}
+
+FString FScheduleDatabase::GetPath() const
+{
+    FScopeLock ScopeLock(&Lock);
+    return Path;
+}
+
+bool FScheduleDatabase::WithStatement(const FString& Sql, TFunctionRef<void(sqlite3_stmt*)> Body)
+{
+    FScopeLock ScopeLock(&Lock);
+
+    if (!DB)
+    {
+        return false;
+    }
+
+    sqlite3_stmt* Statement = nullptr;
+    if (sqlite3_stmt** Cached = StatementCache.Find(Sql))
+    {
+        Statement = *Cached;
+        StatementCacheHits.fetch_add(1, std::memory_order_relaxed);
+        INC_DWORD_STAT(STAT_ScheduleStatementCacheHits);
+    }
+    else
+    {
+        if (sqlite3_prepare_v3(DB, TCHAR_TO_UTF8(*Sql), -1, SQLITE_PREPARE_PERSISTENT, &Statement, nullptr) != SQLITE_OK)
+        {
+            UE_LOG(LogTemp, Error, TEXT("Ошибка подготовки запроса: %s"), UTF8_TO_TCHAR(sqlite3_errmsg(DB)));
+            sqlite3_finalize(Statement);
+            return false;
+        }
+
+        StatementCache.Add(Sql, Statement);
+        StatementCacheMisses.fetch_add(1, std::memory_order_relaxed);
+        INC_DWORD_STAT(STAT_ScheduleStatementCacheMisses);
+    }
+
+    Body(Statement);
+
+    // Сбрасываем сразу, чтобы не держать открытую транзакцию чтения между вызовами
+    sqlite3_reset(Statement);
+    sqlite3_clear_bindings(Statement);
+    return true;
+}
+
+void FScheduleDatabase::FinalizeStatements()
+{
+    for (const TPair<FString, sqlite3_stmt*>& Entry : StatementCache)
+    {
+        sqlite3_finalize(Entry.Value);
+    }
+    StatementCache.Empty();
+}
+
+FString FScheduleDatabase::MakeImmutableUri(const FString& FilePath)
+{
+    FString Escaped;
+    Escaped.Reserve(FilePath.Len() + 16);
+    for (const TCHAR Char : FilePath)
+    {
+        switch (Char)
+        {
+        case TEXT('%'): Escaped += TEXT("%25"); break;
+        case TEXT('?'): Escaped += TEXT("%3f"); break;
+        case TEXT('#'): Escaped += TEXT("%23"); break;
+        case TEXT(' '): Escaped += TEXT("%20"); break;
+        case TEXT('\\'): Escaped += TEXT('/'); break;
+        default: Escaped += Char; break;
+        }
+    }
+
+    // Пути Windows вида C:/... в URI пишутся как /C:/...
+    if (Escaped.Len() > 1 && Escaped[1] == TEXT(':'))
+    {
+        Escaped = TEXT("/") + Escaped;
+    }
+    return TEXT("file:") + Escaped + TEXT("?immutable=1");
+}
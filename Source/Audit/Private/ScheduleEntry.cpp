@@ -0,0 +1,65 @@
+#include "ScheduleEntry.h"
+#include "ScheduleStringPool.h"
+
+static const FString ScheduleWeekdayNames[] =
+{
+    TEXT("Понедельник"),
+    TEXT("Вторник"),
+    TEXT("Среда"),
+    TEXT("Четверг"),
+    TEXT("Пятница"),
+    TEXT("Суббота"),
+    TEXT("Воскресенье"),
+};
+
+FClassroomScheduleRow FScheduleEntry::ToBlueprintRow(const FScheduleStringPool& Pool) const
+{
+    FClassroomScheduleRow Row;
+    Row.Subject   = Pool.Get(Subject);
+    Row.Teacher   = Pool.Get(Teacher);
+    Row.StartTime = FormatMinutes(StartMinute);
+    Row.EndTime   = FormatMinutes(EndMinute);
+    Row.Weekday   = GetWeekdayName(Weekday);
+    return Row;
+}
+
+int32 FScheduleEntry::ParseMinutesUtf8(const ANSICHAR* Text, int32 Length)
+{
+    if (!Text || Length != 5 || Text[2] != ':'
+        || !FCharAnsi::IsDigit(Text[0]) || !FCharAnsi::IsDigit(Text[1]) || !FCharAnsi::IsDigit(Text[3]) || !FCharAnsi::IsDigit(Text[4]))
+    {
+        return INDEX_NONE;
+    }
+
+    const int32 Hours = (Text[0] - '0') * 10 + (Text[1] - '0');
+    const int32 Minutes = (Text[3] - '0') * 10 + (Text[4] - '0');
+    if (Hours > 24 || Minutes > 59 || (Hours == 24 && Minutes != 0))
+    {
+        return INDEX_NONE;
+    }
+    return Hours * 60 + Minutes;
+}
+
+FString FScheduleEntry::FormatMinutes(int32 Minutes)
+{
+    return FString::Printf(TEXT("%02d:%02d"), Minutes / 60, Minutes % 60);
+}
+
+EScheduleWeekday FScheduleEntry::ParseWeekday(const FString& Text)
+{
+    for (int32 Index = 0; Index < UE_ARRAY_COUNT(ScheduleWeekdayNames); ++Index)
+    {
+        if (Text.Equals(ScheduleWeekdayNames[Index], ESearchCase::CaseSensitive))
+        {
+            return static_cast<EScheduleWeekday>(Index);
+        }
+    }
+    return EScheduleWeekday::Invalid;
+}
+
+const FString& FScheduleEntry::GetWeekdayName(EScheduleWeekday Weekday)
+{
+    static const FString Empty;
+    const int32 Index = static_cast<int32>(Weekday);
+    return Index < UE_ARRAY_COUNT(ScheduleWeekdayNames) ? ScheduleWeekdayNames[Index] : Empty;
+}
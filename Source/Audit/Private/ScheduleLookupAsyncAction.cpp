@@ -0,0 +1,111 @@
+#include "ScheduleLookupAsyncAction.h"
+#include "Async/Async.h"
+#include "MyGameInstance.h"
+#include "RoomScheduleIndex.h"
+#include "ScheduleDatabase.h"
+#include "ScheduleResultCache.h"
+#include "SQLiteScheduleLibrary.h"
+
+// Текущий выполняющийся поиск (только игровой поток)
+static TWeakObjectPtr<UScheduleLookupAsyncAction> GActiveScheduleLookup;
+
+UScheduleLookupAsyncAction* UScheduleLookupAsyncAction::GetScheduleForRoomAsync(UObject* WorldContextObject, const FString& RoomCode)
+{
+    UScheduleLookupAsyncAction* Action = NewObject<UScheduleLookupAsyncAction>();
+    Action->RoomCode = RoomCode;
+    Action->RegisterWithGameInstance(WorldContextObject);
+    return Action;
+}
+
+void UScheduleLookupAsyncAction::Activate()
+{
+    check(IsInGameThread());
+
+    if (UScheduleLookupAsyncAction* Active = GActiveScheduleLookup.Get())
+    {
+        if (!Active->bFinished)
+        {
+            if (Active->RoomCode.Equals(RoomCode, ESearchCase::CaseSensitive))
+            {
+                Active->Followers.Add(this);
+                return;
+            }
+            Active->Cancel();
+        }
+    }
+
+    GActiveScheduleLookup = this;
+    Start();
+}
+
+void UScheduleLookupAsyncAction::Start()
+{
+    TSharedPtr<FScheduleDatabase> Database = UMyGameInstance::GetScheduleDatabase();
+    if (!Database.IsValid())
+    {
+        // Общей базы нет - синхронный путь сам откроет её на один вызов
+        Complete(USQLiteScheduleLibrary::GetScheduleForRoom(RoomCode));
+        return;
+    }
+
+    TSharedPtr<FRoomScheduleIndex> Index = UMyGameInstance::GetScheduleIndex();
+    TSharedPtr<FScheduleResultCache> Cache = UMyGameInstance::GetScheduleResultCache();
+    TWeakObjectPtr<UScheduleLookupAsyncAction> WeakThis(this);
+    TSharedRef<FThreadSafeBool, ESPMode::ThreadSafe> Flag = CancelFlag;
+    FString Room = RoomCode;
+
+    Async(EAsyncExecution::ThreadPool, [WeakThis, Flag, Database, Index, Cache, Room]()
+    {
+        if (*Flag)
+        {
+            return;
+        }
+
+        TArray<FClassroomScheduleRow> Rows = USQLiteScheduleLibrary::LookupSchedule(*Database, Index.Get(), Cache.Get(), Room);
+
+        AsyncTask(ENamedThreads::GameThread, [WeakThis, Flag, Rows = MoveTemp(Rows)]()
+        {
+            if (!*Flag)
+            {
+                if (UScheduleLookupAsyncAction* Action = WeakThis.Get())
+                {
+                    Action->Complete(Rows);
+                }
+            }
+        });
+    });
+}
+
+void UScheduleLookupAsyncAction::Complete(const TArray<FClassroomScheduleRow>& Rows)
+{
+    bFinished = true;
+
+    OnCompleted.Broadcast(RoomCode, Rows);
+    SetReadyToDestroy();
+
+    for (UScheduleLookupAsyncAction* Follower : Followers)
+    {
+        Follower->bFinished = true;
+        Follower->OnCompleted.Broadcast(RoomCode, Rows);
+        Follower->SetReadyToDestroy();
+    }
+    Followers.Empty();
+}
+
+void UScheduleLookupAsyncAction::Cancel()
+{
+    *CancelFlag = true;
+    bFinished = true;
+
+    const TArray<FClassroomScheduleRow> NoRows;
+    OnCancelled.Broadcast(RoomCode, NoRows);
+    SetReadyToDestroy();
+
+    for (UScheduleLookupAsyncAction* Follower : Followers)
+    {
+        Follower->bFinished = true;
+        Follower->OnCancelled.Broadcast(RoomCode, NoRows);
+        Follower->SetReadyToDestroy();
+    }
+    Followers.Empty();
+}
@@ -0,0 +1,294 @@
+#include "SchedulePatch.h"
+#include "sqlite3.h"
+#include "ScheduleEntry.h"
+#include "Misc/FileHelper.h"
+#include "Misc/ScopeExit.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+
+// Колонки ClassroomSchedule, которые можно менять патчем, в порядке таблицы
+static const TCHAR* SchedulePatchColumns[] =
+{
+    TEXT("room_code"),
+    TEXT("subject"),
+    TEXT("teacher"),
+    TEXT("start_time"),
+    TEXT("end_time"),
+    TEXT("weekday"),
+};
+
+static bool IsSchedulePatchColumn(const FString& Name)
+{
+    for (const TCHAR* Column : SchedulePatchColumns)
+    {
+        if (Name.Equals(Column, ESearchCase::CaseSensitive))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Время и день недели проверяем заранее, иначе после патча индекс расписания не соберётся
+static bool IsValidSchedulePatchValue(const FString& Column, const FString& Value)
+{
+    if (Column == TEXT("start_time") || Column == TEXT("end_time"))
+    {
+        const FTCHARToUTF8 Utf8(*Value);
+        return FScheduleEntry::ParseMinutesUtf8(Utf8.Get(), Utf8.Length()) != INDEX_NONE;
+    }
+    if (Column == TEXT("weekday"))
+    {
+        return FScheduleEntry::ParseWeekday(Value) != EScheduleWeekday::Invalid;
+    }
+    return true;
+}
+
+static bool ParseSchedulePatchRow(const TSharedPtr<FJsonValue>& Value, bool bIsInsert, FSchedulePatchRow& OutRow, FString& OutError)
+{
+    const TSharedPtr<FJsonObject>* Object = nullptr;
+    if (!Value.IsValid() || !Value->TryGetObject(Object))
+    {
+        OutError = TEXT("строка патча должна быть объектом");
+        return false;
+    }
+
+    for (const TPair<FString, TSharedPtr<FJsonValue>>& Field : (*Object)->Values)
+    {
+        if (Field.Key != TEXT("id") && !IsSchedulePatchColumn(Field.Key))
+        {
+            OutError = FString::Printf(TEXT("неизвестная колонка '%s'"), *Field.Key);
+            return false;
+        }
+    }
+
+    if (!(*Object)->TryGetNumberField(TEXT("id"), OutRow.Id))
+    {
+        OutRow.Id = INDEX_NONE;
+        if (!bIsInsert)
+        {
+            OutError = TEXT("у изменяемой строки нет id");
+            return false;
+        }
+    }
+
+    for (const TCHAR* Column : SchedulePatchColumns)
+    {
+        FString ColumnValue;
+        if (!(*Object)->TryGetStringField(Column, ColumnValue))
+        {
+            if (bIsInsert)
+            {
+                OutError = FString::Printf(TEXT("у новой строки нет колонки '%s'"), Column);
+                return false;
+            }
+            continue;
+        }
+
+        if (!IsValidSchedulePatchValue(Column, ColumnValue))
+        {
+            OutError = FString::Printf(TEXT("недопустимое значение '%s' в колонке '%s'"), *ColumnValue, Column);
+            return false;
+        }
+        OutRow.Columns.Emplace(Column, MoveTemp(ColumnValue));
+    }
+
+    if (OutRow.Columns.Num() == 0)
+    {
+        OutError = FString::Printf(TEXT("в строке %lld нечего менять"), OutRow.Id);
+        return false;
+    }
+    return true;
+}
+
+bool FSchedulePatch::LoadFromFile(const FString& FilePath)
+{
+    FString Json;
+    if (!FFileHelper::LoadFileToString(Json, *FilePath))
+    {
+        UE_LOG(LogTemp, Error, TEXT("Не удалось прочитать патч расписания: %s"), *FilePath);
+        return false;
+    }
+    return LoadFromString(Json, FilePath);
+}
+
+bool FSchedulePatch::LoadFromString(const FString& Json, const FString& SourceName)
+{
+    *this = FSchedulePatch();
+
+    TSharedPtr<FJsonObject> Root;
+    if (!FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(Json), Root) || !Root.IsValid())
+    {
+        UE_LOG(LogTemp, Error, TEXT("Патч расписания не является JSON-объектом: %s"), *SourceName);
+        return false;
+    }
+
+    if (!Root->TryGetNumberField(TEXT("from_version"), FromVersion) || !Root->TryGetNumberField(TEXT("to_version"), ToVersion) || ToVersion <= FromVersion)
+    {
+        UE_LOG(LogTemp, Error, TEXT("В патче расписания неверные from_version/to_version: %s"), *SourceName);
+        return false;
+    }
+
+    FString Error;
+    const TArray<TSharedPtr<FJsonValue>>* Values = nullptr;
+
+    if (Root->TryGetArrayField(TEXT("delete"), Values))
+    {
+        for (const TSharedPtr<FJsonValue>& Value : *Values)
+        {
+            int64 Id = INDEX_NONE;
+            if (!Value.IsValid() || !Value->TryGetNumber(Id))
+            {
+                UE_LOG(LogTemp, Error, TEXT("В патче расписания id удаляемой строки не число: %s"), *SourceName);
+                return false;
+            }
+            Deletes.Add(Id);
+        }
+    }
+
+    if (Root->TryGetArrayField(TEXT("update"), Values))
+    {
+        for (const TSharedPtr<FJsonValue>& Value : *Values)
+        {
+            if (!ParseSchedulePatchRow(Value, false, Updates.AddDefaulted_GetRef(), Error))
+            {
+                UE_LOG(LogTemp, Error, TEXT("Ошибка в патче расписания %s: %s"), *SourceName, *Error);
+                return false;
+            }
+        }
+    }
+
+    if (Root->TryGetArrayField(TEXT("insert"), Values))
+    {
+        for (const TSharedPtr<FJsonValue>& Value : *Values)
+        {
+            if (!ParseSchedulePatchRow(Value, true, Inserts.AddDefaulted_GetRef(), Error))
+            {
+                UE_LOG(LogTemp, Error, TEXT("Ошибка в патче расписания %s: %s"), *SourceName, *Error);
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+bool FSchedulePatch::ApplyRows(sqlite3* Connection, FString& OutError) const
+{
+    // Строки с одинаковым набором колонок используют один скомпилированный запрос
+    TMap<FString, sqlite3_stmt*> Statements;
+    ON_SCOPE_EXIT
+    {
+        for (const TPair<FString, sqlite3_stmt*>& Entry : Statements)
+        {
+            sqlite3_finalize(Entry.Value);
+        }
+    };
+
+    auto Prepare = [&Statements, Connection](const FString& Sql) -> sqlite3_stmt*
+    {
+        if (sqlite3_stmt** Cached = Statements.Find(Sql))
+        {
+            sqlite3_reset(*Cached);
+            sqlite3_clear_bindings(*Cached);
+            return *Cached;
+        }
+
+        sqlite3_stmt* Statement = nullptr;
+        if (sqlite3_prepare_v2(Connection, TCHAR_TO_UTF8(*Sql), -1, &Statement, nullptr) != SQLITE_OK)
+        {
+            sqlite3_finalize(Statement);
+            return nullptr;
+        }
+        Statements.Add(Sql, Statement);
+        return Statement;
+    };
+
+    auto BindColumns = [](sqlite3_stmt* Statement, const FSchedulePatchRow& Row, int32 FirstIndex)
+    {
+        for (int32 Index = 0; Index < Row.Columns.Num(); ++Index)
+        {
+            const FTCHARToUTF8 Utf8(*Row.Columns[Index].Value);
+            sqlite3_bind_text(Statement, FirstIndex + Index, Utf8.Get(), Utf8.Length(), SQLITE_TRANSIENT);
+        }
+    };
+
+    // Каждая операция должна затронуть ровно одну строку
+    auto StepSingleRow = [Connection, &OutError](sqlite3_stmt* Statement, const TCHAR* Operation, int64 Id)
+    {
+        if (!Statement || sqlite3_step(Statement) != SQLITE_DONE)
+        {
+            OutError = FString::Printf(TEXT("%s строки %lld: %s"), Operation, Id, UTF8_TO_TCHAR(sqlite3_errmsg(Connection)));
+            return false;
+        }
+        if (sqlite3_changes(Connection) != 1)
+        {
+            OutError = FString::Printf(TEXT("%s строки %lld: строка не найдена"), Operation, Id);
+            return false;
+        }
+        return true;
+    };
+
+    for (const int64 Id : Deletes)
+    {
+        sqlite3_stmt* Statement = Prepare(TEXT("DELETE FROM main.ClassroomSchedule WHERE id = ?;"));
+        if (Statement)
+        {
+            sqlite3_bind_int64(Statement, 1, Id);
+        }
+        if (!StepSingleRow(Statement, TEXT("Удаление"), Id))
+        {
+            return false;
+        }
+    }
+
+    for (const FSchedulePatchRow& Row : Updates)
+    {
+        FString Sql = TEXT("UPDATE main.ClassroomSchedule SET ");
+        for (int32 Index = 0; Index < Row.Columns.Num(); ++Index)
+        {
+            Sql += FString::Printf(TEXT("%s%s = ?"), Index > 0 ? TEXT(", ") : TEXT(""), *Row.Columns[Index].Key);
+        }
+        Sql += TEXT(" WHERE id = ?;");
+
+        sqlite3_stmt* Statement = Prepare(Sql);
+        if (Statement)
+        {
+            BindColumns(Statement, Row, 1);
+            sqlite3_bind_int64(Statement, Row.Columns.Num() + 1, Row.Id);
+        }
+        if (!StepSingleRow(Statement, TEXT("Изменение"), Row.Id))
+        {
+            return false;
+        }
+    }
+
+    for (const FSchedulePatchRow& Row : Inserts)
+    {
+        const bool bHasId = Row.Id != INDEX_NONE;
+        FString Names = bHasId ? TEXT("id") : TEXT("");
+        FString Placeholders = bHasId ? TEXT("?") : TEXT("");
+        for (const TPair<FString, FString>& Column : Row.Columns)
+        {
+            Names += (Names.IsEmpty() ? TEXT("") : TEXT(", ")) + Column.Key;
+            Placeholders += Placeholders.IsEmpty() ? TEXT("?") : TEXT(", ?");
+        }
+
+        sqlite3_stmt* Statement = Prepare(FString::Printf(TEXT("INSERT INTO main.ClassroomSchedule (%s) VALUES (%s);"), *Names, *Placeholders));
+        if (Statement)
+        {
+            if (bHasId)
+            {
+                sqlite3_bind_int64(Statement, 1, Row.Id);
+            }
+            BindColumns(Statement, Row, bHasId ? 2 : 1);
+        }
+        if (!StepSingleRow(Statement, TEXT("Вставка"), Row.Id))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,112 @@
+#include "ScheduleQuery.h"
+#include "Algo/BinarySearch.h"
+#include "Algo/StableSort.h"
+
+int32 FScheduleQuery::GetWeekMinute(const FDateTime& Time)
+{
+    return static_cast<int32>(Time.GetDayOfWeek()) * MinutesPerDay + Time.GetHour() * 60 + Time.GetMinute();
+}
+
+int32 FScheduleQuery::GetStartWeekMinute(const FScheduleEntry& Entry)
+{
+    return static_cast<int32>(Entry.Weekday) * MinutesPerDay + Entry.StartMinute;
+}
+
+int32 FScheduleQuery::GetEndWeekMinute(const FScheduleEntry& Entry)
+{
+    return static_cast<int32>(Entry.Weekday) * MinutesPerDay + Entry.EndMinute;
+}
+
+void FScheduleQuery::SortByWeekTime(TArrayView<FScheduleEntry> Entries)
+{
+    // Стабильная сортировка: при одинаковом начале порядок rowid сохраняется
+    Algo::StableSortBy(Entries, &FScheduleQuery::GetStartWeekMinute);
+}
+
+int32 FScheduleQuery::LowerBound(TArrayView<const FScheduleEntry> Sorted, int32 WeekMinute)
+{
+    return Algo::LowerBoundBy(Sorted, WeekMinute, &FScheduleQuery::GetStartWeekMinute);
+}
+
+int32 FScheduleQuery::UpperBound(TArrayView<const FScheduleEntry> Sorted, int32 WeekMinute)
+{
+    return Algo::UpperBoundBy(Sorted, WeekMinute, &FScheduleQuery::GetStartWeekMinute);
+}
+
+void FScheduleQuery::CollectOverlapping(TArrayView<const FScheduleEntry> Sorted, int32 From, int32 To, TArray<const FScheduleEntry*>& OutEntries)
+{
+    // Занятие не переходит через полночь, поэтому раньше From - сутки искать нечего
+    const int32 First = LowerBound(Sorted, FMath::Max(0, From - MinutesPerDay));
+    const int32 Last = LowerBound(Sorted, To);
+    for (int32 Index = First; Index < Last; ++Index)
+    {
+        if (GetEndWeekMinute(Sorted[Index]) > From)
+        {
+            OutEntries.Add(&Sorted[Index]);
+        }
+    }
+}
+
+void FScheduleQuery::Run(TArrayView<const FScheduleEntry> Sorted, EScheduleQueryKind Kind, int32 From, int32 To, TArray<const FScheduleEntry*>& OutEntries)
+{
+    if (Sorted.Num() == 0)
+    {
+        return;
+    }
+
+    switch (Kind)
+    {
+    case EScheduleQueryKind::Current:
+        {
+            // Идём назад от последнего начавшегося занятия в пределах того же дня
+            const int32 DayStart = From - From % MinutesPerDay;
+            for (int32 Index = UpperBound(Sorted, From) - 1; Index >= 0 && GetStartWeekMinute(Sorted[Index]) >= DayStart; --Index)
+            {
+                if (GetEndWeekMinute(Sorted[Index]) > From)
+                {
+                    OutEntries.Add(&Sorted[Index]);
+                    break;
+                }
+            }
+        }
+        break;
+    case EScheduleQueryKind::Next:
+        {
+            const int32 Index = UpperBound(Sorted, From);
+            OutEntries.Add(&Sorted[Index < Sorted.Num() ? Index : 0]);
+        }
+        break;
+    case EScheduleQueryKind::Range:
+        {
+            if (To - From >= MinutesPerWeek)
+            {
+                for (const FScheduleEntry& Entry : Sorted)
+                {
+                    OutEntries.Add(&Entry);
+                }
+                break;
+            }
+
+            const int32 Duration = To - From;
+            if (Duration <= 0)
+            {
+                break;
+            }
+
+            From = ((From % MinutesPerWeek) + MinutesPerWeek) % MinutesPerWeek;
+            To = From + Duration;
+            if (To <= MinutesPerWeek)
+            {
+                CollectOverlapping(Sorted, From, To, OutEntries);
+            }
+            else
+            {
+                CollectOverlapping(Sorted, From, MinutesPerWeek, OutEntries);
+                CollectOverlapping(Sorted, 0, To - MinutesPerWeek, OutEntries);
+            }
+        }
+        break;
+    default:
+        break;
+    }
+}
@@ -0,0 +1,141 @@
+#include "ScheduleResultCache.h"
+#include "Misc/ScopeLock.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Result cache hits"), STAT_ScheduleResultCacheHits, STATGROUP_ScheduleDB);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Result cache misses"), STAT_ScheduleResultCacheMisses, STATGROUP_ScheduleDB);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Result cache evictions"), STAT_ScheduleResultCacheEvictions, STATGROUP_ScheduleDB);
+DECLARE_MEMORY_STAT(TEXT("Result cache memory"), STAT_ScheduleResultCacheMemory, STATGROUP_ScheduleDB);
+
+FScheduleResultCache::FScheduleResultCache(SIZE_T InMaxBytes)
+    : MaxBytes(InMaxBytes)
+{
+}
+
+FScheduleResultCache::~FScheduleResultCache()
+{
+    Empty();
+}
+
+bool FScheduleResultCache::Find(const FString& RoomCode, uint32 Generation, TArray<FClassroomScheduleRow>& OutRows)
+{
+    FScopeLock ScopeLock(&Lock);
+    SyncGenerationLocked(Generation);
+
+    FEntry* Entry = Generation == CachedGeneration ? Entries.Find(RoomCode) : nullptr;
+    if (!Entry)
+    {
+        Misses.fetch_add(1, std::memory_order_relaxed);
+        INC_DWORD_STAT(STAT_ScheduleResultCacheMisses);
+        return false;
+    }
+
+    RecentlyUsed.RemoveNode(Entry->Node, false);
+    RecentlyUsed.AddHead(Entry->Node);
+
+    OutRows = Entry->Rows;
+    Hits.fetch_add(1, std::memory_order_relaxed);
+    INC_DWORD_STAT(STAT_ScheduleResultCacheHits);
+    return true;
+}
+
+void FScheduleResultCache::Add(const FString& RoomCode, uint32 Generation, const TArray<FClassroomScheduleRow>& Rows)
+{
+    FScopeLock ScopeLock(&Lock);
+    SyncGenerationLocked(Generation);
+
+    // Ответ собран по данным, которые уже заменены
+    if (Generation != CachedGeneration)
+    {
+        return;
+    }
+
+    const SIZE_T Bytes = GetEntryBytes(RoomCode, Rows);
+    if (Bytes > MaxBytes)
+    {
+        return;
+    }
+
+    if (FEntry* Existing = Entries.Find(RoomCode))
+    {
+        UsedBytes -= Existing->Bytes;
+        RecentlyUsed.RemoveNode(Existing->Node);
+        Entries.Remove(RoomCode);
+    }
+
+    EvictLocked(MaxBytes - Bytes);
+
+    RecentlyUsed.AddHead(RoomCode);
+    FEntry& Entry = Entries.Add(RoomCode);
+    Entry.Rows = Rows;
+    Entry.Bytes = Bytes;
+    Entry.Node = RecentlyUsed.GetHead();
+    UsedBytes += Bytes;
+
+    SET_MEMORY_STAT(STAT_ScheduleResultCacheMemory, UsedBytes);
+}
+
+void FScheduleResultCache::SetMaxBytes(SIZE_T InMaxBytes)
+{
+    FScopeLock ScopeLock(&Lock);
+    MaxBytes = InMaxBytes;
+    EvictLocked(MaxBytes);
+    SET_MEMORY_STAT(STAT_ScheduleResultCacheMemory, UsedBytes);
+}
+
+void FScheduleResultCache::Empty()
+{
+    FScopeLock ScopeLock(&Lock);
+    EmptyLocked();
+}
+
+SIZE_T FScheduleResultCache::GetUsedBytes() const
+{
+    FScopeLock ScopeLock(&Lock);
+    return UsedBytes;
+}
+
+SIZE_T FScheduleResultCache::GetEntryBytes(const FString& RoomCode, const TArray<FClassroomScheduleRow>& Rows)
+{
+    // Ключ хранится дважды: в карте и в узле списка
+    SIZE_T Bytes = sizeof(FEntry) + sizeof(TDoubleLinkedList<FString>::TDoubleLinkedListNode) + 2 * RoomCode.GetAllocatedSize()
+        + Rows.GetAllocatedSize();
+    for (const FClassroomScheduleRow& Row : Rows)
+    {
+        Bytes += Row.Subject.GetAllocatedSize() + Row.Teacher.GetAllocatedSize() + Row.StartTime.GetAllocatedSize()
+            + Row.EndTime.GetAllocatedSize() + Row.Weekday.GetAllocatedSize();
+    }
+    return Bytes;
+}
+
+void FScheduleResultCache::SyncGenerationLocked(uint32 Generation)
+{
+    // Поколения только растут: более новое означает, что все записи устарели
+    if (Generation > CachedGeneration)
+    {
+        EmptyLocked();
+        CachedGeneration = Generation;
+    }
+}
+
+void FScheduleResultCache::EvictLocked(SIZE_T Budget)
+{
+    while (UsedBytes > Budget && RecentlyUsed.GetTail())
+    {
+        TDoubleLinkedList<FString>::TDoubleLinkedListNode* Tail = RecentlyUsed.GetTail();
+        const FEntry& Entry = Entries.FindChecked(Tail->GetValue());
+        UsedBytes -= Entry.Bytes;
+        Entries.Remove(Tail->GetValue());
+        RecentlyUsed.RemoveNode(Tail);
+
+        Evictions.fetch_add(1, std::memory_order_relaxed);
+        INC_DWORD_STAT(STAT_ScheduleResultCacheEvictions);
+    }
+}
+
+void FScheduleResultCache::EmptyLocked()
+{
+    Entries.Empty();
+    RecentlyUsed.Empty();
+    UsedBytes = 0;
+    SET_MEMORY_STAT(STAT_ScheduleResultCacheMemory, 0);
+}
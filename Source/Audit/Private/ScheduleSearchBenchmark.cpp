@@ -0,0 +1,52 @@
+#include "ScheduleBenchmark.h"
+
+#if !UE_BUILD_SHIPPING
+
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+
+// Schedule.BenchmarkSearch [строк=100000] [запросов=1000]
+static void BenchmarkScheduleSearch(const TArray<FString>& Args)
+{
+    const int32 NumRows = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 100000;
+    const int32 NumQueries = Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 1000;
+
+    FScheduleBenchmarkFixture Fixture(TEXT("ScheduleSearchBenchmark.db"), NumRows);
+    if (!Fixture.bIsReady)
+    {
+        return;
+    }
+
+    // Типичные запросы: начало фамилии, фамилия с инициалом, начало предмета
+    static const TCHAR* Queries[] =
+    {
+        TEXT("ива"), TEXT("Петров П"), TEXT("сем"), TEXT("мат"), TEXT("физ"), TEXT("лин алг"), TEXT("лекц"), TEXT("К"),
+    };
+
+    TArray<FRoomScheduleSession> Sessions;
+    double TotalSeconds = 0.0;
+    double MaxSeconds = 0.0;
+    int64 TotalResults = 0;
+    for (int32 QueryIndex = 0; QueryIndex < NumQueries; ++QueryIndex)
+    {
+        Sessions.Reset();
+        const double QueryStart = FPlatformTime::Seconds();
+        Fixture.Index->Search(Queries[QueryIndex % UE_ARRAY_COUNT(Queries)], true, true, 100, Sessions);
+        const double QuerySeconds = FPlatformTime::Seconds() - QueryStart;
+
+        TotalSeconds += QuerySeconds;
+        MaxSeconds = FMath::Max(MaxSeconds, QuerySeconds);
+        TotalResults += Sessions.Num();
+    }
+
+    UE_LOG(LogTemp, Log, TEXT("Поиск по расписанию: строк %d, генерация %.0f мс, индекс %.0f мс (%.1f МБ), запросов %d, среднее %.3f мс, максимум %.3f мс, результатов в среднем %.1f"),
+        NumRows, Fixture.GenerateSeconds * 1000.0, Fixture.BuildSeconds * 1000.0, Fixture.Index->GetAllocatedSize() / (1024.0 * 1024.0), NumQueries,
+        TotalSeconds * 1000.0 / FMath::Max(NumQueries, 1), MaxSeconds * 1000.0, static_cast<double>(TotalResults) / FMath::Max(NumQueries, 1));
+}
+
+static FAutoConsoleCommand ScheduleBenchmarkSearchCommand(
+    TEXT("Schedule.BenchmarkSearch"),
+    TEXT("Генерирует синтетическое расписание и замеряет поиск по предметам и преподавателям. Аргументы: [строк=100000] [запросов=1000]"),
+    FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkScheduleSearch));
+
+#endif
@@ -0,0 +1,198 @@
+#include "ScheduleSearchIndex.h"
+#include "Algo/BinarySearch.h"
+#include "Algo/Unique.h"
+
+// Кириллица, латиница и цифры; остальное (пробелы, точки инициалов, дефисы) - разделители
+static bool IsScheduleSearchChar(TCHAR Char)
+{
+    return FChar::IsAlnum(Char) || (Char >= 0x0400 && Char <= 0x04FF);
+}
+
+static TCHAR FoldScheduleSearchChar(TCHAR Char)
+{
+    if (Char >= 0x0410 && Char <= 0x042F)
+    {
+        Char += 0x20;
+    }
+    else if (Char >= 0x0400 && Char <= 0x040F)
+    {
+        Char += 0x50;
+    }
+    else if (Char < 0x80)
+    {
+        Char = FChar::ToLower(Char);
+    }
+    return Char == 0x0451 ? 0x0435 : Char;
+}
+
+static bool ScheduleTokenLess(const FString& A, const FString& B)
+{
+    return FCString::Strcmp(*A, *B) < 0;
+}
+
+void FScheduleSearchIndex::Tokenize(const FString& Text, TArray<FString>& OutTokens)
+{
+    FString Token;
+    for (const TCHAR Char : Text)
+    {
+        if (IsScheduleSearchChar(Char))
+        {
+            Token.AppendChar(FoldScheduleSearchChar(Char));
+        }
+        else if (!Token.IsEmpty())
+        {
+            OutTokens.Add(MoveTemp(Token));
+            Token.Reset();
+        }
+    }
+    if (!Token.IsEmpty())
+    {
+        OutTokens.Add(MoveTemp(Token));
+    }
+}
+
+void FScheduleSearchIndex::Build(const FScheduleStringPool& Strings, TArrayView<const FScheduleEntry> Entries)
+{
+    Tokens.Reset();
+    EntryOffsets.Reset();
+    EntryIndices.Reset();
+
+    // Слова режем только у предметов и преподавателей, а не у кабинетов и дней недели
+    TBitArray<> IsText(false, Strings.Num());
+    for (const FScheduleEntry& Entry : Entries)
+    {
+        IsText[Entry.Subject] = true;
+        IsText[Entry.Teacher] = true;
+    }
+
+    TArray<FString> Words;
+    for (TConstSetBitIterator<> It(IsText); It; ++It)
+    {
+        Words.Reset();
+        Tokenize(Strings.Get(It.GetIndex()), Words);
+        Words.Sort(ScheduleTokenLess);
+        Words.SetNum(Algo::Unique(Words));
+
+        for (FString& Word : Words)
+        {
+            FToken& Token = Tokens.AddDefaulted_GetRef();
+            Token.Text = MoveTemp(Word);
+            Token.String = It.GetIndex();
+        }
+    }
+
+    Tokens.Sort([](const FToken& A, const FToken& B)
+    {
+        const int32 Compare = FCString::Strcmp(*A.Text, *B.Text);
+        return Compare != 0 ? Compare < 0 : A.String < B.String;
+    });
+    for (FToken& Token : Tokens)
+    {
+        Token.Text.Shrink();
+    }
+
+    // Списки занятий по строкам: подсчёт, префиксные суммы, раскладка в порядке занятий
+    EntryOffsets.SetNumZeroed(Strings.Num() + 1);
+    for (const FScheduleEntry& Entry : Entries)
+    {
+        EntryOffsets[Entry.Subject + 1]++;
+        if (Entry.Teacher != Entry.Subject)
+        {
+            EntryOffsets[Entry.Teacher + 1]++;
+        }
+    }
+    for (int32 Index = 1; Index < EntryOffsets.Num(); ++Index)
+    {
+        EntryOffsets[Index] += EntryOffsets[Index - 1];
+    }
+
+    TArray<int32> Cursor(EntryOffsets.GetData(), Strings.Num());
+    EntryIndices.SetNumUninitialized(EntryOffsets.Last());
+    for (int32 Index = 0; Index < Entries.Num(); ++Index)
+    {
+        const FScheduleEntry& Entry = Entries[Index];
+        EntryIndices[Cursor[Entry.Subject]++] = Index;
+        if (Entry.Teacher != Entry.Subject)
+        {
+            EntryIndices[Cursor[Entry.Teacher]++] = Index;
+        }
+    }
+}
+
+void FScheduleSearchIndex::Search(const FString& Query, bool bSubjects, bool bTeachers, TArrayView<const FScheduleEntry> Entries, int32 MaxResults, TArray<int32>& OutEntries) const
+{
+    TArray<FString> Words;
+    Tokenize(Query, Words);
+    if (Words.Num() == 0 || (!bSubjects && !bTeachers))
+    {
+        return;
+    }
+
+    // Строки пула, содержащие все слова запроса как префиксы своих слов
+    TArray<int32> Matched;
+    TArray<int32> WordMatches;
+    for (int32 WordIndex = 0; WordIndex < Words.Num(); ++WordIndex)
+    {
+        const FString& Word = Words[WordIndex];
+
+        WordMatches.Reset();
+        for (int32 Index = Algo::LowerBoundBy(Tokens, Word, &FToken::Text, ScheduleTokenLess);
+            Index < Tokens.Num() && Tokens[Index].Text.StartsWith(Word, ESearchCase::CaseSensitive); ++Index)
+        {
+            WordMatches.Add(Tokens[Index].String);
+        }
+        WordMatches.Sort();
+        WordMatches.SetNum(Algo::Unique(WordMatches));
+
+        if (WordIndex == 0)
+        {
+            Matched = MoveTemp(WordMatches);
+        }
+        else
+        {
+            Matched.RemoveAll([&WordMatches](int32 String)
+            {
+                return Algo::BinarySearch(WordMatches, String) == INDEX_NONE;
+            });
+        }
+
+        if (Matched.Num() == 0)
+        {
+            return;
+        }
+    }
+
+    const int32 FirstResult = OutEntries.Num();
+    for (const int32 String : Matched)
+    {
+        for (int32 Offset = EntryOffsets[String]; Offset < EntryOffsets[String + 1]; ++Offset)
+        {
+            const int32 EntryIndex = EntryIndices[Offset];
+            const FScheduleEntry& Entry = Entries[EntryIndex];
+            if ((bSubjects && Entry.Subject == String) || (bTeachers && Entry.Teacher == String))
+            {
+                OutEntries.Add(EntryIndex);
+            }
+        }
+    }
+
+    // Одно занятие может совпасть и по предмету, и по преподавателю
+    TArrayView<int32> Results(OutEntries.GetData() + FirstResult, OutEntries.Num() - FirstResult);
+    Results.Sort();
+    int32 NumResults = Algo::Unique(Results);
+    if (MaxResults > 0)
+    {
+        NumResults = FMath::Min(NumResults, MaxResults);
+    }
+    OutEntries.SetNum(FirstResult + NumResults);
+}
+
+SIZE_T FScheduleSearchIndex::GetAllocatedSize() const
+{
+    SIZE_T Size = Tokens.GetAllocatedSize() + EntryOffsets.GetAllocatedSize() + EntryIndices.GetAllocatedSize();
+    for (const FToken& Token : Tokens)
+    {
+        Size += Token.Text.GetAllocatedSize();
+    }
+    return Size;
+}
@@ -0,0 +1,83 @@
+#include "ScheduleBenchmark.h"
+
+#if !UE_BUILD_SHIPPING
+
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "Math/RandomStream.h"
+#include "ScheduleQuery.h"
+#include "SQLiteScheduleLibrary.h"
+
+struct FSessionBenchmarkTiming
+{
+    double TotalSeconds = 0.0;
+    double MaxSeconds = 0.0;
+    int64 TotalResults = 0;
+};
+
+// Одни и те же кабинеты и моменты времени для обоих путей, чтобы результаты можно было сравнивать
+static void RunSessionQueries(FScheduleDatabase& Database, FRoomScheduleIndex* Index, const TArray<FString>& RoomCodes,
+    EScheduleQueryKind Kind, int32 NumQueries, FSessionBenchmarkTiming& OutTiming)
+{
+    FRandomStream Random(54321);
+    TArray<FClassroomScheduleRow> Rows;
+    for (int32 QueryIndex = 0; QueryIndex < NumQueries; ++QueryIndex)
+    {
+        const FString& RoomCode = RoomCodes[Random.RandHelper(RoomCodes.Num())];
+        const int32 From = Random.RandHelper(FScheduleQuery::MinutesPerWeek);
+        const int32 To = From + 4 * 60;
+
+        Rows.Reset();
+        const double QueryStart = FPlatformTime::Seconds();
+        // Без кэша ответов: замеряется сам поиск, а не попадание в кэш
+        USQLiteScheduleLibrary::LookupSessions(Database, Index, nullptr, RoomCode, Kind, From, To, Rows);
+        const double QuerySeconds = FPlatformTime::Seconds() - QueryStart;
+
+        OutTiming.TotalSeconds += QuerySeconds;
+        OutTiming.MaxSeconds = FMath::Max(OutTiming.MaxSeconds, QuerySeconds);
+        OutTiming.TotalResults += Rows.Num();
+    }
+}
+
+// Schedule.BenchmarkSessions [строк=100000] [запросов=1000]
+static void BenchmarkScheduleSessions(const TArray<FString>& Args)
+{
+    const int32 NumRows = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 100000;
+    const int32 NumQueries = Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 1000;
+
+    FScheduleBenchmarkFixture Fixture(TEXT("ScheduleSessionBenchmark.db"), NumRows);
+    const TArray<FString> RoomCodes = Fixture.bIsReady ? Fixture.GetRoomCodes() : TArray<FString>();
+    if (RoomCodes.Num() == 0)
+    {
+        return;
+    }
+
+    static const TPair<const TCHAR*, EScheduleQueryKind> Kinds[] =
+    {
+        { TEXT("GetCurrentSession"), EScheduleQueryKind::Current },
+        { TEXT("GetNextSession"), EScheduleQueryKind::Next },
+        { TEXT("GetSessionsInRange"), EScheduleQueryKind::Range },
+    };
+
+    for (const TPair<const TCHAR*, EScheduleQueryKind>& Kind : Kinds)
+    {
+        // С индексом - бинарный поиск по занятиям кабинета; без него - SQL-выборка всего кабинета и фильтрация
+        FSessionBenchmarkTiming Indexed;
+        FSessionBenchmarkTiming FullFetch;
+        RunSessionQueries(*Fixture.Database, &Fixture.Index.Get(), RoomCodes, Kind.Value, NumQueries, Indexed);
+        RunSessionQueries(*Fixture.Database, nullptr, RoomCodes, Kind.Value, NumQueries, FullFetch);
+
+        UE_LOG(LogTemp, Log, TEXT("%s: строк %d, запросов %d, индекс - среднее %.4f мс, максимум %.3f мс; выборка и фильтрация - среднее %.4f мс, максимум %.3f мс; результатов в среднем %.2f / %.2f"),
+            Kind.Key, NumRows, NumQueries,
+            Indexed.TotalSeconds * 1000.0 / FMath::Max(NumQueries, 1), Indexed.MaxSeconds * 1000.0,
+            FullFetch.TotalSeconds * 1000.0 / FMath::Max(NumQueries, 1), FullFetch.MaxSeconds * 1000.0,
+            static_cast<double>(Indexed.TotalResults) / FMath::Max(NumQueries, 1), static_cast<double>(FullFetch.TotalResults) / FMath::Max(NumQueries, 1));
+    }
+}
+
+static FAutoConsoleCommand ScheduleBenchmarkSessionsCommand(
+    TEXT("Schedule.BenchmarkSessions"),
+    TEXT("Замеряет GetCurrentSession/GetNextSession/GetSessionsInRange через индекс против GetScheduleForRoom с фильтрацией. Аргументы: [строк=100000] [запросов=1000]"),
+    FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkScheduleSessions));
+
+#endif
@@ -0,0 +1,47 @@
+#include "ScheduleStringPool.h"
+
+int32 FScheduleStringPool::InternUtf8(const ANSICHAR* Text, int32 Length)
+{
+    const uint32 Hash = FCrc::MemCrc32(Text, Length);
+
+    TArray<int32, TInlineAllocator<4>> Candidates;
+    Utf8Lookup.MultiFind(Hash, Candidates);
+    for (const int32 Candidate : Candidates)
+    {
+        const FUtf8Range& Range = Utf8Ranges[Candidate];
+        if (Range.Length == Length && FMemory::Memcmp(Utf8Data.GetData() + Range.Offset, Text, Length) == 0)
+        {
+            return Candidate;
+        }
+    }
+
+    const int32 Handle = Strings.Num();
+
+    FUtf8Range& Range = Utf8Ranges.AddDefaulted_GetRef();
+    Range.Offset = Utf8Data.Num();
+    Range.Length = Length;
+    Utf8Data.Append(Text, Length);
+
+    const FUTF8ToTCHAR Converted(Text, Length);
+    FString& Value = Strings.Emplace_GetRef(Converted.Length(), Converted.Get());
+    Utf8Lookup.Add(Hash, Handle);
+    StringLookup.Add(Value, Handle);
+    return Handle;
+}
+
+int32 FScheduleStringPool::Find(const FString& Text) const
+{
+    const int32* Handle = StringLookup.Find(Text);
+    return Handle ? *Handle : INDEX_NONE;
+}
+
+SIZE_T FScheduleStringPool::GetAllocatedSize() const
+{
+    SIZE_T Size = Strings.GetAllocatedSize() + Utf8Ranges.GetAllocatedSize() + Utf8Data.GetAllocatedSize()
+        + Utf8Lookup.GetAllocatedSize() + StringLookup.GetAllocatedSize();
+    for (const FString& Value : Strings)
+    {
+        Size += Value.GetAllocatedSize();
+    }
+    return Size;
+}
@@ -22,3 +22,27 @@ struct FClassroomScheduleRow
     UPROPERTY(BlueprintReadWrite)
     FString Weekday;
 };
+
+USTRUCT(BlueprintType)
+struct FRoomScheduleSession
+{
+    GENERATED_BODY()
+
+    UPROPERTY(BlueprintReadWrite)
+    FString RoomCode;
+
+    UPROPERTY(BlueprintReadWrite)
+    FClassroomScheduleRow Session;
+};
+
+USTRUCT(BlueprintType)
+struct FRoomSchedule
+{
+    GENERATED_BODY()
+
+    UPROPERTY(BlueprintReadWrite)
+    FString RoomCode;
+
+    UPROPERTY(BlueprintReadWrite)
+    TArray<FClassroomScheduleRow> Rows;
+};
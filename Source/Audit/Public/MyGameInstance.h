@@ -3,16 +3,85 @@
 #include "Engine/GameInstance.h"
 #include "MyGameInstance.generated.h"
 
-UCLASS()
+class FScheduleDatabase;
+class FRoomScheduleIndex;
+class FScheduleResultCache;
+
+UENUM()
+enum class EScheduleDatabaseProvisioning : uint8
+{
+    // База из сборки открывается на месте; таблицы копируются в Persistent только при первой записи.
+    // Если база упакована в архив (pak, APK/OBB на Android), Init переходит на CopyOnStartup
+    OpenInPlace,
+    // Прежнее поведение: при первом запуске весь файл копируется в Persistent
+    CopyOnStartup
+};
+
+UCLASS(Config = Game)
 class AUDIT_API UMyGameInstance : public UGameInstance
 {
     GENERATED_BODY()
 
 public:
     virtual void Init() override;
+    virtual void Shutdown() override;
+
+    // Копирует базу из сборки в Persistent поверх прежней копии. Блокирующий вызов
+    static bool CopyBundledDatabase();
+
+    static FString GetBundledDatabasePath();
+
+    // Лежит ли база из сборки отдельным файлом, который sqlite может открыть на месте
+    static bool IsBundledDatabaseOnDisk();
+    static FString GetWritableDatabasePath();
+
+    // Папка с разностными патчами расписания (*.json), применяются при старте
+    static FString GetSchedulePatchDirectory();
+
+    // Применяет патчи по возрастанию версии; применённые файлы удаляются. Блокирующий вызов
+    static int32 ApplySchedulePatchFiles(FScheduleDatabase& Database, const TArray<FString>& PatchFiles);
+
+    // База расписания, открытая на время жизни GameInstance. Получать только в игровом потоке:
+    // фоновые задачи (сборка индекса, патчи, асинхронный поиск) получают указатель, захваченный при постановке
+    static TSharedPtr<FScheduleDatabase> GetScheduleDatabase();
 
-    void CopyDatabaseIfNeeded();
+    // Индекс расписания в памяти; пустой, если bUseScheduleIndex выключен. Только игровой поток
+    static TSharedPtr<FRoomScheduleIndex> GetScheduleIndex();
+
+    // Кэш готовых ответов по кабинетам; пустой, если ScheduleResultCacheMaxKilobytes = 0. Только игровой поток
+    static TSharedPtr<FScheduleResultCache> GetScheduleResultCache();
+
+    // Загружать ClassroomSchedule целиком в память при старте и отвечать на запросы из индекса
+    UPROPERTY(Config, EditAnywhere, Category = "Schedule")
+    bool bUseScheduleIndex = true;
+
+    // Предел памяти кэша ответов GetScheduleForRoom, КБ; 0 - кэш выключен
+    UPROPERTY(Config, EditAnywhere, Category = "Schedule", meta = (ClampMin = "0"))
+    int32 ScheduleResultCacheMaxKilobytes = 256;
+
+    UPROPERTY(Config, EditAnywhere, Category = "Schedule")
+    EScheduleDatabaseProvisioning DatabaseProvisioning = EScheduleDatabaseProvisioning::OpenInPlace;
+
+    // Версия расписания в Content/Movies/TestDB.db, поднимается вместе с файлом. Нужна для CopyOnStartup,
+    // когда база упакована в архив и прочитать её версию без полного копирования нельзя
+    UPROPERTY(Config, EditAnywhere, Category = "Schedule", meta = (ClampMin = "0"))
+    int64 BundledDatabaseVersion = 0;
+
+    // Сколько заняло открытие базы в Init, в секундах
+    UPROPERTY(BlueprintReadOnly, VisibleAnywhere, Category = "Schedule")
+    float DatabaseStartupSeconds = 0.0f;
 
     UPROPERTY(BlueprintReadWrite, VisibleAnywhere, Category = "QR")
     FString LastScannedRoomCode;
+
+private:
+    // Копии нет или расписание в сборке новее неё; сам файл сборки не копируется
+    bool IsDatabaseCopyNeeded() const;
+
+    // Кэш ответов, патчи и индекс поверх открытой базы
+    void StartScheduleServices(double StartTime);
+
+    TSharedPtr<FScheduleDatabase> ScheduleDatabase;
+    TSharedPtr<FRoomScheduleIndex> ScheduleIndex;
+    TSharedPtr<FScheduleResultCache> ScheduleResultCache;
 };
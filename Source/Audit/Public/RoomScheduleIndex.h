@@ -0,0 +1,80 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "ClassroomScheduleRow.h"
+#include "ScheduleDatabase.h"
+#include "ScheduleEntry.h"
+#include "ScheduleStringPool.h"
+#include "ScheduleQuery.h"
+#include "ScheduleSearchIndex.h"
+
+/**
+ * Вся таблица ClassroomSchedule в памяти.
+ * Коды кабинетов интернируются в целые хэндлы, строки каждого кабинета лежат
+ * непрерывным отрезком компактных FScheduleEntry в порядке rowid - ровно как их отдаёт SQL-запрос.
+ */
+class AUDIT_API FRoomScheduleIndex : public TSharedFromThis<FRoomScheduleIndex>
+{
+public:
+    /**
+     * Полностью перечитывает таблицу из базы.
+     * Если хоть одна строка не переводится в компактный вид без потерь, индекс
+     * остаётся несобранным и запросы идут через SQL.
+     */
+    bool Build(FScheduleDatabase& Database);
+
+    /**
+     * Build в пуле потоков; пока сборка идёт, RebuildIfStale возвращает false.
+     * Если сборки перекрываются, результат публикует только начатая последней.
+     * BeforeBuild выполняется в том же потоке до чтения таблицы (например, применение патчей).
+     */
+    void BuildAsync(TSharedRef<FScheduleDatabase> Database, TFunction<void()> BeforeBuild = nullptr);
+
+    /**
+     * Перестраивает индекс, если поколение данных базы сменилось с момента последней сборки.
+     * После неудачной сборки повторная попытка делается только при новом поколении.
+     */
+    bool RebuildIfStale(FScheduleDatabase& Database);
+
+    bool IsBuilt() const;
+
+    /** O(1): поиск хэндла кабинета и перевод его отрезка в Blueprint-строки. false, если индекс не собран. */
+    bool Find(const FString& RoomCode, TArray<FClassroomScheduleRow>& OutRows) const;
+
+    /** Запрос по времени (минуты от начала недели) по отсортированным занятиям кабинета. false, если индекс не собран. */
+    bool Query(const FString& RoomCode, EScheduleQueryKind Kind, int32 From, int32 To, TArray<FClassroomScheduleRow>& OutRows) const;
+
+    /** Поиск по началам слов предметов и/или преподавателей, результаты в порядке кабинетов и rowid. false, если индекс не собран. */
+    bool Search(const FString& Query, bool bSubjects, bool bTeachers, int32 MaxResults, TArray<FRoomScheduleSession>& OutSessions) const;
+
+    int32 GetNumRooms() const;
+    int32 GetNumRows() const;
+    SIZE_T GetAllocatedSize() const;
+
+private:
+    struct FRoomSpan
+    {
+        int32 First = 0;
+        int32 Num = 0;
+    };
+
+    const FRoomSpan* FindSpan(const FString& RoomCode) const;
+
+    FScheduleStringPool Strings;
+    TMap<int32, int32> SpanByRoomString;
+    TArray<FRoomSpan> Spans;
+    TArray<int32> RoomStringBySpan;
+    TArray<FScheduleEntry> Entries;
+    // Те же отрезки, но каждый отсортирован по (день недели, начало) для бинарного поиска
+    TArray<FScheduleEntry> SortedEntries;
+    FScheduleSearchIndex SearchIndex;
+
+    bool bBuilt = false;
+    std::atomic<int32> BuildsInFlight{0};
+    std::atomic<uint32> LatestBuildTicket{0};
+    uint32 SourceGeneration = 0;
+    // Поколение, на котором сборка не удалась
+    bool bBuildFailed = false;
+    uint32 FailedGeneration = 0;
+
+    mutable FRWLock Lock;
+};
@@ -1,9 +1,17 @@
 
 #include "CoreMinimal.h"
 #include "Kismet/BlueprintFunctionLibrary.h"
+#include "Misc/DateTime.h"
 #include "ClassroomScheduleRow.h"
 #include "SQLiteScheduleLibrary.generated.h"
 
+class FScheduleDatabase;
+class FRoomScheduleIndex;
+class FScheduleResultCache;
+enum class EScheduleQueryKind : uint8;
+
+DECLARE_DYNAMIC_DELEGATE_OneParam(FSchedulePatchAppliedDelegate, bool, bApplied);
+
 UCLASS()
 class AUDIT_API USQLiteScheduleLibrary : public UBlueprintFunctionLibrary
 {
@@ -12,4 +20,80 @@ class AUDIT_API USQLiteScheduleLibrary : public UBlueprintFunctionLibrary
 public:
     UFUNCTION(BlueprintCallable, Category = "SQLite")
     static TArray<FClassroomScheduleRow> GetScheduleForRoom(const FString& RoomCode);
+
+    // Расписания нескольких кабинетов за один проход по таблице; по корзине на каждый элемент RoomCodes, в том же порядке
+    UFUNCTION(BlueprintCallable, Category = "SQLite")
+    static TArray<FRoomSchedule> GetSchedulesForRooms(const TArray<FString>& RoomCodes);
+
+    // Поиск занятий по началам слов предмета и/или преподавателя ("иван" найдёт "Иванов И.И."); MaxResults <= 0 - все
+    UFUNCTION(BlueprintCallable, Category = "SQLite|Search")
+    static TArray<FRoomScheduleSession> SearchSchedule(const FString& Query, bool bSubjects = true, bool bTeachers = true, int32 MaxResults = 100);
+
+    // Принудительно перечитывает индекс расписания из базы
+    UFUNCTION(BlueprintCallable, Category = "SQLite")
+    static bool RebuildScheduleIndex();
+
+    // Применяет разностный патч из JSON-файла и перестраивает индекс; всё в пуле потоков, OnApplied - в игровом потоке
+    UFUNCTION(BlueprintCallable, Category = "SQLite")
+    static void ApplySchedulePatch(const FString& PatchFilePath, const FSchedulePatchAppliedDelegate& OnApplied);
+
+    // Версия данных расписания (таблица ScheduleVersion)
+    UFUNCTION(BlueprintPure, Category = "SQLite")
+    static int64 GetScheduleVersion();
+
+    // Кэш ответов, затем индекс (если он есть), затем SQL; потокобезопасен, используется и асинхронным вариантом
+    static TArray<FClassroomScheduleRow> LookupSchedule(FScheduleDatabase& Database, FRoomScheduleIndex* Index, FScheduleResultCache* Cache, const FString& RoomCode);
+
+    // Прямой SQL-запрос в обход индекса; результат должен совпадать с GetScheduleForRoom
+    static TArray<FClassroomScheduleRow> QueryScheduleFromDatabase(FScheduleDatabase& Database, const FString& RoomCode);
+
+    // То же, но false, если запрос не выполнился до конца (база занята, ошибка подготовки)
+    static bool QueryScheduleFromDatabase(FScheduleDatabase& Database, const FString& RoomCode, TArray<FClassroomScheduleRow>& OutRows);
+
+    // Поиск без индекса: один проход по таблице в порядке rowid, останавливается на MaxResults найденных занятиях
+    static bool SearchScheduleFromDatabase(FScheduleDatabase& Database, const FString& Query, bool bSubjects, bool bTeachers, int32 MaxResults,
+        TArray<FRoomScheduleSession>& OutSessions);
+
+    // Пакетные варианты: индекс, а без него - один запрос с room_code IN (...) на пачку кабинетов
+    static TArray<FRoomSchedule> LookupSchedules(FScheduleDatabase& Database, FRoomScheduleIndex* Index, const TArray<FString>& RoomCodes);
+    static TArray<FRoomSchedule> QuerySchedulesFromDatabase(FScheduleDatabase& Database, const TArray<FString>& RoomCodes);
+
+    // Запрос по времени к явно заданной базе: через индекс, а без него - LookupSchedule и фильтрация на месте
+    static void LookupSessions(FScheduleDatabase& Database, FRoomScheduleIndex* Index, FScheduleResultCache* Cache, const FString& RoomCode,
+        EScheduleQueryKind Kind, int32 From, int32 To, TArray<FClassroomScheduleRow>& OutRows);
+
+    // Занятие, идущее в кабинете в момент Time
+    UFUNCTION(BlueprintCallable, Category = "SQLite|Sessions")
+    static bool GetCurrentSession(const FString& RoomCode, const FDateTime& Time, FClassroomScheduleRow& Session);
+
+    // Ближайшее занятие, начинающееся после Time (с переходом на следующую неделю)
+    UFUNCTION(BlueprintCallable, Category = "SQLite|Sessions")
+    static bool GetNextSession(const FString& RoomCode, const FDateTime& Time, FClassroomScheduleRow& Session);
+
+    // Занятия, пересекающие интервал [From, To)
+    UFUNCTION(BlueprintCallable, Category = "SQLite|Sessions")
+    static TArray<FClassroomScheduleRow> GetSessionsInRange(const FString& RoomCode, const FDateTime& From, const FDateTime& To);
+
+    UFUNCTION(BlueprintCallable, Category = "SQLite|Sessions")
+    static TArray<FRoomScheduleSession> GetCurrentSessionsForRooms(const TArray<FString>& RoomCodes, const FDateTime& Time);
+
+    UFUNCTION(BlueprintCallable, Category = "SQLite|Sessions")
+    static TArray<FRoomScheduleSession> GetNextSessionsForRooms(const TArray<FString>& RoomCodes, const FDateTime& Time);
+
+    UFUNCTION(BlueprintCallable, Category = "SQLite|Sessions")
+    static TArray<FRoomScheduleSession> GetSessionsInRangeForRooms(const TArray<FString>& RoomCodes, const FDateTime& From, const FDateTime& To);
+
+    // Счётчики кэша скомпилированных запросов общей базы расписания
+    UFUNCTION(BlueprintPure, Category = "SQLite")
+    static void GetStatementCacheStats(int32& Hits, int32& Misses);
+
+    // Счётчики кэша ответов GetScheduleForRoom и занятая им память в байтах
+    UFUNCTION(BlueprintPure, Category = "SQLite")
+    static void GetResultCacheStats(int32& Hits, int32& Misses, int32& Evictions, int64& UsedBytes);
+
+private:
+    // Запрос по времени: через индекс, а без него - полной выборкой кабинета и фильтрацией
+    static void QuerySessions(const FString& RoomCode, EScheduleQueryKind Kind, int32 From, int32 To, TArray<FClassroomScheduleRow>& OutRows);
+    static void FilterSessions(const TArray<FClassroomScheduleRow>& Rows, EScheduleQueryKind Kind, int32 From, int32 To, TArray<FClassroomScheduleRow>& OutRows);
+    static TArray<FRoomScheduleSession> QuerySessionsForRooms(const TArray<FString>& RoomCodes, EScheduleQueryKind Kind, int32 From, int32 To);
 };
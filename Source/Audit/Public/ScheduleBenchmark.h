@@ -0,0 +1,29 @@
+#pragma once
+#include "CoreMinimal.h"
+
+#if !UE_BUILD_SHIPPING
+
+#include "ScheduleDatabase.h"
+#include "RoomScheduleIndex.h"
+
+/**
+ * Общая подготовка консольных замеров расписания: синтетическая база в Saved/, открытая и с построенным индексом.
+ * Файл удаляется в деструкторе; если подготовка не удалась, bIsReady = false, а причина уже в логе.
+ */
+struct FScheduleBenchmarkFixture
+{
+    FString FilePath;
+    TSharedRef<FScheduleDatabase> Database;
+    TSharedRef<FRoomScheduleIndex> Index;
+    double GenerateSeconds = 0.0;
+    double BuildSeconds = 0.0;
+    bool bIsReady = false;
+
+    FScheduleBenchmarkFixture(const TCHAR* FileName, int32 NumRows);
+    ~FScheduleBenchmarkFixture();
+
+    // Различные кабинеты синтетической таблицы; MaxRooms <= 0 - все
+    TArray<FString> GetRoomCodes(int32 MaxRooms = 0) const;
+};
+
+#endif
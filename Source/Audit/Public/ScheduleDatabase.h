@@ -0,0 +1,128 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "HAL/CriticalSection.h"
+#include "Misc/DateTime.h"
+#include <atomic>
+
+struct sqlite3;
+struct sqlite3_stmt;
+struct FSchedulePatch;
+
+DECLARE_STATS_GROUP(TEXT("ScheduleDB"), STATGROUP_ScheduleDB, STATCAT_Advanced);
+
+/**
+ * Ключи-строки для TMap/TSet с учётом регистра: FString по умолчанию
+ * сравнивается без учёта регистра, а SQLite сравнивает текст побайтно.
+ */
+template <typename ValueType>
+struct TCaseSensitiveStringKeyFuncs : BaseKeyFuncs<TPair<FString, ValueType>, FString, false>
+{
+    static const FString& GetSetKey(const TPair<FString, ValueType>& Element)
+    {
+        return Element.Key;
+    }
+
+    static bool Matches(const FString& A, const FString& B)
+    {
+        return A.Equals(B, ESearchCase::CaseSensitive);
+    }
+
+    static uint32 GetKeyHash(const FString& Key)
+    {
+        return FCrc::StrCrc32(*Key);
+    }
+};
+
+/**
+ * Соединение с базой расписания на всё время жизни процесса.
+ * Файл открывается один раз, скомпилированные запросы кэшируются по тексту SQL
+ * и перед каждым использованием сбрасываются (reset + clear_bindings).
+ * Все обращения к соединению сериализуются внутренней блокировкой.
+ */
+class AUDIT_API FScheduleDatabase
+{
+public:
+    FScheduleDatabase() = default;
+    ~FScheduleDatabase();
+
+    FScheduleDatabase(const FScheduleDatabase&) = delete;
+    FScheduleDatabase& operator=(const FScheduleDatabase&) = delete;
+
+    /** Открывает базу: WAL + query_only, либо чистый read-only, если файл нельзя открыть на запись. */
+    bool Open(const FString& InPath);
+
+    /**
+     * Открывает базу из сборки на месте, без копирования (immutable URI).
+     * Если уже есть записываемая копия OverlayPath, она становится main, а база из сборки
+     * подключается как bundle: неквалифицированные имена таблиц сначала ищутся в копии.
+     * Копия, чья версия расписания старше версии в сборке, удаляется.
+     */
+    bool OpenLayered(const FString& InBundledPath, const FString& InOverlayPath);
+
+    /**
+     * Переносит таблицу из базы сборки в записываемую копию (создаёт её при необходимости)
+     * и переоткрывает соединение. Блокирующий вызов - для фоновых потоков.
+     */
+    bool MaterializeTable(const FString& TableName);
+
+    /**
+     * Применяет разностный патч к ClassroomSchedule одной транзакцией на отдельном соединении.
+     * Патч для уже достигнутой версии пропускается (возвращает true), патч для другой
+     * базовой версии отклоняется. Блокирующий вызов.
+     */
+    bool ApplyPatch(const FSchedulePatch& Patch);
+
+    /** Версия данных расписания из таблицы ScheduleVersion; 0, если таблицы нет. */
+    int64 GetSchemaVersion() const;
+
+    /** Версия расписания в файле базы без открытия общего соединения. */
+    static int64 ReadSchemaVersion(const FString& FilePath);
+
+    /** Удаляет файл базы вместе с -wal и -shm, чтобы старый журнал не применился к новому файлу. */
+    static bool DeleteDatabaseFiles(const FString& FilePath);
+
+    /** Растёт при каждом переоткрытии и каждом применённом патче - признак того, что данные могли измениться. */
+    uint32 GetDataGeneration() const { return DataGeneration.load(std::memory_order_acquire); }
+
+    /** То же, но сначала (не чаще раза в секунду) проверяет, не подменили ли файл базы снаружи. */
+    uint32 RefreshDataGeneration();
+
+    void Close();
+
+    bool IsOpen() const;
+    FString GetPath() const;
+
+    /** file:-URI с immutable=1: SQLite не берёт блокировок и не ищет журналы рядом с файлом. */
+    static FString MakeImmutableUri(const FString& FilePath);
+
+    /**
+     * Выполняет Body с закэшированным запросом для Sql.
+     * Запрос уже сброшен и без привязанных параметров; возвращает false, если его не удалось скомпилировать.
+     */
+    bool WithStatement(const FString& Sql, TFunctionRef<void(sqlite3_stmt*)> Body);
+
+    int32 GetStatementCacheHits() const { return StatementCacheHits.load(std::memory_order_relaxed); }
+    int32 GetStatementCacheMisses() const { return StatementCacheMisses.load(std::memory_order_relaxed); }
+
+private:
+    bool OpenLocked(const FString& MainPath, bool bImmutable, const FString& AttachedPath);
+    void CloseLocked();
+    void FinalizeStatements();
+
+    FString Path;
+    FString BundledPath;
+    FString OverlayPath;
+    sqlite3* DB = nullptr;
+
+    FDateTime FileTimeStamp;
+    int64 FileSize = -1;
+    double LastFileCheckTime = 0.0;
+
+    TMap<FString, sqlite3_stmt*, FDefaultSetAllocator, TCaseSensitiveStringKeyFuncs<sqlite3_stmt*>> StatementCache;
+    mutable FCriticalSection Lock;
+
+    std::atomic<int32> StatementCacheHits{0};
+    std::atomic<int32> StatementCacheMisses{0};
+    std::atomic<uint32> DataGeneration{0};
+};
@@ -0,0 +1,45 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "ClassroomScheduleRow.h"
+#include "ScheduleEntry.generated.h"
+
+class FScheduleStringPool;
+
+// Порядок совпадает с EDayOfWeek, чтобы переводить FDateTime без таблиц
+UENUM(BlueprintType)
+enum class EScheduleWeekday : uint8
+{
+    Monday,
+    Tuesday,
+    Wednesday,
+    Thursday,
+    Friday,
+    Saturday,
+    Sunday,
+    Invalid UMETA(Hidden)
+};
+
+/**
+ * Компактная строка расписания: 16 байт вместо пяти FString.
+ * Время хранится в минутах от полуночи, день недели - перечислением,
+ * предмет и преподаватель - хэндлами в FScheduleStringPool.
+ * В FClassroomScheduleRow переводится только на границе с Blueprint.
+ */
+struct AUDIT_API FScheduleEntry
+{
+    int32 Subject = INDEX_NONE;
+    int32 Teacher = INDEX_NONE;
+    int16 StartMinute = 0;
+    int16 EndMinute = 0;
+    EScheduleWeekday Weekday = EScheduleWeekday::Invalid;
+
+    FClassroomScheduleRow ToBlueprintRow(const FScheduleStringPool& Pool) const;
+
+    /** Строго "ЧЧ:ММ"; INDEX_NONE, если строка в другом формате. */
+    static int32 ParseMinutesUtf8(const ANSICHAR* Text, int32 Length);
+    static FString FormatMinutes(int32 Minutes);
+
+    /** Названия дней недели в том виде, в каком они лежат в базе. */
+    static EScheduleWeekday ParseWeekday(const FString& Text);
+    static const FString& GetWeekdayName(EScheduleWeekday Weekday);
+};
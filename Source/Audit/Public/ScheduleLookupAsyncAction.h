@@ -0,0 +1,46 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "Kismet/BlueprintAsyncActionBase.h"
+#include "HAL/ThreadSafeBool.h"
+#include "ClassroomScheduleRow.h"
+#include "ScheduleLookupAsyncAction.generated.h"
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FScheduleLookupDelegate, const FString&, RoomCode, const TArray<FClassroomScheduleRow>&, Rows);
+
+/**
+ * Асинхронный GetScheduleForRoom: поиск идёт в пуле потоков, результат приходит в игровом потоке.
+ * Одновременно выполняется только один поиск: новый запрос того же кабинета присоединяется
+ * к текущему, запрос другого кабинета отменяет предыдущий (у него срабатывает OnCancelled).
+ */
+UCLASS()
+class AUDIT_API UScheduleLookupAsyncAction : public UBlueprintAsyncActionBase
+{
+    GENERATED_BODY()
+
+public:
+    UPROPERTY(BlueprintAssignable)
+    FScheduleLookupDelegate OnCompleted;
+
+    UPROPERTY(BlueprintAssignable)
+    FScheduleLookupDelegate OnCancelled;
+
+    UFUNCTION(BlueprintCallable, Category = "SQLite", meta = (BlueprintInternalUseOnly = "true", WorldContext = "WorldContextObject"))
+    static UScheduleLookupAsyncAction* GetScheduleForRoomAsync(UObject* WorldContextObject, const FString& RoomCode);
+
+    virtual void Activate() override;
+
+private:
+    void Start();
+    void Complete(const TArray<FClassroomScheduleRow>& Rows);
+    void Cancel();
+
+    FString RoomCode;
+
+    // Флаг отмены разделяется с рабочим потоком, сам объект туда не передаётся
+    TSharedRef<FThreadSafeBool, ESPMode::ThreadSafe> CancelFlag = MakeShared<FThreadSafeBool, ESPMode::ThreadSafe>(false);
+    bool bFinished = false;
+
+    // Запросы того же кабинета, присоединившиеся к этому поиску
+    UPROPERTY()
+    TArray<TObjectPtr<UScheduleLookupAsyncAction>> Followers;
+};
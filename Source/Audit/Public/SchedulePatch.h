@@ -0,0 +1,48 @@
+#pragma once
+#include "CoreMinimal.h"
+
+struct sqlite3;
+
+/**
+ * Строка патча: id и набор колонок ClassroomSchedule.
+ * Колонки хранятся в каноническом порядке таблицы, чтобы одинаковые по составу
+ * строки давали один и тот же текст SQL.
+ */
+struct AUDIT_API FSchedulePatchRow
+{
+    int64 Id = INDEX_NONE;
+    TArray<TPair<FString, FString>> Columns;
+};
+
+/**
+ * Разностный патч расписания: удаления, изменения и вставки строк ClassroomSchedule,
+ * переводящие базу из версии FromVersion в ToVersion.
+ *
+ * Формат файла (JSON):
+ *   { "from_version": 1, "to_version": 2,
+ *     "delete": [ 12, 13 ],
+ *     "update": [ { "id": 5, "teacher": "..." } ],
+ *     "insert": [ { "room_code": "...", "subject": "...", "teacher": "...",
+ *                   "start_time": "08:30", "end_time": "10:00", "weekday": "Понедельник" } ] }
+ */
+struct AUDIT_API FSchedulePatch
+{
+    int64 FromVersion = 0;
+    int64 ToVersion = 0;
+
+    TArray<int64> Deletes;
+    TArray<FSchedulePatchRow> Updates;
+    TArray<FSchedulePatchRow> Inserts;
+
+    bool LoadFromFile(const FString& FilePath);
+    bool LoadFromString(const FString& Json, const FString& SourceName);
+
+    int32 GetNumChanges() const { return Deletes.Num() + Updates.Num() + Inserts.Num(); }
+
+    /**
+     * Применяет строки к main.ClassroomSchedule на соединении Connection.
+     * Транзакцию и проверку версии ведёт вызывающий; удаление или изменение
+     * отсутствующей строки считается ошибкой - патч собран не для этих данных.
+     */
+    bool ApplyRows(sqlite3* Connection, FString& OutError) const;
+};
@@ -0,0 +1,38 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "Misc/DateTime.h"
+#include "ScheduleEntry.h"
+
+enum class EScheduleQueryKind : uint8
+{
+    // Занятие, идущее в момент From
+    Current,
+    // Первое занятие, начинающееся после From (с переходом через конец недели)
+    Next,
+    // Все занятия, пересекающие [From, To)
+    Range
+};
+
+/**
+ * Запросы по времени над массивом занятий одного кабинета,
+ * отсортированным по (день недели, минута начала). Все поиски - бинарные.
+ * Время задаётся в минутах от начала недели (понедельник 00:00).
+ */
+struct AUDIT_API FScheduleQuery
+{
+    static constexpr int32 MinutesPerDay = 24 * 60;
+    static constexpr int32 MinutesPerWeek = 7 * MinutesPerDay;
+
+    static int32 GetWeekMinute(const FDateTime& Time);
+    static int32 GetStartWeekMinute(const FScheduleEntry& Entry);
+    static int32 GetEndWeekMinute(const FScheduleEntry& Entry);
+
+    static void SortByWeekTime(TArrayView<FScheduleEntry> Entries);
+
+    static void Run(TArrayView<const FScheduleEntry> Sorted, EScheduleQueryKind Kind, int32 From, int32 To, TArray<const FScheduleEntry*>& OutEntries);
+
+private:
+    static int32 LowerBound(TArrayView<const FScheduleEntry> Sorted, int32 WeekMinute);
+    static int32 UpperBound(TArrayView<const FScheduleEntry> Sorted, int32 WeekMinute);
+    static void CollectOverlapping(TArrayView<const FScheduleEntry> Sorted, int32 From, int32 To, TArray<const FScheduleEntry*>& OutEntries);
+};
@@ -0,0 +1,63 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "Containers/List.h"
+#include "HAL/CriticalSection.h"
+#include "ClassroomScheduleRow.h"
+#include "ScheduleDatabase.h"
+
+/**
+ * LRU-кэш готовых ответов GetScheduleForRoom по коду кабинета.
+ * Объём ограничен в байтах; при смене поколения данных базы (переоткрытие, патч)
+ * кэш целиком сбрасывается. Потокобезопасен.
+ */
+class AUDIT_API FScheduleResultCache
+{
+public:
+    explicit FScheduleResultCache(SIZE_T InMaxBytes);
+    ~FScheduleResultCache();
+
+    FScheduleResultCache(const FScheduleResultCache&) = delete;
+    FScheduleResultCache& operator=(const FScheduleResultCache&) = delete;
+
+    /** Generation - поколение базы на момент запроса; устаревшие записи не отдаются. */
+    bool Find(const FString& RoomCode, uint32 Generation, TArray<FClassroomScheduleRow>& OutRows);
+
+    /** Generation - поколение, прочитанное до выборки Rows; ответ по более старым данным отбрасывается. */
+    void Add(const FString& RoomCode, uint32 Generation, const TArray<FClassroomScheduleRow>& Rows);
+
+    void SetMaxBytes(SIZE_T InMaxBytes);
+    void Empty();
+
+    int32 GetHits() const { return Hits.load(std::memory_order_relaxed); }
+    int32 GetMisses() const { return Misses.load(std::memory_order_relaxed); }
+    int32 GetEvictions() const { return Evictions.load(std::memory_order_relaxed); }
+    SIZE_T GetUsedBytes() const;
+
+private:
+    struct FEntry
+    {
+        TArray<FClassroomScheduleRow> Rows;
+        SIZE_T Bytes = 0;
+        TDoubleLinkedList<FString>::TDoubleLinkedListNode* Node = nullptr;
+    };
+
+    static SIZE_T GetEntryBytes(const FString& RoomCode, const TArray<FClassroomScheduleRow>& Rows);
+
+    void SyncGenerationLocked(uint32 Generation);
+    void EvictLocked(SIZE_T Budget);
+    void EmptyLocked();
+
+    TMap<FString, FEntry, FDefaultSetAllocator, TCaseSensitiveStringKeyFuncs<FEntry>> Entries;
+    // Голова - последний использованный кабинет, хвост - кандидат на вытеснение
+    TDoubleLinkedList<FString> RecentlyUsed;
+
+    SIZE_T MaxBytes = 0;
+    SIZE_T UsedBytes = 0;
+    uint32 CachedGeneration = 0;
+
+    mutable FCriticalSection Lock;
+
+    std::atomic<int32> Hits{0};
+    std::atomic<int32> Misses{0};
+    std::atomic<int32> Evictions{0};
+};
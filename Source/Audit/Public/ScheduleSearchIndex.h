@@ -0,0 +1,39 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "ScheduleEntry.h"
+#include "ScheduleStringPool.h"
+
+/**
+ * Инвертированный индекс по словам предметов и преподавателей.
+ * Слова приводятся к нижнему регистру (ё -> е) и лежат отсортированными,
+ * поэтому поиск по префиксу - бинарный поиск и проход по соседним словам.
+ * Для каждой строки пула хранится список занятий, где она предмет или преподаватель.
+ */
+class AUDIT_API FScheduleSearchIndex
+{
+public:
+    void Build(const FScheduleStringPool& Strings, TArrayView<const FScheduleEntry> Entries);
+
+    /**
+     * Индексы занятий (по возрастанию), у которых в выбранных полях каждое слово запроса
+     * является началом какого-то слова одного и того же поля. MaxResults <= 0 - без ограничения.
+     */
+    void Search(const FString& Query, bool bSubjects, bool bTeachers, TArrayView<const FScheduleEntry> Entries, int32 MaxResults, TArray<int32>& OutEntries) const;
+
+    SIZE_T GetAllocatedSize() const;
+
+    /** Разбивает текст на слова из букв и цифр в нижнем регистре. */
+    static void Tokenize(const FString& Text, TArray<FString>& OutTokens);
+
+private:
+    struct FToken
+    {
+        FString Text;
+        int32 String = INDEX_NONE;
+    };
+
+    TArray<FToken> Tokens;
+    // Занятия строки пула H: EntryIndices[EntryOffsets[H] .. EntryOffsets[H + 1])
+    TArray<int32> EntryOffsets;
+    TArray<int32> EntryIndices;
+};
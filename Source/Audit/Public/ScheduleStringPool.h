@@ -0,0 +1,37 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "ScheduleDatabase.h"
+
+/**
+ * Пул интернированных строк расписания (кабинеты, предметы, преподаватели).
+ * Строки из SQLite ищутся прямо по байтам UTF-8, поэтому FString
+ * создаётся только один раз на уникальное значение.
+ */
+class AUDIT_API FScheduleStringPool
+{
+public:
+    /** Хэндл строки в UTF-8; новая строка конвертируется в FString только при первом появлении. */
+    int32 InternUtf8(const ANSICHAR* Text, int32 Length);
+
+    /** Хэндл существующей строки или INDEX_NONE (сравнение с учётом регистра). */
+    int32 Find(const FString& Text) const;
+
+    const FString& Get(int32 Handle) const { return Strings[Handle]; }
+    int32 Num() const { return Strings.Num(); }
+
+    SIZE_T GetAllocatedSize() const;
+
+private:
+    struct FUtf8Range
+    {
+        int32 Offset = 0;
+        int32 Length = 0;
+    };
+
+    TArray<FString> Strings;
+    TArray<FUtf8Range> Utf8Ranges;
+    TArray<ANSICHAR> Utf8Data;
+
+    TMultiMap<uint32, int32> Utf8Lookup;
+    TMap<FString, int32, FDefaultSetAllocator, TCaseSensitiveStringKeyFuncs<int32>> StringLookup;
+};